@@ -307,6 +307,29 @@ typedef  unsigned int               TN_UIntPtr;
  */
 #define _TN_SIZE_BYTES_TO_UWORDS(size_in_bytes)    ((size_in_bytes) >> 2)
 
+#if defined(__TN_ARCHFEAT_CORTEX_M_ARMv7M_ISA__)
+/**
+ * Exclusive access to the word: `LDREX`, `STREX` and `CLREX`. Used by the
+ * lock-free fast paths of mutexes, semaphores and buffers (see `tn_mutex.c`,
+ * `tn_sem.c` and `tn_buf.c`).
+ *
+ * `_TN_EXCL_STORE()` returns non-zero if the store succeeded. Since the
+ * processor clears the local exclusive monitor on exception entry and exit,
+ * the store fails if some ISR ran (or the task was preempted) after the
+ * matching `_TN_EXCL_LOAD()`.
+ *
+ * May be not defined: in this case, mutexes, semaphores and buffers always
+ * disable interrupts.
+ */
+#define  _TN_EXCL_LOAD(p_word)            _tn_arch_excl_load(p_word)
+#define  _TN_EXCL_STORE(p_word, value)    _tn_arch_excl_store(p_word, value)
+#define  _TN_EXCL_CLEAR()                 _tn_arch_excl_clear()
+
+TN_UWord _tn_arch_excl_load(volatile TN_UWord *p_word);
+int _tn_arch_excl_store(volatile TN_UWord *p_word, TN_UWord value);
+void _tn_arch_excl_clear(void);
+#endif
+
 #if defined(__TN_COMPILER_ARMCC__)
 #  if TN_FORCED_INLINE
 #     define _TN_INLINE             __forceinline
@@ -0,0 +1,599 @@
+/*******************************************************************************
+ *
+ * TNeo: real-time kernel initially based on TNKernel
+ *
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
+ *
+ *    TNeo was born as a thorough review and re-implementation of
+ *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
+ *    as well as new features being added, and it is tested carefully with
+ *    unit-tests.
+ *
+ *    API is changed somewhat, so it's not 100% compatible with TNKernel,
+ *    hence the new name: TNeo.
+ *
+ *    Permission to use, copy, modify, and distribute this software in source
+ *    and binary forms and its documentation for any purpose and without fee
+ *    is hereby granted, provided that the above copyright notice appear
+ *    in all copies and that both that copyright notice and this permission
+ *    notice appear in supporting documentation.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE DMITRY FRANK AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DMITRY FRANK OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *    THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+/*
+ * POSIX port overview
+ *
+ * Tasks:
+ *
+ *    Each task is an `ucontext_t` context. The context structure itself
+ *    (`struct _TN_PosixContext`) is placed at the very top of the task's
+ *    stack, and `stack_cur_pt` of the task points to it; the rest of the
+ *    stack is given to the context as its stack.
+ *
+ * Interrupts:
+ *
+ *    System interrupts are POSIX signals attached by `tn_posix_int_attach()`.
+ *    Disabling of interrupts is "virtual": it merely sets the flag
+ *    `_int_dis`, so that critical sections are cheap, without any syscalls.
+ *    If the signal comes while the flag is set, the handler just marks it as
+ *    pending and returns; when interrupts get enabled, all pending signals
+ *    are raised again and handled for real.
+ *
+ *    Signal handlers are installed with all the attached signals masked, so
+ *    that "ISRs" don't nest.
+ *
+ * Context switch:
+ *
+ *    Context switch is pended just like PendSV on Cortex-M: it is performed
+ *    as soon as interrupts are enabled and no ISR is running. This may happen
+ *    either in the task (synchronously, e.g. inside `TN_INT_RESTORE()`), or
+ *    at the end of the signal handler. In both cases, `swapcontext()` is
+ *    used: since every context has its own saved signal mask, the preempted
+ *    task resumes right where it was, inside the signal handler if it was
+ *    preempted by an ISR.
+ *
+ *    Consequently, signal frames are stored on task stacks, so tasks need
+ *    much larger stacks than on MCUs: see `#TN_MIN_STACK_SIZE`.
+ */
+
+
+/*******************************************************************************
+ *    INCLUDED FILES
+ ******************************************************************************/
+
+#include "_tn_tasks.h"
+#include "_tn_sys.h"
+
+#include <signal.h>
+#include <ucontext.h>
+#include <sys/time.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+
+/*******************************************************************************
+ *    PRIVATE TYPES
+ ******************************************************************************/
+
+/**
+ * Task context, placed at the top of the task's stack
+ */
+struct _TN_PosixContext {
+   ///
+   /// CPU context along with the signal mask
+   ucontext_t     uc;
+   ///
+   /// task body function, called from `_task_entry()`
+   TN_TaskBody   *task_func;
+   ///
+   /// parameter for `task_func`
+   void          *param;
+};
+
+
+
+/*******************************************************************************
+ *    DEFINITIONS
+ ******************************************************************************/
+
+//-- Signals which can be attached as interrupts are 1 .. (_SIGNALS_CNT - 1),
+//   since bitmask of pending signals is `unsigned long long`
+#define _SIGNALS_CNT    ((int)(sizeof(unsigned long long) * 8))
+
+
+
+/*******************************************************************************
+ *    PRIVATE DATA
+ ******************************************************************************/
+
+//-- Non-zero if system interrupts are disabled. Initially, interrupts are
+//   disabled: they get enabled when the first task starts running.
+static volatile sig_atomic_t _int_dis = 1;
+
+//-- non-zero if the scheduler is disabled, see `tn_arch_sched_dis_save()`
+static volatile sig_atomic_t _sched_dis = 0;
+
+//-- non-zero while some ISR is running
+static volatile sig_atomic_t _isr_nest = 0;
+
+//-- non-zero if context switch is pended
+static volatile sig_atomic_t _context_switch_pending = 0;
+
+//-- non-zero after `_tn_arch_sys_start()` is called
+static volatile sig_atomic_t _sys_started = 0;
+
+//-- bitmask of signals which have come while interrupts were disabled
+static volatile unsigned long long _int_pending = 0;
+
+//-- ISRs for attached signals
+static TN_PosixISR *_isr_table[_SIGNALS_CNT];
+
+//-- word reserved by `_tn_arch_excl_load()` (or `TN_NULL`): reservation is
+//   cleared whenever some ISR runs or context is switched
+static volatile TN_UWord *volatile _excl_addr = TN_NULL;
+
+
+
+/*******************************************************************************
+ *    PRIVATE FUNCTIONS
+ ******************************************************************************/
+
+/**
+ * Compiler barrier: since "interrupts" are signals delivered to the same
+ * thread, it is sufficient to prevent compiler from moving memory accesses
+ * across disabling/enabling of interrupts.
+ */
+_TN_STATIC_INLINE void _barrier(void)
+{
+   __atomic_signal_fence(__ATOMIC_SEQ_CST);
+}
+
+/**
+ * Returns context of the given task
+ */
+_TN_STATIC_INLINE struct _TN_PosixContext *_context_get(struct TN_Task *task)
+{
+   return (struct _TN_PosixContext *)task->stack_cur_pt;
+}
+
+/**
+ * Switch context from `_tn_curr_run_task` to `_tn_next_task_to_run`, saving
+ * the context of the current one. Returns when the current task is switched
+ * back to.
+ *
+ * Should be called with interrupts enabled, outside of ISR.
+ */
+static void _context_switch(void)
+{
+   struct TN_Task *task_prev = _tn_curr_run_task;
+
+   _int_dis = 1;
+   _barrier();
+
+   _context_switch_pending = 0;
+   _excl_addr = TN_NULL;
+
+   if (task_prev != _tn_next_task_to_run){
+#if _TN_ON_CONTEXT_SWITCH_HANDLER
+      _tn_sys_on_context_switch(_tn_curr_run_task, _tn_next_task_to_run);
+#endif
+      _tn_curr_run_task = _tn_next_task_to_run;
+
+      swapcontext(
+            &_context_get(task_prev)->uc,
+            &_context_get(_tn_curr_run_task)->uc
+            );
+   }
+
+   _barrier();
+   _int_dis = 0;
+}
+
+/**
+ * Called whenever interrupts become enabled: delivers signals which have come
+ * while interrupts were disabled, and performs pending context switch, if
+ * possible.
+ */
+static void _int_enabled(void)
+{
+   unsigned long long pending;
+   int signo;
+
+   do {
+      //-- Raise all pending signals again: outside of the handler, they are
+      //   delivered before `raise()` returns; inside the handler, the
+      //   system delivers them when the handler returns.
+      pending = __atomic_exchange_n(&_int_pending, 0, __ATOMIC_SEQ_CST);
+      for (signo = 0; pending != 0; signo++, pending >>= 1){
+         if (pending & 1){
+            raise(signo);
+         }
+      }
+
+      //-- switch context if it is pended and allowed now
+      if (     _context_switch_pending
+            && _sys_started
+            && !_isr_nest
+            && !_sched_dis
+            && !_int_dis
+         )
+      {
+         _context_switch();
+      }
+   } while (_int_pending != 0 && !_int_dis);
+}
+
+/**
+ * Handler for all the attached signals
+ */
+static void _signal_handler(int signo)
+{
+   if (_int_dis){
+      //-- interrupts are disabled: keep the signal pending, it will be
+      //   raised again by `_int_enabled()`
+      __atomic_fetch_or(&_int_pending, 1ULL << signo, __ATOMIC_SEQ_CST);
+   } else {
+      //-- just like exclusive monitor of Cortex-M, clear the reservation
+      //   on exception entry and exit
+      _excl_addr = TN_NULL;
+
+      _isr_nest++;
+      _isr_table[signo]();
+      _isr_nest--;
+
+      _excl_addr = TN_NULL;
+
+      //-- ISR is done, so switch context now if ISR has pended it
+      _int_enabled();
+   }
+}
+
+/**
+ * Entry point of every task: enables interrupts (they were disabled by the
+ * context switch), calls task body function, and terminates the task if the
+ * task body function returns.
+ */
+static void _task_entry(void)
+{
+   struct _TN_PosixContext *ctx = _context_get(_tn_curr_run_task);
+
+   _barrier();
+   _int_dis = 0;
+   _int_enabled();
+
+   ctx->task_func(ctx->param);
+
+   _tn_task_exit_nodelete();
+}
+
+/**
+ * ISR for the periodic tick, see `tn_posix_tick_start()`
+ */
+static void _tick_isr(void)
+{
+   tn_tick_int_processing();
+}
+
+
+
+/*******************************************************************************
+ *    PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+/*
+ * See comments in the file `tn_arch_posix.h`
+ */
+void tn_posix_int_attach(int signo, TN_PosixISR *isr)
+{
+   struct sigaction sa;
+   int i;
+
+   if (signo <= 0 || signo >= _SIGNALS_CNT || isr == TN_NULL){
+      _TN_FATAL_ERRORF("wrong signal number: %d", signo);
+   }
+
+   _isr_table[signo] = isr;
+
+   //-- all attached signals should be masked while any handler runs,
+   //   so, (re)install handlers for all of them with the new mask
+   sa.sa_handler = _signal_handler;
+   sa.sa_flags   = SA_RESTART;
+   sigemptyset(&sa.sa_mask);
+
+   for (i = 1; i < _SIGNALS_CNT; i++){
+      if (_isr_table[i] != TN_NULL){
+         sigaddset(&sa.sa_mask, i);
+      }
+   }
+
+   for (i = 1; i < _SIGNALS_CNT; i++){
+      if (_isr_table[i] != TN_NULL){
+         if (sigaction(i, &sa, TN_NULL) != 0){
+            _TN_FATAL_ERRORF("sigaction() failed for signal %d", i);
+         }
+      }
+   }
+}
+
+/*
+ * See comments in the file `tn_arch_posix.h`
+ */
+void tn_posix_tick_start(unsigned long period_us)
+{
+   struct itimerval itv;
+
+   tn_posix_int_attach(SIGALRM, _tick_isr);
+
+   itv.it_interval.tv_sec  = period_us / 1000000;
+   itv.it_interval.tv_usec = period_us % 1000000;
+   itv.it_value            = itv.it_interval;
+
+   if (setitimer(ITIMER_REAL, &itv, TN_NULL) != 0){
+      _TN_FATAL_ERROR("setitimer() failed");
+   }
+}
+
+/*
+ * See comments in the file `tn_arch_posix.h`
+ */
+void _tn_posix_fatal_error(
+      const char *file,
+      int line,
+      const char *error_msg,
+      ...
+      )
+{
+   va_list args;
+
+   fprintf(stderr, "TNeo fatal error at %s:%d: ", file, line);
+
+   va_start(args, error_msg);
+   vfprintf(stderr, error_msg, args);
+   va_end(args);
+
+   fprintf(stderr, "\n");
+
+   abort();
+}
+
+
+
+/*******************************************************************************
+ *    ARCHITECTURE-DEPENDENT IMPLEMENTATION
+ ******************************************************************************/
+
+/*
+ * See comments in the file `tn_arch.h`
+ */
+void _tn_arch_sys_start(
+      TN_UWord      *int_stack,
+      TN_UWord       int_stack_size
+      )
+{
+   //-- ISRs are executed on the stack of the interrupted task (see comments
+   //   at the top of the file), so interrupt stack isn't used.
+   _TN_UNUSED(int_stack);
+   _TN_UNUSED(int_stack_size);
+
+   tn_arch_int_dis();
+   _sys_started = 1;
+
+   //-- perform first context switch
+   _tn_arch_context_switch_now_nosave();
+}
+
+/*
+ * See comments in the file `tn_arch.h`
+ */
+TN_UWord *_tn_arch_stack_init(
+      TN_TaskBody   *task_func,
+      TN_UWord      *stack_low_addr,
+      TN_UWord      *stack_high_addr,
+      void          *param
+      )
+{
+   //-- context is placed at the top of the stack, aligned by 16 bytes
+   struct _TN_PosixContext *ctx = (struct _TN_PosixContext *)(
+         ((TN_UIntPtr)(stack_high_addr + 1/*'full desc stack' model*/)
+          - sizeof(struct _TN_PosixContext)) & ~(TN_UIntPtr)0x0f
+         );
+
+   ctx->task_func = task_func;
+   ctx->param     = param;
+
+   if (getcontext(&ctx->uc) != 0){
+      _TN_FATAL_ERROR("getcontext() failed");
+   }
+
+   //-- the rest of the stack is given to the task
+   ctx->uc.uc_stack.ss_sp   = stack_low_addr;
+   ctx->uc.uc_stack.ss_size = (TN_UIntPtr)ctx - (TN_UIntPtr)stack_low_addr;
+   ctx->uc.uc_link          = TN_NULL;
+
+   //-- no signals are actually blocked in tasks: interrupts are disabled
+   //   "virtually", by the `_int_dis` flag
+   sigemptyset(&ctx->uc.uc_sigmask);
+
+   makecontext(&ctx->uc, _task_entry, 0);
+
+   return (TN_UWord *)ctx;
+}
+
+/*
+ * See comments in the file `tn_arch.h`
+ */
+void tn_arch_int_dis(void)
+{
+   _int_dis = 1;
+   _barrier();
+}
+
+/*
+ * See comments in the file `tn_arch.h`
+ */
+void tn_arch_int_en(void)
+{
+   _barrier();
+   _int_dis = 0;
+   _int_enabled();
+}
+
+/*
+ * See comments in the file `tn_arch.h`
+ */
+TN_UWord tn_arch_sr_save_int_dis(void)
+{
+   TN_UWord ret = _int_dis;
+
+   _int_dis = 1;
+   _barrier();
+
+   return ret;
+}
+
+/*
+ * See comments in the file `tn_arch.h`
+ */
+void tn_arch_sr_restore(TN_UWord sr)
+{
+   _barrier();
+   _int_dis = sr;
+
+   if (!sr && (_int_pending != 0 || _context_switch_pending)){
+      _int_enabled();
+   }
+}
+
+/*
+ * See comments in the file `tn_arch.h`
+ */
+TN_UWord tn_arch_sched_dis_save(void)
+{
+   TN_UWord ret = _sched_dis;
+
+   _sched_dis = 1;
+   _barrier();
+
+   return ret;
+}
+
+/*
+ * See comments in the file `tn_arch.h`
+ */
+void tn_arch_sched_restore(TN_UWord sched_state)
+{
+   _barrier();
+   _sched_dis = sched_state;
+
+   if (!sched_state && !_int_dis && _context_switch_pending){
+      _int_enabled();
+   }
+}
+
+/*
+ * See comments in the file `tn_arch_posix.h`
+ */
+TN_UWord _tn_arch_excl_load(volatile TN_UWord *p_word)
+{
+   _excl_addr = p_word;
+   _barrier();
+
+   return *p_word;
+}
+
+/*
+ * See comments in the file `tn_arch_posix.h`
+ */
+int _tn_arch_excl_store(volatile TN_UWord *p_word, TN_UWord value)
+{
+   int ret = 0;
+
+   //-- check of the reservation and the store should be atomic, just like
+   //   `STREX`, so no ISR should run in between
+   TN_UWord sr = tn_arch_sr_save_int_dis();
+
+   if (_excl_addr == p_word){
+      *p_word = value;
+      ret = 1;
+   }
+   _excl_addr = TN_NULL;
+
+   tn_arch_sr_restore(sr);
+
+   return ret;
+}
+
+/*
+ * See comments in the file `tn_arch_posix.h`
+ */
+void _tn_arch_excl_clear(void)
+{
+   _excl_addr = TN_NULL;
+}
+
+/*
+ * See comments in the file `tn_arch.h`
+ */
+int _tn_arch_inside_isr(void)
+{
+   return (_isr_nest != 0);
+}
+
+/*
+ * See comments in the file `tn_arch.h`
+ */
+int _tn_arch_is_int_disabled(void)
+{
+   return (_int_dis != 0);
+}
+
+/*
+ * See comments in the file `tn_arch.h`
+ */
+void _tn_arch_context_switch_pend(void)
+{
+   _context_switch_pending = 1;
+
+   if (!_int_dis){
+      _int_enabled();
+   }
+}
+
+/*
+ * See comments in the file `tn_arch.h`
+ */
+void _tn_arch_context_switch_now_nosave(void)
+{
+   _int_dis = 1;
+   _barrier();
+
+   _context_switch_pending = 0;
+   _excl_addr = TN_NULL;
+
+#if _TN_ON_CONTEXT_SWITCH_HANDLER
+   _tn_sys_on_context_switch(_tn_curr_run_task, _tn_next_task_to_run);
+#endif
+   _tn_curr_run_task = _tn_next_task_to_run;
+
+   setcontext(&_context_get(_tn_curr_run_task)->uc);
+
+   //-- should never be here
+   _TN_FATAL_ERROR("setcontext() failed");
+}
+
@@ -0,0 +1,392 @@
+/*******************************************************************************
+ *
+ * TNeo: real-time kernel initially based on TNKernel
+ *
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
+ *
+ *    TNeo was born as a thorough review and re-implementation of
+ *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
+ *    as well as new features being added, and it is tested carefully with
+ *    unit-tests.
+ *
+ *    API is changed somewhat, so it's not 100% compatible with TNKernel,
+ *    hence the new name: TNeo.
+ *
+ *    Permission to use, copy, modify, and distribute this software in source
+ *    and binary forms and its documentation for any purpose and without fee
+ *    is hereby granted, provided that the above copyright notice appear
+ *    in all copies and that both that copyright notice and this permission
+ *    notice appear in supporting documentation.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE DMITRY FRANK AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DMITRY FRANK OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *    THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+/**
+ *
+ * \file
+ *
+ * POSIX (Linux host) architecture-dependent routines
+ *
+ * This port runs the kernel as an ordinary single-threaded process: tasks are
+ * `ucontext_t` contexts living on the task stacks, and <i>system
+ * interrupts</i> are POSIX signals. Useful for simulation, debugging and
+ * benchmarking the application logic without hardware.
+ *
+ */
+
+#ifndef  _TN_ARCH_POSIX_H
+#define  _TN_ARCH_POSIX_H
+
+
+/*******************************************************************************
+ *    INCLUDED FILES
+ ******************************************************************************/
+
+#include "../tn_arch_detect.h"
+#include "../../core/tn_cfg_dispatch.h"
+
+#include <stddef.h>
+
+
+
+
+#ifdef __cplusplus
+extern "C"  {     /*}*/
+#endif
+
+
+/*******************************************************************************
+ *    PUBLIC TYPES
+ ******************************************************************************/
+
+/**
+ * Prototype of the "interrupt service routine": the function which is called
+ * by the port in the <i>system ISR</i> context when the signal, attached by
+ * `tn_posix_int_attach()`, is delivered.
+ */
+typedef void (TN_PosixISR)(void);
+
+
+
+
+/*******************************************************************************
+ *    PUBLIC FUNCTION PROTOTYPES
+ ******************************************************************************/
+
+/**
+ * Attach the "interrupt service routine" to the given signal. Since then,
+ * the signal is treated as a <i>system interrupt</i>:
+ *
+ * - if interrupts are disabled (`TN_INT_DIS_SAVE()`, `tn_arch_int_dis()`,
+ *   etc) when the signal comes, it is kept pending until interrupts get
+ *   enabled, just like with hardware interrupts;
+ * - ISRs do not nest;
+ * - context switch, if needed, is performed when the ISR returns.
+ *
+ * Must be called before `tn_sys_start()` or with interrupts disabled.
+ *
+ * @param signo
+ *    Signal number, for example `SIGALRM` or `SIGUSR1`. Signals which
+ *    are reported synchronously by the system (`SIGSEGV`, etc) must not be
+ *    used.
+ * @param isr
+ *    Function to call when signal is delivered.
+ */
+void tn_posix_int_attach(int signo, TN_PosixISR *isr);
+
+/**
+ * Start the periodic system tick: `tn_tick_int_processing()` is called
+ * every `period_us` microseconds from the `SIGALRM` "interrupt". It is a
+ * convenience wrapper over `tn_posix_int_attach()` and `setitimer()`.
+ *
+ * Typically it is called from the `#TN_CBUserTaskCreate` callback given to
+ * `tn_sys_start()`: interrupts are disabled until the first task runs, so
+ * no tick is lost or processed too early.
+ *
+ * @param period_us
+ *    System tick period, in microseconds.
+ */
+void tn_posix_tick_start(unsigned long period_us);
+
+/**
+ * Called by `_TN_FATAL_ERRORF()`: prints the message with location to
+ * `stderr` and aborts the process, so that the debugger (or core dump)
+ * shows the call stack.
+ */
+void _tn_posix_fatal_error(
+      const char *file,
+      int line,
+      const char *error_msg,
+      ...
+      );
+
+
+
+
+/*******************************************************************************
+ *    ARCH-DEPENDENT DEFINITIONS
+ ******************************************************************************/
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#define  _TN_POSIX_INTSAVE_DATA_INVALID   ((TN_UWord)-1)
+
+#if TN_DEBUG
+#  define   _TN_POSIX_INTSAVE_CHECK()                          \
+{                                                              \
+   if (TN_INTSAVE_VAR == _TN_POSIX_INTSAVE_DATA_INVALID){      \
+      _TN_FATAL_ERROR("");                                     \
+   }                                                           \
+}
+#else
+#  define   _TN_POSIX_INTSAVE_CHECK()  /* nothing */
+#endif
+
+/**
+ * FFS - find first set bit. Used in `_find_next_task_to_run()` function.
+ * Say, for `0xa8` it should return `3`.
+ *
+ * May be not defined: in this case, naive algorithm will be used.
+ */
+#define  _TN_FFS(x)     __builtin_ffs(x)
+
+/**
+ * Used by the kernel as a signal that something really bad happened.
+ * Indicates TNeo bugs as well as illegal kernel usage
+ * (e.g. sleeping in the idle task callback)
+ *
+ * On the host, the message is printed and the process is aborted.
+ */
+#define  _TN_FATAL_ERRORF(error_msg, ...)                         \
+   {_tn_posix_fatal_error(__FILE__, __LINE__, "" error_msg, __VA_ARGS__);}
+
+/**
+ * \def TN_ARCH_STK_ATTR_BEFORE
+ *
+ * Compiler-specific attribute that should be placed **before** declaration of
+ * array used for stack. It is needed because there are often additional 
+ * restrictions applied to alignment of stack, so, to meet them, stack arrays
+ * need to be declared with these macros.
+ *
+ * @see TN_ARCH_STK_ATTR_AFTER
+ */
+
+/**
+ * \def TN_ARCH_STK_ATTR_AFTER
+ *
+ * Compiler-specific attribute that should be placed **after** declaration of
+ * array used for stack. It is needed because there are often additional 
+ * restrictions applied to alignment of stack, so, to meet them, stack arrays
+ * need to be declared with these macros.
+ *
+ * @see TN_ARCH_STK_ATTR_BEFORE
+ */
+
+#define TN_ARCH_STK_ATTR_BEFORE
+#define TN_ARCH_STK_ATTR_AFTER         __attribute__((aligned(0x10)))
+
+
+/**
+ * Minimum task's stack size, in words, not in bytes. On the host, task stack
+ * holds not only the task's own frames, but also the saved `ucontext_t` and
+ * the signal frames of "interrupts" (which may be several kilobytes each,
+ * depending on CPU extensions), plus whatever libc functions called by the
+ * task need. So, it is much larger than on MCUs.
+ */
+#define  TN_MIN_STACK_SIZE          (4096 + _TN_STACK_OVERFLOW_SIZE_ADD)
+
+/**
+ * Width of `int` type.
+ */
+#define  TN_INT_WIDTH               32
+
+/**
+ * Unsigned integer type whose size is equal to the size of CPU register.
+ */
+typedef  unsigned long              TN_UWord;
+
+/**
+ * Unsigned integer type that is able to store pointers.
+ */
+typedef  unsigned long              TN_UIntPtr;
+
+/**
+ * Maximum number of priorities available, this value usually matches
+ * `#TN_INT_WIDTH`.
+ *
+ * @see TN_PRIORITIES_CNT
+ */
+#define  TN_PRIORITIES_MAX_CNT      TN_INT_WIDTH
+
+/**
+ * Value for infinite waiting, usually matches `ULONG_MAX`,
+ * because `#TN_TickCnt` is declared as `unsigned long`.
+ */
+#define  TN_WAIT_INFINITE           ((TN_TickCnt)-1)
+
+/**
+ * Value for initializing the task's stack
+ */
+#define  TN_FILL_STACK_VAL          0xFEEDFACE
+
+
+
+
+/**
+ * Variable name that is used for storing interrupts state
+ * by macros TN_INTSAVE_DATA and friends
+ */
+#define TN_INTSAVE_VAR              tn_save_status_reg
+
+/**
+ * Declares variable that is used by macros `TN_INT_DIS_SAVE()` and
+ * `TN_INT_RESTORE()` for storing status register value.
+ *
+ * @see `TN_INT_DIS_SAVE()`
+ * @see `TN_INT_RESTORE()`
+ */
+#define  TN_INTSAVE_DATA            \
+   TN_UWord TN_INTSAVE_VAR = _TN_POSIX_INTSAVE_DATA_INVALID;
+
+/**
+ * The same as `#TN_INTSAVE_DATA` but for using in ISR together with
+ * `TN_INT_IDIS_SAVE()`, `TN_INT_IRESTORE()`.
+ *
+ * @see `TN_INT_IDIS_SAVE()`
+ * @see `TN_INT_IRESTORE()`
+ */
+#define  TN_INTSAVE_DATA_INT        TN_INTSAVE_DATA
+
+/**
+ * \def TN_INT_DIS_SAVE()
+ *
+ * Disable interrupts and return previous value of status register,
+ * atomically. Similar `tn_arch_sr_save_int_dis()`, but implemented
+ * as a macro, so it is potentially faster.
+ *
+ * Uses `#TN_INTSAVE_DATA` as a temporary storage.
+ *
+ * @see `#TN_INTSAVE_DATA`
+ * @see `tn_arch_sr_save_int_dis()`
+ */
+
+/**
+ * \def TN_INT_RESTORE()
+ *
+ * Restore previously saved status register.
+ * Similar to `tn_arch_sr_restore()`, but implemented as a macro,
+ * so it is potentially faster.
+ *
+ * Uses `#TN_INTSAVE_DATA` as a temporary storage.
+ *
+ * @see `#TN_INTSAVE_DATA`
+ * @see `tn_arch_sr_save_int_dis()`
+ */
+
+#define TN_INT_DIS_SAVE()   TN_INTSAVE_VAR = tn_arch_sr_save_int_dis()
+#define TN_INT_RESTORE()    _TN_POSIX_INTSAVE_CHECK();                      \
+                            tn_arch_sr_restore(TN_INTSAVE_VAR)
+
+/**
+ * The same as `TN_INT_DIS_SAVE()` but for using in ISR.
+ *
+ * Uses `#TN_INTSAVE_DATA_INT` as a temporary storage.
+ *
+ * @see `#TN_INTSAVE_DATA_INT`
+ */
+#define TN_INT_IDIS_SAVE()       TN_INT_DIS_SAVE()
+
+/**
+ * The same as `TN_INT_RESTORE()` but for using in ISR.
+ *
+ * Uses `#TN_INTSAVE_DATA_INT` as a temporary storage.
+ *
+ * @see `#TN_INTSAVE_DATA_INT`
+ */
+#define TN_INT_IRESTORE()        TN_INT_RESTORE()
+
+/**
+ * Returns nonzero if interrupts are disabled, zero otherwise.
+ */
+#define TN_IS_INT_DISABLED()     (_tn_arch_is_int_disabled())
+
+/**
+ * Pend context switch from interrupt.
+ */
+#define _TN_CONTEXT_SWITCH_IPEND_IF_NEEDED()          \
+   _tn_context_switch_pend_if_needed()
+
+/**
+ * Converts size in bytes to size in `#TN_UWord`.
+ * The host may be either 32- or 64-bit, so just divide by the word size.
+ */
+#define _TN_SIZE_BYTES_TO_UWORDS(size_in_bytes)    \
+   ((size_in_bytes) / sizeof(TN_UWord))
+
+/**
+ * Emulation of exclusive access to the word (`LDREX`, `STREX` and `CLREX` on
+ * Cortex-M3/M4), so that the lock-free fast paths are exercised on the host
+ * as well.
+ *
+ * Just like the exclusive monitor of Cortex-M, the reservation made by
+ * `_TN_EXCL_LOAD()` is cleared whenever some ISR runs or context is switched,
+ * so `_TN_EXCL_STORE()` fails (returns zero) then.
+ *
+ * On 64-bit hosts, the word is wider than `int`, so `_TN_EXCL_INT_UNSUPPORTED`
+ * is defined: the `int` counters of semaphores and buffers can't be accessed
+ * this way, and only the fast path of mutexes is used.
+ */
+#define  _TN_EXCL_LOAD(p_word)            _tn_arch_excl_load(p_word)
+#define  _TN_EXCL_STORE(p_word, value)    _tn_arch_excl_store(p_word, value)
+#define  _TN_EXCL_CLEAR()                 _tn_arch_excl_clear()
+
+TN_UWord _tn_arch_excl_load(volatile TN_UWord *p_word);
+int _tn_arch_excl_store(volatile TN_UWord *p_word, TN_UWord value);
+void _tn_arch_excl_clear(void);
+
+#if __SIZEOF_LONG__ != __SIZEOF_INT__
+#  define  _TN_EXCL_INT_UNSUPPORTED
+#endif
+
+#if TN_FORCED_INLINE
+#  define _TN_INLINE             inline __attribute__ ((always_inline))
+#else
+#  define _TN_INLINE             inline
+#endif
+#define _TN_STATIC_INLINE         static _TN_INLINE
+#define _TN_VOLATILE_WORKAROUND   /* nothing */
+
+#define _TN_ARCH_STACK_PT_TYPE   _TN_ARCH_STACK_PT_TYPE__FULL
+#define _TN_ARCH_STACK_DIR       _TN_ARCH_STACK_DIR__DESC
+
+#endif   //-- DOXYGEN_SHOULD_SKIP_THIS
+
+
+
+
+
+
+
+
+
+
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif   // _TN_ARCH_POSIX_H
+
@@ -57,6 +57,7 @@
 #undef __TN_ARCH_CORTEX_M3__
 #undef __TN_ARCH_CORTEX_M4__
 #undef __TN_ARCH_CORTEX_M4_FP__
+#undef __TN_ARCH_POSIX__
 
 #undef __TN_ARCHFEAT_CORTEX_M_FPU__
 #undef __TN_ARCHFEAT_CORTEX_M_ARMv6M_ISA__
@@ -212,6 +213,14 @@
 #     else
 #        error unknown ARM architecture for GCC compiler
 #     endif
+#  elif defined(__unix__)
+
+/*
+ * Host build (Linux or other POSIX system): the kernel runs as a regular
+ * process, see src/arch/posix
+ */
+#     define __TN_ARCH_POSIX__
+
 #  else
 #     error unknown architecture for GCC compiler
 #  endif
@@ -71,6 +71,35 @@ extern "C"  {     /*}*/
  ******************************************************************************/
 
 
+/*******************************************************************************
+ *    PROTECTED FUNCTION PROTOTYPES
+ ******************************************************************************/
+
+/**
+ * Send the data element to the queue without waiting: give it to the first
+ * task waiting to receive, or put it to the FIFO. Returns `#TN_RC_TIMEOUT`
+ * if the FIFO is full. Used by \ref tn_exch_link_queue.h "exchange queue
+ * link".
+ *
+ * \attention Caller must disable interrupts.
+ */
+enum TN_RCode _tn_queue_send(
+      struct TN_DQueue *dque,
+      void *p_data
+      );
+
+/**
+ * Receive the data element from the queue without waiting. Returns
+ * `#TN_RC_TIMEOUT` if the queue is empty. Used by `tn_multi_wait()`.
+ *
+ * \attention Caller must disable interrupts.
+ */
+enum TN_RCode _tn_queue_receive(
+      struct TN_DQueue *dque,
+      void **pp_data
+      );
+
+
 /*******************************************************************************
  *    PROTECTED INLINE FUNCTIONS
  ******************************************************************************/
@@ -69,6 +69,22 @@ extern "C"  {     /*}*/
  *    PROTECTED FUNCTION PROTOTYPES
  ******************************************************************************/
 
+/**
+ * Check the events pattern against the given `wait_pattern` without waiting,
+ * and clear flag(s) if requested by `#TN_EVENTGRP_WMODE_AUTOCLR`. Returns
+ * `#TN_RC_TIMEOUT` if the condition isn't met. Used by `tn_multi_wait()`.
+ *
+ * For params documentation, refer to the `tn_eventgrp_wait()`.
+ *
+ * \attention Caller must disable interrupts.
+ */
+enum TN_RCode _tn_eventgrp_wait(
+      struct TN_EventGrp  *eventgrp,
+      TN_UWord             wait_pattern,
+      enum TN_EGrpWaitMode wait_mode,
+      TN_UWord            *p_flags_pattern
+      );
+
 /**
  * Establish link to the event group. 
  *
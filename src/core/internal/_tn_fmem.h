@@ -71,6 +71,28 @@ extern "C"  {     /*}*/
  ******************************************************************************/
 
 
+/*******************************************************************************
+ *    PROTECTED FUNCTION PROTOTYPES
+ ******************************************************************************/
+
+/**
+ * Get memory block from the pool without waiting. Returns `#TN_RC_TIMEOUT`
+ * if there are no free blocks. Used by \ref tn_exch_link_queue.h "exchange
+ * queue link" and by `tn_multi_wait()`.
+ *
+ * \attention Caller must disable interrupts.
+ */
+enum TN_RCode _tn_fmem_get(struct TN_FMem *fmem, void **p_data);
+
+/**
+ * Release memory block to the pool: give it to the first waiting task, if
+ * any, or put it back to the pool.
+ *
+ * \attention Caller must disable interrupts.
+ */
+enum TN_RCode _tn_fmem_release(struct TN_FMem *fmem, void *p_data);
+
+
 /*******************************************************************************
  *    PROTECTED INLINE FUNCTIONS
  ******************************************************************************/
@@ -2,9 +2,9 @@
  *
  * TNeo: real-time kernel initially based on TNKernel
  *
- *    TNKernel:                  copyright © 2004, 2013 Yuri Tiomkin.
- *    PIC32-specific routines:   copyright © 2013, 2014 Anders Montonen.
- *    TNeo:                      copyright © 2014       Dmitry Frank.
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
  *
  *    TNeo was born as a thorough review and re-implementation of
  *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
@@ -34,15 +34,15 @@
  *
  ******************************************************************************/
 
-#ifndef __TN_EXCH_LINK_H
-#define __TN_EXCH_LINK_H
+#ifndef __TN_MSGBUF_H
+#define __TN_MSGBUF_H
 
 /*******************************************************************************
  *    INCLUDED FILES
  ******************************************************************************/
 
 #include "_tn_sys.h"
-#include "tn_exch_link.h"
+#include "tn_msgbuf.h"
 
 
 
@@ -55,8 +55,6 @@ extern "C"  {     /*}*/
  *    EXTERNAL TYPES
  ******************************************************************************/
 
-struct TN_ExchLink;
-
 
 
 /*******************************************************************************
@@ -64,7 +62,7 @@ struct TN_ExchLink;
  ******************************************************************************/
 
 /*******************************************************************************
- *    GLOBAL VARIABLES
+ *    PROTECTED GLOBAL DATA
  ******************************************************************************/
 
 
@@ -74,40 +72,39 @@ struct TN_ExchLink;
 
 
 /*******************************************************************************
- *    PROTECTED FUNCTION PROTOTYPES
+ *    PROTECTED INLINE FUNCTIONS
  ******************************************************************************/
 
-const struct TN_ExchLink_VTable *_tn_exch_link_vtable(void);
-
-enum TN_RCode _tn_exch_link_create(
-      struct TN_ExchLink     *exch_link
-      );
-
-enum TN_RCode _tn_exch_link_notify(
-      struct TN_ExchLink     *exch_link
-      );
-
-enum TN_RCode _tn_exch_link_delete(
-      struct TN_ExchLink     *exch_link
-      );
-
+/**
+ * Checks whether given message buffer object is valid 
+ * (actually, just checks against `id_msgbuf` field, see `enum #TN_ObjId`)
+ */
+_TN_STATIC_INLINE TN_BOOL _tn_msgbuf_is_valid(
+      const struct TN_MsgBuf    *msgbuf
+      )
+{
+   return (msgbuf->id_msgbuf == TN_ID_MSGBUF);
+}
 
 
 
 /*******************************************************************************
- *    PROTECTED INLINE FUNCTIONS
+ *    PROTECTED FUNCTIONS
  ******************************************************************************/
 
 /**
- * Checks whether given exchange link object is valid 
- * (actually, just checks against `id_exch_link` field, see `enum #TN_ObjId`)
+ * Should be called when task finishes waiting to send the message to the
+ * message buffer. If the task leaves the wait queue without sending (timeout,
+ * wait release, termination), messages of tasks that wait after it might
+ * fit in the ring now, so they are put there.
+ *
+ * Preconditions:
+ *
+ * - `task->task_queue` is removed from the message buffer's send wait queue;
+ * - `task->pwait_queue` still points to that queue;
+ * - `task->task_wait_rc` is already set.
  */
-static inline TN_BOOL _tn_exch_link_is_valid(
-      struct TN_ExchLink   *exch_link
-      )
-{
-   return (exch_link->id_exch_link == TN_ID_EXCHANGE_LINK);
-}
+void _tn_msgbuf_on_task_wait_complete(struct TN_Task *task);
 
 
 
@@ -116,7 +113,7 @@ static inline TN_BOOL _tn_exch_link_is_valid(
 #endif
 
 
-#endif // __TN_EXCH_LINK_H
+#endif // __TN_MSGBUF_H
 
 
 /*******************************************************************************
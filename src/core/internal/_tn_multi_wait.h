@@ -0,0 +1,144 @@
+/*******************************************************************************
+ *
+ * TNeo: real-time kernel initially based on TNKernel
+ *
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
+ *
+ *    TNeo was born as a thorough review and re-implementation of
+ *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
+ *    as well as new features being added, and it is tested carefully with
+ *    unit-tests.
+ *
+ *    API is changed somewhat, so it's not 100% compatible with TNKernel,
+ *    hence the new name: TNeo.
+ *
+ *    Permission to use, copy, modify, and distribute this software in source
+ *    and binary forms and its documentation for any purpose and without fee
+ *    is hereby granted, provided that the above copyright notice appear
+ *    in all copies and that both that copyright notice and this permission
+ *    notice appear in supporting documentation.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE DMITRY FRANK AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DMITRY FRANK OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *    THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+#ifndef __TN_MULTI_WAIT_H
+#define __TN_MULTI_WAIT_H
+
+/*******************************************************************************
+ *    INCLUDED FILES
+ ******************************************************************************/
+
+#include "_tn_sys.h"
+#include "tn_multi_wait.h"
+
+
+
+
+#ifdef __cplusplus
+extern "C"  {     /*}*/
+#endif
+
+/*******************************************************************************
+ *    EXTERNAL TYPES
+ ******************************************************************************/
+
+
+
+/*******************************************************************************
+ *    PUBLIC TYPES
+ ******************************************************************************/
+
+/*******************************************************************************
+ *    PROTECTED GLOBAL DATA
+ ******************************************************************************/
+
+
+/*******************************************************************************
+ *    DEFINITIONS
+ ******************************************************************************/
+
+
+/*******************************************************************************
+ *    PROTECTED FUNCTION PROTOTYPES
+ ******************************************************************************/
+
+/**
+ * Should be called by the object (data queue, semaphore, memory pool) when
+ * it has a resource to give away (data element, signal, memory block) and
+ * there are no tasks waiting for it directly. If there is some task waiting
+ * for the object by `tn_multi_wait()`, the resource is handed to the first of
+ * them: `p_data` is stored in the `p_data` field of the item, and the task is
+ * woken up.
+ *
+ * \attention Caller must disable interrupts.
+ *
+ * @param multi_wait_list
+ *    `multi_wait_list` of the object
+ * @param p_data
+ *    Data element or memory block to give; `TN_NULL` for semaphore.
+ *
+ * @return
+ *    - `TN_TRUE` if the resource was given to some task;
+ *    - `TN_FALSE` if there are no tasks waiting by `tn_multi_wait()`, so
+ *      the object should keep the resource by itself.
+ */
+TN_BOOL _tn_multi_wait_first_complete(
+      struct TN_ListItem  *multi_wait_list,
+      void                *p_data
+      );
+
+/**
+ * Wake up the task waiting for the given item, and make `tn_multi_wait()`
+ * return `wait_rc` along with the index of this item. Items of the task are
+ * removed from all the `multi_wait_list`s then.
+ *
+ * \attention Caller must disable interrupts.
+ */
+void _tn_multi_wait_item_complete(
+      struct TN_MultiWaitItem   *item,
+      enum TN_RCode              wait_rc
+      );
+
+/**
+ * Wake up all the tasks waiting for the object by `tn_multi_wait()` with
+ * `#TN_RC_DELETED` code. Should be called when the object is deleted.
+ *
+ * \attention Caller must disable interrupts.
+ */
+void _tn_multi_wait_notify_deleted(struct TN_ListItem *multi_wait_list);
+
+/**
+ * Should be called when task that waits by `tn_multi_wait()` finishes
+ * waiting for any reason (some item fired, timeout, etc): removes all the
+ * items of the task from the `multi_wait_list`s of the objects.
+ */
+void _tn_multi_wait_on_task_wait_complete(struct TN_Task *task);
+
+
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+
+#endif // __TN_MULTI_WAIT_H
+
+
+/*******************************************************************************
+ *    end of file
+ ******************************************************************************/
+
+
@@ -71,6 +71,19 @@ extern "C"  {     /*}*/
  ******************************************************************************/
 
 
+/*******************************************************************************
+ *    PROTECTED FUNCTION PROTOTYPES
+ ******************************************************************************/
+
+/**
+ * Acquire the semaphore without waiting: decrement its count, or return
+ * `#TN_RC_TIMEOUT` if the count is 0. Used by `tn_multi_wait()`.
+ *
+ * \attention Caller must disable interrupts.
+ */
+enum TN_RCode _tn_sem_wait(struct TN_Sem *sem);
+
+
 /*******************************************************************************
  *    PROTECTED INLINE FUNCTIONS
  ******************************************************************************/
@@ -80,11 +80,34 @@ extern struct TN_Task *_tn_curr_run_task;
 /// _tn_curr_run_task, context switch is needed)
 extern struct TN_Task *_tn_next_task_to_run;
 
+/// Number of groups of priorities: each group takes one word of the bitmask
+/// of priorities with runnable tasks.
+#define _TN_READY_TO_RUN_GROUPS_CNT                                     \
+   ((TN_PRIORITIES_CNT + TN_INT_WIDTH - 1) / TN_INT_WIDTH)
+
+/// Whether two-level bitmask of priorities with runnable tasks is used
+/// (that is, whether `#TN_PRIORITIES_CNT` doesn't fit in a single word)
+#define _TN_READY_TO_RUN_BMP_2LEVEL    (_TN_READY_TO_RUN_GROUPS_CNT > 1)
+
+#if !_TN_READY_TO_RUN_BMP_2LEVEL
 /// bitmask of priorities with runnable tasks.
 /// lowest priority bit (1 << (TN_PRIORITIES_CNT - 1)) should always be set,
 /// since this priority is used by idle task which should be always runnable,
 /// by design.
 extern volatile unsigned int _tn_ready_to_run_bmp;
+#else
+/// bitmask of groups of priorities with runnable tasks: bit N is set if
+/// `_tn_ready_to_run_bmp[N]` is non-zero.
+/// The bit of the lowest-priority group should always be set, since the
+/// lowest priority is used by idle task which should be always runnable,
+/// by design.
+extern volatile unsigned int _tn_ready_to_run_grp_bmp;
+
+/// bitmasks of priorities with runnable tasks, one word per group of
+/// `#TN_INT_WIDTH` priorities: priority P is represented by the bit
+/// `(P % TN_INT_WIDTH)` of the word `(P / TN_INT_WIDTH)`.
+extern volatile unsigned int _tn_ready_to_run_bmp[ _TN_READY_TO_RUN_GROUPS_CNT ];
+#endif
 
 /// idle task structure
 extern struct TN_Task _tn_idle_task;
@@ -122,6 +145,27 @@ extern struct TN_Task _tn_idle_task;
 #define  _TN_BUG_ON(cond)     /* `TN_DEBUG` is 0, so, nothing to do here */
 #endif
 
+#if TN_CRIT_SECT_MEASURE
+//-- Critical sections of the kernel are measured (see
+//   `#TN_CRIT_SECT_MEASURE`): override macros provided by the arch, so that
+//   each kernel critical section is timestamped on entry and exit. Since the
+//   kernel code includes this header, and the application code doesn't,
+//   critical sections of the application aren't affected.
+#undef   TN_INT_DIS_SAVE
+#undef   TN_INT_RESTORE
+#undef   TN_INT_IDIS_SAVE
+#undef   TN_INT_IRESTORE
+
+#define  TN_INT_DIS_SAVE()                                              \
+   TN_INTSAVE_VAR = _tn_crit_sect_enter(__FILE__, __LINE__)
+
+#define  TN_INT_RESTORE()                                               \
+   _tn_crit_sect_exit(TN_INTSAVE_VAR, __FILE__, __LINE__)
+
+#define  TN_INT_IDIS_SAVE()      TN_INT_DIS_SAVE()
+#define  TN_INT_IRESTORE()       TN_INT_RESTORE()
+#endif
+
 
 
 
@@ -195,6 +239,77 @@ void _tn_sys_on_context_switch(
       );
 #endif
 
+#if TN_CRIT_SECT_MEASURE
+/**
+ * Disable interrupts and start measuring the critical section, if
+ * interrupts were enabled (that is, if it isn't a nested one). Used by
+ * `TN_INT_DIS_SAVE()` in the kernel code, see `#TN_CRIT_SECT_MEASURE`.
+ *
+ * @param file
+ *    Source file where critical section is entered
+ * @param line
+ *    Line where critical section is entered
+ *
+ * @return
+ *    Saved status register, as returned by `tn_arch_sr_save_int_dis()`
+ */
+TN_UWord _tn_crit_sect_enter(const char *file, int line);
+
+/**
+ * Finish measuring the critical section (if this is the outermost one),
+ * and restore saved status register. Used by `TN_INT_RESTORE()` in the
+ * kernel code, see `#TN_CRIT_SECT_MEASURE`.
+ *
+ * @param sr
+ *    Status register returned by `_tn_crit_sect_enter()`
+ * @param file
+ *    Source file where critical section is exited
+ * @param line
+ *    Line where critical section is exited
+ */
+void _tn_crit_sect_exit(TN_UWord sr, const char *file, int line);
+#endif
+
+#if TN_PROFILER
+/**
+ * Returns current profiler timestamp: the value returned by user-provided
+ * callback (see `tn_callback_profiler_timestamp_set()`), or system tick
+ * count if the callback isn't set, extended to 64 bits. The raw value is
+ * allowed to wrap around, as long as it doesn't wrap twice between
+ * consecutive calls; the function is called at every context switch and
+ * from `tn_tick_int_processing()` (and, in dynamic tick mode, by the
+ * internal timer, see `tn_callback_profiler_timestamp_set()`).
+ *
+ * Interrupts should be disabled.
+ */
+unsigned long long _tn_sys_profiler_timestamp_get(void);
+#endif
+
+#if TN_DYNAMIC_TICK
+/**
+ * $(TN_IF_ONLY_DYNAMIC_TICK_SET)
+ *
+ * Start or cancel the time slice timer, depending on whether round-robin is
+ * needed at the moment: that is, if there are more than one runnable task with
+ * the priority of `#_tn_next_task_to_run`, and time slice is set for this
+ * priority (see `tn_sys_tslice_set()`). So, the timer is active only when
+ * it is really needed, and system stays tickless otherwise.
+ *
+ * If `#_tn_next_task_to_run` is changed, the timer is restarted, so that
+ * each task gets the full time slice.
+ *
+ * It should be called whenever the set of runnable tasks or
+ * `#_tn_next_task_to_run` is changed. Interrupts should be disabled.
+ */
+void _tn_sys_tslice_manage(void);
+#else
+/*
+ * In static tick mode, round-robin is managed by `tn_tick_int_processing()`,
+ * so nothing to do here.
+ */
+_TN_STATIC_INLINE void _tn_sys_tslice_manage(void) {}
+#endif
+
 
 
 /*******************************************************************************
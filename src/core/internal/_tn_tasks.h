@@ -263,6 +263,23 @@ typedef void (_TN_CBBeforeTaskWaitComplete)(
  */
 enum TN_RCode _tn_task_activate(struct TN_Task *task);
 
+/**
+ * See the comment for tn_task_notify, tn_task_inotify in the tn_tasks.h.
+ *
+ * It modifies notification value of the task and wakes the task up if it
+ * waits for notification. Action should be already validated by caller.
+ * Used by the kernel to notify its own tasks from the places where
+ * interrupts are already disabled (such as `_tn_work_post()`, which is
+ * called from the system timer ISR, see `tn_timer_task_create()`).
+ *
+ * \attention Caller must disable interrupts.
+ */
+enum TN_RCode _tn_task_notify(
+      struct TN_Task            *task,
+      enum TN_TaskNotifyAction   action,
+      TN_UWord                   value
+      );
+
 
 /**
  * Should be called when task finishes waiting for anything.
@@ -367,6 +384,23 @@ TN_BOOL _tn_task_first_wait_complete(
       void                         *user_data_2
       );
 
+/**
+ * The same as `_tn_task_first_wait_complete()`, but the task to wake up is
+ * chosen in accordance with `wait_order`: for `#TN_WAIT_ORDER_PRIORITY`,
+ * the wait queue is walked through, and the task with the highest priority
+ * is woken up (the first one of them, if there are several). Since the
+ * queue isn't kept sorted, priority changes during the wait are handled
+ * for free.
+ */
+TN_BOOL _tn_task_ordered_wait_complete(
+      struct TN_ListItem           *wait_queue,
+      enum TN_WaitOrder             wait_order,
+      enum TN_RCode                 wait_rc,
+      _TN_CBBeforeTaskWaitComplete *callback,
+      void                         *user_data_1,
+      void                         *user_data_2
+      );
+
 
 /**
  * The same as `tn_task_exit(0)`, we need this function that takes no arguments
@@ -50,6 +50,7 @@
 
 
 #include "_tn_sys.h"
+#include "_tn_trace.h"
 
 
 
@@ -101,6 +102,18 @@ void _tn_timers_tick_proceed(TN_UWord TN_INTSAVE_VAR);
  */
 enum TN_RCode _tn_timer_start(struct TN_Timer *timer, TN_TickCnt timeout);
 
+#if TN_DYNAMIC_TICK
+/**
+ * Actual worker function that is called by `#tn_timer_start_slack()`.
+ * Interrupts should be disabled when calling it.
+ */
+enum TN_RCode _tn_timer_start_slack(
+      struct TN_Timer  *timer,
+      TN_TickCnt        timeout,
+      TN_TickCnt        slack
+      );
+#endif
+
 /**
  * Actual worker function that is called by `#tn_timer_cancel()`.
  * Interrupts should be disabled when calling it.
@@ -137,6 +150,38 @@ TN_BOOL _tn_timer_is_active(struct TN_Timer *timer);
  */
 TN_TickCnt _tn_timer_time_left(struct TN_Timer *timer);
 
+#if TN_TIMER_TASK
+/**
+ * Should be called once at system startup (from `#tn_sys_start()`).
+ * It resets the queue of timers whose callbacks are pending for the
+ * timer task.
+ */
+void _tn_timer_task_init(void);
+
+/**
+ * Called from `_tn_timer_callback_call()` when the timer fires: if the
+ * timer's callback should be called from the timer task (see
+ * `tn_timer_task_create()`), the timer is added to the queue of pending
+ * callbacks, and the timer task is woken up if needed.
+ *
+ * Interrupts should be disabled when calling it.
+ *
+ * @return
+ *    `TN_TRUE` if the callback is queued for the timer task, `TN_FALSE` if
+ *    the caller should call it right away (the timer is a kernel-internal
+ *    one, or the timer task isn't running).
+ */
+TN_BOOL _tn_timer_task_queue(struct TN_Timer *timer);
+
+/**
+ * Removes the timer from the queue of pending callbacks, if it's there.
+ * Called when the timer is cancelled or deleted.
+ *
+ * Interrupts should be disabled when calling it.
+ */
+void _tn_timer_task_dequeue(struct TN_Timer *timer);
+#endif
+
 
 
 
@@ -161,6 +206,8 @@ _TN_STATIC_INLINE TN_BOOL _tn_timer_is_valid(
  * depending on `TN_DYNAMIC_TICK` option.
  * 
  * Enables interrupts, calls callback function, disables interrupts back.
+ * If the callback should be called from the timer task instead (see
+ * `#TN_TIMER_TASK`), then just queues it for the timer task.
  * 
  * @param timer
  *    Timer to operate on
@@ -176,17 +223,27 @@ _TN_STATIC_INLINE void _tn_timer_callback_call(
    //   remember user data before enabling them, since the structure
    //   might be changed by interrupt
    void *p_user_data = timer->p_user_data;
+   TN_BOOL call_now = TN_TRUE;
+
+   _TN_TRACE(TN_TRACE_EV_TIMER_FIRE, timer, 0);
+
+#if TN_TIMER_TASK
+   //-- if the timer task is going to call the callback, we're done here
+   call_now = !_tn_timer_task_queue(timer);
+#endif
 
-   //-- before calling callback function, enable interrupts, so that
-   //   they aren't disabled for too long
-   TN_INT_IRESTORE();
+   if (call_now){
+      //-- before calling callback function, enable interrupts, so that
+      //   they aren't disabled for too long
+      TN_INT_IRESTORE();
 
-   //-- call user callback function
-   timer->func(timer, p_user_data);
+      //-- call user callback function
+      timer->func(timer, p_user_data);
 
-   //-- after callback is done, disable interrupts back
-   //   (saved value won't be used by anyone though)
-   TN_INT_IDIS_SAVE();
+      //-- after callback is done, disable interrupts back
+      //   (saved value won't be used by anyone though)
+      TN_INT_IDIS_SAVE();
+   }
 }
 
 
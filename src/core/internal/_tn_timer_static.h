@@ -62,6 +62,7 @@ extern "C"  {     /*}*/
  *    PROTECTED GLOBAL DATA
  ******************************************************************************/
 
+#if !TN_TIMER_WHEEL
 ///
 /// "generic" list of timers, for details, refer to \ref 
 /// timers_static_implementation
@@ -70,6 +71,13 @@ extern struct TN_ListItem _tn_timer_list__gen;
 /// "tick" lists of timers, for details, refer to \ref 
 /// timers_static_implementation
 extern struct TN_ListItem _tn_timer_list__tick[ TN_TICK_LISTS_CNT ];
+#else
+///
+/// Levels of the timing wheel, each of them consists of `#TN_TICK_LISTS_CNT`
+/// lists of timers; for details, refer to \ref timers_wheel_implementation
+extern struct TN_ListItem
+   _tn_timer_wheel[ TN_TIMER_WHEEL_LEVELS ][ TN_TICK_LISTS_CNT ];
+#endif
 ///
 /// system time that can be returned by `tn_sys_time_get()`; it is also used
 /// by tn_timer.h subsystem.
@@ -2,9 +2,9 @@
  *
  * TNeo: real-time kernel initially based on TNKernel
  *
- *    TNKernel:                  copyright © 2004, 2013 Yuri Tiomkin.
- *    PIC32-specific routines:   copyright © 2013, 2014 Anders Montonen.
- *    TNeo:                      copyright © 2014       Dmitry Frank.
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
  *
  *    TNeo was born as a thorough review and re-implementation of
  *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
@@ -37,22 +37,18 @@
 /**
  * \file
  *
- * Exchange link: queue (in terms of OOP, it's an "class, inherited from
- * `#TN_ExchLink`").
- *
- * For internal kernel usage only.
- *
+ * Kernel event trace recorder: internal kernel definitions.
  */
 
-
-#ifndef _TN_EXCH_LINK_QUEUE_H
-#define _TN_EXCH_LINK_QUEUE_H
+#ifndef __TN_TRACE_H
+#define __TN_TRACE_H
 
 /*******************************************************************************
  *    INCLUDED FILES
  ******************************************************************************/
 
-#include "tn_exch_link.h"
+#include "_tn_sys.h"
+#include "tn_trace.h"
 
 
 
@@ -62,60 +58,41 @@ extern "C"  {     /*}*/
 #endif
 
 /*******************************************************************************
- *    PUBLIC TYPES
+ *    PROTECTED GLOBAL DATA
  ******************************************************************************/
 
-struct TN_ExchLinkQueue;
 
+/*******************************************************************************
+ *    DEFINITIONS
+ ******************************************************************************/
 
 /**
- * Base structure for \ref tn_exch.h "exchange" link.
- *
- * For internal kernel usage only.
+ * Record the event `event` with the object `p_obj` and argument `arg` into
+ * the trace buffer, see `enum #TN_TraceEvent`. If `#TN_TRACE` is zero,
+ * it expands to nothing.
  */
-struct TN_ExchLinkQueue {
-   ///
-   /// Exchange link: in terms of OOP, it's a superclass (or base class)
-   struct TN_ExchLink super;
-   ///
-   /// A pointer to queue to send messages to.
-   struct TN_DQueue *queue;
-   ///
-   /// A pointer to fixed-memory pool to get memory from.
-   /// Note: if data size is <= `sizeof(#TN_UWord)`, `fmem` might be `TN_NULL`.
-   struct TN_FMem *fmem;
-};
-
-
+#if TN_TRACE
+#  define _TN_TRACE(event, p_obj, arg)                      \
+      _tn_trace_rec((event), (const void *)(p_obj), (int)(arg))
+#else
+#  define _TN_TRACE(event, p_obj, arg)
+#endif
 
-/*******************************************************************************
- *    GLOBAL VARIABLES
- ******************************************************************************/
 
-/*******************************************************************************
- *    DEFINITIONS
- ******************************************************************************/
 
 /*******************************************************************************
- *    PUBLIC FUNCTION PROTOTYPES
+ *    PROTECTED FUNCTION PROTOTYPES
  ******************************************************************************/
 
-enum TN_RCode tn_exch_link_queue_create(
-      struct TN_ExchLinkQueue   *exch_link_queue,
-      struct TN_DQueue          *queue,
-      struct TN_FMem            *fmem
-      );
-
-enum TN_RCode tn_exch_link_queue_delete(
-      struct TN_ExchLinkQueue   *exch_link_queue
-      );
-
-static inline struct TN_ExchLink *tn_exch_link_queue_base_get(
-      struct TN_ExchLinkQueue   *exch_link_queue
-      )
-{
-   return &exch_link_queue->super;
-}
+#if TN_TRACE
+/**
+ * Store the record in the trace buffer, if recording is active. Can be called
+ * from any context, with interrupts enabled or disabled: interrupts are
+ * disabled inside for a short time. Use `_TN_TRACE()` macro instead of
+ * calling this function directly.
+ */
+void _tn_trace_rec(enum TN_TraceEvent event, const void *p_obj, int arg);
+#endif
 
 
 
@@ -123,7 +100,9 @@ static inline struct TN_ExchLink *tn_exch_link_queue_base_get(
 }  /* extern "C" */
 #endif
 
-#endif // _TN_EXCH_LINK_QUEUE_H
+
+#endif // __TN_TRACE_H
+
 
 /*******************************************************************************
  *    end of file
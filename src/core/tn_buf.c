@@ -0,0 +1,393 @@
+/*******************************************************************************
+ *
+ * TNeo: real-time kernel initially based on TNKernel
+ *
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
+ *
+ *    TNeo was born as a thorough review and re-implementation of
+ *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
+ *    as well as new features being added, and it is tested carefully with
+ *    unit-tests.
+ *
+ *    API is changed somewhat, so it's not 100% compatible with TNKernel,
+ *    hence the new name: TNeo.
+ *
+ *    Permission to use, copy, modify, and distribute this software in source
+ *    and binary forms and its documentation for any purpose and without fee
+ *    is hereby granted, provided that the above copyright notice appear
+ *    in all copies and that both that copyright notice and this permission
+ *    notice appear in supporting documentation.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE DMITRY FRANK AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DMITRY FRANK OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *    THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+/*******************************************************************************
+ *    INCLUDED FILES
+ ******************************************************************************/
+
+#include "tn_common.h"
+#include "tn_sys.h"
+
+//-- internal tnkernel headers
+#include "_tn_sys.h"
+#include "_tn_fmem.h"
+#include "_tn_trace.h"
+
+
+#include "tn_buf.h"
+#include "_tn_buf.h"
+
+#include "tn_tasks.h"
+
+
+
+/*******************************************************************************
+ *    DEFINITIONS
+ ******************************************************************************/
+
+//-- Lock-free reference counting is available if only the architecture
+//   provides exclusive access primitives, see `_TN_EXCL_LOAD()` and friends,
+//   and `int` is as wide as the word they work with.
+#if defined(_TN_EXCL_LOAD) && !defined(_TN_EXCL_INT_UNSUPPORTED)
+#  define _TN_BUF_FAST_PATH      1
+//-- `ref_cnt` field of the buffer as a word, for the exclusive access
+#  define _ref_cnt_word(buf)     ((volatile TN_UWord *)&((buf)->ref_cnt))
+#else
+#  define _TN_BUF_FAST_PATH      0
+#endif
+
+
+
+
+/*******************************************************************************
+ *    PRIVATE FUNCTIONS
+ ******************************************************************************/
+
+//-- Additional param checking {{{
+#if TN_CHECK_PARAM
+_TN_STATIC_INLINE enum TN_RCode _check_param_generic(
+      const struct TN_Buf *buf
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   if (buf == TN_NULL){
+      rc = TN_RC_WPARAM;
+   } else if (!_tn_buf_is_valid(buf)){
+      rc = TN_RC_INVALID_OBJ;
+   }
+
+   return rc;
+}
+
+_TN_STATIC_INLINE enum TN_RCode _check_param_alloc(
+      const struct TN_FMem *fmem,
+      struct TN_Buf **p_buf
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   if (fmem == TN_NULL || p_buf == TN_NULL){
+      rc = TN_RC_WPARAM;
+   } else if (!_tn_fmem_is_valid(fmem)){
+      rc = TN_RC_INVALID_OBJ;
+   } else if (fmem->block_size < TN_BUF_HEADER_SIZE){
+      rc = TN_RC_WPARAM;
+   }
+
+   return rc;
+}
+
+#else
+#  define _check_param_generic(buf)                (TN_RC_OK)
+#  define _check_param_alloc(fmem, p_buf)          (TN_RC_OK)
+#endif
+// }}}
+
+/**
+ * Initialize freshly allocated memory block as a buffer.
+ */
+_TN_STATIC_INLINE void _buf_init(struct TN_FMem *fmem, struct TN_Buf *buf)
+{
+   buf->fmem      = fmem;
+   buf->next      = TN_NULL;
+   buf->ref_cnt   = 1;
+   buf->len       = 0;
+   buf->id_buf    = TN_ID_BUF;
+}
+
+#if _TN_BUF_FAST_PATH
+/**
+ * Lock-free increment of the reference count.
+ *
+ * The processor clears the exclusive monitor on exception entry and exit,
+ * so if some ISR or another task has touched the count after the load, the
+ * store fails, and we try again.
+ */
+_TN_STATIC_INLINE void _buf_ref_cnt_inc(struct TN_Buf *buf)
+{
+   for (;;){
+      int ref_cnt = (int)_TN_EXCL_LOAD(_ref_cnt_word(buf));
+
+      if (_TN_EXCL_STORE(_ref_cnt_word(buf), (TN_UWord)(ref_cnt + 1))){
+         break;
+      } else {
+         //-- some exception has happened after the load: try again
+      }
+   }
+}
+
+/**
+ * Lock-free fast path of unreferencing: if the buffer is referenced by
+ * somebody else, decrement the count without disabling interrupts.
+ *
+ * @returns `TN_TRUE` if the count is decremented, `TN_FALSE` if the buffer
+ *          should be freed, so the slow path should be taken.
+ */
+_TN_STATIC_INLINE TN_BOOL _buf_fast_unref(struct TN_Buf *buf)
+{
+   TN_BOOL ret = TN_FALSE;
+
+   for (;;){
+      int ref_cnt = (int)_TN_EXCL_LOAD(_ref_cnt_word(buf));
+
+      if (ref_cnt <= 1){
+         //-- we hold the last reference: leave it for the slow path
+         _TN_EXCL_CLEAR();
+         break;
+      } else if (_TN_EXCL_STORE(_ref_cnt_word(buf), (TN_UWord)(ref_cnt - 1))){
+         ret = TN_TRUE;
+         break;
+      } else {
+         //-- some exception has happened after the load: try again
+      }
+   }
+
+   return ret;
+}
+
+#else
+
+_TN_STATIC_INLINE void _buf_ref_cnt_inc(struct TN_Buf *buf)
+{
+   TN_INTSAVE_DATA;
+
+   TN_INT_DIS_SAVE();
+   buf->ref_cnt++;
+   TN_INT_RESTORE();
+}
+
+_TN_STATIC_INLINE TN_BOOL _buf_fast_unref(struct TN_Buf *buf)
+{
+   _TN_UNUSED(buf);
+   return TN_FALSE;
+}
+
+#endif
+
+/**
+ * Decrement reference count of the buffer, and if it reaches zero, return
+ * the buffer to its pool, and proceed to the next buffer in the chain.
+ *
+ * Interrupts should be disabled when this function is called.
+ */
+static enum TN_RCode _buf_unref(struct TN_Buf *buf)
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   while (buf != TN_NULL && rc == TN_RC_OK){
+      struct TN_Buf *next = buf->next;
+
+      buf->ref_cnt--;
+      if (buf->ref_cnt > 0){
+         //-- buffer is still referenced by somebody else, so the rest of the
+         //   chain is kept as well
+         break;
+      }
+
+      //-- the last reference is gone: free the buffer. If some task waits
+      //   for free block in the pool, the block is given to it right away.
+      buf->id_buf = TN_ID_NONE;
+      rc = _tn_fmem_release(buf->fmem, buf);
+
+      //-- the buffer held a reference to the next one in the chain
+      buf = next;
+   }
+
+   return rc;
+}
+
+
+
+
+/*******************************************************************************
+ *    PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+/*
+ * See comments in the header file (tn_buf.h)
+ */
+enum TN_RCode tn_buf_alloc(
+      struct TN_FMem   *fmem,
+      struct TN_Buf   **p_buf,
+      TN_TickCnt        timeout
+      )
+{
+   void *p_data = TN_NULL;
+   enum TN_RCode rc = _check_param_alloc(fmem, p_buf);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else {
+      rc = tn_fmem_get(fmem, &p_data, timeout);
+      if (rc == TN_RC_OK){
+         //-- nobody else knows about the block yet, so we don't need
+         //   to disable interrupts here
+         _buf_init(fmem, (struct TN_Buf *)p_data);
+         *p_buf = (struct TN_Buf *)p_data;
+      }
+   }
+
+   _TN_TRACE(TN_TRACE_EV_BUF_ALLOC, p_data, rc);
+   return rc;
+}
+
+
+/*
+ * See comments in the header file (tn_buf.h)
+ */
+enum TN_RCode tn_buf_ialloc(
+      struct TN_FMem   *fmem,
+      struct TN_Buf   **p_buf
+      )
+{
+   void *p_data = TN_NULL;
+   enum TN_RCode rc = _check_param_alloc(fmem, p_buf);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else {
+      rc = tn_fmem_iget_polling(fmem, &p_data);
+      if (rc == TN_RC_OK){
+         _buf_init(fmem, (struct TN_Buf *)p_data);
+         *p_buf = (struct TN_Buf *)p_data;
+      }
+   }
+
+   _TN_TRACE(TN_TRACE_EV_BUF_ALLOC, p_data, rc);
+   return rc;
+}
+
+
+/*
+ * See comments in the header file (tn_buf.h)
+ */
+enum TN_RCode tn_buf_ref(struct TN_Buf *buf)
+{
+   enum TN_RCode rc = _check_param_generic(buf);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else {
+      _buf_ref_cnt_inc(buf);
+   }
+
+   _TN_TRACE(TN_TRACE_EV_BUF_REF, buf, rc);
+   return rc;
+}
+
+
+/*
+ * See comments in the header file (tn_buf.h)
+ */
+enum TN_RCode tn_buf_unref(struct TN_Buf *buf)
+{
+   enum TN_RCode rc = _check_param_generic(buf);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_task_context()){
+      rc = TN_RC_WCONTEXT;
+   } else if (_buf_fast_unref(buf)){
+      //-- buffer is still referenced by somebody else, nothing to free
+   } else {
+      TN_INTSAVE_DATA;
+
+      TN_INT_DIS_SAVE();
+
+      rc = _buf_unref(buf);
+
+      TN_INT_RESTORE();
+      _tn_context_switch_pend_if_needed();
+   }
+
+   _TN_TRACE(TN_TRACE_EV_BUF_UNREF, buf, rc);
+   return rc;
+}
+
+
+/*
+ * See comments in the header file (tn_buf.h)
+ */
+enum TN_RCode tn_buf_iunref(struct TN_Buf *buf)
+{
+   enum TN_RCode rc = _check_param_generic(buf);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_isr_context()){
+      rc = TN_RC_WCONTEXT;
+   } else if (_buf_fast_unref(buf)){
+      //-- buffer is still referenced by somebody else, nothing to free
+   } else {
+      TN_INTSAVE_DATA_INT;
+
+      TN_INT_IDIS_SAVE();
+
+      rc = _buf_unref(buf);
+
+      TN_INT_IRESTORE();
+      _TN_CONTEXT_SWITCH_IPEND_IF_NEEDED();
+   }
+
+   _TN_TRACE(TN_TRACE_EV_BUF_UNREF, buf, rc);
+   return rc;
+}
+
+
+/*
+ * See comments in the header file (tn_buf.h)
+ */
+enum TN_RCode tn_buf_chain(struct TN_Buf *buf, struct TN_Buf *tail)
+{
+   enum TN_RCode rc = _check_param_generic(buf);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if ((rc = _check_param_generic(tail)) != TN_RC_OK){
+      //-- just return rc as it is
+   } else {
+      //-- find the last buffer in the chain
+      while (buf->next != TN_NULL){
+         buf = buf->next;
+      }
+
+      buf->next = tail;
+   }
+
+   return rc;
+}
+
+
@@ -0,0 +1,346 @@
+/*******************************************************************************
+ *
+ * TNeo: real-time kernel initially based on TNKernel
+ *
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
+ *
+ *    TNeo was born as a thorough review and re-implementation of
+ *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
+ *    as well as new features being added, and it is tested carefully with
+ *    unit-tests.
+ *
+ *    API is changed somewhat, so it's not 100% compatible with TNKernel,
+ *    hence the new name: TNeo.
+ *
+ *    Permission to use, copy, modify, and distribute this software in source
+ *    and binary forms and its documentation for any purpose and without fee
+ *    is hereby granted, provided that the above copyright notice appear
+ *    in all copies and that both that copyright notice and this permission
+ *    notice appear in supporting documentation.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE DMITRY FRANK AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DMITRY FRANK OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *    THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+/**
+ * \file
+ *
+ * Reference-counted buffers: zero-copy sharing of data between tasks.
+ *
+ * Buffer is a memory block taken from the \ref tn_fmem.h "fixed memory pool"
+ * with the small descriptor (`struct #TN_Buf`) at the beginning; user data
+ * follows the descriptor, see `tn_buf_data()`. The buffer has a reference
+ * count: it is allocated by `tn_buf_alloc()` with the count of 1, each
+ * `tn_buf_ref()` increments the count, and each `tn_buf_unref()` decrements
+ * it. When the count reaches zero, the block is returned to its pool.
+ *
+ * So, in order to pass the same data to several consumers (say, through
+ * \ref tn_dqueue.h "data queues"), the producer doesn't need to copy it: it
+ * calls `tn_buf_ref()` once per additional consumer, and sends the pointer
+ * to the buffer to each of them. Each consumer calls `tn_buf_unref()` when it
+ * is done with the data, and the last one frees the buffer.
+ *
+ * Reference count is changed atomically: if the architecture provides
+ * exclusive access instructions (currently, `LDREX` / `STREX` on
+ * Cortex-M3/M4/M4F), it is done without disabling interrupts (unless the
+ * buffer is to be freed); otherwise, interrupts are disabled for a few
+ * instructions.
+ *
+ * Buffers can be chained by `tn_buf_chain()`: this is useful for
+ * scatter/gather, e.g. to prepend a header to the payload without copying.
+ * The chain holds a reference to each of its buffers, so, when the
+ * first buffer of the chain is freed, the next one is unreferenced, and so
+ * on. Since each buffer has its own reference count, the same payload can be
+ * shared by several chains: just call `tn_buf_ref()` for the payload before
+ * chaining it to the second header.
+ *
+ * Typical usage:
+ *
+ * \code{.c}
+ *     //-- pool of 16 buffers with 256 bytes of data each
+ *     TN_FMEM_BUF_DEF(
+ *           pkt_pool_buf, TN_UWord[ TN_BUF_BLOCK_SIZE(256) / sizeof(TN_UWord) ],
+ *           16
+ *           );
+ *     static struct TN_FMem pkt_pool;
+ *
+ *     void some_init(void)
+ *     {
+ *        tn_fmem_create(
+ *              &pkt_pool, pkt_pool_buf, TN_BUF_BLOCK_SIZE(256), 16
+ *              );
+ *     }
+ *
+ *     void producer_task_body(void *param)
+ *     {
+ *        struct TN_Buf *pkt;
+ *
+ *        tn_buf_alloc(&pkt_pool, &pkt, TN_WAIT_INFINITE);
+ *        pkt->len = receive_packet(tn_buf_data(pkt), tn_buf_capacity(pkt));
+ *
+ *        //-- two consumers: one more reference is needed
+ *        tn_buf_ref(pkt);
+ *        tn_queue_send(&consumer_1_queue, pkt, TN_WAIT_INFINITE);
+ *        tn_queue_send(&consumer_2_queue, pkt, TN_WAIT_INFINITE);
+ *     }
+ *
+ *     void consumer_task_body(void *param)
+ *     {
+ *        struct TN_Buf *pkt;
+ *
+ *        tn_queue_receive(&consumer_1_queue, (void **)&pkt, TN_WAIT_INFINITE);
+ *        //-- use tn_buf_data(pkt) ...
+ *        tn_buf_unref(pkt);
+ *     }
+ * \endcode
+ *
+ */
+
+#ifndef _TN_BUF_H
+#define _TN_BUF_H
+
+/*******************************************************************************
+ *    INCLUDED FILES
+ ******************************************************************************/
+
+#include "tn_common.h"
+#include "tn_fmem.h"
+
+
+
+#ifdef __cplusplus
+extern "C"  {  /*}*/
+#endif
+
+/*******************************************************************************
+ *    PUBLIC TYPES
+ ******************************************************************************/
+
+/**
+ * Buffer descriptor, located at the beginning of the memory block of the
+ * buffer. User data follows it, see `tn_buf_data()`.
+ */
+struct TN_Buf {
+   ///
+   /// id for object validity verification.
+   /// This field is in the beginning of the structure to make it easier
+   /// to detect memory corruption.
+   enum TN_ObjId     id_buf;
+   ///
+   /// memory pool from which the buffer was allocated
+   struct TN_FMem   *fmem;
+   ///
+   /// next buffer in the chain, or `#TN_NULL`. See `tn_buf_chain()`.
+   struct TN_Buf    *next;
+   ///
+   /// reference count. Don't touch it directly: use `tn_buf_ref()` and
+   /// `tn_buf_unref()`.
+   int               ref_cnt;
+   ///
+   /// length of valid data in the buffer, in bytes. It is set to 0 by
+   /// `tn_buf_alloc()`, and then maintained by the application; the kernel
+   /// doesn't use it.
+   unsigned int      len;
+};
+
+
+
+
+/*******************************************************************************
+ *    DEFINITIONS
+ ******************************************************************************/
+
+/**
+ * Size of the buffer descriptor, rounded up to the size of `#TN_UWord`:
+ * user data of the buffer starts at this offset from the beginning of the
+ * memory block.
+ */
+#define TN_BUF_HEADER_SIZE                                        \
+   (TN_MAKE_ALIG_SIZE(sizeof(struct TN_Buf)))
+
+/**
+ * Block size of the memory pool for buffers which should be able to hold
+ * `data_size` bytes of data. See typical usage example in the
+ * \ref tn_buf.h "file description".
+ */
+#define TN_BUF_BLOCK_SIZE(data_size)                              \
+   (TN_BUF_HEADER_SIZE + TN_MAKE_ALIG_SIZE(data_size))
+
+
+
+
+/*******************************************************************************
+ *    PUBLIC FUNCTION PROTOTYPES
+ ******************************************************************************/
+
+/**
+ * Allocate buffer from the given memory pool. The buffer's reference count
+ * is set to 1, `len` is set to 0, and it isn't chained to any other buffer.
+ * If there is no free block in the pool, behavior depends on `timeout`
+ * value: refer to `#TN_TickCnt`.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_CAN_SLEEP)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param fmem
+ *    Memory pool to allocate buffer from. Its block size should be at least
+ *    `#TN_BUF_HEADER_SIZE`, see `TN_BUF_BLOCK_SIZE()`.
+ * @param p_buf
+ *    Address of the `(struct TN_Buf *)` to which the allocated buffer will
+ *    be saved
+ * @param timeout
+ *    Refer to `#TN_TickCnt`
+ *
+ * @return
+ *    * `#TN_RC_OK` if buffer was successfully allocated;
+ *    * `#TN_RC_WCONTEXT` if called from wrong context;
+ *    * Other possible return codes depend on `timeout` value,
+ *      refer to `#TN_TickCnt`
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_buf_alloc(
+      struct TN_FMem   *fmem,
+      struct TN_Buf   **p_buf,
+      TN_TickCnt        timeout
+      );
+
+/**
+ * The same as `tn_buf_alloc()` with zero timeout, but for using in the ISR.
+ *
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ */
+enum TN_RCode tn_buf_ialloc(
+      struct TN_FMem   *fmem,
+      struct TN_Buf   **p_buf
+      );
+
+/**
+ * Increment reference count of the buffer. Only the given buffer is
+ * affected, not the rest of its chain: the chain is kept alive by the
+ * reference of its first buffer.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param buf
+ *    Buffer to reference
+ *
+ * @return
+ *    * `#TN_RC_OK` on success;
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_buf_ref(struct TN_Buf *buf);
+
+/**
+ * Decrement reference count of the buffer. If it reaches zero, the buffer is
+ * returned to its memory pool (and given to the task which waits for free
+ * block in that pool, if any), and the next buffer in the chain (if any)
+ * is unreferenced in the same way.
+ *
+ * After the call, the caller shouldn't touch the buffer anymore.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param buf
+ *    Buffer to unreference
+ *
+ * @return
+ *    * `#TN_RC_OK` on success;
+ *    * `#TN_RC_OVERFLOW` if the memory pool of some freed buffer already has
+ *      all its blocks free: this may never happen in normal program
+ *      execution;
+ *    * `#TN_RC_WCONTEXT` if called from wrong context;
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_buf_unref(struct TN_Buf *buf);
+
+/**
+ * The same as `tn_buf_unref()`, but for using in the ISR.
+ *
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ */
+enum TN_RCode tn_buf_iunref(struct TN_Buf *buf);
+
+/**
+ * Append the buffer (or the chain of buffers) `tail` to the end of the chain
+ * which starts from `buf`. The chain takes over the caller's reference to
+ * `tail`: if the caller needs to keep using `tail` on its own, it should call
+ * `tn_buf_ref()` for it first.
+ *
+ * The chain isn't protected from concurrent modifications, so it should be
+ * built before the buffer is shared with other tasks.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param buf
+ *    First buffer of the chain
+ * @param tail
+ *    Buffer to append
+ *
+ * @return
+ *    * `#TN_RC_OK` on success;
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_buf_chain(struct TN_Buf *buf, struct TN_Buf *tail);
+
+/**
+ * Returns pointer to the data of the buffer.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ */
+_TN_STATIC_INLINE void *tn_buf_data(struct TN_Buf *buf)
+{
+   return (unsigned char *)buf + TN_BUF_HEADER_SIZE;
+}
+
+/**
+ * Returns how many bytes of data the buffer can hold, which depends on the
+ * block size of its memory pool.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ */
+_TN_STATIC_INLINE unsigned int tn_buf_capacity(const struct TN_Buf *buf)
+{
+   return buf->fmem->block_size - TN_BUF_HEADER_SIZE;
+}
+
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif // _TN_BUF_H
+
+/*******************************************************************************
+ *    end of file
+ ******************************************************************************/
@@ -117,10 +117,30 @@
 #  endif
 #endif
 
+#if !defined(TN_USE_EXCH)
+#  error TN_USE_EXCH is not defined
+#endif
+
+#if !defined(TN_USE_MULTI_WAIT)
+#  error TN_USE_MULTI_WAIT is not defined
+#endif
+
 #if !defined(TN_TICK_LISTS_CNT)
 #  error TN_TICK_LISTS_CNT is not defined
 #endif
 
+#if !defined(TN_TIMER_WHEEL)
+#  error TN_TIMER_WHEEL is not defined
+#endif
+
+#if !defined(TN_TIMER_WHEEL_LEVELS)
+#  error TN_TIMER_WHEEL_LEVELS is not defined
+#endif
+
+#if !defined(TN_TIMER_TASK)
+#  error TN_TIMER_TASK is not defined
+#endif
+
 #if !defined(TN_API_MAKE_ALIG_ARG)
 #  error TN_API_MAKE_ALIG_ARG is not defined
 #endif
@@ -133,6 +153,14 @@
 #  error TN_PROFILER_WAIT_TIME is not defined
 #endif
 
+#if !defined(TN_TRACE)
+#  error TN_TRACE is not defined
+#endif
+
+#if !defined(TN_CRIT_SECT_MEASURE)
+#  error TN_CRIT_SECT_MEASURE is not defined
+#endif
+
 #if !defined(TN_INIT_INTERRUPT_STACK_SPACE)
 #  error TN_INIT_INTERRUPT_STACK_SPACE is not defined
 #endif
@@ -178,7 +206,9 @@
 #  endif
 #endif
 
-//-- NOTE: TN_TICK_LISTS_CNT is checked in tn_timer_static.c
+//-- NOTE: TN_TICK_LISTS_CNT is checked in tn_timer_static.c and
+//         tn_timer_wheel.c
+//-- NOTE: TN_TIMER_WHEEL_LEVELS is checked in tn_timer_wheel.c
 //-- NOTE: TN_PRIORITIES_CNT is checked in tn_sys.c
 //-- NOTE: TN_API_MAKE_ALIG_ARG is checked in tn_common.h
 
@@ -187,7 +217,7 @@
  * Internal kernel definition: set to non-zero if `_tn_sys_on_context_switch()`
  * should be called on context switch. 
  */
-#if TN_PROFILER || TN_STACK_OVERFLOW_CHECK
+#if TN_PROFILER || TN_STACK_OVERFLOW_CHECK || TN_TRACE
 #  define   _TN_ON_CONTEXT_SWITCH_HANDLER  1
 #else
 #  define   _TN_ON_CONTEXT_SWITCH_HANDLER  0
@@ -73,6 +73,29 @@ enum TN_ObjId {
    TN_ID_TIMER          = (int)0x1A937FBC,  //!< id for timers
    TN_ID_EXCHANGE       = (int)0x32b7c072,  //!< id for exchange objects
    TN_ID_EXCHANGE_LINK  = (int)0x24d36f35,  //!< id for exchange link
+   TN_ID_MSGBUF         = (int)0x5b3e91d7,  //!< id for message buffers
+   TN_ID_WORKQ          = (int)0x3c1f5a9d,  //!< id for work queues
+   TN_ID_FMEM_MULTI     = (int)0x4d2e8b13,  //!< id for multi-size pools
+   TN_ID_HEAP           = (int)0x61c5d3a7,  //!< id for heaps
+   TN_ID_BUF            = (int)0x7e5a2c31,  //!< id for buffers
+};
+
+/**
+ * Order in which the tasks waiting for the object are served, see
+ * `tn_sem_create_wattr()`, `tn_queue_create_wattr()` and
+ * `tn_fmem_create_wattr()`.
+ */
+enum TN_WaitOrder {
+   ///
+   /// Tasks are served in the order they have started waiting, no matter
+   /// of their priorities. This is the default.
+   TN_WAIT_ORDER_FIFO      = 0,
+   ///
+   /// The task with the highest priority is served first (tasks with the
+   /// same priority are served in FIFO order). Priority is checked when the
+   /// task is about to be woken up, so, if it has changed during the wait
+   /// (say, because of mutex priority inheritance), the new one is used.
+   TN_WAIT_ORDER_PRIORITY  = 1,
 };
 
 /**
@@ -89,9 +112,12 @@ enum TN_RCode {
    ///
    /// This code is returned in the following cases:
    ///   * Trying to increment semaphore count more than its max count;
-   ///   * Trying to return extra memory block to fixed memory pool.
+   ///   * Trying to return extra memory block to fixed memory pool;
+   ///   * Trying to send a message which can't fit in the message buffer,
+   ///     or to receive a message into too small user's buffer.
    /// @see tn_sem.h
    /// @see tn_fmem.h
+   /// @see tn_msgbuf.h
    TN_RC_OVERFLOW             =  -2,
    ///
    /// Wrong context error: returned if function is called from 
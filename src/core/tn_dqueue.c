@@ -46,6 +46,8 @@
 #include "_tn_eventgrp.h"
 #include "_tn_tasks.h"
 #include "_tn_list.h"
+#include "_tn_trace.h"
+#include "_tn_multi_wait.h"
 
 
 #include "tn_dqueue.h"
@@ -95,7 +97,8 @@ _TN_STATIC_INLINE enum TN_RCode _check_param_generic(
 _TN_STATIC_INLINE enum TN_RCode _check_param_create(
       const struct TN_DQueue *dque,
       void **data_fifo,
-      int items_cnt
+      int items_cnt,
+      enum TN_WaitOrder wait_order
       )
 {
    enum TN_RCode rc = TN_RC_OK;
@@ -104,6 +107,10 @@ _TN_STATIC_INLINE enum TN_RCode _check_param_create(
       rc = TN_RC_WPARAM;
    } else if (items_cnt < 0 || _tn_dqueue_is_valid(dque)){
       rc = TN_RC_WPARAM;
+   } else if (    wait_order != TN_WAIT_ORDER_FIFO
+               && wait_order != TN_WAIT_ORDER_PRIORITY)
+   {
+      rc = TN_RC_WPARAM;
    }
 
    _TN_UNUSED(data_fifo);
@@ -118,10 +125,22 @@ _TN_STATIC_INLINE enum TN_RCode _check_param_read(
    return (pp_data == TN_NULL) ? TN_RC_WPARAM : TN_RC_OK;
 }
 
+_TN_STATIC_INLINE enum TN_RCode _check_param_multi(
+      void *const *p_data_arr,
+      int items_cnt
+      )
+{
+   return (p_data_arr == TN_NULL || items_cnt <= 0)
+      ? TN_RC_WPARAM
+      : TN_RC_OK;
+}
+
 #else
 #  define _check_param_generic(dque)                        (TN_RC_OK)
-#  define _check_param_create(dque, data_fifo, items_cnt)   (TN_RC_OK)
+#  define _check_param_create(dque, data_fifo, items_cnt, wait_order)    \
+                                                            (TN_RC_OK)
 #  define _check_param_read(pp_data)                        (TN_RC_OK)
+#  define _check_param_multi(p_data_arr, items_cnt)        (TN_RC_OK)
 #endif
 // }}}
 
@@ -209,7 +228,7 @@ static enum TN_RCode _fifo_read(struct TN_DQueue *dque, void **pp_data)
 // }}}
 
 /**
- * Callback function that is given to `_tn_task_first_wait_complete()`
+ * Callback function that is given to `_tn_task_ordered_wait_complete()`
  * when task finishes waiting for new messages in the queue.
  *
  * See `#_TN_CBBeforeTaskWaitComplete` for details on function signature.
@@ -226,7 +245,7 @@ static void _cb_before_task_wait_complete__send(
 }
 
 /**
- * Callback function that is given to `_tn_task_first_wait_complete()`
+ * Callback function that is given to `_tn_task_ordered_wait_complete()`
  * when task finishes waiting for free item in the queue.
  *
  * See `#_TN_CBBeforeTaskWaitComplete` for details on function signature.
@@ -248,7 +267,7 @@ static void _cb_before_task_wait_complete__receive_ok(
 }
 
 /**
- * Callback function that is given to `_tn_task_first_wait_complete()`
+ * Callback function that is given to `_tn_task_ordered_wait_complete()`
  * when `items_cnt` is 0.
  *
  * See `#_TN_CBBeforeTaskWaitComplete` for details on function signature.
@@ -277,9 +296,9 @@ static void _cb_before_task_wait_complete__receive_timeout(
  * - `tn_queue_isend_polling()`
  *
  *
- * First of all, it checks whether there are tasks that wait for new data. If
- * so, the data is given to that task, and task is woken up. FIFO stays
- * untouched.
+ * First of all, it checks whether there are tasks that wait for new data
+ * (directly or by `tn_multi_wait()`). If so, the data is given to that task,
+ * and task is woken up. FIFO stays untouched.
  *
  * Otherwise, it calls `_fifo_write()` which tries to put data to the FIFO.
  * If there is a room in the FIFO, data is written, and `#TN_RC_OK` is
@@ -307,12 +326,18 @@ static enum TN_RCode _queue_send(
    //   from the waiting tasks list, and don't modify messages
    //   fifo at all.
    //
+   //   Then, the same is done for tasks that wait by `tn_multi_wait()`.
+   //
    //   Otherwise (no waiting tasks), we add new message to the fifo.
 
-   if (  !_tn_task_first_wait_complete(
-            &dque->wait_receive_list, TN_RC_OK,
+   if (  !_tn_task_ordered_wait_complete(
+            &dque->wait_receive_list, dque->wait_order,
+            TN_RC_OK,
             _cb_before_task_wait_complete__send, p_data, TN_NULL
             )
+#if TN_USE_MULTI_WAIT
+         && !_tn_multi_wait_first_complete(&dque->multi_wait_list, p_data)
+#endif
       )
    {
       //-- the data queue's wait_receive list is empty
@@ -361,8 +386,9 @@ static enum TN_RCode _queue_receive(
          //-- successfully read item from the queue.
          //   if there are tasks that wait to send data to the queue,
          //   wake the first one up, since there is room now.
-         _tn_task_first_wait_complete(
-               &dque->wait_send_list, TN_RC_OK,
+         _tn_task_ordered_wait_complete(
+               &dque->wait_send_list, dque->wait_order,
+               TN_RC_OK,
                _cb_before_task_wait_complete__receive_ok, dque, TN_NULL
                );
          break;
@@ -371,8 +397,9 @@ static enum TN_RCode _queue_receive(
          //-- nothing to read from the queue.
          //   Let's check whether some task wants to send data
          //   (that might happen if only dque->items_cnt is 0)
-         if (  _tn_task_first_wait_complete(
-                  &dque->wait_send_list, TN_RC_OK,
+         if (  _tn_task_ordered_wait_complete(
+                  &dque->wait_send_list, dque->wait_order,
+                  TN_RC_OK,
                   _cb_before_task_wait_complete__receive_timeout, pp_data, TN_NULL
                   )
             )
@@ -399,12 +426,104 @@ static enum TN_RCode _queue_receive(
 }
 
 
+/**
+ * Calls `_queue_send()` for each item of `p_data_arr` until it fails
+ * (there's no room in the queue) or all items are sent.
+ *
+ * @param dque
+ *    Data queue in which data should be written
+ * @param p_data_arr
+ *    Array of data items to write
+ * @param items_cnt
+ *    Number of items in `p_data_arr`
+ * @param p_done_cnt
+ *    Pointer to the place at which the number of sent items is stored
+ *
+ * @return
+ *    `#TN_RC_OK` if at least one item was sent; otherwise, the value
+ *    returned by `_queue_send()`.
+ */
+static enum TN_RCode _queue_send_multi(
+      struct TN_DQueue *dque,
+      void *const *p_data_arr,
+      int items_cnt,
+      int *p_done_cnt
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+   int done_cnt = 0;
+
+   while (done_cnt < items_cnt){
+      rc = _queue_send(dque, p_data_arr[done_cnt]);
+      if (rc != TN_RC_OK){
+         break;
+      }
+      done_cnt++;
+   }
+
+   if (done_cnt > 0){
+      rc = TN_RC_OK;
+   }
+
+   *p_done_cnt = done_cnt;
+   return rc;
+}
+
+/**
+ * Calls `_queue_receive()` for each item of `p_data_arr` until it fails
+ * (the queue is empty) or all items are received.
+ *
+ * @param dque
+ *    Data queue from which data should be read
+ * @param p_data_arr
+ *    Array at which data items should be read
+ * @param items_cnt
+ *    Number of items in `p_data_arr`
+ * @param p_done_cnt
+ *    Pointer to the place at which the number of received items is stored
+ *
+ * @return
+ *    `#TN_RC_OK` if at least one item was received; otherwise, the value
+ *    returned by `_queue_receive()`.
+ */
+static enum TN_RCode _queue_receive_multi(
+      struct TN_DQueue *dque,
+      void **p_data_arr,
+      int items_cnt,
+      int *p_done_cnt
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+   int done_cnt = 0;
+
+   while (done_cnt < items_cnt){
+      rc = _queue_receive(dque, &p_data_arr[done_cnt]);
+      if (rc != TN_RC_OK){
+         break;
+      }
+      done_cnt++;
+   }
+
+   if (done_cnt > 0){
+      rc = TN_RC_OK;
+   }
+
+   *p_done_cnt = done_cnt;
+   return rc;
+}
+
+
 /**
  * Intermediary function that is called by queue-related services
  * (`tn_queue_send()`, `tn_queue_receive()`, etc), which performs all necessary
  * housekeeping and eventually calls actual worker function depending on given
  * `job_type`.
  *
+ * Single-item services are handled as transfer of the array of 1 item.
+ * All the items are transferred in one critical section. If no items can be
+ * transferred at all, then, depending on `timeout`, the task waits to
+ * transfer the first item.
+ *
  *
  * $(TN_CALL_FROM_TASK)
  * $(TN_CAN_SWITCH_CONTEXT)
@@ -414,28 +533,37 @@ static enum TN_RCode _queue_receive(
  *    Data queue on which job should be performed.
  * @param job_type
  *    Type of job to perform, depending on it, appropriate worker function
- *    will be called (`_queue_send()` or `_queue_receive()`).
- * @param p_data
+ *    will be called (`_queue_send_multi()` or `_queue_receive_multi()`).
+ * @param p_data_arr
  *    Depends on given job_type:
  *
- *    - `_JOB_TYPE__SEND`: data to send;
- *    - `_JOB_TYPE__RECEIVE`: pointer at which data should be received.
+ *    - `_JOB_TYPE__SEND`: array of data items to send;
+ *    - `_JOB_TYPE__RECEIVE`: array at which data items should be received.
+ * @param items_cnt
+ *    Number of items in `p_data_arr`
+ * @param p_done_cnt
+ *    Pointer to the place at which the number of transferred items is
+ *    stored. Can be `TN_NULL`.
  * @param timeout
  *    Refer to `#TN_TickCnt`.
  */
 static enum TN_RCode _dqueue_job_perform(
       struct TN_DQueue *dque,
       enum _JobType job_type,
-      void *p_data,
+      void **p_data_arr,
+      int items_cnt,
+      int *p_done_cnt,
       TN_TickCnt timeout
       )
 {
    TN_BOOL waited = TN_FALSE;
-   void **pp_data = (void **)p_data;
+   int done_cnt = 0;
    enum TN_RCode rc = _check_param_generic(dque);
 
    if (rc != TN_RC_OK){
       //-- just return rc as it is
+   } else if ((rc = _check_param_multi(p_data_arr, items_cnt)) != TN_RC_OK){
+      //-- just return rc as it is
    } else if (!tn_is_task_context()){
       rc = TN_RC_WCONTEXT;
    } else {
@@ -446,8 +574,8 @@ static enum TN_RCode _dqueue_job_perform(
       switch (job_type){
 
          case _JOB_TYPE__SEND:
-            //-- try to put new item to the queue
-            rc = _queue_send(dque, p_data);
+            //-- try to put new items to the queue
+            rc = _queue_send_multi(dque, p_data_arr, items_cnt, &done_cnt);
 
             if (rc == TN_RC_TIMEOUT && timeout != 0){
                //-- We can't put new item to the queue right now (queue is
@@ -456,7 +584,7 @@ static enum TN_RCode _dqueue_job_perform(
                //   Save user-provided data in the `dqueue.data_elem` task
                //   field, and put current task to wait until there's room in
                //   the queue.
-               _tn_curr_run_task->subsys_wait.dqueue.data_elem = p_data;
+               _tn_curr_run_task->subsys_wait.dqueue.data_elem = p_data_arr[0];
                _tn_task_curr_to_wait_action(
                      &(dque->wait_send_list),
                      TN_WAIT_REASON_DQUE_WSEND,
@@ -468,8 +596,8 @@ static enum TN_RCode _dqueue_job_perform(
             break;
 
          case _JOB_TYPE__RECEIVE:
-            //-- try to get the item from the queue
-            rc = _queue_receive(dque, pp_data);
+            //-- try to get items from the queue
+            rc = _queue_receive_multi(dque, p_data_arr, items_cnt, &done_cnt);
 
             if (rc == TN_RC_TIMEOUT && timeout != 0){
                //-- Queue is empty right now, and user asked to wait if that
@@ -500,6 +628,11 @@ static enum TN_RCode _dqueue_job_perform(
          //-- get wait result
          rc = _tn_curr_run_task->task_wait_rc;
 
+         if (rc == TN_RC_OK){
+            //-- exactly one item is transferred while we were waiting
+            done_cnt = 1;
+         }
+
          switch (job_type){
             case _JOB_TYPE__SEND:
                //-- do nothing special
@@ -510,13 +643,19 @@ static enum TN_RCode _dqueue_job_perform(
                if (rc == TN_RC_OK){
                   //-- dqueue.data_elem should contain valid value now,
                   //   return it to caller
-                  *pp_data = _tn_curr_run_task->subsys_wait.dqueue.data_elem;
+                  p_data_arr[0]
+                     = _tn_curr_run_task->subsys_wait.dqueue.data_elem;
                }
                break;
          }
       }
 
    }
+
+   if (p_done_cnt != TN_NULL){
+      *p_done_cnt = done_cnt;
+   }
+
    return rc;
 }
 
@@ -531,14 +670,18 @@ static enum TN_RCode _dqueue_job_perform(
 static enum TN_RCode _dqueue_job_iperform(
       struct TN_DQueue *dque,
       enum _JobType job_type,
-      void *p_data      //-- used for _JOB_TYPE__SEND
+      void **p_data_arr,
+      int items_cnt,
+      int *p_done_cnt
       )
 {
-   void **pp_data = (void **)p_data;
+   int done_cnt = 0;
    enum TN_RCode rc = _check_param_generic(dque);
 
    if (rc != TN_RC_OK){
       //-- just return rc as it is
+   } else if ((rc = _check_param_multi(p_data_arr, items_cnt)) != TN_RC_OK){
+      //-- just return rc as it is
    } else if (!tn_is_isr_context()){
       //-- wrong context
       rc = TN_RC_WCONTEXT;
@@ -551,17 +694,17 @@ static enum TN_RCode _dqueue_job_iperform(
       switch (job_type){
 
          case _JOB_TYPE__SEND:
-            //-- Try to put new item to the queue. We don't handle returned
+            //-- Try to put new items to the queue. We don't handle returned
             //   value here, since we can't wait in interrupt, so, just return
             //   the value to the caller.
-            rc = _queue_send(dque, p_data);
+            rc = _queue_send_multi(dque, p_data_arr, items_cnt, &done_cnt);
             break;
 
          case _JOB_TYPE__RECEIVE:
-            //-- try to get the item from the queue. We don't handle returned
+            //-- try to get items from the queue. We don't handle returned
             //   value here, since we can't wait in interrupt, so, just return
             //   the value to the caller.
-            rc = _queue_receive(dque, pp_data);
+            rc = _queue_receive_multi(dque, p_data_arr, items_cnt, &done_cnt);
             break;
       }
 
@@ -569,6 +712,10 @@ static enum TN_RCode _dqueue_job_iperform(
       _TN_CONTEXT_SWITCH_IPEND_IF_NEEDED();
    }
 
+   if (p_done_cnt != TN_NULL){
+      *p_done_cnt = done_cnt;
+   }
+
    return rc;
 }
 
@@ -583,23 +730,28 @@ static enum TN_RCode _dqueue_job_iperform(
 /*
  * See comments in the header file (tn_dqueue.h)
  */
-enum TN_RCode tn_queue_create(
-      struct TN_DQueue *dque,
-      void **data_fifo,
-      int items_cnt
+enum TN_RCode tn_queue_create_wattr(
+      struct TN_DQueue    *dque,
+      void               **data_fifo,
+      int                  items_cnt,
+      enum TN_WaitOrder    wait_order
       )
 {
    enum TN_RCode rc = TN_RC_OK;
 
-   rc = _check_param_create(dque, data_fifo, items_cnt);
+   rc = _check_param_create(dque, data_fifo, items_cnt, wait_order);
    if (rc != TN_RC_OK){
       //-- just return rc as it is
    } else {
       _tn_list_reset(&(dque->wait_send_list));
       _tn_list_reset(&(dque->wait_receive_list));
+#if TN_USE_MULTI_WAIT
+      _tn_list_reset(&(dque->multi_wait_list));
+#endif
 
       dque->data_fifo         = data_fifo;
       dque->items_cnt         = items_cnt;
+      dque->wait_order        = wait_order;
 
       _tn_eventgrp_link_reset(&dque->eventgrp_link);
 
@@ -614,6 +766,7 @@ enum TN_RCode tn_queue_create(
       dque->id_dque = TN_ID_DATAQUEUE;
    }
 
+   _TN_TRACE(TN_TRACE_EV_QUEUE_CREATE, dque, rc);
    return rc;
 }
 
@@ -639,6 +792,9 @@ enum TN_RCode tn_queue_delete(struct TN_DQueue * dque)
       //   (TN_RC_DELETED is returned)
       _tn_wait_queue_notify_deleted(&(dque->wait_send_list));
       _tn_wait_queue_notify_deleted(&(dque->wait_receive_list));
+#if TN_USE_MULTI_WAIT
+      _tn_multi_wait_notify_deleted(&(dque->multi_wait_list));
+#endif
 
       dque->id_dque = TN_ID_NONE; //-- data queue does not exist now
 
@@ -650,6 +806,7 @@ enum TN_RCode tn_queue_delete(struct TN_DQueue * dque)
 
    }
 
+   _TN_TRACE(TN_TRACE_EV_QUEUE_DELETE, dque, rc);
    return rc;
 
 }
@@ -664,7 +821,12 @@ enum TN_RCode tn_queue_send(
       TN_TickCnt timeout
       )
 {
-   return _dqueue_job_perform(dque, _JOB_TYPE__SEND, p_data, timeout);
+   enum TN_RCode rc = _dqueue_job_perform(
+         dque, _JOB_TYPE__SEND, &p_data, 1, TN_NULL, timeout
+         );
+
+   _TN_TRACE(TN_TRACE_EV_QUEUE_SEND, dque, rc);
+   return rc;
 }
 
 
@@ -673,7 +835,12 @@ enum TN_RCode tn_queue_send(
  */
 enum TN_RCode tn_queue_send_polling(struct TN_DQueue *dque, void *p_data)
 {
-   return _dqueue_job_perform(dque, _JOB_TYPE__SEND, p_data, 0);
+   enum TN_RCode rc = _dqueue_job_perform(
+         dque, _JOB_TYPE__SEND, &p_data, 1, TN_NULL, 0
+         );
+
+   _TN_TRACE(TN_TRACE_EV_QUEUE_SEND, dque, rc);
+   return rc;
 }
 
 
@@ -682,7 +849,12 @@ enum TN_RCode tn_queue_send_polling(struct TN_DQueue *dque, void *p_data)
  */
 enum TN_RCode tn_queue_isend_polling(struct TN_DQueue *dque, void *p_data)
 {
-   return _dqueue_job_iperform(dque, _JOB_TYPE__SEND, p_data);
+   enum TN_RCode rc = _dqueue_job_iperform(
+         dque, _JOB_TYPE__SEND, &p_data, 1, TN_NULL
+         );
+
+   _TN_TRACE(TN_TRACE_EV_QUEUE_SEND, dque, rc);
+   return rc;
 }
 
 
@@ -695,7 +867,12 @@ enum TN_RCode tn_queue_receive(
       TN_TickCnt timeout
       )
 {
-   return _dqueue_job_perform(dque, _JOB_TYPE__RECEIVE, pp_data, timeout);
+   enum TN_RCode rc = _dqueue_job_perform(
+         dque, _JOB_TYPE__RECEIVE, pp_data, 1, TN_NULL, timeout
+         );
+
+   _TN_TRACE(TN_TRACE_EV_QUEUE_RECEIVE, dque, rc);
+   return rc;
 }
 
 
@@ -704,7 +881,12 @@ enum TN_RCode tn_queue_receive(
  */
 enum TN_RCode tn_queue_receive_polling(struct TN_DQueue *dque, void **pp_data)
 {
-   return _dqueue_job_perform(dque, _JOB_TYPE__RECEIVE, pp_data, 0);
+   enum TN_RCode rc = _dqueue_job_perform(
+         dque, _JOB_TYPE__RECEIVE, pp_data, 1, TN_NULL, 0
+         );
+
+   _TN_TRACE(TN_TRACE_EV_QUEUE_RECEIVE, dque, rc);
+   return rc;
 }
 
 
@@ -713,7 +895,91 @@ enum TN_RCode tn_queue_receive_polling(struct TN_DQueue *dque, void **pp_data)
  */
 enum TN_RCode tn_queue_ireceive_polling(struct TN_DQueue *dque, void **pp_data)
 {
-   return _dqueue_job_iperform(dque, _JOB_TYPE__RECEIVE, pp_data);
+   enum TN_RCode rc = _dqueue_job_iperform(
+         dque, _JOB_TYPE__RECEIVE, pp_data, 1, TN_NULL
+         );
+
+   _TN_TRACE(TN_TRACE_EV_QUEUE_RECEIVE, dque, rc);
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_dqueue.h)
+ */
+enum TN_RCode tn_queue_send_multi(
+      struct TN_DQueue *dque,
+      void *const *p_data_arr,
+      int items_cnt,
+      int *p_sent_cnt,
+      TN_TickCnt timeout
+      )
+{
+   enum TN_RCode rc = _dqueue_job_perform(
+         dque, _JOB_TYPE__SEND, (void **)p_data_arr, items_cnt, p_sent_cnt,
+         timeout
+         );
+
+   _TN_TRACE(TN_TRACE_EV_QUEUE_SEND, dque, rc);
+   return rc;
+}
+
+
+/*
+ * See comments in the header file (tn_dqueue.h)
+ */
+enum TN_RCode tn_queue_isend_multi(
+      struct TN_DQueue *dque,
+      void *const *p_data_arr,
+      int items_cnt,
+      int *p_sent_cnt
+      )
+{
+   enum TN_RCode rc = _dqueue_job_iperform(
+         dque, _JOB_TYPE__SEND, (void **)p_data_arr, items_cnt, p_sent_cnt
+         );
+
+   _TN_TRACE(TN_TRACE_EV_QUEUE_SEND, dque, rc);
+   return rc;
+}
+
+
+/*
+ * See comments in the header file (tn_dqueue.h)
+ */
+enum TN_RCode tn_queue_receive_multi(
+      struct TN_DQueue *dque,
+      void **p_data_arr,
+      int items_cnt,
+      int *p_received_cnt,
+      TN_TickCnt timeout
+      )
+{
+   enum TN_RCode rc = _dqueue_job_perform(
+         dque, _JOB_TYPE__RECEIVE, p_data_arr, items_cnt, p_received_cnt,
+         timeout
+         );
+
+   _TN_TRACE(TN_TRACE_EV_QUEUE_RECEIVE, dque, rc);
+   return rc;
+}
+
+
+/*
+ * See comments in the header file (tn_dqueue.h)
+ */
+enum TN_RCode tn_queue_ireceive_multi(
+      struct TN_DQueue *dque,
+      void **p_data_arr,
+      int items_cnt,
+      int *p_received_cnt
+      )
+{
+   enum TN_RCode rc = _dqueue_job_iperform(
+         dque, _JOB_TYPE__RECEIVE, p_data_arr, items_cnt, p_received_cnt
+         );
+
+   _TN_TRACE(TN_TRACE_EV_QUEUE_RECEIVE, dque, rc);
+   return rc;
 }
 
 /*
@@ -764,13 +1030,13 @@ enum TN_RCode tn_queue_eventgrp_connect(
       TN_UWord             pattern
       )
 {
-   int sr_saved;
+   TN_INTSAVE_DATA;
    enum TN_RCode rc = _check_param_generic(dque);
 
    if (rc == TN_RC_OK){
-      sr_saved = tn_arch_sr_save_int_dis();
+      TN_INT_DIS_SAVE();
       rc = _tn_eventgrp_link_set(&dque->eventgrp_link, eventgrp, pattern);
-      tn_arch_sr_restore(sr_saved);
+      TN_INT_RESTORE();
    }
 
    return rc;
@@ -783,16 +1049,49 @@ enum TN_RCode tn_queue_eventgrp_disconnect(
       struct TN_DQueue    *dque
       )
 {
-   int sr_saved;
+   TN_INTSAVE_DATA;
    enum TN_RCode rc = _check_param_generic(dque);
 
    if (rc == TN_RC_OK){
-      sr_saved = tn_arch_sr_save_int_dis();
+      TN_INT_DIS_SAVE();
       rc = _tn_eventgrp_link_reset(&dque->eventgrp_link);
-      tn_arch_sr_restore(sr_saved);
+      TN_INT_RESTORE();
    }
 
    return rc;
 }
 
 
+
+/*******************************************************************************
+ *    PROTECTED FUNCTIONS
+ ******************************************************************************/
+
+/**
+ * See comments in the file _tn_dqueue.h
+ */
+enum TN_RCode _tn_queue_send(
+      struct TN_DQueue *dque,
+      void *p_data
+      )
+{
+   //-- interrupts should be disabled here
+   _TN_BUG_ON( !TN_IS_INT_DISABLED() );
+
+   return _queue_send(dque, p_data);
+}
+
+/**
+ * See comments in the file _tn_dqueue.h
+ */
+enum TN_RCode _tn_queue_receive(
+      struct TN_DQueue *dque,
+      void **pp_data
+      )
+{
+   //-- interrupts should be disabled here
+   _TN_BUG_ON( !TN_IS_INT_DISABLED() );
+
+   return _queue_receive(dque, pp_data);
+}
+
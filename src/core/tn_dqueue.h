@@ -114,6 +114,12 @@ struct TN_DQueue {
    ///
    /// list of tasks waiting to receive data
    struct TN_ListItem  wait_receive_list;
+#if TN_USE_MULTI_WAIT || defined(DOXYGEN_ACTIVE)
+   ///
+   /// list of items of tasks waiting to receive data by `tn_multi_wait()`,
+   /// available if only `#TN_USE_MULTI_WAIT` is non-zero.
+   struct TN_ListItem  multi_wait_list;
+#endif
 
    ///
    /// array of `void *` to store data queue items. Can be `TN_NULL`.
@@ -131,6 +137,9 @@ struct TN_DQueue {
    /// index of the item which will be read next time
    int            tail_idx;
    ///
+   /// order in which waiting tasks are served, see `tn_queue_create_wattr()`
+   enum TN_WaitOrder wait_order;
+   ///
    /// connected event group
    struct TN_EGrpLink eventgrp_link;
 };
@@ -159,10 +168,34 @@ struct TN_DQueueTaskWait {
  *    PUBLIC FUNCTION PROTOTYPES
  ******************************************************************************/
 
+/**
+ * The same as `tn_queue_create()`, but takes additional argument:
+ * `wait_order`. If it is `#TN_WAIT_ORDER_PRIORITY`, then the task with the
+ * highest priority is served first, no matter when it has started waiting.
+ * This applies to both tasks waiting to send and tasks waiting to receive.
+ *
+ * @param dque       pointer to already allocated struct TN_DQueue.
+ * @param data_fifo  pointer to already allocated array of `void *` to store
+ *                   data queue items. Can be `#TN_NULL`.
+ * @param items_cnt  capacity of queue
+ *                   (count of elements in the `data_fifo` array)
+ *                   Can be 0.
+ * @param wait_order order in which waiting tasks are served,
+ *                   see `enum #TN_WaitOrder`
+ */
+enum TN_RCode tn_queue_create_wattr(
+      struct TN_DQueue    *dque,
+      void               **data_fifo,
+      int                  items_cnt,
+      enum TN_WaitOrder    wait_order
+      );
+
 /**
  * Construct data queue. `id_dque` member should not contain `#TN_ID_DATAQUEUE`,
  * otherwise, `#TN_RC_WPARAM` is returned.
  *
+ * Waiting tasks are served in FIFO order, see `tn_queue_create_wattr()`.
+ *
  * $(TN_CALL_FROM_TASK)
  * $(TN_CALL_FROM_ISR)
  * $(TN_LEGEND_LINK)
@@ -179,11 +212,16 @@ struct TN_DQueueTaskWait {
  *    * If `#TN_CHECK_PARAM` is non-zero, additional return code
  *      is available: `#TN_RC_WPARAM`.
  */
-enum TN_RCode tn_queue_create(
+_TN_STATIC_INLINE enum TN_RCode tn_queue_create(
       struct TN_DQueue *dque,
       void **data_fifo,
       int items_cnt
-      );
+      )
+{
+   return tn_queue_create_wattr(
+         dque, data_fifo, items_cnt, TN_WAIT_ORDER_FIFO
+         );
+}
 
 
 /**
@@ -330,6 +368,131 @@ enum TN_RCode tn_queue_ireceive_polling(
       void **pp_data
       );
 
+/**
+ * Send up to `items_cnt` data elements from the array `p_data_arr` to the
+ * data queue specified by the `dque`, in one critical section. This is much
+ * cheaper than calling `tn_queue_send()` for each element, since
+ * interrupts are disabled, parameters are checked and context switch is
+ * pended just once for the whole batch.
+ *
+ * Each element is sent as if by `tn_queue_send()`: it is given to the
+ * first task waiting to receive, if any, or placed to the tail of data FIFO.
+ * Elements are sent in order, until either all of them are sent or the FIFO
+ * becomes full. The number of sent elements is stored at `p_sent_cnt`.
+ *
+ * If at least one element is sent, the function returns `#TN_RC_OK`
+ * immediately. If no elements can be sent at all, behavior depends on the
+ * `timeout` value (refer to `#TN_TickCnt`): the task waits to send the
+ * first element only, and if it succeeds, `*p_sent_cnt` is set to 1. The
+ * caller is expected to call the function again to send the rest.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_CAN_SLEEP)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param dque       pointer to data queue to send data to
+ * @param p_data_arr array of values to send
+ * @param items_cnt  number of elements in `p_data_arr`, should be positive
+ * @param p_sent_cnt pointer to location to store the number of sent
+ *                   elements. Can be `#TN_NULL`.
+ * @param timeout    refer to `#TN_TickCnt`
+ *
+ * @return  
+ *    * `#TN_RC_OK`   if at least one element was sent;
+ *    * `#TN_RC_WCONTEXT` if called from wrong context;
+ *    * Other possible return codes depend on `timeout` value,
+ *      refer to `#TN_TickCnt`
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ *
+ * @see `#TN_TickCnt`
+ */
+enum TN_RCode tn_queue_send_multi(
+      struct TN_DQueue *dque,
+      void *const *p_data_arr,
+      int items_cnt,
+      int *p_sent_cnt,
+      TN_TickCnt timeout
+      );
+
+/**
+ * The same as `tn_queue_send_multi()` with zero timeout, but for using in
+ * the ISR.
+ *
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ */
+enum TN_RCode tn_queue_isend_multi(
+      struct TN_DQueue *dque,
+      void *const *p_data_arr,
+      int items_cnt,
+      int *p_sent_cnt
+      );
+
+/**
+ * Receive up to `items_cnt` data elements from the data queue specified by
+ * the `dque` into the array `p_data_arr`, in one critical section. This is
+ * much cheaper than calling `tn_queue_receive()` for each element.
+ *
+ * Each element is received as if by `tn_queue_receive()`, so tasks that
+ * wait to send are woken up as the room appears in the FIFO. Elements are
+ * received until either `items_cnt` elements are received or the queue
+ * becomes empty. The number of received elements is stored at
+ * `p_received_cnt`.
+ *
+ * If at least one element is received, the function returns `#TN_RC_OK`
+ * immediately. If the queue is empty, behavior depends on the `timeout`
+ * value (refer to `#TN_TickCnt`): the task waits for one element, and if it
+ * is received, `*p_received_cnt` is set to 1.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_CAN_SLEEP)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param dque             pointer to data queue to receive data from
+ * @param p_data_arr       array to store received values to
+ * @param items_cnt        number of elements in `p_data_arr`, should be
+ *                         positive
+ * @param p_received_cnt   pointer to location to store the number of
+ *                         received elements. Can be `#TN_NULL`.
+ * @param timeout          refer to `#TN_TickCnt`
+ *
+ * @return  
+ *    * `#TN_RC_OK`   if at least one element was received;
+ *    * `#TN_RC_WCONTEXT` if called from wrong context;
+ *    * Other possible return codes depend on `timeout` value,
+ *      refer to `#TN_TickCnt`
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ *
+ * @see `#TN_TickCnt`
+ */
+enum TN_RCode tn_queue_receive_multi(
+      struct TN_DQueue *dque,
+      void **p_data_arr,
+      int items_cnt,
+      int *p_received_cnt,
+      TN_TickCnt timeout
+      );
+
+/**
+ * The same as `tn_queue_receive_multi()` with zero timeout, but for using in
+ * the ISR.
+ *
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ */
+enum TN_RCode tn_queue_ireceive_multi(
+      struct TN_DQueue *dque,
+      void **p_data_arr,
+      int items_cnt,
+      int *p_received_cnt
+      );
+
 
 /**
  * Returns number of free items in the queue
@@ -45,6 +45,8 @@
 #include "_tn_eventgrp.h"
 #include "_tn_tasks.h"
 #include "_tn_list.h"
+#include "_tn_trace.h"
+#include "_tn_multi_wait.h"
 
 
 //-- header of current module
@@ -225,8 +227,9 @@ static void _clear_pattern_if_needed(
 
 
 /**
- * Walk through all tasks waiting for some event, wake up tasks whose waiting
- * condition is already satisfied.
+ * Walk through all tasks waiting for some event (directly or by
+ * `tn_multi_wait()`), wake up tasks whose waiting condition is already
+ * satisfied.
  *
  * @param eventgrp
  *    Event group to handle.
@@ -268,6 +271,48 @@ static void _scan_event_waitqueue(struct TN_EventGrp *eventgrp)
                );
       }
    }
+
+#if TN_USE_MULTI_WAIT
+   //-- Now, walk through the items of tasks waiting by `tn_multi_wait()`.
+   //
+   //   When the item fires, all the items of that task are removed from
+   //   their lists, and the task might have several items for this event
+   //   group, so the next list item is not necessarily safe to use. Items
+   //   of other tasks are left intact, though: so, before firing, skip
+   //   the following items of the same task, and continue from the first
+   //   item of another task. This way, the list is walked just once.
+   {
+      struct TN_ListItem *list = &(eventgrp->multi_wait_list);
+      struct TN_ListItem *cur = list->next;
+
+      while (cur != list){
+         struct TN_MultiWaitItem *item = _tn_list_entry(
+               cur, struct TN_MultiWaitItem, obj_link
+               );
+
+         cur = cur->next;
+
+         if (_cond_check(eventgrp, item->wait_mode, item->wait_pattern)){
+            while (     cur != list
+                     && _tn_list_entry(
+                           cur, struct TN_MultiWaitItem, obj_link
+                           )->task == item->task
+                  )
+            {
+               cur = cur->next;
+            }
+
+            item->flags_pattern = eventgrp->pattern;
+            _tn_multi_wait_item_complete(item, TN_RC_OK);
+
+            //-- Atomically clear flag(s) if we need to.
+            _clear_pattern_if_needed(
+                  eventgrp, item->wait_mode, item->wait_pattern
+                  );
+         }
+      }
+   }
+#endif
 }
 
 
@@ -414,6 +459,9 @@ enum TN_RCode tn_eventgrp_create_wattr(
    } else {
 
       _tn_list_reset(&(eventgrp->wait_queue));
+#if TN_USE_MULTI_WAIT
+      _tn_list_reset(&(eventgrp->multi_wait_list));
+#endif
 
       eventgrp->pattern    = initial_pattern;
       eventgrp->id_event   = TN_ID_EVENTGRP;
@@ -422,6 +470,7 @@ enum TN_RCode tn_eventgrp_create_wattr(
 #endif
 
    }
+   _TN_TRACE(TN_TRACE_EV_EVENTGRP_CREATE, eventgrp, rc);
    return rc;
 }
 
@@ -445,6 +494,9 @@ enum TN_RCode tn_eventgrp_delete(struct TN_EventGrp *eventgrp)
       // remove all waiting tasks from wait list (if any), returning the
       // TN_RC_DELETED code.
       _tn_wait_queue_notify_deleted(&(eventgrp->wait_queue));
+#if TN_USE_MULTI_WAIT
+      _tn_multi_wait_notify_deleted(&(eventgrp->multi_wait_list));
+#endif
 
       eventgrp->id_event = TN_ID_NONE; //-- event does not exist now
 
@@ -455,6 +507,7 @@ enum TN_RCode tn_eventgrp_delete(struct TN_EventGrp *eventgrp)
       _tn_context_switch_pend_if_needed();
 
    }
+   _TN_TRACE(TN_TRACE_EV_EVENTGRP_DELETE, eventgrp, rc);
    return rc;
 }
 
@@ -527,6 +580,7 @@ enum TN_RCode tn_eventgrp_wait(
       }
 
    }
+   _TN_TRACE(TN_TRACE_EV_EVENTGRP_WAIT, eventgrp, rc);
    return rc;
 }
 
@@ -558,6 +612,7 @@ enum TN_RCode tn_eventgrp_wait_polling(
 
       TN_INT_RESTORE();
    }
+   _TN_TRACE(TN_TRACE_EV_EVENTGRP_WAIT, eventgrp, rc);
    return rc;
 }
 
@@ -591,6 +646,7 @@ enum TN_RCode tn_eventgrp_iwait_polling(
       _TN_CONTEXT_SWITCH_IPEND_IF_NEEDED();
 
    }
+   _TN_TRACE(TN_TRACE_EV_EVENTGRP_WAIT, eventgrp, rc);
    return rc;
 }
 
@@ -622,6 +678,7 @@ enum TN_RCode tn_eventgrp_modify(
       _tn_context_switch_pend_if_needed();
 
    }
+   _TN_TRACE(TN_TRACE_EV_EVENTGRP_MODIFY, eventgrp, rc);
    return rc;
 }
 
@@ -652,6 +709,7 @@ enum TN_RCode tn_eventgrp_imodify(
       TN_INT_IRESTORE();
       _TN_CONTEXT_SWITCH_IPEND_IF_NEEDED();
    }
+   _TN_TRACE(TN_TRACE_EV_EVENTGRP_MODIFY, eventgrp, rc);
    return rc;
 }
 
@@ -662,6 +720,19 @@ enum TN_RCode tn_eventgrp_imodify(
  *    PROTECTED FUNCTIONS
  ******************************************************************************/
 
+/**
+ * See comments in the file _tn_eventgrp.h
+ */
+enum TN_RCode _tn_eventgrp_wait(
+      struct TN_EventGrp  *eventgrp,
+      TN_UWord             wait_pattern,
+      enum TN_EGrpWaitMode wait_mode,
+      TN_UWord            *p_flags_pattern
+      )
+{
+   return _eventgrp_wait(eventgrp, wait_pattern, wait_mode, p_flags_pattern);
+}
+
 /**
  * See comments in the file _tn_eventgrp.h
  */
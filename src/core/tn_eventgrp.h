@@ -218,6 +218,12 @@ struct TN_EventGrp {
    ///
    /// task wait queue
    struct TN_ListItem   wait_queue;
+#if TN_USE_MULTI_WAIT || defined(DOXYGEN_ACTIVE)
+   ///
+   /// list of items of tasks waiting for events by `tn_multi_wait()`,
+   /// available if only `#TN_USE_MULTI_WAIT` is non-zero.
+   struct TN_ListItem   multi_wait_list;
+#endif
    ///
    /// current flags pattern
    TN_UWord             pattern;
@@ -2,9 +2,9 @@
  *
  * TNeo: real-time kernel initially based on TNKernel
  *
- *    TNKernel:                  copyright  2004, 2013 Yuri Tiomkin.
- *    PIC32-specific routines:   copyright  2013, 2014 Anders Montonen.
- *    TNeo:                      copyright  2014       Dmitry Frank.
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
  *
  *    TNeo was born as a thorough review and re-implementation of
  *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
@@ -41,34 +41,23 @@
 //-- common tnkernel headers
 #include "tn_common.h"
 #include "tn_sys.h"
-#include "tn_exch_link.h"
 
 //-- internal tnkernel headers
 #include "_tn_sys.h"
 #include "_tn_exch.h"
 #include "_tn_exch_link.h"
 #include "_tn_list.h"
+#include "_tn_trace.h"
 
 
 //-- header of current module
 #include "tn_exch.h"
 
+//-- header of other needed modules
+#include "tn_exch_link.h"
 
 
-
-
-/*******************************************************************************
- *    PUBLIC DATA
- ******************************************************************************/
-
-
-
-
-/*******************************************************************************
- *    DEFINITIONS
- ******************************************************************************/
-
-
+#if TN_USE_EXCH
 
 
 
@@ -78,8 +67,8 @@
 
 //-- Additional param checking {{{
 #if TN_CHECK_PARAM
-static inline enum TN_RCode _check_param_generic(
-      struct TN_Exch *exch
+_TN_STATIC_INLINE enum TN_RCode _check_param_generic(
+      const struct TN_Exch *exch
       )
 {
    enum TN_RCode rc = TN_RC_OK;
@@ -93,8 +82,8 @@ static inline enum TN_RCode _check_param_generic(
    return rc;
 }
 
-static inline enum TN_RCode _check_param_create(
-      struct TN_Exch  *exch
+_TN_STATIC_INLINE enum TN_RCode _check_param_create(
+      const struct TN_Exch *exch
       )
 {
    enum TN_RCode rc = TN_RC_OK;
@@ -108,23 +97,79 @@ static inline enum TN_RCode _check_param_create(
    return rc;
 }
 
+_TN_STATIC_INLINE enum TN_RCode _check_param_data(
+      const void *data
+      )
+{
+   return (data == TN_NULL) ? TN_RC_WPARAM : TN_RC_OK;
+}
+
+_TN_STATIC_INLINE enum TN_RCode _check_param_link(
+      const struct TN_ExchLink *exch_link
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   if (exch_link == TN_NULL){
+      rc = TN_RC_WPARAM;
+   } else if (!_tn_exch_link_is_valid(exch_link)){
+      rc = TN_RC_INVALID_OBJ;
+   }
+
+   return rc;
+}
+
 #else
 #  define _check_param_generic(exch)            (TN_RC_OK)
 #  define _check_param_create(exch)             (TN_RC_OK)
+#  define _check_param_data(data)               (TN_RC_OK)
+#  define _check_param_link(exch_link)          (TN_RC_OK)
 #endif
 // }}}
 
-static enum TN_RCode _notify_all(
-      struct TN_Exch   *exch
+/**
+ * Copy `uwords_cnt` words from `src` to `tgt`.
+ */
+static void _data_copy(
+      TN_UWord         *tgt,
+      const TN_UWord   *src,
+      unsigned int      uwords_cnt
+      )
+{
+   while (uwords_cnt-- > 0){
+      *tgt++ = *src++;
+   }
+}
+
+/**
+ * Write new data to the exchange object and notify all the links.
+ * Interrupts should be disabled when it is called.
+ *
+ * @return
+ *    `#TN_RC_OK` if all links were notified successfully; otherwise, return
+ *    code of the first failed link (other links are notified anyway).
+ */
+static enum TN_RCode _exch_write(
+      struct TN_Exch   *exch,
+      const void       *data
       )
 {
    enum TN_RCode rc = TN_RC_OK;
    struct TN_ExchLink *exch_link;
-   
-   _tn_list_for_each_entry(exch_link, &(exch->links_list), links_list_item){
-      rc = _tn_exch_link_notify(exch_link);
-      if (rc != TN_RC_OK){
-         break;
+
+   _data_copy(
+         (TN_UWord *)exch->data,
+         (const TN_UWord *)data,
+         _TN_SIZE_BYTES_TO_UWORDS(exch->size)
+         );
+
+   _tn_list_for_each_entry(
+         exch_link, struct TN_ExchLink, &(exch->links_list), links_list_item
+         )
+   {
+      enum TN_RCode link_rc = _tn_exch_link_notify(exch_link);
+      if (rc == TN_RC_OK){
+         rc = link_rc;
       }
    }
 
@@ -158,13 +203,12 @@ enum TN_RCode tn_exch_create(
       goto out;
    }
 
-
    //-- check that `data` is aligned properly
    {
-      unsigned long data_aligned 
-         = TN_MAKE_ALIG_SIZE((unsigned long)data);
+      TN_UIntPtr data_aligned 
+         = TN_MAKE_ALIG_SIZE((TN_UIntPtr)data);
 
-      if (data_aligned != (unsigned int)data){
+      if (data_aligned != (TN_UIntPtr)data){
          rc = TN_RC_WPARAM;
          goto out;
       }
@@ -190,6 +234,7 @@ enum TN_RCode tn_exch_create(
    exch->id_exch = TN_ID_EXCHANGE;
 
 out:
+   _TN_TRACE(TN_TRACE_EV_EXCH_CREATE, exch, rc);
    return rc;
 }
 
@@ -199,20 +244,35 @@ out:
 enum TN_RCode tn_exch_delete(struct TN_Exch *exch)
 {
    enum TN_RCode rc = _check_param_generic(exch);
-   int sr_saved;
 
    if (rc != TN_RC_OK){
       //-- just return rc as it is
+   } else if (!tn_is_task_context()){
+      rc = TN_RC_WCONTEXT;
    } else {
-      sr_saved = tn_arch_sr_save_int_dis();
-      exch->id_exch = 0;   //-- Exchange object does not exist now
-      tn_arch_sr_restore(sr_saved);
+      TN_INTSAVE_DATA;
+
+      TN_INT_DIS_SAVE();
+
+      //-- remove all the links
+      while (!_tn_list_is_empty(&(exch->links_list))){
+         _tn_exch_link_detach(
+               _tn_list_first_entry(
+                  &(exch->links_list), struct TN_ExchLink, links_list_item
+                  )
+               );
+      }
+
+      exch->id_exch = TN_ID_NONE; //-- Exchange object does not exist now
+
+      TN_INT_RESTORE();
    }
 
+   _TN_TRACE(TN_TRACE_EV_EXCH_DELETE, exch, rc);
    return rc;
 }
 
-/**
+/*
  * See comments in the header file (tn_exch.h)
  */
 enum TN_RCode tn_exch_read(
@@ -220,22 +280,25 @@ enum TN_RCode tn_exch_read(
       void             *data_tgt
       )
 {
-   int sr_saved;
    enum TN_RCode rc = _check_param_generic(exch);
 
    if (rc != TN_RC_OK){
       //-- just return rc as it is
+   } else if ((rc = _check_param_data(data_tgt)) != TN_RC_OK){
+      //-- just return rc as it is
    } else {
-      sr_saved = tn_arch_sr_save_int_dis();
-      rc = _tn_exch_read(exch, data_tgt);
-      tn_arch_sr_restore(sr_saved);
+      TN_INTSAVE_DATA;
+
+      TN_INT_DIS_SAVE();
+      _tn_exch_read(exch, data_tgt);
+      TN_INT_RESTORE();
    }
 
+   _TN_TRACE(TN_TRACE_EV_EXCH_READ, exch, rc);
    return rc;
 }
 
-
-/**
+/*
  * See comments in the header file (tn_exch.h)
  */
 enum TN_RCode tn_exch_write(
@@ -244,62 +307,138 @@ enum TN_RCode tn_exch_write(
       )
 {
    enum TN_RCode rc = _check_param_generic(exch);
-   int sr_saved;
 
    if (rc != TN_RC_OK){
       //-- just return rc as it is
+   } else if ((rc = _check_param_data(data)) != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_task_context()){
+      rc = TN_RC_WCONTEXT;
    } else {
-      sr_saved = tn_arch_sr_save_int_dis();
+      TN_INTSAVE_DATA;
 
-      _tn_exch_write(exch, data);
-      rc = _notify_all(exch);
+      TN_INT_DIS_SAVE();
+      rc = _exch_write(exch, data);
+      TN_INT_RESTORE();
 
-      tn_arch_sr_restore(sr_saved);
+      //-- some link might have woken up some high-priority task
+      _tn_context_switch_pend_if_needed();
    }
 
+   _TN_TRACE(TN_TRACE_EV_EXCH_WRITE, exch, rc);
    return rc;
 }
 
+/*
+ * See comments in the header file (tn_exch.h)
+ */
+enum TN_RCode tn_exch_iwrite(
+      struct TN_Exch   *exch,
+      const void       *data
+      )
+{
+   enum TN_RCode rc = _check_param_generic(exch);
 
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if ((rc = _check_param_data(data)) != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_isr_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_INTSAVE_DATA_INT;
 
+      TN_INT_IDIS_SAVE();
+      rc = _exch_write(exch, data);
+      TN_INT_IRESTORE();
 
+      _TN_CONTEXT_SWITCH_IPEND_IF_NEEDED();
+   }
 
-/*******************************************************************************
- *    PROTECTED FUNCTIONS
- ******************************************************************************/
+   _TN_TRACE(TN_TRACE_EV_EXCH_WRITE, exch, rc);
+   return rc;
+}
 
-/**
- * See comments in the _tn_exch.h file
+/*
+ * See comments in the header file (tn_exch.h)
  */
-void _tn_exch_write(
-      struct TN_Exch   *exch,
-      const void       *data
+enum TN_RCode tn_exch_link_add(
+      struct TN_Exch      *exch,
+      struct TN_ExchLink  *exch_link
       )
 {
-   _tn_memcpy_uword(
-         (TN_UWord *)exch->data,
-         (const TN_UWord *)data,
-         _TN_SIZE_BYTES_TO_UWORDS(exch->size)
-         );
+   enum TN_RCode rc = _check_param_generic(exch);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if ((rc = _check_param_link(exch_link)) != TN_RC_OK){
+      //-- just return rc as it is
+   } else if ((rc = _tn_exch_link_attach_check(exch_link, exch)) != TN_RC_OK){
+      //-- the link is unable to deliver data of this exchange object
+      //   (say, it is too large): just return rc as it is
+   } else {
+      TN_INTSAVE_DATA;
+
+      TN_INT_DIS_SAVE();
+
+      //-- if the link is added to some exchange object, remove it from there
+      _tn_exch_link_detach(exch_link);
+
+      _tn_list_add_tail(&(exch->links_list), &(exch_link->links_list_item));
+      exch_link->exch = exch;
+
+      TN_INT_RESTORE();
+   }
+
+   return rc;
 }
 
+/*
+ * See comments in the header file (tn_exch.h)
+ */
+enum TN_RCode tn_exch_link_remove(
+      struct TN_ExchLink  *exch_link
+      )
+{
+   enum TN_RCode rc = _check_param_link(exch_link);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else {
+      TN_INTSAVE_DATA;
+
+      TN_INT_DIS_SAVE();
+      _tn_exch_link_detach(exch_link);
+      TN_INT_RESTORE();
+   }
 
-/**
+   return rc;
+}
+
+
+
+
+
+/*******************************************************************************
+ *    PROTECTED FUNCTIONS
+ ******************************************************************************/
+
+/*
  * See comments in the _tn_exch.h file
  */
-enum TN_RCode _tn_exch_read(
-      struct TN_Exch   *exch,
-      void             *data_tgt
+void _tn_exch_read(
+      const struct TN_Exch   *exch,
+      void                   *data_tgt
       )
 {
-   _tn_memcpy_uword(
+   _data_copy(
          (TN_UWord *)data_tgt,
          (const TN_UWord *)exch->data,
          _TN_SIZE_BYTES_TO_UWORDS(exch->size)
          );
-
-   return TN_RC_OK;
 }
 
 
+#endif //-- TN_USE_EXCH
+
 
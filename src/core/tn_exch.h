@@ -0,0 +1,398 @@
+/*******************************************************************************
+ *
+ * TNeo: real-time kernel initially based on TNKernel
+ *
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
+ *
+ *    TNeo was born as a thorough review and re-implementation of
+ *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
+ *    as well as new features being added, and it is tested carefully with
+ *    unit-tests.
+ *
+ *    API is changed somewhat, so it's not 100% compatible with TNKernel,
+ *    hence the new name: TNeo.
+ *
+ *    Permission to use, copy, modify, and distribute this software in source
+ *    and binary forms and its documentation for any purpose and without fee
+ *    is hereby granted, provided that the above copyright notice appear
+ *    in all copies and that both that copyright notice and this permission
+ *    notice appear in supporting documentation.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE DMITRY FRANK AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DMITRY FRANK OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *    THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+/**
+ * \file
+ *
+ * Exchange object: a shared data slot of fixed size that holds the latest
+ * value written to it. Any number of readers can get the latest value by
+ * `tn_exch_read()` at any time, and, additionally, each write can be pushed
+ * to the subscribers through the connected links:
+ *
+ * - \ref tn_exch_link_queue.h "queue link": each write allocates a memory
+ *   block from the given fixed memory pool, copies data there, and sends
+ *   pointer to the block to the given data queue;
+ * - \ref tn_exch_link_eventgrp.h "event group link": each write sets the
+ *   given flags in the given event group.
+ *
+ * This gives a "latest-value broadcast" channel: say, some task measures
+ * temperature and writes it to the exchange object, and all interested
+ * consumers get notified about new value, without the need to poll some
+ * mutex-protected structure.
+ *
+ * Writing never blocks: if some link can't deliver the notification (say,
+ * the queue is full or the memory pool is empty), that notification is lost
+ * (but the value is still available by `tn_exch_read()`), and the writer
+ * gets the error code.
+ *
+ * Data is copied word by word, so the exchange data buffer, as well as
+ * buffers given to `tn_exch_read()` and `tn_exch_write()`, should be
+ * aligned to `sizeof(#TN_UWord)`.
+ *
+ * Typical usage:
+ *
+ * \code{.c}
+ *     struct MySensorData {
+ *        int temperature;
+ *        int humidity;
+ *     };
+ *
+ *     TN_EXCH_DATA_BUF_DEF(my_exch_buf, struct MySensorData);
+ *     struct TN_Exch my_exch;
+ *
+ *     //-- consumer: connected with queue, each message is allocated
+ *     //   from memory pool
+ *     TN_FMEM_BUF_DEF(my_fmem_buf, struct MySensorData, 4);
+ *     struct TN_FMem my_fmem;
+ *     void *my_queue_buf[4];
+ *     struct TN_DQueue my_queue;
+ *     struct TN_ExchLinkQueue my_exch_link_queue;
+ *
+ *     void init(void)
+ *     {
+ *        tn_exch_create(
+ *              &my_exch, my_exch_buf,
+ *              TN_MAKE_ALIG_SIZE(sizeof(struct MySensorData))
+ *              );
+ *
+ *        tn_fmem_create(
+ *              &my_fmem, my_fmem_buf,
+ *              TN_MAKE_ALIG_SIZE(sizeof(struct MySensorData)), 4
+ *              );
+ *        tn_queue_create(&my_queue, my_queue_buf, 4);
+ *
+ *        tn_exch_link_queue_create(&my_exch_link_queue, &my_queue, &my_fmem);
+ *        tn_exch_link_add(
+ *              &my_exch, tn_exch_link_queue_base_get(&my_exch_link_queue)
+ *              );
+ *     }
+ * \endcode
+ *
+ * After that, each `tn_exch_write()` to `my_exch` sends the copy of new
+ * data to `my_queue`; the consumer should release the memory block to
+ * `my_fmem` when it is done with the data.
+ *
+ * Exchange objects are available if only `#TN_USE_EXCH` is non-zero.
+ */
+
+
+#ifndef _TN_EXCH_H
+#define _TN_EXCH_H
+
+/*******************************************************************************
+ *    INCLUDED FILES
+ ******************************************************************************/
+
+#include "tn_list.h"
+#include "tn_common.h"
+#include "tn_sys.h"
+
+
+
+/*******************************************************************************
+ *    EXTERN TYPES
+ ******************************************************************************/
+
+struct TN_ExchLink;
+
+
+
+#ifdef __cplusplus
+extern "C"  {     /*}*/
+#endif
+
+/*******************************************************************************
+ *    PUBLIC TYPES
+ ******************************************************************************/
+
+/**
+ * Exchange object
+ */
+struct TN_Exch {
+   ///
+   /// id for object validity verification.
+   /// This field is in the beginning of the structure to make it easier
+   /// to detect memory corruption.
+   enum TN_ObjId id_exch;
+   ///
+   /// List of all connected links (`struct TN_ExchLinkQueue`, etc)
+   struct TN_ListItem links_list;
+   ///
+   /// Pointer to actual exchange data
+   void *data;
+   ///
+   /// Size of the exchange data in bytes, should be a multiple of
+   /// `sizeof(#TN_UWord)`
+   unsigned int size;
+};
+
+
+/*******************************************************************************
+ *    PROTECTED GLOBAL DATA
+ ******************************************************************************/
+
+/*******************************************************************************
+ *    DEFINITIONS
+ ******************************************************************************/
+
+/**
+ * Convenience macro for the definition of buffer for data. See
+ * `tn_exch_create()` for usage example.
+ *
+ * @param name
+ *    C variable name of the buffer array (this name should be given 
+ *    to the `tn_exch_create()` function as the `data` argument)
+ * @param item_type
+ *    Type of data stored in the exchange object, like
+ *    `struct MyExchangeData`.
+ */
+#define TN_EXCH_DATA_BUF_DEF(name, item_type)                     \
+   TN_UWord name[                                                 \
+      (TN_MAKE_ALIG_SIZE(sizeof(item_type)) / sizeof(TN_UWord))   \
+   ]
+
+
+/*******************************************************************************
+ *    PUBLIC FUNCTION PROTOTYPES
+ ******************************************************************************/
+
+/**
+ * Construct the exchange object. `id_exch` field should not contain
+ * `#TN_ID_EXCHANGE`, otherwise, `#TN_RC_WPARAM` is returned.
+ *
+ * Note that `data` and `size` should be a multiple of `sizeof(#TN_UWord)`.
+ *
+ * For the definition of buffer, convenience macro `TN_EXCH_DATA_BUF_DEF()`
+ * was invented.
+ *
+ * Typical definition looks as follows:
+ *
+ * \code{.c}
+ *     //-- type of data that exchange object stores
+ *     struct MyExchangeData {
+ *        // ... arbitrary fields ...
+ *     };
+ *     
+ *     //-- define buffer for exchange data
+ *     TN_EXCH_DATA_BUF_DEF(my_exch_buf, struct MyExchangeData);
+ *
+ *     //-- define exchange object structure
+ *     struct TN_Exch my_exch;
+ * \endcode
+ *
+ * And then, construct your `my_exch` as follows:
+ *
+ * \code{.c}
+ *     enum TN_RCode rc;
+ *     rc = tn_exch_create( &my_exch,
+ *                          my_exch_buf,
+ *                          TN_MAKE_ALIG_SIZE(sizeof(struct MyExchangeData))
+ *                        );
+ *     if (rc != TN_RC_OK){
+ *        //-- handle error
+ *     }
+ * \endcode
+ *
+ * If given `data` and/or `size` aren't aligned properly, `#TN_RC_WPARAM` is
+ * returned.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param exch
+ *    Pointer to already allocated `struct TN_Exch`
+ * @param data
+ *    Pointer to already allocated exchange data buffer, its size must be a
+ *    multiple of `sizeof(#TN_UWord)`
+ * @param size
+ *    Size of the exchange data buffer in bytes, must be a multiple of
+ *    `sizeof(#TN_UWord)`
+ *
+ * @return 
+ *    * `#TN_RC_OK` if exchange object was successfully created;
+ *    * `#TN_RC_WPARAM` if wrong params were given.
+ */
+enum TN_RCode tn_exch_create(
+      struct TN_Exch   *exch,
+      void             *data,
+      unsigned int      size
+      );
+
+/**
+ * Destruct the exchange object. All the links connected to it are removed
+ * (but not deleted: they can be added to another exchange object).
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param exch     exchange object to destruct
+ *
+ * @return 
+ *    * `#TN_RC_OK` if object was successfully deleted;
+ *    * `#TN_RC_WCONTEXT` if called from wrong context;
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_exch_delete(struct TN_Exch *exch);
+
+/**
+ * Copy the latest value of exchange data to the location specified by
+ * `data_tgt`. It should be aligned to `sizeof(#TN_UWord)`, and should have
+ * at least `size` bytes (given to `tn_exch_create()`).
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param exch       exchange object to read data from
+ * @param data_tgt   location to copy data to
+ *
+ * @return 
+ *    * `#TN_RC_OK` if data was successfully read;
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_exch_read(
+      struct TN_Exch   *exch,
+      void             *data_tgt
+      );
+
+/**
+ * Copy new value from the location specified by `data` to the exchange
+ * object, and notify all connected links. The location should be aligned
+ * to `sizeof(#TN_UWord)`, and should have at least `size` bytes (given to
+ * `tn_exch_create()`).
+ *
+ * Data is written and links are notified atomically, so that each
+ * notification corresponds to the value written by this call. Writing
+ * never blocks: if some link fails to deliver notification, other links are
+ * notified anyway, and the error code of the first failed link is returned.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param exch       exchange object to write data to
+ * @param data       location to copy data from
+ *
+ * @return 
+ *    * `#TN_RC_OK` if data was successfully written, and all links were
+ *      successfully notified;
+ *    * `#TN_RC_WCONTEXT` if called from wrong context;
+ *    * `#TN_RC_TIMEOUT` if some queue link failed to deliver notification
+ *      because memory pool is empty or the queue is full (data is written
+ *      anyway);
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_exch_write(
+      struct TN_Exch   *exch,
+      const void       *data
+      );
+
+/**
+ * The same as `tn_exch_write()`, but for using in the ISR.
+ *
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ */
+enum TN_RCode tn_exch_iwrite(
+      struct TN_Exch   *exch,
+      const void       *data
+      );
+
+/**
+ * Add the link to the exchange object, so that subsequent writes to the
+ * exchange object are pushed through the link. If the link is already added
+ * to some exchange object, it is removed from the old one first.
+ *
+ * The link should be constructed by the link-specific function, like
+ * `tn_exch_link_queue_create()`; base link pointer is returned by
+ * link-specific function like `tn_exch_link_queue_base_get()`.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param exch       exchange object to add link to
+ * @param exch_link  link to add
+ *
+ * @return 
+ *    * `#TN_RC_OK` if link was successfully added;
+ *    * `#TN_RC_WPARAM` if the link is unable to deliver data of this
+ *      exchange object: say, for queue link, if exchange data doesn't fit
+ *      in the memory block (see `tn_exch_link_queue_create()`);
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_exch_link_add(
+      struct TN_Exch      *exch,
+      struct TN_ExchLink  *exch_link
+      );
+
+/**
+ * Remove the link from the exchange object it is added to. If the link
+ * isn't added to any exchange object, nothing is done.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param exch_link  link to remove
+ *
+ * @return 
+ *    * `#TN_RC_OK` if link was successfully removed;
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_exch_link_remove(
+      struct TN_ExchLink  *exch_link
+      );
+
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif // _TN_EXCH_H
+
+/*******************************************************************************
+ *    end of file
+ ******************************************************************************/
+
+
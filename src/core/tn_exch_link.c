@@ -2,9 +2,9 @@
  *
  * TNeo: real-time kernel initially based on TNKernel
  *
- *    TNKernel:                  copyright  2004, 2013 Yuri Tiomkin.
- *    PIC32-specific routines:   copyright  2013, 2014 Anders Montonen.
- *    TNeo:                      copyright  2014       Dmitry Frank.
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
  *
  *    TNeo was born as a thorough review and re-implementation of
  *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
@@ -51,10 +51,8 @@
 #include "tn_exch_link.h"
 
 
+#if TN_USE_EXCH
 
-/*******************************************************************************
- *    PUBLIC DATA
- ******************************************************************************/
 
 
 /*******************************************************************************
@@ -63,6 +61,10 @@
 
 static enum TN_RCode _notify_error(struct TN_ExchLink *exch_link);
 static enum TN_RCode _dtor(struct TN_ExchLink *exch_link);
+static enum TN_RCode _attach_check(
+      struct TN_ExchLink    *exch_link,
+      const struct TN_Exch  *exch
+      );
 
 
 
@@ -74,19 +76,10 @@ static enum TN_RCode _dtor(struct TN_ExchLink *exch_link);
  * Virtual methods table of "abstract class" `#TN_ExchLink`.
  */
 static const struct TN_ExchLink_VTable _vtable = {
-   .notify     = _notify_error,
-   .dtor       = _dtor,
+   _notify_error,    //-- notify
+   _dtor,            //-- dtor
+   _attach_check,    //-- attach_check
 };
-//static TN_BOOL _vtable_initialized = TN_FALSE;
-
-
-
-
-/*******************************************************************************
- *    DEFINITIONS
- ******************************************************************************/
-
-
 
 
 
@@ -96,8 +89,8 @@ static const struct TN_ExchLink_VTable _vtable = {
 
 //-- Additional param checking {{{
 #if TN_CHECK_PARAM
-static inline enum TN_RCode _check_param_generic(
-      struct TN_ExchLink *exch_link
+_TN_STATIC_INLINE enum TN_RCode _check_param_generic(
+      const struct TN_ExchLink *exch_link
       )
 {
    enum TN_RCode rc = TN_RC_OK;
@@ -111,8 +104,8 @@ static inline enum TN_RCode _check_param_generic(
    return rc;
 }
 
-static inline enum TN_RCode _check_param_create(
-      struct TN_ExchLink  *exch_link
+_TN_STATIC_INLINE enum TN_RCode _check_param_create(
+      const struct TN_ExchLink  *exch_link
       )
 {
    enum TN_RCode rc = TN_RC_OK;
@@ -135,29 +128,27 @@ static inline enum TN_RCode _check_param_create(
 static enum TN_RCode _notify_error(struct TN_ExchLink *exch_link)
 {
    //-- should never be here
+   _TN_UNUSED(exch_link);
    _TN_FATAL_ERROR("called notify() of base TN_ExchLink");
    return TN_RC_INTERNAL;
 }
 
 static enum TN_RCode _dtor(struct TN_ExchLink *exch_link)
 {
-   exch_link->id_exch_link = 0;  //-- exchange link does not exist now
+   exch_link->id_exch_link = TN_ID_NONE;  //-- exchange link does not exist now
    return TN_RC_OK;
 }
 
-#if 0
-static void _vtable_init()
+static enum TN_RCode _attach_check(
+      struct TN_ExchLink    *exch_link,
+      const struct TN_Exch  *exch
+      )
 {
-   if (!_vtable_initialized){
-      _vtable.notify    = _notify_error;
-      _vtable.dtor      = _dtor;
-
-      _vtable_initialized = TN_TRUE;
-   }
+   //-- base link accepts any exchange object
+   _TN_UNUSED(exch_link);
+   _TN_UNUSED(exch);
+   return TN_RC_OK;
 }
-#endif
-
-
 
 
 
@@ -172,7 +163,6 @@ static void _vtable_init()
  */
 const struct TN_ExchLink_VTable *_tn_exch_link_vtable(void)
 {
-   //_vtable_init();
    return &_vtable;
 }
 
@@ -189,8 +179,8 @@ enum TN_RCode _tn_exch_link_create(
    if (rc != TN_RC_OK){
       //-- just return rc as it is
    } else {
-      //_vtable_init();
       exch_link->vtable = &_vtable;
+      exch_link->exch   = TN_NULL;
 
       _tn_list_reset(&(exch_link->links_list_item));
 
@@ -208,18 +198,24 @@ enum TN_RCode _tn_exch_link_notify(
       struct TN_ExchLink     *exch_link
       )
 {
-   enum TN_RCode rc = _check_param_generic(exch_link);
+   //-- interrupts should be disabled here
+   _TN_BUG_ON( !TN_IS_INT_DISABLED() );
 
-   if (rc != TN_RC_OK){
-      //-- just return rc as it is
-   } else {
-      rc = exch_link->vtable->notify(exch_link);
-   }
-
-   return rc;
+   return exch_link->vtable->notify(exch_link);
 }
 
 
+/**
+ * See comments in the _tn_exch_link.h file
+ */
+enum TN_RCode _tn_exch_link_attach_check(
+      struct TN_ExchLink     *exch_link,
+      const struct TN_Exch   *exch
+      )
+{
+   return exch_link->vtable->attach_check(exch_link, exch);
+}
+
 
 /**
  * See comments in the _tn_exch_link.h file
@@ -233,11 +229,38 @@ enum TN_RCode _tn_exch_link_delete(
    if (rc != TN_RC_OK){
       //-- just return rc as it is
    } else {
+      TN_INTSAVE_DATA;
+
+      TN_INT_DIS_SAVE();
+
+      _tn_exch_link_detach(exch_link);
       rc = exch_link->vtable->dtor(exch_link);
+
+      TN_INT_RESTORE();
    }
 
    return rc;
 }
 
 
+/**
+ * See comments in the _tn_exch_link.h file
+ */
+void _tn_exch_link_detach(
+      struct TN_ExchLink     *exch_link
+      )
+{
+   //-- interrupts should be disabled here
+   _TN_BUG_ON( !TN_IS_INT_DISABLED() );
+
+   if (exch_link->exch != TN_NULL){
+      _tn_list_remove_entry(&(exch_link->links_list_item));
+      _tn_list_reset(&(exch_link->links_list_item));
+      exch_link->exch = TN_NULL;
+   }
+}
+
+
+#endif //-- TN_USE_EXCH
+
 
@@ -2,9 +2,9 @@
  *
  * TNeo: real-time kernel initially based on TNKernel
  *
- *    TNKernel:                  copyright © 2004, 2013 Yuri Tiomkin.
- *    PIC32-specific routines:   copyright © 2013, 2014 Anders Montonen.
- *    TNeo:                      copyright © 2014       Dmitry Frank.
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
  *
  *    TNeo was born as a thorough review and re-implementation of
  *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
@@ -38,9 +38,13 @@
  * \file
  *
  * Exchange link (in terms of OOP, it's an "abstract class" of any exchange
- * link).
+ * link). Particular link types are:
  *
- * For internal kernel usage only.
+ * - `struct TN_ExchLinkQueue`, see \ref tn_exch_link_queue.h;
+ * - `struct TN_ExchLinkEventGrp`, see \ref tn_exch_link_eventgrp.h.
+ *
+ * Fields of these structures are for internal kernel usage only. Links are
+ * added to the \ref tn_exch.h "exchange" by `tn_exch_link_add()`.
  *
  */
 
@@ -57,6 +61,13 @@
 
 
 
+/*******************************************************************************
+ *    EXTERN TYPES
+ ******************************************************************************/
+
+struct TN_Exch;
+
+
 
 #ifdef __cplusplus
 extern "C"  {     /*}*/
@@ -70,18 +81,32 @@ struct TN_ExchLink;
 
 
 /**
- * Virtual method prototype: notify.
+ * Virtual method prototype: notify. Called with interrupts disabled, after
+ * new data is written to the exchange object; should not block.
  *
  * For internal kernel usage only.
  */
-typedef enum TN_RCode (TN_ExchLink_Notify)(struct TN_ExchLink *exch);
+typedef enum TN_RCode (TN_ExchLink_Notify)(struct TN_ExchLink *exch_link);
 
 /**
  * Virtual method prototype: destructor.
  *
  * For internal kernel usage only.
  */
-typedef enum TN_RCode (TN_ExchLink_Dtor)  (struct TN_ExchLink *exch);
+typedef enum TN_RCode (TN_ExchLink_Dtor)  (struct TN_ExchLink *exch_link);
+
+/**
+ * Virtual method prototype: attach check. Called by `tn_exch_link_add()`
+ * before the link is added to the exchange object; should return
+ * `#TN_RC_WPARAM` if the link is unable to deliver data of the given
+ * exchange object (say, data is too large).
+ *
+ * For internal kernel usage only.
+ */
+typedef enum TN_RCode (TN_ExchLink_AttachCheck)(
+      struct TN_ExchLink    *exch_link,
+      const struct TN_Exch  *exch
+      );
 
 /**
  * Virtual methods table for each type of \ref tn_exch.h "exchange" link. 
@@ -91,6 +116,7 @@ typedef enum TN_RCode (TN_ExchLink_Dtor)  (struct TN_ExchLink *exch);
 struct TN_ExchLink_VTable {
    TN_ExchLink_Notify  *notify;
    TN_ExchLink_Dtor    *dtor;
+   TN_ExchLink_AttachCheck *attach_check;
 };
 
 /**
@@ -99,6 +125,11 @@ struct TN_ExchLink_VTable {
  * For internal kernel usage only.
  */
 struct TN_ExchLink {
+   ///
+   /// id for object validity verification.
+   /// This field is in the beginning of the structure to make it easier
+   /// to detect memory corruption.
+   enum TN_ObjId id_exch_link;
    ///
    /// A list item to be included in the exchange links list
    struct TN_ListItem links_list_item;
@@ -109,14 +140,11 @@ struct TN_ExchLink {
    ///
    /// Pointer to the virtual methods table
    const struct TN_ExchLink_VTable *vtable;
-   ///
-   /// Id for object validity verification
-   enum TN_ObjId              id_exch_link;
 };
 
 
 /*******************************************************************************
- *    GLOBAL VARIABLES
+ *    PROTECTED GLOBAL DATA
  ******************************************************************************/
 
 /*******************************************************************************
@@ -0,0 +1,231 @@
+/*******************************************************************************
+ *
+ * TNeo: real-time kernel initially based on TNKernel
+ *
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
+ *
+ *    TNeo was born as a thorough review and re-implementation of
+ *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
+ *    as well as new features being added, and it is tested carefully with
+ *    unit-tests.
+ *
+ *    API is changed somewhat, so it's not 100% compatible with TNKernel,
+ *    hence the new name: TNeo.
+ *
+ *    Permission to use, copy, modify, and distribute this software in source
+ *    and binary forms and its documentation for any purpose and without fee
+ *    is hereby granted, provided that the above copyright notice appear
+ *    in all copies and that both that copyright notice and this permission
+ *    notice appear in supporting documentation.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE DMITRY FRANK AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DMITRY FRANK OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *    THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+/*******************************************************************************
+ *    INCLUDED FILES
+ ******************************************************************************/
+
+//-- common tnkernel headers
+#include "tn_common.h"
+#include "tn_sys.h"
+
+#include "tn_eventgrp.h"
+
+//-- internal tnkernel headers
+#include "_tn_exch_link.h"
+#include "_tn_eventgrp.h"
+
+
+//-- header of current module
+#include "tn_exch_link_eventgrp.h"
+
+
+#if TN_USE_EXCH
+
+
+
+/*******************************************************************************
+ *    PRIVATE FUNCTION PROTOTYPES
+ ******************************************************************************/
+
+static enum TN_RCode _notify(struct TN_ExchLink *exch_link);
+static enum TN_RCode _dtor(struct TN_ExchLink *exch_link);
+static enum TN_RCode _attach_check(
+      struct TN_ExchLink    *exch_link,
+      const struct TN_Exch  *exch
+      );
+
+
+
+/*******************************************************************************
+ *    PRIVATE DATA
+ ******************************************************************************/
+
+/**
+ * Virtual methods table
+ */
+static const struct TN_ExchLink_VTable _vtable = {
+   _notify,          //-- notify
+   _dtor,            //-- dtor
+   _attach_check,    //-- attach_check
+};
+
+
+
+
+/*******************************************************************************
+ *    DEFINITIONS
+ ******************************************************************************/
+
+#define _get_exch_link_eventgrp_by_exch_link(exch_link)                       \
+   container_of(exch_link, struct TN_ExchLinkEventGrp, super)
+
+
+
+
+
+/*******************************************************************************
+ *    PRIVATE FUNCTIONS
+ ******************************************************************************/
+
+//-- Additional param checking {{{
+#if TN_CHECK_PARAM
+_TN_STATIC_INLINE enum TN_RCode _check_param_create(
+      struct TN_ExchLinkEventGrp   *exch_link_eventgrp,
+      struct TN_EventGrp           *eventgrp
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   if (exch_link_eventgrp == TN_NULL || eventgrp == TN_NULL){
+      rc = TN_RC_WPARAM;
+   }
+
+   return rc;
+}
+
+#else
+#  define _check_param_create(exch_link_eventgrp, eventgrp)  (TN_RC_OK)
+#endif
+// }}}
+
+
+/**
+ * Implementation of `notify()` virtual method: set flags in the event group
+ */
+static enum TN_RCode _notify(struct TN_ExchLink *exch_link)
+{
+   struct TN_ExchLinkEventGrp *exch_link_eventgrp = 
+      _get_exch_link_eventgrp_by_exch_link(exch_link);
+
+   return _tn_eventgrp_link_manage(
+         &exch_link_eventgrp->eventgrp_link, TN_TRUE
+         );
+}
+
+/**
+ * Implementation of `dtor()` virtual method
+ */
+static enum TN_RCode _dtor(struct TN_ExchLink *exch_link)
+{
+   struct TN_ExchLinkEventGrp *exch_link_eventgrp = 
+      _get_exch_link_eventgrp_by_exch_link(exch_link);
+
+   _tn_eventgrp_link_reset(&exch_link_eventgrp->eventgrp_link);
+
+   //-- call destructor of superclass
+   return _tn_exch_link_vtable()->dtor(exch_link);
+}
+
+/**
+ * Implementation of `attach_check()` virtual method: event group link
+ * doesn't deliver data, so any exchange object is fine
+ */
+static enum TN_RCode _attach_check(
+      struct TN_ExchLink    *exch_link,
+      const struct TN_Exch  *exch
+      )
+{
+   //-- just call method of superclass
+   return _tn_exch_link_vtable()->attach_check(exch_link, exch);
+}
+
+
+
+
+
+
+
+/*******************************************************************************
+ *    PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+/*
+ * See comments in the header file (tn_exch_link_eventgrp.h)
+ */
+enum TN_RCode tn_exch_link_eventgrp_create(
+      struct TN_ExchLinkEventGrp   *exch_link_eventgrp,
+      struct TN_EventGrp           *eventgrp,
+      TN_UWord                      pattern
+      )
+{
+   enum TN_RCode rc = _check_param_create(exch_link_eventgrp, eventgrp);
+
+   if (rc == TN_RC_OK){
+      //-- call constructor of superclass
+      rc = _tn_exch_link_create(&exch_link_eventgrp->super);
+   }
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else {
+      TN_INTSAVE_DATA;
+
+      //-- set the virtual functions table of this particular subclass
+      exch_link_eventgrp->super.vtable = &_vtable;
+
+      TN_INT_DIS_SAVE();
+      rc = _tn_eventgrp_link_set(
+            &exch_link_eventgrp->eventgrp_link, eventgrp, pattern
+            );
+      TN_INT_RESTORE();
+
+      if (rc != TN_RC_OK){
+         //-- wrong event group or pattern: destroy the link we've just
+         //   constructed
+         _tn_exch_link_vtable()->dtor(&exch_link_eventgrp->super);
+      }
+   }
+
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_exch_link_eventgrp.h)
+ */
+enum TN_RCode tn_exch_link_eventgrp_delete(
+      struct TN_ExchLinkEventGrp   *exch_link_eventgrp
+      )
+{
+   return _tn_exch_link_delete(
+         (exch_link_eventgrp != TN_NULL) ? &exch_link_eventgrp->super : TN_NULL
+         );
+}
+
+
+#endif //-- TN_USE_EXCH
+
+
@@ -0,0 +1,182 @@
+/*******************************************************************************
+ *
+ * TNeo: real-time kernel initially based on TNKernel
+ *
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
+ *
+ *    TNeo was born as a thorough review and re-implementation of
+ *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
+ *    as well as new features being added, and it is tested carefully with
+ *    unit-tests.
+ *
+ *    API is changed somewhat, so it's not 100% compatible with TNKernel,
+ *    hence the new name: TNeo.
+ *
+ *    Permission to use, copy, modify, and distribute this software in source
+ *    and binary forms and its documentation for any purpose and without fee
+ *    is hereby granted, provided that the above copyright notice appear
+ *    in all copies and that both that copyright notice and this permission
+ *    notice appear in supporting documentation.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE DMITRY FRANK AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DMITRY FRANK OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *    THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+/**
+ * \file
+ *
+ * Exchange link: event group (in terms of OOP, it's a "class, inherited
+ * from `#TN_ExchLink`").
+ *
+ * Each write to the \ref tn_exch.h "exchange" object sets the given flags
+ * pattern in the event group. Subscribers wait for the flags (and clear
+ * them, say, by `#TN_EVENTGRP_WMODE_AUTOCLR`), and then get the latest value
+ * by `tn_exch_read()`. Unlike \ref tn_exch_link_queue.h "queue link", this
+ * link never fails and doesn't need memory, but intermediate values written
+ * while the subscriber was busy are not seen by it.
+ */
+
+
+#ifndef _TN_EXCH_LINK_EVENTGRP_H
+#define _TN_EXCH_LINK_EVENTGRP_H
+
+/*******************************************************************************
+ *    INCLUDED FILES
+ ******************************************************************************/
+
+#include "tn_exch_link.h"
+#include "tn_eventgrp.h"
+
+
+
+/*******************************************************************************
+ *    EXTERN TYPES
+ ******************************************************************************/
+
+
+
+#ifdef __cplusplus
+extern "C"  {     /*}*/
+#endif
+
+/*******************************************************************************
+ *    PUBLIC TYPES
+ ******************************************************************************/
+
+/**
+ * Event group link for \ref tn_exch.h "exchange" object.
+ *
+ * For internal kernel usage only.
+ */
+struct TN_ExchLinkEventGrp {
+   ///
+   /// Exchange link: in terms of OOP, it's a superclass (or base class)
+   struct TN_ExchLink super;
+   ///
+   /// Event group and flags pattern to set in it
+   struct TN_EGrpLink eventgrp_link;
+};
+
+
+
+/*******************************************************************************
+ *    PROTECTED GLOBAL DATA
+ ******************************************************************************/
+
+/*******************************************************************************
+ *    DEFINITIONS
+ ******************************************************************************/
+
+/*******************************************************************************
+ *    PUBLIC FUNCTION PROTOTYPES
+ ******************************************************************************/
+
+/**
+ * Construct event group link. `super.id_exch_link` field should not contain
+ * `#TN_ID_EXCHANGE_LINK`, otherwise, `#TN_RC_WPARAM` is returned.
+ *
+ * After construction, the link should be added to the exchange object by
+ * `tn_exch_link_add()`.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param exch_link_eventgrp
+ *    Pointer to already allocated `struct TN_ExchLinkEventGrp`
+ * @param eventgrp
+ *    Event group to set flags in
+ * @param pattern
+ *    Flags pattern to set, should not be 0
+ *
+ * @return 
+ *    * `#TN_RC_OK` if link was successfully created;
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_exch_link_eventgrp_create(
+      struct TN_ExchLinkEventGrp   *exch_link_eventgrp,
+      struct TN_EventGrp           *eventgrp,
+      TN_UWord                      pattern
+      );
+
+/**
+ * Destruct event group link. If the link is added to some exchange object,
+ * it is removed first.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param exch_link_eventgrp
+ *    Link to destruct
+ *
+ * @return 
+ *    * `#TN_RC_OK` if link was successfully deleted;
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_exch_link_eventgrp_delete(
+      struct TN_ExchLinkEventGrp   *exch_link_eventgrp
+      );
+
+/**
+ * Returns pointer to the base link, to be given to `tn_exch_link_add()`
+ * or `tn_exch_link_remove()`.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ */
+_TN_STATIC_INLINE struct TN_ExchLink *tn_exch_link_eventgrp_base_get(
+      struct TN_ExchLinkEventGrp   *exch_link_eventgrp
+      )
+{
+   return &exch_link_eventgrp->super;
+}
+
+
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif // _TN_EXCH_LINK_EVENTGRP_H
+
+/*******************************************************************************
+ *    end of file
+ ******************************************************************************/
+
+
@@ -2,9 +2,9 @@
  *
  * TNeo: real-time kernel initially based on TNKernel
  *
- *    TNKernel:                  copyright  2004, 2013 Yuri Tiomkin.
- *    PIC32-specific routines:   copyright  2013, 2014 Anders Montonen.
- *    TNeo:                      copyright  2014       Dmitry Frank.
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
  *
  *    TNeo was born as a thorough review and re-implementation of
  *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
@@ -43,8 +43,11 @@
 #include "tn_sys.h"
 
 #include "tn_exch.h"
+#include "tn_dqueue.h"
+#include "tn_fmem.h"
 
 //-- internal tnkernel headers
+#include "_tn_exch.h"
 #include "_tn_exch_link.h"
 #include "_tn_dqueue.h"
 #include "_tn_fmem.h"
@@ -54,10 +57,8 @@
 #include "tn_exch_link_queue.h"
 
 
+#if TN_USE_EXCH
 
-/*******************************************************************************
- *    PUBLIC DATA
- ******************************************************************************/
 
 
 /*******************************************************************************
@@ -66,6 +67,10 @@
 
 static enum TN_RCode _notify(struct TN_ExchLink *exch_link);
 static enum TN_RCode _dtor(struct TN_ExchLink *exch_link);
+static enum TN_RCode _attach_check(
+      struct TN_ExchLink    *exch_link,
+      const struct TN_Exch  *exch
+      );
 
 
 
@@ -77,8 +82,9 @@ static enum TN_RCode _dtor(struct TN_ExchLink *exch_link);
  * Virtual methods table
  */
 static const struct TN_ExchLink_VTable _vtable = {
-   .notify     = _notify,
-   .dtor       = _dtor,
+   _notify,          //-- notify
+   _dtor,            //-- dtor
+   _attach_check,    //-- attach_check
 };
 
 
@@ -88,8 +94,8 @@ static const struct TN_ExchLink_VTable _vtable = {
  *    DEFINITIONS
  ******************************************************************************/
 
-#define _tn_get_exch_link_queue_by_exch_link(exch_link)                       \
-   (exch_link ? container_of(exch_link, struct TN_ExchLinkQueue, super) : 0)
+#define _get_exch_link_queue_by_exch_link(exch_link)                          \
+   container_of(exch_link, struct TN_ExchLinkQueue, super)
 
 
 
@@ -101,7 +107,7 @@ static const struct TN_ExchLink_VTable _vtable = {
 
 //-- Additional param checking {{{
 #if TN_CHECK_PARAM
-static inline enum TN_RCode _check_param_create(
+_TN_STATIC_INLINE enum TN_RCode _check_param_create(
       struct TN_ExchLinkQueue   *exch_link_queue,
       struct TN_DQueue          *queue,
       struct TN_FMem            *fmem
@@ -109,71 +115,101 @@ static inline enum TN_RCode _check_param_create(
 {
    enum TN_RCode rc = TN_RC_OK;
 
-   if (exch_link_queue == TN_NULL){
+   if (exch_link_queue == TN_NULL || queue == TN_NULL){
       rc = TN_RC_WPARAM;
    } else if (!_tn_dqueue_is_valid(queue)){
-      rc = TN_RC_WPARAM;
-   } else if (!_tn_fmem_is_valid(fmem)){
-      rc = TN_RC_WPARAM;
+      rc = TN_RC_INVALID_OBJ;
+   } else if (fmem != TN_NULL && !_tn_fmem_is_valid(fmem)){
+      rc = TN_RC_INVALID_OBJ;
    }
 
    return rc;
 }
 
 #else
-#  define _check_param_create(exch_link)        (TN_RC_OK)
+#  define _check_param_create(exch_link_queue, queue, fmem)  (TN_RC_OK)
 #endif
 // }}}
 
 
+/**
+ * Implementation of `notify()` virtual method: allocate memory block (if
+ * memory pool is used), copy exchange data there and send it to the queue.
+ */
 static enum TN_RCode _notify(struct TN_ExchLink *exch_link)
 {
    enum TN_RCode rc = TN_RC_OK;
 
    struct TN_ExchLinkQueue *exch_link_queue = 
-      _tn_get_exch_link_queue_by_exch_link(exch_link);
+      _get_exch_link_queue_by_exch_link(exch_link);
 
    void *p_msg = TN_NULL;
 
-   rc = tn_is_task_context()
-      ? tn_fmem_get(exch_link_queue->fmem, &p_msg, TN_WAIT_INFINITE)
-      : tn_fmem_iget_polling(exch_link_queue->fmem, &p_msg);
+   if (exch_link_queue->fmem == TN_NULL){
+      //-- no memory pool: data is small enough to be sent as a value
+      _TN_BUG_ON(exch_link->exch->size > sizeof(p_msg));
 
-   if (rc != TN_RC_OK){
-      //-- there was some error: just return rc as it is
+      _tn_exch_read(exch_link->exch, &p_msg);
+      rc = _tn_queue_send(exch_link_queue->queue, p_msg);
    } else {
-      //-- memory was received from fixed-memory pool, copy data there
-      _tn_memcpy_uword(
-            p_msg,
-            exch_link->exch->data,
-            _TN_SIZE_BYTES_TO_UWORDS(exch_link->exch->size)
-            );
-
-      //-- put it to the queue
-      rc = tn_is_task_context()
-         ? tn_queue_send(exch_link_queue->queue, p_msg, TN_WAIT_INFINITE)
-         : tn_queue_isend_polling(exch_link_queue->queue, p_msg);
+      _TN_BUG_ON(exch_link->exch->size > exch_link_queue->fmem->block_size);
+
+      rc = _tn_fmem_get(exch_link_queue->fmem, &p_msg);
+
       if (rc != TN_RC_OK){
-         //-- there was some error while sending the message,
-         //   so before we return, we should free buffer that we've allocated
-         rc = tn_is_task_context()
-            ? tn_fmem_release(exch_link_queue->fmem, p_msg)
-            : tn_fmem_irelease(exch_link_queue->fmem, p_msg);
+         //-- there are no free blocks: just return rc as it is
       } else {
-         //-- everything is fine, so, leave rc = TN_RC_OK
+         //-- memory was received from fixed-memory pool, copy data there
+         _tn_exch_read(exch_link->exch, p_msg);
+
+         //-- put it to the queue
+         rc = _tn_queue_send(exch_link_queue->queue, p_msg);
+         if (rc != TN_RC_OK){
+            //-- there was some error while sending the message,
+            //   so before we return, we should free buffer that we've
+            //   allocated (but keep rc from the queue)
+            _tn_fmem_release(exch_link_queue->fmem, p_msg);
+         }
       }
-
    }
 
    return rc;
 }
 
+/**
+ * Implementation of `dtor()` virtual method
+ */
 static enum TN_RCode _dtor(struct TN_ExchLink *exch_link)
 {
-   //-- just call desctructor of superclass
+   //-- just call destructor of superclass
    return _tn_exch_link_vtable()->dtor(exch_link);
 }
 
+/**
+ * Implementation of `attach_check()` virtual method: exchange data should
+ * fit in a pointer (if there's no memory pool), or in a memory block
+ */
+static enum TN_RCode _attach_check(
+      struct TN_ExchLink    *exch_link,
+      const struct TN_Exch  *exch
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   struct TN_ExchLinkQueue *exch_link_queue = 
+      _get_exch_link_queue_by_exch_link(exch_link);
+
+   if (exch_link_queue->fmem == TN_NULL){
+      if (exch->size > sizeof(void *)){
+         rc = TN_RC_WPARAM;
+      }
+   } else if (exch->size > exch_link_queue->fmem->block_size){
+      rc = TN_RC_WPARAM;
+   }
+
+   return rc;
+}
+
 
 
 
@@ -184,6 +220,9 @@ static enum TN_RCode _dtor(struct TN_ExchLink *exch_link)
  *    PUBLIC FUNCTIONS
  ******************************************************************************/
 
+/*
+ * See comments in the header file (tn_exch_link_queue.h)
+ */
 enum TN_RCode tn_exch_link_queue_create(
       struct TN_ExchLinkQueue   *exch_link_queue,
       struct TN_DQueue          *queue,
@@ -210,12 +249,19 @@ enum TN_RCode tn_exch_link_queue_create(
    return rc;
 }
 
+/*
+ * See comments in the header file (tn_exch_link_queue.h)
+ */
 enum TN_RCode tn_exch_link_queue_delete(
       struct TN_ExchLinkQueue   *exch_link_queue
       )
 {
-   return _tn_exch_link_delete(&exch_link_queue->super);
+   return _tn_exch_link_delete(
+         (exch_link_queue != TN_NULL) ? &exch_link_queue->super : TN_NULL
+         );
 }
 
 
+#endif //-- TN_USE_EXCH
+
 
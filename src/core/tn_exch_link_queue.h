@@ -0,0 +1,196 @@
+/*******************************************************************************
+ *
+ * TNeo: real-time kernel initially based on TNKernel
+ *
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
+ *
+ *    TNeo was born as a thorough review and re-implementation of
+ *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
+ *    as well as new features being added, and it is tested carefully with
+ *    unit-tests.
+ *
+ *    API is changed somewhat, so it's not 100% compatible with TNKernel,
+ *    hence the new name: TNeo.
+ *
+ *    Permission to use, copy, modify, and distribute this software in source
+ *    and binary forms and its documentation for any purpose and without fee
+ *    is hereby granted, provided that the above copyright notice appear
+ *    in all copies and that both that copyright notice and this permission
+ *    notice appear in supporting documentation.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE DMITRY FRANK AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DMITRY FRANK OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *    THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+/**
+ * \file
+ *
+ * Exchange link: queue (in terms of OOP, it's a "class, inherited from
+ * `#TN_ExchLink`").
+ *
+ * Each write to the \ref tn_exch.h "exchange" object allocates a memory
+ * block from the fixed memory pool, copies the exchange data there, and
+ * sends the pointer to the block to the data queue. The receiver is
+ * responsible for releasing the block back to the memory pool.
+ *
+ * If the exchange data size is not larger than `sizeof(void *)`, the memory
+ * pool might be omitted (`#TN_NULL`): then, data itself is sent through the
+ * queue as the `void *` value.
+ *
+ * If there is no free memory block or no room in the queue, notification is
+ * lost, and writer gets `#TN_RC_TIMEOUT`.
+ */
+
+
+#ifndef _TN_EXCH_LINK_QUEUE_H
+#define _TN_EXCH_LINK_QUEUE_H
+
+/*******************************************************************************
+ *    INCLUDED FILES
+ ******************************************************************************/
+
+#include "tn_exch_link.h"
+
+
+
+/*******************************************************************************
+ *    EXTERN TYPES
+ ******************************************************************************/
+
+struct TN_DQueue;
+struct TN_FMem;
+
+
+
+#ifdef __cplusplus
+extern "C"  {     /*}*/
+#endif
+
+/*******************************************************************************
+ *    PUBLIC TYPES
+ ******************************************************************************/
+
+/**
+ * Queue link for \ref tn_exch.h "exchange" object.
+ *
+ * For internal kernel usage only.
+ */
+struct TN_ExchLinkQueue {
+   ///
+   /// Exchange link: in terms of OOP, it's a superclass (or base class)
+   struct TN_ExchLink super;
+   ///
+   /// A pointer to queue to send messages to.
+   struct TN_DQueue *queue;
+   ///
+   /// A pointer to fixed-memory pool to get memory from.
+   /// Note: if data size is <= `sizeof(void *)`, `fmem` might be `TN_NULL`.
+   struct TN_FMem *fmem;
+};
+
+
+
+/*******************************************************************************
+ *    PROTECTED GLOBAL DATA
+ ******************************************************************************/
+
+/*******************************************************************************
+ *    DEFINITIONS
+ ******************************************************************************/
+
+/*******************************************************************************
+ *    PUBLIC FUNCTION PROTOTYPES
+ ******************************************************************************/
+
+/**
+ * Construct queue link. `super.id_exch_link` field should not contain
+ * `#TN_ID_EXCHANGE_LINK`, otherwise, `#TN_RC_WPARAM` is returned.
+ *
+ * After construction, the link should be added to the exchange object by
+ * `tn_exch_link_add()`.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param exch_link_queue
+ *    Pointer to already allocated `struct TN_ExchLinkQueue`
+ * @param queue
+ *    Queue to send messages to
+ * @param fmem
+ *    Memory pool to allocate messages from; its block size should not be
+ *    less than exchange data size. Can be `#TN_NULL` if only exchange data
+ *    size is not larger than `sizeof(void *)`. Both are checked by
+ *    `tn_exch_link_add()`, which returns `#TN_RC_WPARAM` if data doesn't fit.
+ *
+ * @return 
+ *    * `#TN_RC_OK` if link was successfully created;
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return code
+ *      is available: `#TN_RC_WPARAM`.
+ */
+enum TN_RCode tn_exch_link_queue_create(
+      struct TN_ExchLinkQueue   *exch_link_queue,
+      struct TN_DQueue          *queue,
+      struct TN_FMem            *fmem
+      );
+
+/**
+ * Destruct queue link. If the link is added to some exchange object, it is
+ * removed first.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param exch_link_queue
+ *    Link to destruct
+ *
+ * @return 
+ *    * `#TN_RC_OK` if link was successfully deleted;
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_exch_link_queue_delete(
+      struct TN_ExchLinkQueue   *exch_link_queue
+      );
+
+/**
+ * Returns pointer to the base link, to be given to `tn_exch_link_add()`
+ * or `tn_exch_link_remove()`.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ */
+_TN_STATIC_INLINE struct TN_ExchLink *tn_exch_link_queue_base_get(
+      struct TN_ExchLinkQueue   *exch_link_queue
+      )
+{
+   return &exch_link_queue->super;
+}
+
+
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif // _TN_EXCH_LINK_QUEUE_H
+
+/*******************************************************************************
+ *    end of file
+ ******************************************************************************/
+
+
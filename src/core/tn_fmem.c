@@ -46,6 +46,8 @@
 //-- internal tnkernel headers
 #include "_tn_tasks.h"
 #include "_tn_list.h"
+#include "_tn_trace.h"
+#include "_tn_multi_wait.h"
 
 
 //-- header of current module
@@ -71,7 +73,8 @@
 //-- Additional param checking {{{
 #if TN_CHECK_PARAM
 _TN_STATIC_INLINE enum TN_RCode _check_param_fmem_create(
-      const struct TN_FMem *fmem
+      const struct TN_FMem *fmem,
+      enum TN_WaitOrder wait_order
       )
 {
    enum TN_RCode rc = TN_RC_OK;
@@ -80,6 +83,10 @@ _TN_STATIC_INLINE enum TN_RCode _check_param_fmem_create(
       rc = TN_RC_WPARAM;
    } else if (_tn_fmem_is_valid(fmem)){
       rc = TN_RC_WPARAM;
+   } else if (    wait_order != TN_WAIT_ORDER_FIFO
+               && wait_order != TN_WAIT_ORDER_PRIORITY)
+   {
+      rc = TN_RC_WPARAM;
    }
 
    return rc;
@@ -130,16 +137,34 @@ _TN_STATIC_INLINE enum TN_RCode _check_param_generic(
 
    return rc;
 }
+
+_TN_STATIC_INLINE enum TN_RCode _check_param_multi(
+      const struct TN_FMem *fmem,
+      void *const *p_data_arr,
+      int items_cnt
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   if (fmem == TN_NULL || p_data_arr == TN_NULL || items_cnt <= 0){
+      rc = TN_RC_WPARAM;
+   } else if (!_tn_fmem_is_valid(fmem)){
+      rc = TN_RC_INVALID_OBJ;
+   }
+
+   return rc;
+}
 #else
-#  define _check_param_fmem_create(fmem)               (TN_RC_OK)
+#  define _check_param_fmem_create(fmem, wait_order)   (TN_RC_OK)
 #  define _check_param_fmem_delete(fmem)               (TN_RC_OK)
 #  define _check_param_job_perform(fmem, p_data)       (TN_RC_OK)
 #  define _check_param_generic(fmem)                   (TN_RC_OK)
+#  define _check_param_multi(fmem, p_data_arr, items_cnt)   (TN_RC_OK)
 #endif
 // }}}
 
 /**
- * Callback function that is given to `_tn_task_first_wait_complete()`
+ * Callback function that is given to `_tn_task_ordered_wait_complete()`
  * when task finishes waiting for free block in the memory pool.
  *
  * See `#_TN_CBBeforeTaskWaitComplete` for details on function signature.
@@ -201,12 +226,43 @@ _TN_STATIC_INLINE enum TN_RCode _fmem_get(struct TN_FMem *fmem, void **p_data)
    return rc;
 }
 
+/**
+ * Give memory block to the task that waits for free block in the pool
+ * (directly or by `tn_multi_wait()`), if any. If `wait_order` is
+ * `#TN_WAIT_ORDER_PRIORITY`, the highest-priority task from the wait queue
+ * is chosen; otherwise, the first one.
+ *
+ * @param fmem
+ *    Memory pool
+ * @param p_data
+ *    Pointer to the memory block to give.
+ *
+ * @return
+ *    - `TN_TRUE` if some task was waiting and the block was given to it;
+ *    - `TN_FALSE` if nobody waits for free block.
+ */
+_TN_STATIC_INLINE TN_BOOL _fmem_waiting_task_give(
+      struct TN_FMem *fmem,
+      void *p_data
+      )
+{
+   return (
+         _tn_task_ordered_wait_complete(
+            &fmem->wait_queue, fmem->wait_order, TN_RC_OK,
+            _cb_before_task_wait_complete, p_data, TN_NULL
+            )
+#if TN_USE_MULTI_WAIT
+         || _tn_multi_wait_first_complete(&fmem->multi_wait_list, p_data)
+#endif
+         );
+}
+
 /**
  * Return memory block to the pool.
  *
  * First of all, check if there is some task that waits for free block
- * in the pool. If there is, the block is given to it, task is woken up, and
- * the memory pool isn't altered at all.
+ * in the pool (directly or by `tn_multi_wait()`). If there is, the block is
+ * given to it, task is woken up, and the memory pool isn't altered at all.
  *
  * If there aren't waiting tasks, then put memory block to the pool.
  *
@@ -226,13 +282,9 @@ _TN_STATIC_INLINE enum TN_RCode _fmem_release(struct TN_FMem *fmem, void *p_data
    enum TN_RCode rc = TN_RC_OK;
 
    //-- Check if there are tasks waiting for memory block. If there is,
-   //   give the block to the first task from the queue.
-   if (  !_tn_task_first_wait_complete(
-            &fmem->wait_queue, TN_RC_OK,
-            _cb_before_task_wait_complete, p_data, TN_NULL
-            )
-      )
-   {
+   //   give the block to the first (or the highest-priority one,
+   //   depending on `wait_order`) task from the queue.
+   if (!_fmem_waiting_task_give(fmem, p_data)){
       //-- no task is waiting for free memory block, so,
       //   insert in to the memory pool
 
@@ -259,6 +311,113 @@ _TN_STATIC_INLINE enum TN_RCode _fmem_release(struct TN_FMem *fmem, void *p_data
    return rc;
 }
 
+/**
+ * Try to allocate up to `items_cnt` memory blocks from the pool at once.
+ *
+ * The blocks are detached from the head of the free list as a single chain,
+ * and their addresses are stored to `p_data_arr`.
+ *
+ * @param fmem
+ *    Memory pool from which blocks should be taken
+ * @param p_data_arr
+ *    Array to store addresses of allocated blocks to
+ * @param items_cnt
+ *    Max number of blocks to allocate
+ * @param p_got_cnt
+ *    Location to store the number of actually allocated blocks to
+ *
+ * @return
+ *    - `#TN_RC_OK`, if at least one block was allocated;
+ *    - `#TN_RC_TIMEOUT`, if there are no free blocks in the pool.
+ */
+static enum TN_RCode _fmem_get_multi(
+      struct TN_FMem *fmem,
+      void **p_data_arr,
+      int items_cnt,
+      int *p_got_cnt
+      )
+{
+   enum TN_RCode rc = TN_RC_TIMEOUT;
+   void *ptr = fmem->free_list;
+   int got_cnt = 0;
+
+   if (items_cnt > fmem->free_blocks_cnt){
+      items_cnt = fmem->free_blocks_cnt;
+   }
+
+   //-- walk the free list, storing block addresses to the user's array
+   while (got_cnt < items_cnt){
+      p_data_arr[got_cnt++] = ptr;
+      ptr = *(void **)ptr;
+   }
+
+   if (got_cnt > 0){
+      //-- detach the whole chain from the free list at once
+      fmem->free_list = ptr;
+      fmem->free_blocks_cnt -= got_cnt;
+      rc = TN_RC_OK;
+   }
+
+   *p_got_cnt = got_cnt;
+
+   return rc;
+}
+
+/**
+ * Return `items_cnt` memory blocks to the pool at once.
+ *
+ * Blocks are given to the waiting tasks (one block per task, see
+ * `_fmem_release()`) while there are any, and the rest are linked in a chain
+ * which is put to the head of the free list at once.
+ *
+ * @param fmem
+ *    Memory pool
+ * @param p_data_arr
+ *    Array of addresses of the memory blocks to release
+ * @param items_cnt
+ *    Number of elements in `p_data_arr`
+ *
+ * @return
+ *    - `#TN_RC_OK`, if operation was successful
+ *    - `#TN_RC_OVERFLOW`, if the number of blocks to release is larger than
+ *      the number of currently allocated blocks. In this case, nothing is
+ *      released.
+ */
+static enum TN_RCode _fmem_release_multi(
+      struct TN_FMem *fmem,
+      void *const *p_data_arr,
+      int items_cnt
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+   int i = 0;
+
+   if (items_cnt > (fmem->blocks_cnt - fmem->free_blocks_cnt)){
+      //-- we're asked to release more blocks than allocated
+      rc = TN_RC_OVERFLOW;
+   } else {
+      //-- wake up as many waiting tasks as we can
+      while (i < items_cnt && _fmem_waiting_task_give(fmem, p_data_arr[i])){
+         i++;
+      }
+
+      if (i < items_cnt){
+         int j;
+
+         //-- no more waiting tasks: link the rest of blocks in a chain,
+         //   and put it to the head of the free list
+         for (j = i; j < (items_cnt - 1); j++){
+            *(void **)p_data_arr[j] = p_data_arr[j + 1];
+         }
+         *(void **)p_data_arr[items_cnt - 1] = fmem->free_list;
+
+         fmem->free_list = p_data_arr[i];
+         fmem->free_blocks_cnt += (items_cnt - i);
+      }
+   }
+
+   return rc;
+}
 
 
 
@@ -270,16 +429,17 @@ _TN_STATIC_INLINE enum TN_RCode _fmem_release(struct TN_FMem *fmem, void *p_data
 /*
  * See comments in the header file (tn_dqueue.h)
  */
-enum TN_RCode tn_fmem_create(
-      struct TN_FMem   *fmem,
-      void             *start_addr,
-      unsigned int      block_size,
-      int               blocks_cnt
+enum TN_RCode tn_fmem_create_wattr(
+      struct TN_FMem      *fmem,
+      void                *start_addr,
+      unsigned int         block_size,
+      int                  blocks_cnt,
+      enum TN_WaitOrder    wait_order
       )
 {
    enum TN_RCode rc;
 
-   rc = _check_param_fmem_create(fmem);
+   rc = _check_param_fmem_create(fmem, wait_order);
    if (rc != TN_RC_OK){
       goto out;
    }
@@ -316,9 +476,13 @@ enum TN_RCode tn_fmem_create(
    fmem->start_addr = start_addr;
    fmem->block_size = block_size;
    fmem->blocks_cnt = blocks_cnt;
+   fmem->wait_order = wait_order;
 
    //-- reset wait_queue
    _tn_list_reset(&(fmem->wait_queue));
+#if TN_USE_MULTI_WAIT
+   _tn_list_reset(&(fmem->multi_wait_list));
+#endif
 
    //-- init block pointers
    {
@@ -343,6 +507,7 @@ enum TN_RCode tn_fmem_create(
    fmem->id_fmp = TN_ID_FSMEMORYPOOL;
 
 out:
+   _TN_TRACE(TN_TRACE_EV_FMEM_CREATE, fmem, rc);
    return rc;
 }
 
@@ -365,6 +530,9 @@ enum TN_RCode tn_fmem_delete(struct TN_FMem *fmem)
 
       //-- remove all tasks (if any) from fmem's wait queue
       _tn_wait_queue_notify_deleted(&(fmem->wait_queue));
+#if TN_USE_MULTI_WAIT
+      _tn_multi_wait_notify_deleted(&(fmem->multi_wait_list));
+#endif
 
       fmem->id_fmp = TN_ID_NONE;   //-- Fixed-size memory pool does not exist now
 
@@ -375,6 +543,7 @@ enum TN_RCode tn_fmem_delete(struct TN_FMem *fmem)
       _tn_context_switch_pend_if_needed();
 
    }
+   _TN_TRACE(TN_TRACE_EV_FMEM_DELETE, fmem, rc);
    return rc;
 }
 
@@ -427,6 +596,7 @@ enum TN_RCode tn_fmem_get(
       }
 
    }
+   _TN_TRACE(TN_TRACE_EV_FMEM_GET, fmem, rc);
    return rc;
 }
 
@@ -450,6 +620,7 @@ enum TN_RCode tn_fmem_get_polling(struct TN_FMem *fmem,void **p_data)
       TN_INT_RESTORE();
    }
 
+   _TN_TRACE(TN_TRACE_EV_FMEM_GET, fmem, rc);
    return rc;
 }
 
@@ -475,6 +646,7 @@ enum TN_RCode tn_fmem_iget_polling(struct TN_FMem *fmem, void **p_data)
       TN_INT_IRESTORE();
       _TN_CONTEXT_SWITCH_IPEND_IF_NEEDED();
    }
+   _TN_TRACE(TN_TRACE_EV_FMEM_GET, fmem, rc);
    return rc;
 }
 
@@ -500,6 +672,7 @@ enum TN_RCode tn_fmem_release(struct TN_FMem *fmem, void *p_data)
       TN_INT_RESTORE();
       _tn_context_switch_pend_if_needed();
    }
+   _TN_TRACE(TN_TRACE_EV_FMEM_RELEASE, fmem, rc);
    return rc;
 }
 
@@ -526,6 +699,165 @@ enum TN_RCode tn_fmem_irelease(struct TN_FMem *fmem, void *p_data)
       _TN_CONTEXT_SWITCH_IPEND_IF_NEEDED();
    }
 
+   _TN_TRACE(TN_TRACE_EV_FMEM_RELEASE, fmem, rc);
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_fmem.h)
+ */
+enum TN_RCode tn_fmem_get_multi(
+      struct TN_FMem *fmem,
+      void **p_data_arr,
+      int items_cnt,
+      int *p_got_cnt,
+      TN_TickCnt timeout
+      )
+{
+   TN_BOOL waited_for_data = TN_FALSE;
+   int got_cnt = 0;
+   enum TN_RCode rc = _check_param_multi(fmem, p_data_arr, items_cnt);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_task_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_INTSAVE_DATA;
+
+      TN_INT_DIS_SAVE();
+
+      rc = _fmem_get_multi(fmem, p_data_arr, items_cnt, &got_cnt);
+
+      if (rc == TN_RC_TIMEOUT && timeout > 0){
+         //-- the pool is empty: wait for one block only
+         _tn_task_curr_to_wait_action(
+               &(fmem->wait_queue),
+               TN_WAIT_REASON_WFIXMEM,
+               timeout
+               );
+         waited_for_data = TN_TRUE;
+      }
+
+      TN_INT_RESTORE();
+      _tn_context_switch_pend_if_needed();
+      if (waited_for_data){
+
+         //-- get wait result
+         rc = _tn_curr_run_task->task_wait_rc;
+
+         if (rc == TN_RC_OK){
+            p_data_arr[0] = _tn_curr_run_task->subsys_wait.fmem.data_elem;
+            got_cnt = 1;
+         }
+
+      }
+
+   }
+
+   if (p_got_cnt != TN_NULL){
+      *p_got_cnt = got_cnt;
+   }
+
+   _TN_TRACE(TN_TRACE_EV_FMEM_GET, fmem, rc);
+   return rc;
+}
+
+
+/*
+ * See comments in the header file (tn_fmem.h)
+ */
+enum TN_RCode tn_fmem_iget_multi(
+      struct TN_FMem *fmem,
+      void **p_data_arr,
+      int items_cnt,
+      int *p_got_cnt
+      )
+{
+   int got_cnt = 0;
+   enum TN_RCode rc = _check_param_multi(fmem, p_data_arr, items_cnt);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_isr_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_INTSAVE_DATA_INT;
+
+      TN_INT_IDIS_SAVE();
+
+      rc = _fmem_get_multi(fmem, p_data_arr, items_cnt, &got_cnt);
+
+      TN_INT_IRESTORE();
+      _TN_CONTEXT_SWITCH_IPEND_IF_NEEDED();
+   }
+
+   if (p_got_cnt != TN_NULL){
+      *p_got_cnt = got_cnt;
+   }
+
+   _TN_TRACE(TN_TRACE_EV_FMEM_GET, fmem, rc);
+   return rc;
+}
+
+
+/*
+ * See comments in the header file (tn_fmem.h)
+ */
+enum TN_RCode tn_fmem_release_multi(
+      struct TN_FMem *fmem,
+      void *const *p_data_arr,
+      int items_cnt
+      )
+{
+   enum TN_RCode rc = _check_param_multi(fmem, p_data_arr, items_cnt);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_task_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_INTSAVE_DATA;
+
+      TN_INT_DIS_SAVE();
+
+      rc = _fmem_release_multi(fmem, p_data_arr, items_cnt);
+
+      TN_INT_RESTORE();
+      _tn_context_switch_pend_if_needed();
+   }
+   _TN_TRACE(TN_TRACE_EV_FMEM_RELEASE, fmem, rc);
+   return rc;
+}
+
+
+/*
+ * See comments in the header file (tn_fmem.h)
+ */
+enum TN_RCode tn_fmem_irelease_multi(
+      struct TN_FMem *fmem,
+      void *const *p_data_arr,
+      int items_cnt
+      )
+{
+   enum TN_RCode rc = _check_param_multi(fmem, p_data_arr, items_cnt);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_isr_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_INTSAVE_DATA_INT;
+
+      TN_INT_IDIS_SAVE();
+
+      rc = _fmem_release_multi(fmem, p_data_arr, items_cnt);
+
+      TN_INT_IRESTORE();
+      _TN_CONTEXT_SWITCH_IPEND_IF_NEEDED();
+   }
+
+   _TN_TRACE(TN_TRACE_EV_FMEM_RELEASE, fmem, rc);
    return rc;
 }
 
@@ -564,3 +896,32 @@ int tn_fmem_used_blocks_cnt_get(struct TN_FMem *fmem)
    return ret;
 }
 
+
+
+/*******************************************************************************
+ *    PROTECTED FUNCTIONS
+ ******************************************************************************/
+
+/**
+ * See comments in the file _tn_fmem.h
+ */
+enum TN_RCode _tn_fmem_get(struct TN_FMem *fmem, void **p_data)
+{
+   //-- interrupts should be disabled here
+   _TN_BUG_ON( !TN_IS_INT_DISABLED() );
+
+   return _fmem_get(fmem, p_data);
+}
+
+/**
+ * See comments in the file _tn_fmem.h
+ */
+enum TN_RCode _tn_fmem_release(struct TN_FMem *fmem, void *p_data)
+{
+   //-- interrupts should be disabled here
+   _TN_BUG_ON( !TN_IS_INT_DISABLED() );
+
+   return _fmem_release(fmem, p_data);
+}
+
+
@@ -63,6 +63,7 @@
 
 #include "tn_list.h"
 #include "tn_common.h"
+#include "tn_sys.h"
 
 
 
@@ -86,6 +87,12 @@ struct TN_FMem {
    ///
    /// list of tasks waiting for free memory block
    struct TN_ListItem   wait_queue;
+#if TN_USE_MULTI_WAIT || defined(DOXYGEN_ACTIVE)
+   ///
+   /// list of items of tasks waiting for free memory block by
+   /// `tn_multi_wait()`, available if only `#TN_USE_MULTI_WAIT` is non-zero.
+   struct TN_ListItem   multi_wait_list;
+#endif
 
    ///
    /// block size (in bytes); note that it should be a multiple of
@@ -108,6 +115,9 @@ struct TN_FMem {
    /// pointer to the next free memory block as the first word, or `NULL` if
    /// this is the last block.
    void                *free_list;
+   ///
+   /// order in which waiting tasks are served, see `tn_fmem_create_wattr()`
+   enum TN_WaitOrder    wait_order;
 };
 
 
@@ -156,6 +166,28 @@ struct TN_FMemTaskWait {
  *    PUBLIC FUNCTION PROTOTYPES
  ******************************************************************************/
 
+/**
+ * The same as `tn_fmem_create()`, but takes additional argument:
+ * `wait_order`. If it is `#TN_WAIT_ORDER_PRIORITY`, then the task with the
+ * highest priority gets the released block first, no matter when it has
+ * started waiting.
+ *
+ * @param fmem       pointer to already allocated `struct TN_FMem`.
+ * @param start_addr pointer to start of the array; should be aligned properly
+ * @param block_size size of memory block; should be a multiple of 
+ *                   `sizeof(#TN_UWord)`
+ * @param blocks_cnt capacity (total number of blocks in the memory pool)
+ * @param wait_order order in which waiting tasks are served,
+ *                   see `enum #TN_WaitOrder`
+ */
+enum TN_RCode tn_fmem_create_wattr(
+      struct TN_FMem      *fmem,
+      void                *start_addr,
+      unsigned int         block_size,
+      int                  blocks_cnt,
+      enum TN_WaitOrder    wait_order
+      );
+
 /**
  * Construct fixed memory blocks pool. `id_fmp` field should not contain
  * `#TN_ID_FSMEMORYPOOL`, otherwise, `#TN_RC_WPARAM` is returned.
@@ -200,6 +232,8 @@ struct TN_FMemTaskWait {
  * If given `start_addr` and/or `block_size` aren't aligned properly,
  * `#TN_RC_WPARAM` is returned.
  *
+ * Waiting tasks are served in FIFO order, see `tn_fmem_create_wattr()`.
+ *
  * $(TN_CALL_FROM_TASK)
  * $(TN_CALL_FROM_ISR)
  * $(TN_LEGEND_LINK)
@@ -218,12 +252,17 @@ struct TN_FMemTaskWait {
  *
  * @see TN_MAKE_ALIG_SIZE
  */
-enum TN_RCode tn_fmem_create(
+_TN_STATIC_INLINE enum TN_RCode tn_fmem_create(
       struct TN_FMem   *fmem,
       void             *start_addr,
       unsigned int      block_size,
       int               blocks_cnt
-      );
+      )
+{
+   return tn_fmem_create_wattr(
+         fmem, start_addr, block_size, blocks_cnt, TN_WAIT_ORDER_FIFO
+         );
+}
 
 /**
  * Destruct fixed memory blocks pool.
@@ -329,6 +368,115 @@ enum TN_RCode tn_fmem_release(struct TN_FMem *fmem, void *p_data);
  */
 enum TN_RCode tn_fmem_irelease(struct TN_FMem *fmem, void *p_data);
 
+/**
+ * Get up to `items_cnt` memory blocks from the pool in one critical section,
+ * and store their start addresses to the array `p_data_arr`. This is much
+ * cheaper than calling `tn_fmem_get()` for each block, since interrupts are
+ * disabled, parameters are checked and context switch is pended just once
+ * for the whole batch. The number of obtained blocks is stored at
+ * `p_got_cnt`.
+ *
+ * If there is at least one free block in the pool, the function returns
+ * `#TN_RC_OK` immediately. If the pool is empty, behavior depends on the
+ * `timeout` value (refer to `#TN_TickCnt`): the task waits for one block,
+ * and if it is obtained, `*p_got_cnt` is set to 1.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_CAN_SLEEP)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param fmem
+ *    Pointer to memory pool
+ * @param p_data_arr
+ *    Array to store addresses of obtained blocks to
+ * @param items_cnt
+ *    Number of elements in `p_data_arr`, should be positive
+ * @param p_got_cnt
+ *    Pointer to location to store the number of obtained blocks.
+ *    Can be `#TN_NULL`.
+ * @param timeout    
+ *    Refer to `#TN_TickCnt`
+ *
+ * @return
+ *    * `#TN_RC_OK` if at least one block was obtained;
+ *    * `#TN_RC_WCONTEXT` if called from wrong context;
+ *    * Other possible return codes depend on `timeout` value,
+ *      refer to `#TN_TickCnt`
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_fmem_get_multi(
+      struct TN_FMem *fmem,
+      void **p_data_arr,
+      int items_cnt,
+      int *p_got_cnt,
+      TN_TickCnt timeout
+      );
+
+/**
+ * The same as `tn_fmem_get_multi()` with zero timeout, but for using in the
+ * ISR.
+ *
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ */
+enum TN_RCode tn_fmem_iget_multi(
+      struct TN_FMem *fmem,
+      void **p_data_arr,
+      int items_cnt,
+      int *p_got_cnt
+      );
+
+/**
+ * Release `items_cnt` memory blocks back to the pool in one critical
+ * section. Blocks are given to the tasks waiting for free block (one block
+ * per task) while there are any, and the rest are put to the pool as a
+ * single chain.
+ *
+ * If `items_cnt` is larger than the number of currently allocated blocks,
+ * `#TN_RC_OVERFLOW` is returned, and nothing is released. Just like
+ * `tn_fmem_release()`, the kernel does not check the validity of the
+ * membership of given blocks in the memory pool.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param fmem
+ *    Pointer to memory pool.
+ * @param p_data_arr
+ *    Array of addresses of the memory blocks to release.
+ * @param items_cnt
+ *    Number of elements in `p_data_arr`, should be positive
+ *
+ * @return
+ *    * `#TN_RC_OK` on success
+ *    * `#TN_RC_OVERFLOW` if there are less allocated blocks than `items_cnt`;
+ *    * `#TN_RC_WCONTEXT` if called from wrong context;
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_fmem_release_multi(
+      struct TN_FMem *fmem,
+      void *const *p_data_arr,
+      int items_cnt
+      );
+
+/**
+ * The same as `tn_fmem_release_multi()`, but for using in the ISR.
+ *
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ */
+enum TN_RCode tn_fmem_irelease_multi(
+      struct TN_FMem *fmem,
+      void *const *p_data_arr,
+      int items_cnt
+      );
+
 /**
  * Returns number of free blocks in the memory pool
  *
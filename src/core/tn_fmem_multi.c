@@ -0,0 +1,547 @@
+/*******************************************************************************
+ *
+ * TNeo: real-time kernel initially based on TNKernel
+ *
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
+ *
+ *    TNeo was born as a thorough review and re-implementation of
+ *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
+ *    as well as new features being added, and it is tested carefully with
+ *    unit-tests.
+ *
+ *    API is changed somewhat, so it's not 100% compatible with TNKernel,
+ *    hence the new name: TNeo.
+ *
+ *    Permission to use, copy, modify, and distribute this software in source
+ *    and binary forms and its documentation for any purpose and without fee
+ *    is hereby granted, provided that the above copyright notice appear
+ *    in all copies and that both that copyright notice and this permission
+ *    notice appear in supporting documentation.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE DMITRY FRANK AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DMITRY FRANK OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *    THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+/*******************************************************************************
+ *    INCLUDED FILES
+ ******************************************************************************/
+
+#include "tn_common.h"
+#include "tn_sys.h"
+
+//-- internal tnkernel headers
+#include "_tn_tasks.h"
+#include "_tn_list.h"
+#include "_tn_fmem.h"
+#include "_tn_trace.h"
+
+
+#include "tn_fmem_multi.h"
+#include "_tn_fmem_multi.h"
+
+#include "tn_tasks.h"
+
+
+
+
+/*******************************************************************************
+ *    PRIVATE FUNCTIONS
+ ******************************************************************************/
+
+//-- Additional param checking {{{
+#if TN_CHECK_PARAM
+_TN_STATIC_INLINE enum TN_RCode _check_param_generic(
+      const struct TN_FMemMulti *fmem_multi
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   if (fmem_multi == TN_NULL){
+      rc = TN_RC_WPARAM;
+   } else if (!_tn_fmem_multi_is_valid(fmem_multi)){
+      rc = TN_RC_INVALID_OBJ;
+   }
+
+   return rc;
+}
+
+_TN_STATIC_INLINE enum TN_RCode _check_param_create(
+      const struct TN_FMemMulti *fmem_multi,
+      struct TN_FMem *classes,
+      int classes_cnt
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   if (fmem_multi == TN_NULL || classes == TN_NULL){
+      rc = TN_RC_WPARAM;
+   } else if (classes_cnt <= 0 || _tn_fmem_multi_is_valid(fmem_multi)){
+      rc = TN_RC_WPARAM;
+   }
+
+   return rc;
+}
+
+_TN_STATIC_INLINE enum TN_RCode _check_param_job(void *p)
+{
+   return (p == TN_NULL) ? TN_RC_WPARAM : TN_RC_OK;
+}
+
+#else
+#  define _check_param_generic(fmem_multi)                      (TN_RC_OK)
+#  define _check_param_create(fmem_multi, classes, classes_cnt) (TN_RC_OK)
+#  define _check_param_job(p)                                   (TN_RC_OK)
+#endif
+// }}}
+
+/**
+ * Returns index of the smallest size class whose blocks fit `size` bytes,
+ * or `classes_cnt` if `size` is too large for all of them.
+ */
+static int _class_idx_by_size(
+      const struct TN_FMemMulti *fmem_multi,
+      unsigned int size
+      )
+{
+   int i = 0;
+
+   while (     i < fmem_multi->classes_cnt
+            && fmem_multi->classes[i].block_size < size
+         )
+   {
+      i++;
+   }
+
+   return i;
+}
+
+/**
+ * Returns size class to which the block with given address belongs,
+ * or `TN_NULL` if it doesn't belong to any of them.
+ */
+static struct TN_FMem *_class_by_addr(
+      const struct TN_FMemMulti *fmem_multi,
+      void *p_data
+      )
+{
+   struct TN_FMem *ret = TN_NULL;
+   TN_UIntPtr addr = (TN_UIntPtr)p_data;
+   int i;
+
+   for (i = 0; i < fmem_multi->classes_cnt && ret == TN_NULL; i++){
+      struct TN_FMem *cls = &fmem_multi->classes[i];
+      TN_UIntPtr start = (TN_UIntPtr)cls->start_addr;
+
+      if (     addr >= start
+            && (addr - start) < (TN_UIntPtr)cls->block_size * cls->blocks_cnt
+            && (addr - start) % cls->block_size == 0
+         )
+      {
+         ret = cls;
+      }
+   }
+
+   return ret;
+}
+
+/**
+ * Returns index of the least significant set bit of `x`; `x` must not be 0.
+ */
+_TN_STATIC_INLINE int _ffs(unsigned int x)
+{
+#ifdef _TN_FFS
+   return _TN_FFS((int)x) - 1;
+#else
+   int bit = 0;
+
+   while ((x & 1) == 0){
+      x >>= 1;
+      bit++;
+   }
+
+   return bit;
+#endif
+}
+
+/**
+ * Returns the first task which waits for the block that a block of the class
+ * `cls_idx` fits, or `TN_NULL` if there are no such tasks.
+ *
+ * Tasks wait in the queue of the smallest class which fits the requested
+ * size, so the block fits tasks of classes from 0 to `cls_idx`: the first
+ * task of the smallest of them which has waiting tasks is taken. The bit of
+ * the class is cleared lazily, when its queue is found empty (waiting tasks
+ * might leave the queue on timeout, etc), so that each iteration clears one
+ * bit: the loop is bounded by the number of classes.
+ */
+static struct TN_Task *_waiting_task_find(
+      struct TN_FMemMulti *fmem_multi,
+      int cls_idx
+      )
+{
+   struct TN_Task *ret = TN_NULL;
+
+   //-- bits of classes from 0 to `cls_idx`, inclusive
+   unsigned int mask = (1u << cls_idx) | ((1u << cls_idx) - 1);
+
+   while (ret == TN_NULL && (fmem_multi->wait_bmp & mask) != 0){
+      int i = _ffs(fmem_multi->wait_bmp & mask);
+      struct TN_ListItem *wait_queue = &fmem_multi->classes[i].wait_queue;
+
+      if (_tn_list_is_empty(wait_queue)){
+         fmem_multi->wait_bmp &= ~(1u << i);
+      } else {
+         ret = _tn_list_first_entry(wait_queue, struct TN_Task, task_queue);
+      }
+   }
+
+   return ret;
+}
+
+/**
+ * Try to allocate memory block of at least `size` bytes: take it from the
+ * smallest size class which fits `size` and has free blocks.
+ *
+ * If there is no such class, `#TN_RC_TIMEOUT` is returned, and this case
+ * can be handled by the caller. If `size` is too large for all classes,
+ * `#TN_RC_OVERFLOW` is returned.
+ */
+static enum TN_RCode _fmem_multi_get(
+      struct TN_FMemMulti *fmem_multi,
+      unsigned int size,
+      void **p_data
+      )
+{
+   enum TN_RCode rc = TN_RC_OVERFLOW;
+   int i = _class_idx_by_size(fmem_multi, size);
+
+   if (i < fmem_multi->classes_cnt){
+      //-- try the smallest suitable class first; if it is exhausted,
+      //   fall back to the next (larger) one, and so on.
+      rc = TN_RC_TIMEOUT;
+      for (; i < fmem_multi->classes_cnt && rc == TN_RC_TIMEOUT; i++){
+         rc = _tn_fmem_get(&fmem_multi->classes[i], p_data);
+      }
+   }
+
+   return rc;
+}
+
+/**
+ * Return memory block to the pool.
+ *
+ * If there is some task that waits for the block which this one fits, the
+ * block is given to it, and task is woken up. Otherwise, the block is
+ * returned to its size class.
+ */
+static enum TN_RCode _fmem_multi_release(
+      struct TN_FMemMulti *fmem_multi,
+      void *p_data
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+   struct TN_FMem *cls = _class_by_addr(fmem_multi, p_data);
+
+   if (cls == TN_NULL){
+      //-- the block doesn't belong to this pool
+      rc = TN_RC_WPARAM;
+   } else {
+      struct TN_Task *task = _waiting_task_find(
+            fmem_multi, (int)(cls - fmem_multi->classes)
+            );
+
+      if (task != TN_NULL){
+         //-- give the block right to the waiting task
+         task->subsys_wait.fmem_multi.data_elem = p_data;
+         _tn_task_wait_complete(task, TN_RC_OK);
+      } else {
+         rc = _tn_fmem_release(cls, p_data);
+      }
+   }
+
+   return rc;
+}
+
+
+
+
+
+/*******************************************************************************
+ *    PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+/*
+ * See comments in the header file (tn_fmem_multi.h)
+ */
+enum TN_RCode tn_fmem_multi_create(
+      struct TN_FMemMulti    *fmem_multi,
+      struct TN_FMem         *classes,
+      int                     classes_cnt
+      )
+{
+   enum TN_RCode rc = _check_param_create(fmem_multi, classes, classes_cnt);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else {
+      int i;
+
+      //-- each class has a bit in the `wait_bmp`
+      if (classes_cnt > TN_INT_WIDTH){
+         rc = TN_RC_WPARAM;
+      }
+
+      //-- all classes should be valid memory pools, sorted by block size
+      for (i = 0; i < classes_cnt && rc == TN_RC_OK; i++){
+         if (     !_tn_fmem_is_valid(&classes[i])
+               || (     i > 0
+                     && classes[i].block_size <= classes[i - 1].block_size)
+            )
+         {
+            rc = TN_RC_WPARAM;
+         }
+      }
+
+      if (rc == TN_RC_OK){
+         fmem_multi->wait_bmp       = 0;
+         fmem_multi->classes        = classes;
+         fmem_multi->classes_cnt    = classes_cnt;
+
+         fmem_multi->id_fmem_multi  = TN_ID_FMEM_MULTI;
+      }
+   }
+
+   _TN_TRACE(TN_TRACE_EV_FMEM_MULTI_CREATE, fmem_multi, rc);
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_fmem_multi.h)
+ */
+enum TN_RCode tn_fmem_multi_delete(struct TN_FMemMulti *fmem_multi)
+{
+   enum TN_RCode rc = _check_param_generic(fmem_multi);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_task_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_INTSAVE_DATA;
+      int i;
+
+      TN_INT_DIS_SAVE();
+
+      //-- remove all tasks (if any) from the wait queues of all classes
+      for (i = 0; i < fmem_multi->classes_cnt; i++){
+         _tn_wait_queue_notify_deleted(&(fmem_multi->classes[i].wait_queue));
+      }
+
+      fmem_multi->id_fmem_multi = TN_ID_NONE;
+
+      TN_INT_RESTORE();
+
+      //-- we might need to switch context if _tn_wait_queue_notify_deleted()
+      //   has woken up some high-priority task
+      _tn_context_switch_pend_if_needed();
+   }
+
+   _TN_TRACE(TN_TRACE_EV_FMEM_MULTI_DELETE, fmem_multi, rc);
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_fmem_multi.h)
+ */
+enum TN_RCode tn_fmem_multi_get(
+      struct TN_FMemMulti    *fmem_multi,
+      unsigned int            size,
+      void                  **p_data,
+      TN_TickCnt              timeout
+      )
+{
+   TN_BOOL waited_for_data = TN_FALSE;
+   enum TN_RCode rc = _check_param_generic(fmem_multi);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if ((rc = _check_param_job(p_data)) != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_task_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_INTSAVE_DATA;
+
+      TN_INT_DIS_SAVE();
+
+      rc = _fmem_multi_get(fmem_multi, size, p_data);
+
+      if (rc == TN_RC_TIMEOUT && timeout > 0){
+         //-- wait in the queue of the smallest class which fits `size`,
+         //   so that `_fmem_multi_release()` finds out whether released
+         //   block fits by the class index
+         int i = _class_idx_by_size(fmem_multi, size);
+
+         fmem_multi->wait_bmp |= (1u << i);
+         _tn_task_curr_to_wait_action(
+               &(fmem_multi->classes[i].wait_queue),
+               TN_WAIT_REASON_WFIXMEM_MULTI,
+               timeout
+               );
+         waited_for_data = TN_TRUE;
+      }
+
+      TN_INT_RESTORE();
+      _tn_context_switch_pend_if_needed();
+      if (waited_for_data){
+
+         //-- get wait result
+         rc = _tn_curr_run_task->task_wait_rc;
+
+         //-- if wait result is TN_RC_OK, copy memory block pointer to the
+         //   user's location
+         if (rc == TN_RC_OK){
+            *p_data = _tn_curr_run_task->subsys_wait.fmem_multi.data_elem;
+         }
+
+      }
+
+   }
+
+   _TN_TRACE(TN_TRACE_EV_FMEM_MULTI_GET, fmem_multi, rc);
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_fmem_multi.h)
+ */
+enum TN_RCode tn_fmem_multi_get_polling(
+      struct TN_FMemMulti    *fmem_multi,
+      unsigned int            size,
+      void                  **p_data
+      )
+{
+   enum TN_RCode rc = _check_param_generic(fmem_multi);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if ((rc = _check_param_job(p_data)) != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_task_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_INTSAVE_DATA;
+
+      TN_INT_DIS_SAVE();
+      rc = _fmem_multi_get(fmem_multi, size, p_data);
+      TN_INT_RESTORE();
+   }
+
+   _TN_TRACE(TN_TRACE_EV_FMEM_MULTI_GET, fmem_multi, rc);
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_fmem_multi.h)
+ */
+enum TN_RCode tn_fmem_multi_iget_polling(
+      struct TN_FMemMulti    *fmem_multi,
+      unsigned int            size,
+      void                  **p_data
+      )
+{
+   enum TN_RCode rc = _check_param_generic(fmem_multi);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if ((rc = _check_param_job(p_data)) != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_isr_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_INTSAVE_DATA_INT;
+
+      TN_INT_IDIS_SAVE();
+      rc = _fmem_multi_get(fmem_multi, size, p_data);
+      TN_INT_IRESTORE();
+   }
+
+   _TN_TRACE(TN_TRACE_EV_FMEM_MULTI_GET, fmem_multi, rc);
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_fmem_multi.h)
+ */
+enum TN_RCode tn_fmem_multi_release(
+      struct TN_FMemMulti    *fmem_multi,
+      void                   *p_data
+      )
+{
+   enum TN_RCode rc = _check_param_generic(fmem_multi);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if ((rc = _check_param_job(p_data)) != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_task_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_INTSAVE_DATA;
+
+      TN_INT_DIS_SAVE();
+
+      rc = _fmem_multi_release(fmem_multi, p_data);
+
+      TN_INT_RESTORE();
+      _tn_context_switch_pend_if_needed();
+   }
+
+   _TN_TRACE(TN_TRACE_EV_FMEM_MULTI_RELEASE, fmem_multi, rc);
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_fmem_multi.h)
+ */
+enum TN_RCode tn_fmem_multi_irelease(
+      struct TN_FMemMulti    *fmem_multi,
+      void                   *p_data
+      )
+{
+   enum TN_RCode rc = _check_param_generic(fmem_multi);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if ((rc = _check_param_job(p_data)) != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_isr_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_INTSAVE_DATA_INT;
+
+      TN_INT_IDIS_SAVE();
+
+      rc = _fmem_multi_release(fmem_multi, p_data);
+
+      TN_INT_IRESTORE();
+      _TN_CONTEXT_SWITCH_IPEND_IF_NEEDED();
+   }
+
+   _TN_TRACE(TN_TRACE_EV_FMEM_MULTI_RELEASE, fmem_multi, rc);
+   return rc;
+}
+
+
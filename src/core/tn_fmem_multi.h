@@ -0,0 +1,341 @@
+/*******************************************************************************
+ *
+ * TNeo: real-time kernel initially based on TNKernel
+ *
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
+ *
+ *    TNeo was born as a thorough review and re-implementation of
+ *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
+ *    as well as new features being added, and it is tested carefully with
+ *    unit-tests.
+ *
+ *    API is changed somewhat, so it's not 100% compatible with TNKernel,
+ *    hence the new name: TNeo.
+ *
+ *    Permission to use, copy, modify, and distribute this software in source
+ *    and binary forms and its documentation for any purpose and without fee
+ *    is hereby granted, provided that the above copyright notice appear
+ *    in all copies and that both that copyright notice and this permission
+ *    notice appear in supporting documentation.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE DMITRY FRANK AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DMITRY FRANK OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *    THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+/**
+ * \file
+ *
+ * Multi-size-class memory pool: a set of fixed memory pools (see
+ * \ref tn_fmem.h) with different block sizes, used as a single allocator of
+ * blocks of variable size.
+ *
+ * Each size class is just an ordinary `struct #TN_FMem` created by the
+ * application by `tn_fmem_create()`; the array of them, sorted by block size
+ * in ascending order, is given to `tn_fmem_multi_create()`. When the task
+ * asks for `size` bytes by `tn_fmem_multi_get()`, the block is taken from the
+ * smallest class whose blocks fit `size`; if this class is exhausted, the
+ * next (larger) class is tried, and so on. So, small requests don't eat
+ * large blocks while there are small ones available, and a single call site
+ * serves requests of any size.
+ *
+ * If there are no suitable free blocks at all, the task waits (depending on
+ * the `timeout`, as usual) until some block which fits the requested size
+ * is released by `tn_fmem_multi_release()`. The task waits in the wait queue
+ * of the smallest class which fits the requested size, and the pool keeps
+ * the bitmap of classes with waiting tasks. The released block is given
+ * right to the first task of the smallest class with waiting tasks which
+ * the block fits, otherwise it is returned to its class.
+ *
+ * Both getting and releasing the block take a time which doesn't depend on
+ * the number of blocks or on the number of waiting tasks: it only depends on
+ * the number of size classes (which is small and fixed), since the class is
+ * looked up by the requested size on get and by the block address on
+ * release, and the waiting task to give the released block to is found by
+ * the bitmap.
+ *
+ * \attention Pools given to `tn_fmem_multi_create()` are owned by the
+ * multi-size-class pool: the application should not get or release their
+ * blocks directly by `tn_fmem_get()` / `tn_fmem_release()`, and should not
+ * wait for them by `tn_multi_wait()`, otherwise tasks waiting in
+ * `tn_fmem_multi_get()` won't be woken up. The wait queues of these pools
+ * are used by `tn_fmem_multi_get()` for waiting tasks.
+ *
+ * Typical usage:
+ *
+ * \code{.c}
+ *     TN_FMEM_BUF_DEF(buf_16,  TN_UWord[ 16  / sizeof(TN_UWord)], 32);
+ *     TN_FMEM_BUF_DEF(buf_64,  TN_UWord[ 64  / sizeof(TN_UWord)], 16);
+ *     TN_FMEM_BUF_DEF(buf_256, TN_UWord[ 256 / sizeof(TN_UWord)], 4);
+ *
+ *     static struct TN_FMem my_classes[3];
+ *     static struct TN_FMemMulti my_pool;
+ *
+ *     void some_init(void)
+ *     {
+ *        tn_fmem_create(&my_classes[0], buf_16,  16,  32);
+ *        tn_fmem_create(&my_classes[1], buf_64,  64,  16);
+ *        tn_fmem_create(&my_classes[2], buf_256, 256, 4);
+ *
+ *        tn_fmem_multi_create(&my_pool, my_classes, 3);
+ *     }
+ *
+ *     void some_task_body(void *param)
+ *     {
+ *        void *p_msg;
+ *
+ *        if (tn_fmem_multi_get(
+ *                 &my_pool, 40, &p_msg, TN_WAIT_INFINITE
+ *                 ) == TN_RC_OK)
+ *        {
+ *           //-- p_msg points to the 64-byte block (or 256-byte one,
+ *           //   if 64-byte blocks were exhausted)
+ *           tn_fmem_multi_release(&my_pool, p_msg);
+ *        }
+ *     }
+ * \endcode
+ */
+
+#ifndef _TN_FMEM_MULTI_H
+#define _TN_FMEM_MULTI_H
+
+/*******************************************************************************
+ *    INCLUDED FILES
+ ******************************************************************************/
+
+#include "tn_list.h"
+#include "tn_common.h"
+#include "tn_fmem.h"
+
+
+
+#ifdef __cplusplus
+extern "C"  {  /*}*/
+#endif
+
+/*******************************************************************************
+ *    PUBLIC TYPES
+ ******************************************************************************/
+
+/**
+ * Multi-size-class memory pool
+ */
+struct TN_FMemMulti {
+   ///
+   /// id for object validity verification.
+   /// This field is in the beginning of the structure to make it easier
+   /// to detect memory corruption.
+   enum TN_ObjId        id_fmem_multi;
+   ///
+   /// bitmap of classes with waiting tasks: bit `i` is set if some task
+   /// might wait in the `wait_queue` of `classes[i]`
+   unsigned int         wait_bmp;
+   ///
+   /// array of size classes: already created fixed memory pools, sorted by
+   /// `block_size` in ascending order
+   struct TN_FMem      *classes;
+   ///
+   /// count of items in the `classes` array
+   int                  classes_cnt;
+};
+
+/**
+ * FMemMulti-specific fields related to waiting task,
+ * to be included in struct TN_Task.
+ */
+struct TN_FMemMultiTaskWait {
+   ///
+   /// if Task receives the block, this is the pointer to it
+   void          *data_elem;
+};
+
+
+/*******************************************************************************
+ *    PROTECTED GLOBAL DATA
+ ******************************************************************************/
+
+/*******************************************************************************
+ *    DEFINITIONS
+ ******************************************************************************/
+
+
+
+
+/*******************************************************************************
+ *    PUBLIC FUNCTION PROTOTYPES
+ ******************************************************************************/
+
+/**
+ * Construct multi-size-class memory pool. `id_fmem_multi` field should not
+ * contain `#TN_ID_FMEM_MULTI`, otherwise, `#TN_RC_WPARAM` is returned.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param fmem_multi    pointer to already allocated `struct TN_FMemMulti`.
+ * @param classes       array of already created fixed memory pools (see
+ *                      `tn_fmem_create()`), sorted by block size in
+ *                      ascending order; block sizes must be different.
+ * @param classes_cnt   count of items in the `classes` array, at most
+ *                      `#TN_INT_WIDTH`
+ *
+ * @return
+ *    * `#TN_RC_OK` if memory pool was successfully created;
+ *    * `#TN_RC_WPARAM` if wrong params were given: say, some of `classes`
+ *      isn't a valid fixed memory pool, classes aren't sorted properly, or
+ *      there are too many of them.
+ */
+enum TN_RCode tn_fmem_multi_create(
+      struct TN_FMemMulti    *fmem_multi,
+      struct TN_FMem         *classes,
+      int                     classes_cnt
+      );
+
+/**
+ * Destruct multi-size-class memory pool. All tasks that wait for free block
+ * become runnable with `#TN_RC_DELETED` code returned. Pools of size classes
+ * are left as they are, the application may delete them after that.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param fmem_multi    pointer to memory pool to be deleted
+ *
+ * @return
+ *    * `#TN_RC_OK` if memory pool is successfully deleted;
+ *    * `#TN_RC_WCONTEXT` if called from wrong context;
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_fmem_multi_delete(struct TN_FMemMulti *fmem_multi);
+
+/**
+ * Get memory block of at least `size` bytes. Start address of the memory
+ * block is returned through the `p_data` argument. The content of memory
+ * block is undefined.
+ *
+ * The block is taken from the smallest size class which fits `size` and
+ * has free blocks. If there are no such classes, behavior depends on
+ * `timeout` value: refer to `#TN_TickCnt`.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_CAN_SLEEP)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param fmem_multi
+ *    Pointer to memory pool
+ * @param size
+ *    Requested block size, in bytes
+ * @param p_data
+ *    Address of the `(void *)` to which received block address will be saved
+ * @param timeout
+ *    Refer to `#TN_TickCnt`
+ *
+ * @return
+ *    * `#TN_RC_OK` if block was successfully returned through `p_data`;
+ *    * `#TN_RC_OVERFLOW` if `size` is larger than the block size of the
+ *      largest class, so that the request can never be satisfied;
+ *    * `#TN_RC_WCONTEXT` if called from wrong context;
+ *    * Other possible return codes depend on `timeout` value,
+ *      refer to `#TN_TickCnt`
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_fmem_multi_get(
+      struct TN_FMemMulti    *fmem_multi,
+      unsigned int            size,
+      void                  **p_data,
+      TN_TickCnt              timeout
+      );
+
+/**
+ * The same as `tn_fmem_multi_get()` with zero timeout
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_LEGEND_LINK)
+ */
+enum TN_RCode tn_fmem_multi_get_polling(
+      struct TN_FMemMulti    *fmem_multi,
+      unsigned int            size,
+      void                  **p_data
+      );
+
+/**
+ * The same as `tn_fmem_multi_get()` with zero timeout, but for using in
+ * the ISR.
+ *
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ */
+enum TN_RCode tn_fmem_multi_iget_polling(
+      struct TN_FMemMulti    *fmem_multi,
+      unsigned int            size,
+      void                  **p_data
+      );
+
+/**
+ * Release memory block back to the memory pool. The size class of the block
+ * is determined by its address. If there are tasks waiting for a block which
+ * this one fits, the first task of the smallest class with waiting tasks
+ * gets the block and becomes runnable; otherwise, the block is returned to
+ * its class.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param fmem_multi
+ *    Pointer to memory pool.
+ * @param p_data
+ *    Address of the memory block to release.
+ *
+ * @return
+ *    * `#TN_RC_OK` on success;
+ *    * `#TN_RC_WPARAM` if `p_data` doesn't belong to any of size classes;
+ *    * `#TN_RC_OVERFLOW` if the class of the block already has all its
+ *      blocks free;
+ *    * `#TN_RC_WCONTEXT` if called from wrong context;
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_fmem_multi_release(
+      struct TN_FMemMulti    *fmem_multi,
+      void                   *p_data
+      );
+
+/**
+ * The same as `tn_fmem_multi_release()`, but for using in the ISR.
+ *
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ */
+enum TN_RCode tn_fmem_multi_irelease(
+      struct TN_FMemMulti    *fmem_multi,
+      void                   *p_data
+      );
+
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif // _TN_FMEM_MULTI_H
+
+/*******************************************************************************
+ *    end of file
+ ******************************************************************************/
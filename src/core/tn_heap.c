@@ -0,0 +1,1002 @@
+/*******************************************************************************
+ *
+ * TNeo: real-time kernel initially based on TNKernel
+ *
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
+ *
+ *    TNeo was born as a thorough review and re-implementation of
+ *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
+ *    as well as new features being added, and it is tested carefully with
+ *    unit-tests.
+ *
+ *    API is changed somewhat, so it's not 100% compatible with TNKernel,
+ *    hence the new name: TNeo.
+ *
+ *    Permission to use, copy, modify, and distribute this software in source
+ *    and binary forms and its documentation for any purpose and without fee
+ *    is hereby granted, provided that the above copyright notice appear
+ *    in all copies and that both that copyright notice and this permission
+ *    notice appear in supporting documentation.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE DMITRY FRANK AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DMITRY FRANK OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *    THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+/*******************************************************************************
+ *    INCLUDED FILES
+ ******************************************************************************/
+
+#include "tn_common.h"
+#include "tn_sys.h"
+
+//-- internal tnkernel headers
+#include "_tn_tasks.h"
+#include "_tn_list.h"
+#include "_tn_trace.h"
+
+
+#include "tn_heap.h"
+#include "_tn_heap.h"
+
+#include "tn_tasks.h"
+
+
+
+
+/*******************************************************************************
+ *    PRIVATE TYPES
+ ******************************************************************************/
+
+/**
+ * Block of the heap. Blocks follow each other in memory without gaps.
+ *
+ * Allocated block has just a header (`prev_phys` and `size_flags`), and
+ * user data follows it right away (at `#TN_HEAP_BLOCK_OVERHEAD` offset);
+ * free block keeps pointers to its neighbours in the free list in place of
+ * user data.
+ */
+struct _TN_HeapBlock {
+   ///
+   /// previous block in memory, or `TN_NULL` for the first block
+   struct _TN_HeapBlock *prev_phys;
+   ///
+   /// size of the block in bytes, including header. Since it is always
+   /// a multiple of `sizeof(#TN_UWord)`, the least significant bit is used
+   /// as a `_BLOCK_FREE` flag.
+   unsigned int size_flags;
+   ///
+   /// next block in the free list (for free blocks only)
+   struct _TN_HeapBlock *next_free;
+   ///
+   /// previous block in the free list (for free blocks only)
+   struct _TN_HeapBlock *prev_free;
+};
+
+
+
+/*******************************************************************************
+ *    DEFINITIONS
+ ******************************************************************************/
+
+//-- log2 of `TN_HEAP_SL_CNT`
+#define  _SL_LOG2          3
+
+//-- blocks smaller than this are all kept at the first-level index 0, in
+//   the lists which differ by `sizeof(TN_UWord)`
+#define  _SMALL_SIZE       (TN_HEAP_SL_CNT * sizeof(TN_UWord))
+
+#define  _BLOCK_HDR_SIZE   TN_HEAP_BLOCK_OVERHEAD
+#define  _BLOCK_MIN_SIZE   TN_MAKE_ALIG_SIZE(sizeof(struct _TN_HeapBlock))
+
+//-- flag in `size_flags`: block is free
+#define  _BLOCK_FREE       1u
+
+#if (TN_HEAP_SL_CNT != (1 << _SL_LOG2))
+#  error TN_HEAP_SL_CNT should be 2 ^ _SL_LOG2
+#endif
+
+
+
+/*******************************************************************************
+ *    PRIVATE FUNCTIONS
+ ******************************************************************************/
+
+//-- Additional param checking {{{
+#if TN_CHECK_PARAM
+_TN_STATIC_INLINE enum TN_RCode _check_param_generic(
+      const struct TN_Heap *heap
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   if (heap == TN_NULL){
+      rc = TN_RC_WPARAM;
+   } else if (!_tn_heap_is_valid(heap)){
+      rc = TN_RC_INVALID_OBJ;
+   }
+
+   return rc;
+}
+
+_TN_STATIC_INLINE enum TN_RCode _check_param_create(
+      const struct TN_Heap *heap,
+      void *start_addr
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   if (heap == TN_NULL || start_addr == TN_NULL){
+      rc = TN_RC_WPARAM;
+   } else if (_tn_heap_is_valid(heap)){
+      rc = TN_RC_WPARAM;
+   }
+
+   return rc;
+}
+
+_TN_STATIC_INLINE enum TN_RCode _check_param_job(const void *p)
+{
+   return (p == TN_NULL) ? TN_RC_WPARAM : TN_RC_OK;
+}
+
+#else
+#  define _check_param_generic(heap)                  (TN_RC_OK)
+#  define _check_param_create(heap, start_addr)       (TN_RC_OK)
+#  define _check_param_job(p)                         (TN_RC_OK)
+#endif
+// }}}
+
+//-- Bit operations {{{
+
+/**
+ * Returns index of the most significant set bit of `x`; `x` must not be 0.
+ */
+_TN_STATIC_INLINE int _fls(unsigned int x)
+{
+   int bit = 0;
+   int shift;
+
+   //-- binary search: takes log2 of the int width steps
+   for (shift = (int)(sizeof(x) * 8 / 2); shift > 0; shift >>= 1){
+      if ((x >> shift) != 0){
+         x >>= shift;
+         bit += shift;
+      }
+   }
+
+   return bit;
+}
+
+/**
+ * Returns index of the least significant set bit of `x`; `x` must not be 0.
+ */
+_TN_STATIC_INLINE int _ffs(unsigned int x)
+{
+#ifdef _TN_FFS
+   return _TN_FFS((int)x) - 1;
+#else
+   int bit = 0;
+
+   while ((x & 1) == 0){
+      x >>= 1;
+      bit++;
+   }
+
+   return bit;
+#endif
+}
+
+// }}}
+
+//-- Blocks and free lists {{{
+
+_TN_STATIC_INLINE unsigned int _block_size(const struct _TN_HeapBlock *block)
+{
+   return block->size_flags & ~_BLOCK_FREE;
+}
+
+_TN_STATIC_INLINE TN_BOOL _block_is_free(const struct _TN_HeapBlock *block)
+{
+   return !!(block->size_flags & _BLOCK_FREE);
+}
+
+/**
+ * Returns the block which follows given one in memory, or `TN_NULL` if the
+ * given block is the last one.
+ */
+static struct _TN_HeapBlock *_block_next_phys(
+      const struct TN_Heap *heap,
+      struct _TN_HeapBlock *block
+      )
+{
+   unsigned char *next = (unsigned char *)block + _block_size(block);
+
+   return (next < (unsigned char *)heap->first_block + heap->size)
+      ? (struct _TN_HeapBlock *)next
+      : TN_NULL;
+}
+
+/**
+ * Calculates first-level and second-level indexes of the free list which
+ * keeps blocks of given size.
+ */
+static void _mapping(unsigned int size, int *p_fl, int *p_sl)
+{
+   if (size < _SMALL_SIZE){
+      *p_fl = 0;
+      *p_sl = (int)(size / sizeof(TN_UWord));
+   } else {
+      int msb = _fls(size);
+
+      *p_fl = msb - _fls(_SMALL_SIZE) + 1;
+      *p_sl = (int)((size >> (msb - _SL_LOG2)) ^ TN_HEAP_SL_CNT);
+   }
+}
+
+/**
+ * Returns the size which should be looked for in the free lists, so that
+ * any block from the found list is large enough for the block of given
+ * size. That is, the size is rounded up to the next list boundary.
+ */
+static unsigned int _search_size(unsigned int size)
+{
+   if (size >= _SMALL_SIZE){
+      size += (1u << (_fls(size) - _SL_LOG2)) - 1;
+   }
+   return size;
+}
+
+/**
+ * Put free block to the appropriate free list, and mark it as free.
+ */
+static void _free_list_insert(
+      struct TN_Heap *heap,
+      struct _TN_HeapBlock *block
+      )
+{
+   unsigned int size = _block_size(block);
+   struct _TN_HeapBlock **p_head;
+   int fl, sl;
+
+   _mapping(size, &fl, &sl);
+   p_head = &heap->free_lists[fl * TN_HEAP_SL_CNT + sl];
+
+   block->next_free = *p_head;
+   block->prev_free = TN_NULL;
+   if (*p_head != TN_NULL){
+      (*p_head)->prev_free = block;
+   }
+   *p_head = block;
+
+   heap->sl_bmps[fl] |= (unsigned char)(1u << sl);
+   heap->fl_bmp      |= (1u << fl);
+
+   block->size_flags |= _BLOCK_FREE;
+   heap->free_size   += size;
+   heap->free_blocks_cnt++;
+}
+
+/**
+ * Remove free block from its free list, and mark it as allocated.
+ */
+static void _free_list_remove(
+      struct TN_Heap *heap,
+      struct _TN_HeapBlock *block
+      )
+{
+   unsigned int size = _block_size(block);
+   int fl, sl;
+
+   _mapping(size, &fl, &sl);
+
+   if (block->prev_free != TN_NULL){
+      block->prev_free->next_free = block->next_free;
+   } else {
+      heap->free_lists[fl * TN_HEAP_SL_CNT + sl] = block->next_free;
+
+      if (block->next_free == TN_NULL){
+         //-- the list became empty
+         heap->sl_bmps[fl] &= (unsigned char)~(1u << sl);
+         if (heap->sl_bmps[fl] == 0){
+            heap->fl_bmp &= ~(1u << fl);
+         }
+      }
+   }
+
+   if (block->next_free != TN_NULL){
+      block->next_free->prev_free = block->prev_free;
+   }
+
+   block->size_flags &= ~_BLOCK_FREE;
+   heap->free_size   -= size;
+   heap->free_blocks_cnt--;
+}
+
+/**
+ * Find free block of at least `search_size` bytes (the size should be
+ * already rounded by `_search_size()`), or return `TN_NULL` if there is
+ * no such block. The block isn't removed from the free list.
+ */
+static struct _TN_HeapBlock *_free_block_find(
+      const struct TN_Heap *heap,
+      unsigned int search_size
+      )
+{
+   struct _TN_HeapBlock *ret = TN_NULL;
+   unsigned int sl_bmp = 0;
+   int fl, sl;
+
+   _mapping(search_size, &fl, &sl);
+
+   if (fl < heap->fl_cnt){
+      //-- first, look for the non-empty list of the same first-level index
+      sl_bmp = heap->sl_bmps[fl] & (~0u << sl);
+
+      if (sl_bmp == 0 && (fl + 1) < TN_INT_WIDTH){
+         //-- there is no suitable list, so take the smallest non-empty
+         //   first-level index which is larger than ours
+         unsigned int fl_bmp = heap->fl_bmp & (~0u << (fl + 1));
+
+         if (fl_bmp != 0){
+            fl = _ffs(fl_bmp);
+            sl_bmp = heap->sl_bmps[fl];
+         }
+      }
+   }
+
+   if (sl_bmp != 0){
+      sl = _ffs(sl_bmp);
+      ret = heap->free_lists[fl * TN_HEAP_SL_CNT + sl];
+   }
+
+   return ret;
+}
+
+/**
+ * If the block is larger than `size` at least by the minimal block size,
+ * split it: the rest becomes a new free block.
+ */
+static void _block_split(
+      struct TN_Heap *heap,
+      struct _TN_HeapBlock *block,
+      unsigned int size
+      )
+{
+   unsigned int rest_size = _block_size(block) - size;
+
+   if (rest_size >= _BLOCK_MIN_SIZE){
+      struct _TN_HeapBlock *next = _block_next_phys(heap, block);
+      struct _TN_HeapBlock *rest = (struct _TN_HeapBlock *)(
+            (unsigned char *)block + size
+            );
+
+      rest->prev_phys   = block;
+      rest->size_flags  = rest_size;
+      if (next != TN_NULL){
+         next->prev_phys = rest;
+      }
+
+      block->size_flags = size;
+
+      _free_list_insert(heap, rest);
+   }
+}
+
+/**
+ * Merge the block with its free neighbours, and put the result to the
+ * free list.
+ */
+static void _block_release(
+      struct TN_Heap *heap,
+      struct _TN_HeapBlock *block
+      )
+{
+   struct _TN_HeapBlock *neighbour = _block_next_phys(heap, block);
+
+   if (neighbour != TN_NULL && _block_is_free(neighbour)){
+      //-- merge with the next block
+      _free_list_remove(heap, neighbour);
+      block->size_flags += _block_size(neighbour);
+
+      neighbour = _block_next_phys(heap, block);
+      if (neighbour != TN_NULL){
+         neighbour->prev_phys = block;
+      }
+   }
+
+   neighbour = block->prev_phys;
+   if (neighbour != TN_NULL && _block_is_free(neighbour)){
+      //-- merge with the previous block
+      _free_list_remove(heap, neighbour);
+      neighbour->size_flags += _block_size(block);
+      block = neighbour;
+
+      neighbour = _block_next_phys(heap, block);
+      if (neighbour != TN_NULL){
+         neighbour->prev_phys = block;
+      }
+   }
+
+   _free_list_insert(heap, block);
+}
+
+/**
+ * Returns the size of the block (including header) which is needed for the
+ * user data of given size, or 0 if the heap could never provide that much.
+ */
+static unsigned int _block_size_for_data(
+      const struct TN_Heap *heap,
+      unsigned int data_size
+      )
+{
+   unsigned int ret = 0;
+
+   //-- the first check also protects the calculation below from overflow
+   if (data_size <= heap->size){
+      ret = TN_MAKE_ALIG_SIZE(data_size) + _BLOCK_HDR_SIZE;
+      if (ret < _BLOCK_MIN_SIZE){
+         ret = _BLOCK_MIN_SIZE;
+      }
+
+      if (_search_size(ret) > heap->size){
+         ret = 0;
+      }
+   }
+
+   return ret;
+}
+
+/**
+ * Returns the block which contains given user data, or `TN_NULL` if
+ * `p_data` doesn't look like a pointer to the user data of the allocated
+ * block of this heap.
+ */
+static struct _TN_HeapBlock *_block_by_data(
+      const struct TN_Heap *heap,
+      void *p_data
+      )
+{
+   struct _TN_HeapBlock *ret = TN_NULL;
+   unsigned char *first = (unsigned char *)heap->first_block;
+   unsigned char *p = (unsigned char *)p_data;
+
+   if (     p >= first + _BLOCK_HDR_SIZE
+         && p <  first + heap->size
+         && TN_MAKE_ALIG_SIZE((TN_UIntPtr)p) == (TN_UIntPtr)p
+      )
+   {
+      struct _TN_HeapBlock *block = (struct _TN_HeapBlock *)(
+            p - _BLOCK_HDR_SIZE
+            );
+      struct _TN_HeapBlock *prev = block->prev_phys;
+
+      //-- the block should be allocated, and its previous block should
+      //   point to it (check that `prev` is inside the heap before reading
+      //   it, since `block` might be garbage)
+      if (     !_block_is_free(block)
+            && (prev == TN_NULL
+               ?  block == heap->first_block
+               :  (     prev >= heap->first_block
+                     && prev < block
+                     && _block_next_phys(heap, prev) == block)
+               )
+         )
+      {
+         ret = block;
+      }
+   }
+
+   return ret;
+}
+
+// }}}
+
+/**
+ * Try to allocate the block for the user data of `size` bytes, not taking
+ * waiting tasks into account.
+ *
+ * @return
+ *    - `#TN_RC_OK`, if block is allocated and its user data address is
+ *      stored at `p_data`;
+ *    - `#TN_RC_TIMEOUT`, if there is no free block large enough;
+ *    - `#TN_RC_OVERFLOW`, if the heap could never provide that much.
+ */
+static enum TN_RCode _block_alloc(
+      struct TN_Heap *heap,
+      unsigned int size,
+      void **p_data
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+   unsigned int block_size = _block_size_for_data(heap, size);
+
+   if (block_size == 0){
+      rc = TN_RC_OVERFLOW;
+   } else {
+      struct _TN_HeapBlock *block = _free_block_find(
+            heap, _search_size(block_size)
+            );
+
+      if (block == TN_NULL){
+         rc = TN_RC_TIMEOUT;
+      } else {
+         _free_list_remove(heap, block);
+         _block_split(heap, block, block_size);
+
+         heap->used_blocks_cnt++;
+         if (heap->free_size < heap->free_size_min){
+            heap->free_size_min = heap->free_size;
+         }
+
+         *p_data = (unsigned char *)block + _BLOCK_HDR_SIZE;
+      }
+   }
+
+   return rc;
+}
+
+/**
+ * While there are tasks waiting for memory, and the request of the first
+ * one can be satisfied, allocate memory for it and wake it up.
+ */
+static void _waiting_tasks_feed(struct TN_Heap *heap)
+{
+   while (!_tn_list_is_empty(&heap->wait_queue)){
+      struct TN_Task *task = _tn_list_first_entry(
+            &heap->wait_queue, struct TN_Task, task_queue
+            );
+
+      if (_block_alloc(
+               heap,
+               task->subsys_wait.heap.size,
+               &task->subsys_wait.heap.data_elem
+               ) != TN_RC_OK)
+      {
+         //-- still not enough memory for the first task
+         break;
+      }
+
+      _tn_task_first_wait_complete(
+            &heap->wait_queue, TN_RC_OK, TN_NULL, TN_NULL, TN_NULL
+            );
+   }
+}
+
+/**
+ * Try to allocate memory. If there are tasks waiting for memory already,
+ * `#TN_RC_TIMEOUT` is returned (unless the request can never be satisfied),
+ * so that the new request doesn't bypass them.
+ */
+static enum TN_RCode _heap_alloc(
+      struct TN_Heap *heap,
+      unsigned int size,
+      void **p_data
+      )
+{
+   enum TN_RCode rc;
+
+   if (!_tn_list_is_empty(&heap->wait_queue)){
+      rc = (_block_size_for_data(heap, size) == 0)
+         ? TN_RC_OVERFLOW
+         : TN_RC_TIMEOUT;
+   } else {
+      rc = _block_alloc(heap, size, p_data);
+   }
+
+   return rc;
+}
+
+/**
+ * Return memory block to the heap, and give tasks waiting for memory a
+ * chance to get it.
+ */
+static enum TN_RCode _heap_free(struct TN_Heap *heap, void *p_data)
+{
+   enum TN_RCode rc = TN_RC_OK;
+   struct _TN_HeapBlock *block = _block_by_data(heap, p_data);
+
+   if (block == TN_NULL){
+      rc = TN_RC_WPARAM;
+   } else {
+      heap->used_blocks_cnt--;
+      _block_release(heap, block);
+      _waiting_tasks_feed(heap);
+   }
+
+   return rc;
+}
+
+
+
+
+
+/*******************************************************************************
+ *    PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+/*
+ * See comments in the header file (tn_heap.h)
+ */
+enum TN_RCode tn_heap_create(
+      struct TN_Heap   *heap,
+      void             *start_addr,
+      unsigned int      size
+      )
+{
+   enum TN_RCode rc = _check_param_create(heap, start_addr);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (
+         TN_MAKE_ALIG_SIZE((TN_UIntPtr)start_addr) != (TN_UIntPtr)start_addr
+         )
+   {
+      //-- start_addr isn't aligned properly
+      rc = TN_RC_WPARAM;
+   } else {
+      unsigned int lists_size;
+      int fl_cnt;
+      int sl;
+
+      //-- use aligned part of the memory only
+      size &= ~(unsigned int)(sizeof(TN_UWord) - 1);
+
+      //-- count of first-level indexes is determined by the largest
+      //   possible block, which can't be larger than the whole memory
+      if (size < _SMALL_SIZE){
+         fl_cnt = 1;
+      } else {
+         _mapping(size, &fl_cnt, &sl);
+         fl_cnt++;
+      }
+
+      //-- free list heads and second-level bitmaps are placed at the
+      //   beginning of the memory
+      lists_size = TN_MAKE_ALIG_SIZE(
+               fl_cnt * TN_HEAP_SL_CNT * sizeof(struct _TN_HeapBlock *)
+            +  fl_cnt * sizeof(unsigned char)
+            );
+
+      if (fl_cnt > TN_INT_WIDTH || size < lists_size + _BLOCK_MIN_SIZE){
+         rc = TN_RC_WPARAM;
+      } else {
+         int i;
+
+         _tn_list_reset(&(heap->wait_queue));
+
+         heap->free_lists  = (struct _TN_HeapBlock **)start_addr;
+         heap->sl_bmps     = (unsigned char *)(
+               heap->free_lists + fl_cnt * TN_HEAP_SL_CNT
+               );
+         heap->fl_bmp      = 0;
+         heap->fl_cnt      = fl_cnt;
+
+         for (i = 0; i < fl_cnt * TN_HEAP_SL_CNT; i++){
+            heap->free_lists[i] = TN_NULL;
+         }
+         for (i = 0; i < fl_cnt; i++){
+            heap->sl_bmps[i] = 0;
+         }
+
+         heap->size              = size - lists_size;
+         heap->free_size         = 0;
+         heap->free_blocks_cnt   = 0;
+         heap->used_blocks_cnt   = 0;
+
+         //-- initially, all the memory is a single free block
+         heap->first_block = (struct _TN_HeapBlock *)(
+               (unsigned char *)start_addr + lists_size
+               );
+         heap->first_block->prev_phys  = TN_NULL;
+         heap->first_block->size_flags = heap->size;
+         _free_list_insert(heap, heap->first_block);
+
+         heap->free_size_min = heap->free_size;
+
+         heap->id_heap = TN_ID_HEAP;
+      }
+   }
+
+   _TN_TRACE(TN_TRACE_EV_HEAP_CREATE, heap, rc);
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_heap.h)
+ */
+enum TN_RCode tn_heap_delete(struct TN_Heap *heap)
+{
+   enum TN_RCode rc = _check_param_generic(heap);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_task_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_INTSAVE_DATA;
+
+      TN_INT_DIS_SAVE();
+
+      //-- invalidate heap before waking up the tasks, so that
+      //   `_tn_heap_on_task_wait_complete()` doesn't try to feed
+      //   the rest of them
+      heap->id_heap = TN_ID_NONE;
+
+      //-- remove all tasks (if any) from the wait queue
+      _tn_wait_queue_notify_deleted(&(heap->wait_queue));
+
+      TN_INT_RESTORE();
+
+      //-- we might need to switch context if _tn_wait_queue_notify_deleted()
+      //   has woken up some high-priority task
+      _tn_context_switch_pend_if_needed();
+   }
+
+   _TN_TRACE(TN_TRACE_EV_HEAP_DELETE, heap, rc);
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_heap.h)
+ */
+enum TN_RCode tn_heap_alloc(
+      struct TN_Heap   *heap,
+      unsigned int      size,
+      void            **p_data,
+      TN_TickCnt        timeout
+      )
+{
+   TN_BOOL waited_for_data = TN_FALSE;
+   enum TN_RCode rc = _check_param_generic(heap);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if ((rc = _check_param_job(p_data)) != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_task_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_INTSAVE_DATA;
+
+      TN_INT_DIS_SAVE();
+
+      rc = _heap_alloc(heap, size, p_data);
+
+      if (rc == TN_RC_TIMEOUT && timeout > 0){
+         //-- save requested size, so that `_waiting_tasks_feed()` is able
+         //   to allocate memory for us
+         _tn_curr_run_task->subsys_wait.heap.size = size;
+         _tn_curr_run_task->subsys_wait.heap.data_elem = TN_NULL;
+         _tn_task_curr_to_wait_action(
+               &(heap->wait_queue),
+               TN_WAIT_REASON_HEAP,
+               timeout
+               );
+         waited_for_data = TN_TRUE;
+      }
+
+      TN_INT_RESTORE();
+      _tn_context_switch_pend_if_needed();
+      if (waited_for_data){
+
+         //-- get wait result
+         rc = _tn_curr_run_task->task_wait_rc;
+
+         //-- if wait result is TN_RC_OK, copy memory block pointer to the
+         //   user's location
+         if (rc == TN_RC_OK){
+            *p_data = _tn_curr_run_task->subsys_wait.heap.data_elem;
+         }
+
+      }
+
+   }
+
+   _TN_TRACE(TN_TRACE_EV_HEAP_ALLOC, heap, rc);
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_heap.h)
+ */
+enum TN_RCode tn_heap_alloc_polling(
+      struct TN_Heap   *heap,
+      unsigned int      size,
+      void            **p_data
+      )
+{
+   enum TN_RCode rc = _check_param_generic(heap);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if ((rc = _check_param_job(p_data)) != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_task_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_INTSAVE_DATA;
+
+      TN_INT_DIS_SAVE();
+      rc = _heap_alloc(heap, size, p_data);
+      TN_INT_RESTORE();
+   }
+
+   _TN_TRACE(TN_TRACE_EV_HEAP_ALLOC, heap, rc);
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_heap.h)
+ */
+enum TN_RCode tn_heap_ialloc_polling(
+      struct TN_Heap   *heap,
+      unsigned int      size,
+      void            **p_data
+      )
+{
+   enum TN_RCode rc = _check_param_generic(heap);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if ((rc = _check_param_job(p_data)) != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_isr_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_INTSAVE_DATA_INT;
+
+      TN_INT_IDIS_SAVE();
+      rc = _heap_alloc(heap, size, p_data);
+      TN_INT_IRESTORE();
+   }
+
+   _TN_TRACE(TN_TRACE_EV_HEAP_ALLOC, heap, rc);
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_heap.h)
+ */
+enum TN_RCode tn_heap_free(struct TN_Heap *heap, void *p_data)
+{
+   enum TN_RCode rc = _check_param_generic(heap);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if ((rc = _check_param_job(p_data)) != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_task_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_INTSAVE_DATA;
+
+      TN_INT_DIS_SAVE();
+
+      rc = _heap_free(heap, p_data);
+
+      TN_INT_RESTORE();
+      _tn_context_switch_pend_if_needed();
+   }
+
+   _TN_TRACE(TN_TRACE_EV_HEAP_FREE, heap, rc);
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_heap.h)
+ */
+enum TN_RCode tn_heap_ifree(struct TN_Heap *heap, void *p_data)
+{
+   enum TN_RCode rc = _check_param_generic(heap);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if ((rc = _check_param_job(p_data)) != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_isr_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_INTSAVE_DATA_INT;
+
+      TN_INT_IDIS_SAVE();
+
+      rc = _heap_free(heap, p_data);
+
+      TN_INT_IRESTORE();
+      _TN_CONTEXT_SWITCH_IPEND_IF_NEEDED();
+   }
+
+   _TN_TRACE(TN_TRACE_EV_HEAP_FREE, heap, rc);
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_heap.h)
+ */
+enum TN_RCode tn_heap_stat_get(
+      struct TN_Heap       *heap,
+      struct TN_HeapStat   *stat
+      )
+{
+   enum TN_RCode rc = _check_param_generic(heap);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if ((rc = _check_param_job(stat)) != TN_RC_OK){
+      //-- just return rc as it is
+   } else {
+      unsigned int largest_free_size = 0;
+      TN_INTSAVE_DATA;
+
+      TN_INT_DIS_SAVE();
+
+      if (heap->fl_bmp != 0){
+         //-- the largest free block is in the highest non-empty list
+         int fl = _fls(heap->fl_bmp);
+         int sl = _fls(heap->sl_bmps[fl]);
+         struct _TN_HeapBlock *block
+            = heap->free_lists[fl * TN_HEAP_SL_CNT + sl];
+
+         for (; block != TN_NULL; block = block->next_free){
+            if (_block_size(block) > largest_free_size){
+               largest_free_size = _block_size(block);
+            }
+         }
+      }
+
+      stat->size              = heap->size;
+      stat->free_size         = heap->free_size;
+      stat->used_size_max     = heap->size - heap->free_size_min;
+      stat->largest_free_size = largest_free_size;
+      stat->free_blocks_cnt   = heap->free_blocks_cnt;
+      stat->used_blocks_cnt   = heap->used_blocks_cnt;
+
+      TN_INT_RESTORE();
+
+      stat->fragmentation = (stat->free_size == 0)
+         ? 0
+         : (int)(100 - (unsigned long)largest_free_size * 100
+               / stat->free_size);
+   }
+
+   return rc;
+}
+
+
+
+/*******************************************************************************
+ *    INTERNAL TNKERNEL FUNCTIONS
+ ******************************************************************************/
+
+/**
+ * See comment in _tn_heap.h file
+ */
+void _tn_heap_on_task_wait_complete(struct TN_Task *task)
+{
+   struct TN_Heap *heap = _tn_list_entry(
+         task->pwait_queue, struct TN_Heap, wait_queue
+         );
+
+   //-- if task leaves without memory (timeout, wait release, termination),
+   //   the task that is the first one now might be satisfied already
+   if (     task->subsys_wait.heap.data_elem == TN_NULL
+         && _tn_heap_is_valid(heap)
+      )
+   {
+      _waiting_tasks_feed(heap);
+   }
+}
+
+
@@ -0,0 +1,426 @@
+/*******************************************************************************
+ *
+ * TNeo: real-time kernel initially based on TNKernel
+ *
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
+ *
+ *    TNeo was born as a thorough review and re-implementation of
+ *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
+ *    as well as new features being added, and it is tested carefully with
+ *    unit-tests.
+ *
+ *    API is changed somewhat, so it's not 100% compatible with TNKernel,
+ *    hence the new name: TNeo.
+ *
+ *    Permission to use, copy, modify, and distribute this software in source
+ *    and binary forms and its documentation for any purpose and without fee
+ *    is hereby granted, provided that the above copyright notice appear
+ *    in all copies and that both that copyright notice and this permission
+ *    notice appear in supporting documentation.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE DMITRY FRANK AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DMITRY FRANK OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *    THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+/**
+ * \file
+ *
+ * Heap: real-time allocator of memory blocks of arbitrary size.
+ *
+ * Unlike \ref tn_fmem.h "fixed memory pools", blocks of any size can be
+ * allocated from the same heap, so there's no need to provision a pool
+ * for each block size. Unlike the `malloc()` from the C library, the
+ * heap is deterministic: both `tn_heap_alloc()` and `tn_heap_free()` take a
+ * time which doesn't depend on the number of allocated or free blocks, and
+ * it is task-aware: if there's not enough free memory, the task may wait for
+ * it with a timeout, just like it does with `tn_fmem_get()`.
+ *
+ * The allocator is a two-level segregated fit (TLSF) one. Free blocks are
+ * kept in the lists by their size: the first level splits sizes by the
+ * power of two, and the second level splits each power-of-two range into
+ * `#TN_HEAP_SL_CNT` lists. A bitmap of non-empty lists is maintained for each
+ * level, so that the suitable free block is found by a couple of
+ * find-first-set bit operations. A block which is larger than requested is
+ * split, and a freed block is merged with its free neighbours immediately.
+ *
+ * The free lists and bitmaps are stored at the beginning of the memory given
+ * to `tn_heap_create()`, and their size depends on the size of the heap:
+ * for the heap of several kilobytes it takes a few hundred bytes. Each
+ * allocated block additionally takes `#TN_HEAP_BLOCK_OVERHEAD` bytes.
+ *
+ * Tasks which wait for memory are served in FIFO order: when some memory is
+ * freed, the first waiting task gets its block if it fits now, then the
+ * next one, and so on, until the request of the first waiting task can't be
+ * satisfied. While there are waiting tasks, new requests don't bypass them
+ * (they wait, or get `#TN_RC_TIMEOUT` if timeout is zero), so the large
+ * request is not starved by small ones.
+ *
+ * Typical usage:
+ *
+ * \code{.c}
+ *     static TN_UWord my_heap_mem[ 4096 / sizeof(TN_UWord) ];
+ *     static struct TN_Heap my_heap;
+ *
+ *     void some_init(void)
+ *     {
+ *        tn_heap_create(&my_heap, my_heap_mem, sizeof(my_heap_mem));
+ *     }
+ *
+ *     void some_task_body(void *param)
+ *     {
+ *        void *p_frame;
+ *
+ *        if (tn_heap_alloc(
+ *                 &my_heap, frame_len, &p_frame, TN_WAIT_INFINITE
+ *                 ) == TN_RC_OK)
+ *        {
+ *           //-- use p_frame
+ *           tn_heap_free(&my_heap, p_frame);
+ *        }
+ *     }
+ * \endcode
+ *
+ * Memory usage and fragmentation can be monitored by `tn_heap_stat_get()`.
+ */
+
+#ifndef _TN_HEAP_H
+#define _TN_HEAP_H
+
+/*******************************************************************************
+ *    INCLUDED FILES
+ ******************************************************************************/
+
+#include "tn_list.h"
+#include "tn_common.h"
+
+
+
+#ifdef __cplusplus
+extern "C"  {  /*}*/
+#endif
+
+/*******************************************************************************
+ *    PUBLIC TYPES
+ ******************************************************************************/
+
+struct _TN_HeapBlock;
+
+/**
+ * Heap
+ */
+struct TN_Heap {
+   ///
+   /// id for object validity verification.
+   /// This field is in the beginning of the structure to make it easier
+   /// to detect memory corruption.
+   enum TN_ObjId              id_heap;
+   ///
+   /// list of tasks waiting for memory
+   struct TN_ListItem         wait_queue;
+
+   ///
+   /// heads of free lists: `fl_cnt * #TN_HEAP_SL_CNT` items,
+   /// stored at the beginning of the heap memory
+   struct _TN_HeapBlock     **free_lists;
+   ///
+   /// bitmaps of non-empty second-level lists, one per first-level index
+   unsigned char             *sl_bmps;
+   ///
+   /// bitmap of first-level indexes which have non-empty lists
+   unsigned int               fl_bmp;
+   ///
+   /// count of first-level indexes
+   int                        fl_cnt;
+
+   ///
+   /// first block of the heap
+   struct _TN_HeapBlock      *first_block;
+   ///
+   /// size of the memory available for blocks (that is, the size of the
+   /// heap minus the size of free lists), in bytes
+   unsigned int               size;
+   ///
+   /// total size of free blocks, in bytes
+   unsigned int               free_size;
+   ///
+   /// minimal value `free_size` has ever had
+   unsigned int               free_size_min;
+   ///
+   /// count of free blocks
+   unsigned int               free_blocks_cnt;
+   ///
+   /// count of allocated blocks
+   unsigned int               used_blocks_cnt;
+};
+
+/**
+ * Heap-specific fields related to waiting task,
+ * to be included in struct TN_Task.
+ */
+struct TN_HeapTaskWait {
+   ///
+   /// requested size, in bytes
+   unsigned int   size;
+   ///
+   /// if Task receives the memory, this is the pointer to it
+   void          *data_elem;
+};
+
+/**
+ * Heap statistics, see `tn_heap_stat_get()`.
+ *
+ * Sizes of blocks include `#TN_HEAP_BLOCK_OVERHEAD`.
+ */
+struct TN_HeapStat {
+   ///
+   /// size of the memory available for blocks, in bytes
+   unsigned int   size;
+   ///
+   /// total size of free blocks, in bytes
+   unsigned int   free_size;
+   ///
+   /// high-water mark: maximum total size of allocated blocks the heap has
+   /// ever had, in bytes
+   unsigned int   used_size_max;
+   ///
+   /// size of the largest free block, in bytes. Requests of up to
+   /// `(largest_free_size - #TN_HEAP_BLOCK_OVERHEAD)` bytes will succeed
+   /// right now.
+   unsigned int   largest_free_size;
+   ///
+   /// count of free blocks
+   unsigned int   free_blocks_cnt;
+   ///
+   /// count of allocated blocks
+   unsigned int   used_blocks_cnt;
+   ///
+   /// fragmentation of free memory, in percents: 0 means that all free
+   /// memory is a single block; the more it is, the smaller portion of free
+   /// memory can be allocated by a single request.
+   int            fragmentation;
+};
+
+
+
+/*******************************************************************************
+ *    PROTECTED GLOBAL DATA
+ ******************************************************************************/
+
+/*******************************************************************************
+ *    DEFINITIONS
+ ******************************************************************************/
+
+/**
+ * Count of second-level free lists per each power-of-two range of sizes.
+ */
+#define  TN_HEAP_SL_CNT          8
+
+/**
+ * Count of bytes that each allocated block takes in addition to the
+ * requested size (not counting alignment).
+ */
+#define  TN_HEAP_BLOCK_OVERHEAD                                   \
+   TN_MAKE_ALIG_SIZE(sizeof(void *) + sizeof(unsigned int))
+
+
+
+
+/*******************************************************************************
+ *    PUBLIC FUNCTION PROTOTYPES
+ ******************************************************************************/
+
+/**
+ * Construct heap. `id_heap` field should not contain `#TN_ID_HEAP`,
+ * otherwise, `#TN_RC_WPARAM` is returned.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param heap       pointer to already allocated `struct TN_Heap`.
+ * @param start_addr start address of the memory for the heap; should be
+ *                   aligned properly (a multiple of `sizeof(#TN_UWord)`).
+ * @param size       size of the memory for the heap, in bytes. Part of it
+ *                   is taken by free lists, see the comment at the top of
+ *                   this file.
+ *
+ * @return
+ *    * `#TN_RC_OK` if heap was successfully created;
+ *    * `#TN_RC_WPARAM` if wrong params were given: say, `start_addr` isn't
+ *      aligned properly, or `size` is too small or too large.
+ */
+enum TN_RCode tn_heap_create(
+      struct TN_Heap   *heap,
+      void             *start_addr,
+      unsigned int      size
+      );
+
+/**
+ * Destruct heap. All tasks that wait for memory become runnable with
+ * `#TN_RC_DELETED` code returned.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param heap       pointer to heap to be deleted
+ *
+ * @return
+ *    * `#TN_RC_OK` if heap is successfully deleted;
+ *    * `#TN_RC_WCONTEXT` if called from wrong context;
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_heap_delete(struct TN_Heap *heap);
+
+/**
+ * Allocate memory block of `size` bytes from the heap. Start address of the
+ * memory block is returned through the `p_data` argument; it is aligned
+ * to `sizeof(#TN_UWord)`. The content of memory block is undefined.
+ *
+ * If there's no free block large enough (or there are other tasks already
+ * waiting for memory), behavior depends on `timeout` value: refer to
+ * `#TN_TickCnt`.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_CAN_SLEEP)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param heap
+ *    Pointer to heap
+ * @param size
+ *    Requested size, in bytes
+ * @param p_data
+ *    Address of the `(void *)` to which allocated block address will be
+ *    saved
+ * @param timeout
+ *    Refer to `#TN_TickCnt`
+ *
+ * @return
+ *    * `#TN_RC_OK` if block was successfully returned through `p_data`;
+ *    * `#TN_RC_OVERFLOW` if `size` is larger than the heap could ever
+ *      provide;
+ *    * `#TN_RC_WCONTEXT` if called from wrong context;
+ *    * Other possible return codes depend on `timeout` value,
+ *      refer to `#TN_TickCnt`
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_heap_alloc(
+      struct TN_Heap   *heap,
+      unsigned int      size,
+      void            **p_data,
+      TN_TickCnt        timeout
+      );
+
+/**
+ * The same as `tn_heap_alloc()` with zero timeout
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_LEGEND_LINK)
+ */
+enum TN_RCode tn_heap_alloc_polling(
+      struct TN_Heap   *heap,
+      unsigned int      size,
+      void            **p_data
+      );
+
+/**
+ * The same as `tn_heap_alloc()` with zero timeout, but for using in the ISR.
+ *
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ */
+enum TN_RCode tn_heap_ialloc_polling(
+      struct TN_Heap   *heap,
+      unsigned int      size,
+      void            **p_data
+      );
+
+/**
+ * Return memory block to the heap. The block is merged with its free
+ * neighbours, and tasks waiting for memory, if any, are given a chance to
+ * get their blocks.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param heap
+ *    Pointer to heap.
+ * @param p_data
+ *    Address of the memory block to release, as returned by
+ *    `tn_heap_alloc()`.
+ *
+ * @return
+ *    * `#TN_RC_OK` on success;
+ *    * `#TN_RC_WPARAM` if `p_data` isn't an allocated block of this heap
+ *      (the check is not exhaustive: it just checks that `p_data` is inside
+ *      the heap and the block isn't free);
+ *    * `#TN_RC_WCONTEXT` if called from wrong context;
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_heap_free(struct TN_Heap *heap, void *p_data);
+
+/**
+ * The same as `tn_heap_free()`, but for using in the ISR.
+ *
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ */
+enum TN_RCode tn_heap_ifree(struct TN_Heap *heap, void *p_data);
+
+/**
+ * Get heap statistics: free and used memory, high-water mark,
+ * fragmentation.
+ *
+ * In order to find the largest free block, this function walks the list
+ * of free blocks of the highest non-empty size class (with interrupts
+ * disabled), so, unlike other heap services, its execution time depends
+ * on the number of free blocks of similar size. It is intended for
+ * diagnostics.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param heap
+ *    Pointer to heap.
+ * @param stat
+ *    Pointer to the structure to fill.
+ *
+ * @return
+ *    * `#TN_RC_OK` on success;
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_heap_stat_get(
+      struct TN_Heap       *heap,
+      struct TN_HeapStat   *stat
+      );
+
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif // _TN_HEAP_H
+
+/*******************************************************************************
+ *    end of file
+ ******************************************************************************/
@@ -0,0 +1,921 @@
+/*******************************************************************************
+ *
+ * TNeo: real-time kernel initially based on TNKernel
+ *
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
+ *
+ *    TNeo was born as a thorough review and re-implementation of
+ *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
+ *    as well as new features being added, and it is tested carefully with
+ *    unit-tests.
+ *
+ *    API is changed somewhat, so it's not 100% compatible with TNKernel,
+ *    hence the new name: TNeo.
+ *
+ *    Permission to use, copy, modify, and distribute this software in source
+ *    and binary forms and its documentation for any purpose and without fee
+ *    is hereby granted, provided that the above copyright notice appear
+ *    in all copies and that both that copyright notice and this permission
+ *    notice appear in supporting documentation.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE DMITRY FRANK AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DMITRY FRANK OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *    THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+/*******************************************************************************
+ *    INCLUDED FILES
+ ******************************************************************************/
+
+#include "tn_common.h"
+#include "tn_sys.h"
+
+//-- internal tnkernel headers
+#include "_tn_tasks.h"
+#include "_tn_list.h"
+#include "_tn_trace.h"
+
+
+#include "tn_msgbuf.h"
+#include "_tn_msgbuf.h"
+
+#include "tn_tasks.h"
+
+#include <string.h>
+
+
+
+
+/*******************************************************************************
+ *    PRIVATE TYPES
+ ******************************************************************************/
+
+/**
+ * Type of job: send message or receive message. Given to
+ * `_msgbuf_job_perform()` and `_msgbuf_job_iperform()`.
+ */
+enum _JobType {
+   _JOB_TYPE__SEND,
+   _JOB_TYPE__RECEIVE,
+};
+
+
+
+/*******************************************************************************
+ *    PRIVATE FUNCTIONS
+ ******************************************************************************/
+
+//-- Additional param checking {{{
+#if TN_CHECK_PARAM
+_TN_STATIC_INLINE enum TN_RCode _check_param_generic(
+      const struct TN_MsgBuf *msgbuf
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   if (msgbuf == TN_NULL){
+      rc = TN_RC_WPARAM;
+   } else if (!_tn_msgbuf_is_valid(msgbuf)){
+      rc = TN_RC_INVALID_OBJ;
+   }
+
+   return rc;
+}
+
+_TN_STATIC_INLINE enum TN_RCode _check_param_create(
+      const struct TN_MsgBuf *msgbuf,
+      void *buf,
+      unsigned int buf_size
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   if (msgbuf == TN_NULL || buf == TN_NULL){
+      rc = TN_RC_WPARAM;
+   } else if (buf_size < TN_MSGBUF_HDR_SIZE || _tn_msgbuf_is_valid(msgbuf)){
+      rc = TN_RC_WPARAM;
+   }
+
+   return rc;
+}
+
+_TN_STATIC_INLINE enum TN_RCode _check_param_job(
+      enum _JobType job_type,
+      void *data,
+      unsigned int size,
+      unsigned int *p_size
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   if (data == TN_NULL && size != 0){
+      rc = TN_RC_WPARAM;
+   } else if (job_type == _JOB_TYPE__RECEIVE && p_size == TN_NULL){
+      rc = TN_RC_WPARAM;
+   }
+
+   return rc;
+}
+
+#else
+#  define _check_param_generic(msgbuf)                      (TN_RC_OK)
+#  define _check_param_create(msgbuf, buf, buf_size)        (TN_RC_OK)
+#  define _check_param_job(job_type, data, size, p_size)    (TN_RC_OK)
+#endif
+// }}}
+
+//-- Message buffer storage ring processing {{{
+
+/**
+ * Copy `size` bytes from `src` to the ring, starting from `head_idx`, and
+ * move `head_idx` forward. The caller should make sure there is enough free
+ * space in the ring.
+ *
+ * Data is copied in at most two contiguous chunks: up to the end of the
+ * buffer, and then the rest from the beginning of it.
+ */
+static void _ring_write(
+      struct TN_MsgBuf *msgbuf,
+      const unsigned char *src,
+      unsigned int size
+      )
+{
+   unsigned int idx = msgbuf->head_idx;
+   unsigned int chunk = msgbuf->buf_size - idx;
+
+   if (chunk > size){
+      chunk = size;
+   }
+
+   memcpy(&msgbuf->buf[idx], src, chunk);
+   memcpy(&msgbuf->buf[0], src + chunk, size - chunk);
+
+   idx += size;
+   if (idx >= msgbuf->buf_size){
+      idx -= msgbuf->buf_size;
+   }
+
+   msgbuf->head_idx = idx;
+}
+
+/**
+ * Copy `size` bytes from the ring, starting from `tail_idx`, to `dst`, and
+ * move `tail_idx` forward. The caller should make sure there are enough
+ * used bytes in the ring.
+ *
+ * Just like `_ring_write()`, data is copied in at most two chunks.
+ */
+static void _ring_read(
+      struct TN_MsgBuf *msgbuf,
+      unsigned char *dst,
+      unsigned int size
+      )
+{
+   unsigned int idx = msgbuf->tail_idx;
+   unsigned int chunk = msgbuf->buf_size - idx;
+
+   if (chunk > size){
+      chunk = size;
+   }
+
+   memcpy(dst, &msgbuf->buf[idx], chunk);
+   memcpy(dst + chunk, &msgbuf->buf[0], size - chunk);
+
+   idx += size;
+   if (idx >= msgbuf->buf_size){
+      idx -= msgbuf->buf_size;
+   }
+
+   msgbuf->tail_idx = idx;
+}
+
+/**
+ * Returns size of the oldest message in the ring, without removing it.
+ * The caller should make sure the ring is not empty.
+ */
+static unsigned int _ring_msg_size_peek(const struct TN_MsgBuf *msgbuf)
+{
+   unsigned int idx = msgbuf->tail_idx;
+   unsigned int size = msgbuf->buf[idx];
+
+   if (++idx >= msgbuf->buf_size){
+      idx = 0;
+   }
+
+   return size | ((unsigned int)msgbuf->buf[idx] << 8);
+}
+
+/**
+ * Try to put the message to the ring.
+ *
+ * If there is enough space in the ring, the record (length prefix followed by
+ * the message data) is written, and `#TN_RC_OK` is returned. If the message
+ * can never fit in the ring, `#TN_RC_OVERFLOW` is returned. Otherwise,
+ * `#TN_RC_TIMEOUT` is returned, and this case can be handled by the caller.
+ *
+ * @param msgbuf
+ *    Message buffer in which message should be written
+ * @param data
+ *    Message data
+ * @param size
+ *    Message size in bytes
+ */
+static enum TN_RCode _msg_write(
+      struct TN_MsgBuf *msgbuf,
+      const void *data,
+      unsigned int size
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   if (     size > TN_MSGBUF_MSG_SIZE_MAX
+         || size > msgbuf->buf_size - TN_MSGBUF_HDR_SIZE
+      )
+   {
+      //-- message will never fit
+      rc = TN_RC_OVERFLOW;
+   } else if (
+         TN_MSGBUF_RECORD_SIZE(size)
+         > msgbuf->buf_size - msgbuf->used_bytes_cnt
+         )
+   {
+      //-- no space for new message right now
+      rc = TN_RC_TIMEOUT;
+   } else {
+      unsigned char hdr[ TN_MSGBUF_HDR_SIZE ];
+
+      //-- write length prefix (16-bit little-endian) and message data
+      hdr[0] = (unsigned char)(size & 0xff);
+      hdr[1] = (unsigned char)((size >> 8) & 0xff);
+
+      _ring_write(msgbuf, hdr, TN_MSGBUF_HDR_SIZE);
+      _ring_write(msgbuf, (const unsigned char *)data, size);
+
+      msgbuf->used_bytes_cnt += TN_MSGBUF_RECORD_SIZE(size);
+      msgbuf->msgs_cnt++;
+   }
+
+   return rc;
+}
+
+/**
+ * Try to get the oldest message from the ring.
+ *
+ * If there is some message in the ring, its size is stored to `p_size`.
+ * Then, if the message fits in `max_size`, it is copied to `data`, removed
+ * from the ring, and `#TN_RC_OK` is returned; otherwise, the message stays
+ * in the ring and `#TN_RC_OVERFLOW` is returned.
+ *
+ * If there are no messages in the ring, `#TN_RC_TIMEOUT` is returned, and
+ * this case can be handled by the caller.
+ *
+ * @param msgbuf
+ *    Message buffer from which message should be read
+ * @param data
+ *    Pointer to the place at which the message should be copied
+ * @param max_size
+ *    Size of the place pointed to by `data`
+ * @param p_size
+ *    Pointer to the place at which message size should be stored
+ */
+static enum TN_RCode _msg_read(
+      struct TN_MsgBuf *msgbuf,
+      void *data,
+      unsigned int max_size,
+      unsigned int *p_size
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   if (msgbuf->msgs_cnt == 0){
+      //-- nothing to read
+      rc = TN_RC_TIMEOUT;
+   } else {
+      unsigned int size = _ring_msg_size_peek(msgbuf);
+
+      *p_size = size;
+
+      if (size > max_size){
+         //-- user's buffer is too small, leave the message in the ring
+         rc = TN_RC_OVERFLOW;
+      } else {
+         unsigned char hdr[ TN_MSGBUF_HDR_SIZE ];
+
+         //-- skip length prefix and read message data
+         _ring_read(msgbuf, hdr, TN_MSGBUF_HDR_SIZE);
+         _ring_read(msgbuf, (unsigned char *)data, size);
+
+         msgbuf->used_bytes_cnt -= TN_MSGBUF_RECORD_SIZE(size);
+         msgbuf->msgs_cnt--;
+      }
+   }
+
+   return rc;
+}
+// }}}
+
+/**
+ * While there are messages in the ring and tasks waiting to receive, give
+ * the oldest message to the first waiting task and wake it up. If the
+ * message doesn't fit in the task's buffer, the task is woken up with
+ * `#TN_RC_OVERFLOW`, and the message stays in the ring for the next one.
+ */
+static void _receivers_feed(struct TN_MsgBuf *msgbuf)
+{
+   while (     msgbuf->msgs_cnt > 0
+            && !_tn_list_is_empty(&msgbuf->wait_receive_list)
+         )
+   {
+      struct TN_Task *task = _tn_list_first_entry(
+            &msgbuf->wait_receive_list, struct TN_Task, task_queue
+            );
+
+      //-- copy message right to the task's buffer; the task will get
+      //   actual message size from `subsys_wait.msgbuf.size`
+      enum TN_RCode rc = _msg_read(
+            msgbuf,
+            task->subsys_wait.msgbuf.data,
+            task->subsys_wait.msgbuf.size,
+            &task->subsys_wait.msgbuf.size
+            );
+
+      _tn_task_first_wait_complete(
+            &msgbuf->wait_receive_list, rc, TN_NULL, TN_NULL, TN_NULL
+            );
+   }
+}
+
+/**
+ * While there are tasks waiting to send, and the message of the first one
+ * fits in the ring, put this message to the ring and wake the task up.
+ * The first task whose message doesn't fit stops the process, so that
+ * the order of messages is preserved.
+ */
+static void _senders_feed(struct TN_MsgBuf *msgbuf)
+{
+   while (!_tn_list_is_empty(&msgbuf->wait_send_list)){
+      struct TN_Task *task = _tn_list_first_entry(
+            &msgbuf->wait_send_list, struct TN_Task, task_queue
+            );
+
+      enum TN_RCode rc = _msg_write(
+            msgbuf,
+            task->subsys_wait.msgbuf.data,
+            task->subsys_wait.msgbuf.size
+            );
+
+      if (rc != TN_RC_OK){
+         //-- still no room for the message of the first task
+         //   (TN_RC_OVERFLOW isn't possible here: it is checked before
+         //   the task starts waiting)
+         break;
+      }
+
+      _tn_task_first_wait_complete(
+            &msgbuf->wait_send_list, TN_RC_OK, TN_NULL, TN_NULL, TN_NULL
+            );
+   }
+}
+
+/**
+ * Actual worker function that sends new message to the message buffer.
+ * Eventually called when user calls one of these functions:
+ *
+ * - `tn_msgbuf_send()`
+ * - `tn_msgbuf_send_polling()`
+ * - `tn_msgbuf_isend_polling()`
+ *
+ * If there are tasks that already wait to send, `#TN_RC_TIMEOUT` is returned
+ * (unless the message can never fit at all), so that messages aren't
+ * reordered. Otherwise, the message is written to the ring by `_msg_write()`,
+ * and tasks that wait to receive, if any, are woken up.
+ *
+ * `#TN_RC_TIMEOUT` is probably handled by the caller (`_msgbuf_job_perform()`
+ * or `_msgbuf_job_iperform()`) depending on requested `timeout` value.
+ */
+static enum TN_RCode _msgbuf_send(
+      struct TN_MsgBuf *msgbuf,
+      const void *data,
+      unsigned int size
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   if (!_tn_list_is_empty(&msgbuf->wait_send_list)){
+      //-- there are tasks waiting to send already, so we can't put our
+      //   message to the ring before theirs. We still need to check
+      //   whether the message will ever fit.
+      if (     size > TN_MSGBUF_MSG_SIZE_MAX
+            || size > msgbuf->buf_size - TN_MSGBUF_HDR_SIZE
+         )
+      {
+         rc = TN_RC_OVERFLOW;
+      } else {
+         rc = TN_RC_TIMEOUT;
+      }
+   } else {
+      rc = _msg_write(msgbuf, data, size);
+
+      if (rc == TN_RC_OK){
+         _receivers_feed(msgbuf);
+      }
+   }
+
+   return rc;
+}
+
+/**
+ * Actual worker function that receives message from the message buffer.
+ * Eventually called when user calls one of these functions:
+ *
+ * - `tn_msgbuf_receive()`
+ * - `tn_msgbuf_receive_polling()`
+ * - `tn_msgbuf_ireceive_polling()`
+ *
+ * It tries to read message from the ring by calling `_msg_read()`. In case
+ * of success, it gives tasks that wait for the free space a chance to put
+ * their messages to the ring.
+ *
+ * If the ring is empty, `#TN_RC_TIMEOUT` is returned, and this can be handled
+ * by the caller (`_msgbuf_job_perform()` or `_msgbuf_job_iperform()`)
+ * depending on requested `timeout` value.
+ */
+static enum TN_RCode _msgbuf_receive(
+      struct TN_MsgBuf *msgbuf,
+      void *data,
+      unsigned int max_size,
+      unsigned int *p_size
+      )
+{
+   enum TN_RCode rc = _msg_read(msgbuf, data, max_size, p_size);
+
+   if (rc == TN_RC_OK){
+      _senders_feed(msgbuf);
+   }
+
+   return rc;
+}
+
+
+/**
+ * Intermediary function that is called by message buffer services
+ * (`tn_msgbuf_send()`, `tn_msgbuf_receive()`, etc), which performs all
+ * necessary housekeeping and eventually calls actual worker function
+ * depending on given `job_type`.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param msgbuf
+ *    Message buffer on which job should be performed.
+ * @param job_type
+ *    Type of job to perform, depending on it, appropriate worker function
+ *    will be called (`_msgbuf_send()` or `_msgbuf_receive()`).
+ * @param data
+ *    Depends on given job_type:
+ *
+ *    - `_JOB_TYPE__SEND`: message to send;
+ *    - `_JOB_TYPE__RECEIVE`: pointer at which message should be received.
+ * @param size
+ *    Depends on given job_type:
+ *
+ *    - `_JOB_TYPE__SEND`: size of message to send;
+ *    - `_JOB_TYPE__RECEIVE`: size of location pointed to by `data`.
+ * @param p_size
+ *    Used for `_JOB_TYPE__RECEIVE` only: pointer at which size of received
+ *    message should be stored.
+ * @param timeout
+ *    Refer to `#TN_TickCnt`.
+ */
+static enum TN_RCode _msgbuf_job_perform(
+      struct TN_MsgBuf *msgbuf,
+      enum _JobType job_type,
+      void *data,
+      unsigned int size,
+      unsigned int *p_size,
+      TN_TickCnt timeout
+      )
+{
+   TN_BOOL waited = TN_FALSE;
+   enum TN_RCode rc = _check_param_generic(msgbuf);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if ((rc = _check_param_job(job_type, data, size, p_size))
+         != TN_RC_OK)
+   {
+      //-- just return rc as it is
+   } else if (!tn_is_task_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_INTSAVE_DATA;
+
+      TN_INT_DIS_SAVE();
+
+      switch (job_type){
+
+         case _JOB_TYPE__SEND:
+            //-- try to put new message to the buffer
+            rc = _msgbuf_send(msgbuf, data, size);
+
+            if (rc == TN_RC_TIMEOUT && timeout != 0){
+               //-- We can't put new message to the buffer right now (not
+               //   enough space), and user asked to wait if that happens.
+               //
+               //   Save user-provided message in the `msgbuf` task
+               //   field, and put current task to wait until there's room in
+               //   the buffer.
+               _tn_curr_run_task->subsys_wait.msgbuf.data = data;
+               _tn_curr_run_task->subsys_wait.msgbuf.size = size;
+               _tn_task_curr_to_wait_action(
+                     &(msgbuf->wait_send_list),
+                     TN_WAIT_REASON_MSGBUF_WSEND,
+                     timeout
+                     );
+
+               waited = TN_TRUE;
+            }
+            break;
+
+         case _JOB_TYPE__RECEIVE:
+            //-- try to get the message from the buffer
+            rc = _msgbuf_receive(msgbuf, data, size, p_size);
+
+            if (rc == TN_RC_TIMEOUT && timeout != 0){
+               //-- Buffer is empty right now, and user asked to wait if that
+               //   happens.
+               //
+               //   Save user-provided location in the `msgbuf` task field
+               //   (the message will be copied right there), and put current
+               //   task to wait until new message comes.
+               _tn_curr_run_task->subsys_wait.msgbuf.data = data;
+               _tn_curr_run_task->subsys_wait.msgbuf.size = size;
+               _tn_task_curr_to_wait_action(
+                     &(msgbuf->wait_receive_list),
+                     TN_WAIT_REASON_MSGBUF_WRECEIVE,
+                     timeout
+                     );
+
+               waited = TN_TRUE;
+            }
+            break;
+      }
+
+#if TN_DEBUG
+      if (!_tn_need_context_switch() && waited){
+         _TN_FATAL_ERROR("");
+      }
+#endif
+
+      TN_INT_RESTORE();
+      _tn_context_switch_pend_if_needed();
+      if (waited){
+
+         //-- get wait result
+         rc = _tn_curr_run_task->task_wait_rc;
+
+         switch (job_type){
+            case _JOB_TYPE__SEND:
+               //-- do nothing special
+               break;
+            case _JOB_TYPE__RECEIVE:
+               //-- message is already copied to the user's location,
+               //   return its size to caller
+               if (rc == TN_RC_OK || rc == TN_RC_OVERFLOW){
+                  *p_size = _tn_curr_run_task->subsys_wait.msgbuf.size;
+               }
+               break;
+         }
+      }
+
+   }
+   return rc;
+}
+
+/**
+ * The same as `_msgbuf_job_perform()` with zero timeout, but for using in the
+ * ISR.
+ *
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ */
+static enum TN_RCode _msgbuf_job_iperform(
+      struct TN_MsgBuf *msgbuf,
+      enum _JobType job_type,
+      void *data,
+      unsigned int size,
+      unsigned int *p_size
+      )
+{
+   enum TN_RCode rc = _check_param_generic(msgbuf);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if ((rc = _check_param_job(job_type, data, size, p_size))
+         != TN_RC_OK)
+   {
+      //-- just return rc as it is
+   } else if (!tn_is_isr_context()){
+      //-- wrong context
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_INTSAVE_DATA_INT;
+
+      TN_INT_IDIS_SAVE();
+
+      //-- depending on the job type, call appropriate function. We don't
+      //   handle returned value here, since we can't wait in interrupt, so,
+      //   just return the value to the caller.
+      switch (job_type){
+
+         case _JOB_TYPE__SEND:
+            rc = _msgbuf_send(msgbuf, data, size);
+            break;
+
+         case _JOB_TYPE__RECEIVE:
+            rc = _msgbuf_receive(msgbuf, data, size, p_size);
+            break;
+      }
+
+      TN_INT_IRESTORE();
+      _TN_CONTEXT_SWITCH_IPEND_IF_NEEDED();
+   }
+
+   return rc;
+}
+
+
+
+
+
+/*******************************************************************************
+ *    PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+/*
+ * See comments in the header file (tn_msgbuf.h)
+ */
+enum TN_RCode tn_msgbuf_create(
+      struct TN_MsgBuf *msgbuf,
+      void *buf,
+      unsigned int buf_size
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   rc = _check_param_create(msgbuf, buf, buf_size);
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else {
+      _tn_list_reset(&(msgbuf->wait_send_list));
+      _tn_list_reset(&(msgbuf->wait_receive_list));
+
+      msgbuf->buf             = (unsigned char *)buf;
+      msgbuf->buf_size        = buf_size;
+
+      msgbuf->used_bytes_cnt  = 0;
+      msgbuf->msgs_cnt        = 0;
+      msgbuf->tail_idx        = 0;
+      msgbuf->head_idx        = 0;
+
+      msgbuf->id_msgbuf = TN_ID_MSGBUF;
+   }
+
+   _TN_TRACE(TN_TRACE_EV_MSGBUF_CREATE, msgbuf, rc);
+   return rc;
+}
+
+
+/*
+ * See comments in the header file (tn_msgbuf.h)
+ */
+enum TN_RCode tn_msgbuf_delete(struct TN_MsgBuf *msgbuf)
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   rc = _check_param_generic(msgbuf);
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_task_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_INTSAVE_DATA;
+
+      TN_INT_DIS_SAVE();
+
+      //-- message buffer does not exist now. NOTE: it should be done
+      //   before waking up the tasks, so that
+      //   `_tn_msgbuf_on_task_wait_complete()` doesn't try to feed the rest
+      //   of them
+      msgbuf->id_msgbuf = TN_ID_NONE;
+
+      //-- notify waiting tasks that the object is deleted
+      //   (TN_RC_DELETED is returned)
+      _tn_wait_queue_notify_deleted(&(msgbuf->wait_send_list));
+      _tn_wait_queue_notify_deleted(&(msgbuf->wait_receive_list));
+
+      TN_INT_RESTORE();
+
+      //-- we might need to switch context if _tn_wait_queue_notify_deleted()
+      //   has woken up some high-priority task
+      _tn_context_switch_pend_if_needed();
+
+   }
+
+   _TN_TRACE(TN_TRACE_EV_MSGBUF_DELETE, msgbuf, rc);
+   return rc;
+
+}
+
+
+/*
+ * See comments in the header file (tn_msgbuf.h)
+ */
+enum TN_RCode tn_msgbuf_send(
+      struct TN_MsgBuf *msgbuf,
+      const void *data,
+      unsigned int size,
+      TN_TickCnt timeout
+      )
+{
+   enum TN_RCode rc = _msgbuf_job_perform(
+         msgbuf, _JOB_TYPE__SEND, (void *)data, size, TN_NULL, timeout
+         );
+
+   _TN_TRACE(TN_TRACE_EV_MSGBUF_SEND, msgbuf, rc);
+   return rc;
+}
+
+
+/*
+ * See comments in the header file (tn_msgbuf.h)
+ */
+enum TN_RCode tn_msgbuf_send_polling(
+      struct TN_MsgBuf *msgbuf,
+      const void *data,
+      unsigned int size
+      )
+{
+   enum TN_RCode rc = _msgbuf_job_perform(
+         msgbuf, _JOB_TYPE__SEND, (void *)data, size, TN_NULL, 0
+         );
+
+   _TN_TRACE(TN_TRACE_EV_MSGBUF_SEND, msgbuf, rc);
+   return rc;
+}
+
+
+/*
+ * See comments in the header file (tn_msgbuf.h)
+ */
+enum TN_RCode tn_msgbuf_isend_polling(
+      struct TN_MsgBuf *msgbuf,
+      const void *data,
+      unsigned int size
+      )
+{
+   enum TN_RCode rc = _msgbuf_job_iperform(
+         msgbuf, _JOB_TYPE__SEND, (void *)data, size, TN_NULL
+         );
+
+   _TN_TRACE(TN_TRACE_EV_MSGBUF_SEND, msgbuf, rc);
+   return rc;
+}
+
+
+/*
+ * See comments in the header file (tn_msgbuf.h)
+ */
+enum TN_RCode tn_msgbuf_receive(
+      struct TN_MsgBuf *msgbuf,
+      void *data,
+      unsigned int max_size,
+      unsigned int *p_size,
+      TN_TickCnt timeout
+      )
+{
+   enum TN_RCode rc = _msgbuf_job_perform(
+         msgbuf, _JOB_TYPE__RECEIVE, data, max_size, p_size, timeout
+         );
+
+   _TN_TRACE(TN_TRACE_EV_MSGBUF_RECEIVE, msgbuf, rc);
+   return rc;
+}
+
+
+/*
+ * See comments in the header file (tn_msgbuf.h)
+ */
+enum TN_RCode tn_msgbuf_receive_polling(
+      struct TN_MsgBuf *msgbuf,
+      void *data,
+      unsigned int max_size,
+      unsigned int *p_size
+      )
+{
+   enum TN_RCode rc = _msgbuf_job_perform(
+         msgbuf, _JOB_TYPE__RECEIVE, data, max_size, p_size, 0
+         );
+
+   _TN_TRACE(TN_TRACE_EV_MSGBUF_RECEIVE, msgbuf, rc);
+   return rc;
+}
+
+
+/*
+ * See comments in the header file (tn_msgbuf.h)
+ */
+enum TN_RCode tn_msgbuf_ireceive_polling(
+      struct TN_MsgBuf *msgbuf,
+      void *data,
+      unsigned int max_size,
+      unsigned int *p_size
+      )
+{
+   enum TN_RCode rc = _msgbuf_job_iperform(
+         msgbuf, _JOB_TYPE__RECEIVE, data, max_size, p_size
+         );
+
+   _TN_TRACE(TN_TRACE_EV_MSGBUF_RECEIVE, msgbuf, rc);
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_msgbuf.h)
+ */
+int tn_msgbuf_free_bytes_cnt_get(
+      struct TN_MsgBuf    *msgbuf
+      )
+{
+   int ret = -1;
+   enum TN_RCode rc = _check_param_generic(msgbuf);
+
+   if (rc == TN_RC_OK){
+      //-- It's not needed to disable interrupts here, since `used_bytes_cnt`
+      //   is read by just one assembler instruction, and `buf_size` never
+      //   changes.
+      ret = (int)(msgbuf->buf_size - msgbuf->used_bytes_cnt);
+   }
+
+   return ret;
+}
+
+/*
+ * See comments in the header file (tn_msgbuf.h)
+ */
+int tn_msgbuf_msgs_cnt_get(
+      struct TN_MsgBuf    *msgbuf
+      )
+{
+   int ret = -1;
+   enum TN_RCode rc = _check_param_generic(msgbuf);
+
+   if (rc == TN_RC_OK){
+      //-- It's not needed to disable interrupts here, since `msgs_cnt`
+      //   is read by just one assembler instruction.
+      ret = (int)msgbuf->msgs_cnt;
+   }
+
+   return ret;
+}
+
+
+
+/*******************************************************************************
+ *    INTERNAL TNKERNEL FUNCTIONS
+ ******************************************************************************/
+
+/**
+ * See comment in _tn_msgbuf.h file
+ */
+void _tn_msgbuf_on_task_wait_complete(struct TN_Task *task)
+{
+   struct TN_MsgBuf *msgbuf = _tn_list_entry(
+         task->pwait_queue, struct TN_MsgBuf, wait_send_list
+         );
+
+   //-- if the sender leaves without putting its message to the ring
+   //   (timeout, wait release, termination), the message of the sender
+   //   that is the first one now might fit already
+   if (     task->task_wait_rc != TN_RC_OK
+         && _tn_msgbuf_is_valid(msgbuf)
+      )
+   {
+      _senders_feed(msgbuf);
+   }
+}
+
+
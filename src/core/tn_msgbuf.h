@@ -0,0 +1,459 @@
+/*******************************************************************************
+ *
+ * TNeo: real-time kernel initially based on TNKernel
+ *
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
+ *
+ *    TNeo was born as a thorough review and re-implementation of
+ *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
+ *    as well as new features being added, and it is tested carefully with
+ *    unit-tests.
+ *
+ *    API is changed somewhat, so it's not 100% compatible with TNKernel,
+ *    hence the new name: TNeo.
+ *
+ *    Permission to use, copy, modify, and distribute this software in source
+ *    and binary forms and its documentation for any purpose and without fee
+ *    is hereby granted, provided that the above copyright notice appear
+ *    in all copies and that both that copyright notice and this permission
+ *    notice appear in supporting documentation.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE DMITRY FRANK AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DMITRY FRANK OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *    THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+/**
+ * \file
+ *
+ * A message buffer is a FIFO of variable-length messages which are copied
+ * byte-by-byte into the user-provided storage (unlike the data queue from
+ * \ref tn_dqueue.h, which only carries `void *` pointers). Each message is
+ * stored in the ring as a record: `#TN_MSGBUF_HDR_SIZE` bytes of length
+ * prefix followed by the message bytes, so that the receiver always gets
+ * exactly the message that was sent. A message may have zero length.
+ *
+ * As well as data queue, message buffer has an associated wait queue each
+ * for sending (`wait_send` queue) and for receiving (`wait_receive` queue).
+ * A task that sends a message tries to copy it into the buffer. If there is
+ * not enough free space in the buffer, the task is switched to the waiting
+ * state and placed in the `wait_send` queue until enough space appears. The
+ * order of messages is preserved: while there are tasks waiting to send,
+ * new messages are not put to the buffer even if they would fit.
+ *
+ * A task that receives a message tries to get the oldest record from the
+ * buffer. If the buffer is empty, the task is switched to the waiting state
+ * and placed in the `wait_receive` queue until some message arrives.
+ *
+ * Since data is copied, there's no need for a memory pool round-trip: a
+ * driver (say, UART or radio) can push a whole packet to the buffer with a
+ * single call from an ISR by means of `tn_msgbuf_isend_polling()`.
+ *
+ * Typical usage:
+ *
+ * \code{.c}
+ *     //-- we need to keep up to 4 messages of up to 32 bytes
+ *     #define MY_MSG_SIZE_MAX    32
+ *     #define MY_MSGS_CNT        4
+ *
+ *     static unsigned char my_msgbuf_data[
+ *        MY_MSGS_CNT * TN_MSGBUF_RECORD_SIZE(MY_MSG_SIZE_MAX)
+ *     ];
+ *     static struct TN_MsgBuf my_msgbuf;
+ *
+ *     void some_init(void)
+ *     {
+ *        tn_msgbuf_create(
+ *              &my_msgbuf, my_msgbuf_data, sizeof(my_msgbuf_data)
+ *              );
+ *     }
+ *
+ *     void some_task_body(void *param)
+ *     {
+ *        unsigned char msg[ MY_MSG_SIZE_MAX ];
+ *        unsigned int msg_size;
+ *
+ *        for (;;){
+ *           if (tn_msgbuf_receive(
+ *                    &my_msgbuf, msg, sizeof(msg), &msg_size,
+ *                    TN_WAIT_INFINITE
+ *                    ) == TN_RC_OK)
+ *           {
+ *              //-- handle msg_size bytes of msg
+ *           }
+ *        }
+ *     }
+ * \endcode
+ *
+ */
+
+#ifndef _TN_MSGBUF_H
+#define _TN_MSGBUF_H
+
+/*******************************************************************************
+ *    INCLUDED FILES
+ ******************************************************************************/
+
+#include "tn_list.h"
+#include "tn_common.h"
+
+
+
+/*******************************************************************************
+ *    EXTERN TYPES
+ ******************************************************************************/
+
+
+
+#ifdef __cplusplus
+extern "C"  {  /*}*/
+#endif
+
+/*******************************************************************************
+ *    PUBLIC TYPES
+ ******************************************************************************/
+
+/**
+ * Structure representing message buffer object
+ */
+struct TN_MsgBuf {
+   ///
+   /// id for object validity verification.
+   /// This field is in the beginning of the structure to make it easier
+   /// to detect memory corruption.
+   enum TN_ObjId id_msgbuf;
+   ///
+   /// list of tasks waiting to send messages
+   struct TN_ListItem  wait_send_list;
+   ///
+   /// list of tasks waiting to receive messages
+   struct TN_ListItem  wait_receive_list;
+
+   ///
+   /// byte storage for records (length prefix + message data)
+   unsigned char *buf;
+   ///
+   /// size of `buf` in bytes
+   unsigned int   buf_size;
+   ///
+   /// count of used bytes in `buf` (including length prefixes)
+   unsigned int   used_bytes_cnt;
+   ///
+   /// count of messages in `buf`
+   unsigned int   msgs_cnt;
+   ///
+   /// index of the byte which will be written next time
+   unsigned int   head_idx;
+   ///
+   /// index of the byte which will be read next time
+   unsigned int   tail_idx;
+};
+
+/**
+ * MsgBuf-specific fields related to waiting task,
+ * to be included in struct TN_Task.
+ */
+struct TN_MsgBufTaskWait {
+   /// if task waits to send the message, this is the message data;
+   /// if task waits to receive the message, this is the user's buffer
+   /// to copy message to.
+   void          *data;
+   ///
+   /// if task waits to send the message, this is the message size;
+   /// if task waits to receive the message, this is the size of user's
+   /// buffer initially, and it is set to the actual message size
+   /// when the message is received.
+   unsigned int   size;
+};
+
+
+/*******************************************************************************
+ *    PROTECTED GLOBAL DATA
+ ******************************************************************************/
+
+/*******************************************************************************
+ *    DEFINITIONS
+ ******************************************************************************/
+
+/**
+ * Size of the length prefix of each record in the message buffer, in bytes.
+ * The length is stored as 16-bit little-endian value, so that message can't
+ * be longer than `#TN_MSGBUF_MSG_SIZE_MAX` bytes.
+ */
+#define  TN_MSGBUF_HDR_SIZE      2
+
+/**
+ * Max size of a single message, in bytes.
+ */
+#define  TN_MSGBUF_MSG_SIZE_MAX  0xffff
+
+/**
+ * Number of bytes that a message of given size takes in the message buffer
+ * storage. Convenient for the definition of storage, see usage example
+ * in the header of \ref tn_msgbuf.h.
+ *
+ * @param msg_size
+ *    Size of message in bytes
+ */
+#define  TN_MSGBUF_RECORD_SIZE(msg_size)  ((msg_size) + TN_MSGBUF_HDR_SIZE)
+
+
+
+
+/*******************************************************************************
+ *    PUBLIC FUNCTION PROTOTYPES
+ ******************************************************************************/
+
+/**
+ * Construct message buffer. `id_msgbuf` member should not contain
+ * `#TN_ID_MSGBUF`, otherwise, `#TN_RC_WPARAM` is returned.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param msgbuf     pointer to already allocated struct TN_MsgBuf.
+ * @param buf        pointer to already allocated byte storage for messages.
+ *                   No alignment is required.
+ * @param buf_size   size of `buf` in bytes, should be at least
+ *                   `#TN_MSGBUF_HDR_SIZE`. Each message takes
+ *                   `TN_MSGBUF_RECORD_SIZE(msg_size)` bytes.
+ *
+ * @return 
+ *    * `#TN_RC_OK` if message buffer was successfully created;
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return code
+ *      is available: `#TN_RC_WPARAM`.
+ */
+enum TN_RCode tn_msgbuf_create(
+      struct TN_MsgBuf *msgbuf,
+      void *buf,
+      unsigned int buf_size
+      );
+
+
+/**
+ * Destruct message buffer.
+ *
+ * All tasks that wait for sending to or receiving from the message buffer
+ * become runnable with `#TN_RC_DELETED` code returned.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param msgbuf     pointer to message buffer to be deleted
+ *
+ * @return 
+ *    * `#TN_RC_OK` if message buffer was successfully deleted;
+ *    * `#TN_RC_WCONTEXT` if called from wrong context;
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_msgbuf_delete(struct TN_MsgBuf *msgbuf);
+
+
+/**
+ * Copy the message of `size` bytes pointed to by `data` to the message
+ * buffer specified by the `msgbuf`.
+ *
+ * If there is enough free space in the buffer (and there are no other tasks
+ * already waiting to send), the message is copied and, if there are tasks
+ * waiting to receive, the first one of them gets the message and becomes
+ * runnable. Otherwise, behavior depends on the `timeout` value: refer to
+ * `#TN_TickCnt`. If the task has to wait, the message is copied when the
+ * space appears, so the `data` should remain valid until the function
+ * returns.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_CAN_SLEEP)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param msgbuf     pointer to message buffer to send message to
+ * @param data       pointer to message data. Can be `#TN_NULL` if only
+ *                   `size` is 0.
+ * @param size       size of message in bytes
+ * @param timeout    refer to `#TN_TickCnt`
+ *
+ * @return  
+ *    * `#TN_RC_OK`   if message was successfully sent;
+ *    * `#TN_RC_OVERFLOW` if the message can never fit in the buffer, i.e.
+ *      `TN_MSGBUF_RECORD_SIZE(size)` is larger than the buffer size, or
+ *      `size` is larger than `#TN_MSGBUF_MSG_SIZE_MAX`;
+ *    * `#TN_RC_WCONTEXT` if called from wrong context;
+ *    * Other possible return codes depend on `timeout` value,
+ *      refer to `#TN_TickCnt`
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ *
+ * @see `#TN_TickCnt`
+ */
+enum TN_RCode tn_msgbuf_send(
+      struct TN_MsgBuf *msgbuf,
+      const void *data,
+      unsigned int size,
+      TN_TickCnt timeout
+      );
+
+/**
+ * The same as `tn_msgbuf_send()` with zero timeout
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ */
+enum TN_RCode tn_msgbuf_send_polling(
+      struct TN_MsgBuf *msgbuf,
+      const void *data,
+      unsigned int size
+      );
+
+/**
+ * The same as `tn_msgbuf_send()` with zero timeout, but for using in the ISR.
+ *
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ */
+enum TN_RCode tn_msgbuf_isend_polling(
+      struct TN_MsgBuf *msgbuf,
+      const void *data,
+      unsigned int size
+      );
+
+/**
+ * Receive the oldest message from the message buffer specified by the
+ * `msgbuf`, copy it to the location specified by `data` and store its size
+ * at the location specified by `p_size`.
+ *
+ * If the message is larger than `max_size`, it stays in the buffer,
+ * its size is stored at `p_size`, and `#TN_RC_OVERFLOW` is returned, so that
+ * the caller is able to retry with larger buffer.
+ *
+ * After the message is received, tasks that wait to send are given a chance
+ * to put their messages to the freed space (in the order they started
+ * waiting). If the buffer is empty, behavior depends on the `timeout` value:
+ * refer to `#TN_TickCnt`.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_CAN_SLEEP)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param msgbuf     pointer to message buffer to receive message from
+ * @param data       pointer to location to copy message to
+ * @param max_size   size of location pointed to by `data`, in bytes
+ * @param p_size     pointer to location to store the message size
+ * @param timeout    refer to `#TN_TickCnt`
+ *
+ * @return  
+ *    * `#TN_RC_OK`   if message was successfully received;
+ *    * `#TN_RC_OVERFLOW` if the message is larger than `max_size`;
+ *    * `#TN_RC_WCONTEXT` if called from wrong context;
+ *    * Other possible return codes depend on `timeout` value,
+ *      refer to `#TN_TickCnt`
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ *
+ * @see `#TN_TickCnt`
+ */
+enum TN_RCode tn_msgbuf_receive(
+      struct TN_MsgBuf *msgbuf,
+      void *data,
+      unsigned int max_size,
+      unsigned int *p_size,
+      TN_TickCnt timeout
+      );
+
+/**
+ * The same as `tn_msgbuf_receive()` with zero timeout
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ */
+enum TN_RCode tn_msgbuf_receive_polling(
+      struct TN_MsgBuf *msgbuf,
+      void *data,
+      unsigned int max_size,
+      unsigned int *p_size
+      );
+
+/**
+ * The same as `tn_msgbuf_receive()` with zero timeout, but for using in the
+ * ISR.
+ *
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ */
+enum TN_RCode tn_msgbuf_ireceive_polling(
+      struct TN_MsgBuf *msgbuf,
+      void *data,
+      unsigned int max_size,
+      unsigned int *p_size
+      );
+
+
+/**
+ * Returns number of free bytes in the message buffer. Note that the
+ * largest message that can be sent right now is
+ * `#TN_MSGBUF_HDR_SIZE` bytes smaller.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param msgbuf
+ *    Pointer to message buffer.
+ *
+ * @return
+ *    Number of free bytes in the message buffer, or -1 if wrong params were
+ *    given (the check is performed if only `#TN_CHECK_PARAM` is non-zero)
+ */
+int tn_msgbuf_free_bytes_cnt_get(
+      struct TN_MsgBuf    *msgbuf
+      );
+
+
+/**
+ * Returns number of messages in the message buffer
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param msgbuf
+ *    Pointer to message buffer.
+ *
+ * @return
+ *    Number of messages in the message buffer, or -1 if wrong params were
+ *    given (the check is performed if only `#TN_CHECK_PARAM` is non-zero)
+ */
+int tn_msgbuf_msgs_cnt_get(
+      struct TN_MsgBuf    *msgbuf
+      );
+
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif // _TN_MSGBUF_H
+
+/*******************************************************************************
+ *    end of file
+ ******************************************************************************/
+
+
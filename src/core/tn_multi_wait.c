@@ -0,0 +1,492 @@
+/*******************************************************************************
+ *
+ * TNeo: real-time kernel initially based on TNKernel
+ *
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
+ *
+ *    TNeo was born as a thorough review and re-implementation of
+ *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
+ *    as well as new features being added, and it is tested carefully with
+ *    unit-tests.
+ *
+ *    API is changed somewhat, so it's not 100% compatible with TNKernel,
+ *    hence the new name: TNeo.
+ *
+ *    Permission to use, copy, modify, and distribute this software in source
+ *    and binary forms and its documentation for any purpose and without fee
+ *    is hereby granted, provided that the above copyright notice appear
+ *    in all copies and that both that copyright notice and this permission
+ *    notice appear in supporting documentation.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE DMITRY FRANK AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DMITRY FRANK OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *    THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+/*******************************************************************************
+ *    INCLUDED FILES
+ ******************************************************************************/
+
+//-- common tnkernel headers
+#include "tn_common.h"
+#include "tn_sys.h"
+
+//-- internal tnkernel headers
+#include "_tn_tasks.h"
+#include "_tn_list.h"
+#include "_tn_trace.h"
+#include "_tn_dqueue.h"
+#include "_tn_sem.h"
+#include "_tn_fmem.h"
+#include "_tn_eventgrp.h"
+
+
+//-- header of current module
+#include "_tn_multi_wait.h"
+
+//-- header of other needed modules
+#include "tn_tasks.h"
+
+
+
+#if TN_USE_MULTI_WAIT
+
+/*******************************************************************************
+ *    PRIVATE FUNCTIONS
+ ******************************************************************************/
+
+//-- Additional param checking {{{
+#if TN_CHECK_PARAM
+static enum TN_RCode _check_param_item(
+      const struct TN_MultiWaitItem *item
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   if (item->obj == TN_NULL){
+      rc = TN_RC_WPARAM;
+   } else {
+      TN_BOOL valid = TN_FALSE;
+
+      switch (item->type){
+         case TN_MULTI_WAIT_OBJ_DQUEUE:
+            valid = _tn_dqueue_is_valid((struct TN_DQueue *)item->obj);
+            break;
+         case TN_MULTI_WAIT_OBJ_SEM:
+            valid = _tn_sem_is_valid((struct TN_Sem *)item->obj);
+            break;
+         case TN_MULTI_WAIT_OBJ_FMEM:
+            valid = _tn_fmem_is_valid((struct TN_FMem *)item->obj);
+            break;
+         case TN_MULTI_WAIT_OBJ_EVENTGRP:
+            valid = _tn_eventgrp_is_valid((struct TN_EventGrp *)item->obj);
+            break;
+         default:
+            rc = TN_RC_WPARAM;
+            break;
+      }
+
+      if (rc == TN_RC_OK && !valid){
+         rc = TN_RC_INVALID_OBJ;
+      }
+   }
+
+   return rc;
+}
+
+static enum TN_RCode _check_param_generic(
+      const struct TN_MultiWaitItem *items,
+      int                            items_cnt,
+      const int                     *p_fired_idx
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   if (items == TN_NULL || items_cnt <= 0 || p_fired_idx == TN_NULL){
+      rc = TN_RC_WPARAM;
+   } else {
+      int i;
+      for (i = 0; i < items_cnt && rc == TN_RC_OK; i++){
+         rc = _check_param_item(&items[i]);
+      }
+   }
+
+   return rc;
+}
+
+#else
+#  define _check_param_generic(items, items_cnt, p_fired_idx)  (TN_RC_OK)
+#endif
+// }}}
+
+/**
+ * Returns `multi_wait_list` of the object which is waited for by the given
+ * item.
+ */
+static struct TN_ListItem *_multi_wait_list_get(
+      struct TN_MultiWaitItem *item
+      )
+{
+   struct TN_ListItem *ret = TN_NULL;
+
+   switch (item->type){
+      case TN_MULTI_WAIT_OBJ_DQUEUE:
+         ret = &((struct TN_DQueue *)item->obj)->multi_wait_list;
+         break;
+      case TN_MULTI_WAIT_OBJ_SEM:
+         ret = &((struct TN_Sem *)item->obj)->multi_wait_list;
+         break;
+      case TN_MULTI_WAIT_OBJ_FMEM:
+         ret = &((struct TN_FMem *)item->obj)->multi_wait_list;
+         break;
+      case TN_MULTI_WAIT_OBJ_EVENTGRP:
+         ret = &((struct TN_EventGrp *)item->obj)->multi_wait_list;
+         break;
+      default:
+         _TN_FATAL_ERROR("wrong item type");
+         break;
+   }
+
+   return ret;
+}
+
+/**
+ * Try to claim the object of the given item without waiting: receive data
+ * element from the queue, acquire the semaphore, etc.
+ *
+ * @return
+ *    - `#TN_RC_OK` if the object was claimed, and the result (if any) is
+ *      stored in the item;
+ *    - `#TN_RC_TIMEOUT` if the object isn't ready;
+ *    - other code if some error occurred.
+ */
+static enum TN_RCode _item_try(struct TN_MultiWaitItem *item)
+{
+   enum TN_RCode rc;
+
+   switch (item->type){
+      case TN_MULTI_WAIT_OBJ_DQUEUE:
+         rc = _tn_queue_receive((struct TN_DQueue *)item->obj, &item->p_data);
+         break;
+      case TN_MULTI_WAIT_OBJ_SEM:
+         rc = _tn_sem_wait((struct TN_Sem *)item->obj);
+         break;
+      case TN_MULTI_WAIT_OBJ_FMEM:
+         rc = _tn_fmem_get((struct TN_FMem *)item->obj, &item->p_data);
+         break;
+      case TN_MULTI_WAIT_OBJ_EVENTGRP:
+         rc = _tn_eventgrp_wait(
+               (struct TN_EventGrp *)item->obj,
+               item->wait_pattern, item->wait_mode, &item->flags_pattern
+               );
+         break;
+      default:
+         rc = TN_RC_WPARAM;
+         break;
+   }
+
+   return rc;
+}
+
+/**
+ * Actual worker function that is eventually called when user calls
+ * `tn_multi_wait()` and friends. It never sleeps: it walks through the items
+ * in the array order, and claims the object of the first ready item. If none
+ * of the items is ready, `#TN_RC_TIMEOUT` is returned, and the caller may
+ * sleep then (it depends).
+ */
+static enum TN_RCode _multi_wait(
+      struct TN_MultiWaitItem   *items,
+      int                        items_cnt,
+      int                       *p_fired_idx
+      )
+{
+   enum TN_RCode rc = TN_RC_TIMEOUT;
+   int i;
+
+   for (i = 0; i < items_cnt; i++){
+      rc = _item_try(&items[i]);
+      if (rc != TN_RC_TIMEOUT){
+         //-- either the item has fired, or some error has occurred
+         if (rc == TN_RC_OK){
+            *p_fired_idx = i;
+         }
+         break;
+      }
+   }
+
+   return rc;
+}
+
+/**
+ * Put current task to wait for all the given items: add each item to the
+ * `multi_wait_list` of its object, so that the object will hand the item to
+ * the task when it gets ready.
+ */
+static void _curr_task_to_wait(
+      struct TN_MultiWaitItem   *items,
+      int                        items_cnt,
+      TN_TickCnt                 timeout
+      )
+{
+   struct TN_Task *task = _tn_curr_run_task;
+   int i;
+
+   for (i = 0; i < items_cnt; i++){
+      items[i].task = task;
+      _tn_list_add_tail(_multi_wait_list_get(&items[i]), &items[i].obj_link);
+   }
+
+   task->subsys_wait.multi.items       = items;
+   task->subsys_wait.multi.items_cnt   = items_cnt;
+   task->subsys_wait.multi.fired_idx   = -1;
+
+   //-- task isn't contained in any task wait queue: its items are contained
+   //   in `multi_wait_list`s of the objects instead
+   _tn_task_curr_to_wait_action(TN_NULL, TN_WAIT_REASON_MULTI, timeout);
+}
+
+/**
+ * Generic function that performs job from task context
+ *
+ * For params documentation, refer to the `tn_multi_wait()`.
+ */
+static enum TN_RCode _multi_job_perform(
+      struct TN_MultiWaitItem   *items,
+      int                        items_cnt,
+      int                       *p_fired_idx,
+      TN_TickCnt                 timeout
+      )
+{
+   TN_BOOL waited = TN_FALSE;
+   enum TN_RCode rc = _check_param_generic(items, items_cnt, p_fired_idx);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_task_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_INTSAVE_DATA;
+
+      TN_INT_DIS_SAVE();
+
+      rc = _multi_wait(items, items_cnt, p_fired_idx);
+
+      if (rc == TN_RC_TIMEOUT && timeout != 0){
+         //-- none of the items is ready, and user wants to wait in this case.
+         _curr_task_to_wait(items, items_cnt, timeout);
+         waited = TN_TRUE;
+      }
+
+      _TN_BUG_ON(!_tn_need_context_switch() && waited);
+
+      TN_INT_RESTORE();
+      _tn_context_switch_pend_if_needed();
+
+      if (waited){
+         //-- task was waiting, and now it has just woke up.
+         //-- get wait result
+         rc = _tn_curr_run_task->task_wait_rc;
+
+         //-- if wait was finished by some item (it either fired or its
+         //   object was deleted), return index of that item.
+         //   The item has its result (if any) already stored in it.
+         if (_tn_curr_run_task->subsys_wait.multi.fired_idx >= 0){
+            *p_fired_idx = _tn_curr_run_task->subsys_wait.multi.fired_idx;
+         }
+      }
+   }
+
+   return rc;
+}
+
+/**
+ * Generic function that performs job from interrupt context
+ *
+ * For params documentation, refer to the `tn_multi_wait()`.
+ */
+static enum TN_RCode _multi_job_iperform(
+      struct TN_MultiWaitItem   *items,
+      int                        items_cnt,
+      int                       *p_fired_idx
+      )
+{
+   enum TN_RCode rc = _check_param_generic(items, items_cnt, p_fired_idx);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_isr_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_INTSAVE_DATA_INT;
+
+      TN_INT_IDIS_SAVE();
+
+      rc = _multi_wait(items, items_cnt, p_fired_idx);
+
+      TN_INT_IRESTORE();
+      _TN_CONTEXT_SWITCH_IPEND_IF_NEEDED();
+   }
+
+   return rc;
+}
+
+
+
+
+/*******************************************************************************
+ *    PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+/*
+ * See comments in the header file (tn_multi_wait.h)
+ */
+enum TN_RCode tn_multi_wait(
+      struct TN_MultiWaitItem   *items,
+      int                        items_cnt,
+      int                       *p_fired_idx,
+      TN_TickCnt                 timeout
+      )
+{
+   enum TN_RCode rc = _multi_job_perform(
+         items, items_cnt, p_fired_idx, timeout
+         );
+
+   _TN_TRACE(TN_TRACE_EV_MULTI_WAIT, items, rc);
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_multi_wait.h)
+ */
+enum TN_RCode tn_multi_wait_polling(
+      struct TN_MultiWaitItem   *items,
+      int                        items_cnt,
+      int                       *p_fired_idx
+      )
+{
+   enum TN_RCode rc = _multi_job_perform(items, items_cnt, p_fired_idx, 0);
+
+   _TN_TRACE(TN_TRACE_EV_MULTI_WAIT, items, rc);
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_multi_wait.h)
+ */
+enum TN_RCode tn_multi_iwait_polling(
+      struct TN_MultiWaitItem   *items,
+      int                        items_cnt,
+      int                       *p_fired_idx
+      )
+{
+   enum TN_RCode rc = _multi_job_iperform(items, items_cnt, p_fired_idx);
+
+   _TN_TRACE(TN_TRACE_EV_MULTI_WAIT, items, rc);
+   return rc;
+}
+
+
+
+
+/*******************************************************************************
+ *    PROTECTED FUNCTIONS
+ ******************************************************************************/
+
+/**
+ * See comments in the file _tn_multi_wait.h
+ */
+TN_BOOL _tn_multi_wait_first_complete(
+      struct TN_ListItem  *multi_wait_list,
+      void                *p_data
+      )
+{
+   TN_BOOL ret = TN_FALSE;
+
+   //-- interrupts should be disabled here
+   _TN_BUG_ON( !TN_IS_INT_DISABLED() );
+
+   if (!_tn_list_is_empty(multi_wait_list)){
+      struct TN_MultiWaitItem *item = _tn_list_first_entry(
+            multi_wait_list, struct TN_MultiWaitItem, obj_link
+            );
+
+      item->p_data = p_data;
+      _tn_multi_wait_item_complete(item, TN_RC_OK);
+
+      ret = TN_TRUE;
+   }
+
+   return ret;
+}
+
+/**
+ * See comments in the file _tn_multi_wait.h
+ */
+void _tn_multi_wait_item_complete(
+      struct TN_MultiWaitItem   *item,
+      enum TN_RCode              wait_rc
+      )
+{
+   struct TN_Task *task = item->task;
+
+   //-- interrupts should be disabled here
+   _TN_BUG_ON( !TN_IS_INT_DISABLED() );
+
+   task->subsys_wait.multi.fired_idx 
+      = (int)(item - task->subsys_wait.multi.items);
+
+   //-- all the items of the task are removed from their lists in
+   //   `_tn_multi_wait_on_task_wait_complete()`
+   _tn_task_wait_complete(task, wait_rc);
+}
+
+/**
+ * See comments in the file _tn_multi_wait.h
+ */
+void _tn_multi_wait_notify_deleted(struct TN_ListItem *multi_wait_list)
+{
+   //-- interrupts should be disabled here
+   _TN_BUG_ON( !TN_IS_INT_DISABLED() );
+
+   //-- each completed item gets removed from the list (together with other
+   //   items of the same task), so just take the first one until the list
+   //   is empty
+   while (!_tn_list_is_empty(multi_wait_list)){
+      _tn_multi_wait_item_complete(
+            _tn_list_first_entry(
+               multi_wait_list, struct TN_MultiWaitItem, obj_link
+               ),
+            TN_RC_DELETED
+            );
+   }
+}
+
+/**
+ * See comments in the file _tn_multi_wait.h
+ */
+void _tn_multi_wait_on_task_wait_complete(struct TN_Task *task)
+{
+   struct TN_MultiWaitItem *items = task->subsys_wait.multi.items;
+   int i;
+
+   for (i = 0; i < task->subsys_wait.multi.items_cnt; i++){
+      _tn_list_remove_entry(&items[i].obj_link);
+      _tn_list_reset(&items[i].obj_link);
+   }
+}
+
+#endif //-- TN_USE_MULTI_WAIT
+
+
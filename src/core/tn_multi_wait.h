@@ -0,0 +1,305 @@
+/*******************************************************************************
+ *
+ * TNeo: real-time kernel initially based on TNKernel
+ *
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
+ *
+ *    TNeo was born as a thorough review and re-implementation of
+ *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
+ *    as well as new features being added, and it is tested carefully with
+ *    unit-tests.
+ *
+ *    API is changed somewhat, so it's not 100% compatible with TNKernel,
+ *    hence the new name: TNeo.
+ *
+ *    Permission to use, copy, modify, and distribute this software in source
+ *    and binary forms and its documentation for any purpose and without fee
+ *    is hereby granted, provided that the above copyright notice appear
+ *    in all copies and that both that copyright notice and this permission
+ *    notice appear in supporting documentation.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE DMITRY FRANK AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DMITRY FRANK OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *    THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+/**
+ * \file
+ *
+ * Waiting for multiple kernel objects at once.
+ *
+ * Sometimes a task has to serve several sources of events: say, a gateway
+ * task receives messages from a few data queues, and also wants to be woken
+ * up when some semaphore is signaled. Without special support from the
+ * kernel, this is usually done by connecting all the queues to the same event
+ * group (see `tn_queue_eventgrp_connect()`), but then each waiting task is
+ * woken up on each event, and all of them have to race with polling receive.
+ *
+ * `tn_multi_wait()` takes an array of items (`struct TN_MultiWaitItem`), each
+ * of them describes one object to wait for:
+ *
+ * - data queue (`#TN_MULTI_WAIT_OBJ_DQUEUE`): wait for the data element;
+ * - semaphore (`#TN_MULTI_WAIT_OBJ_SEM`): wait to acquire the semaphore;
+ * - fixed memory pool (`#TN_MULTI_WAIT_OBJ_FMEM`): wait for the free block;
+ * - event group (`#TN_MULTI_WAIT_OBJ_EVENTGRP`): wait for the event bits,
+ *   as `tn_eventgrp_wait()` does.
+ *
+ * If some of these objects are ready already, the first one (in array order)
+ * is taken immediately. Otherwise, the task waits until some object fires.
+ * The item is always claimed by the kernel on behalf of the waiting task, 
+ * atomically with waking it up: the data element, the memory block or the
+ * semaphore count is handed to the task directly (just like it is given to
+ * the task waiting by `tn_queue_receive()`, etc), and just one waiting task
+ * is woken up for each data element / block / signal. So, there are no
+ * spurious wakeups, and the task doesn't need to poll anything after it is
+ * woken up: it just checks the index of the fired item.
+ *
+ * Tasks that wait for the object directly (by `tn_queue_receive()`,
+ * `tn_sem_wait()`, etc) are served before tasks that wait for it by
+ * `tn_multi_wait()`; the latter ones are served in FIFO order.
+ *
+ * The array of items is used by the kernel while the task waits, so it must
+ * stay valid until `tn_multi_wait()` returns (typically, it is allocated on
+ * the task's stack). The same array can be reused by subsequent calls.
+ *
+ * Typical usage:
+ *
+ * \code{.c}
+ *     void gateway_task_body(void *param)
+ *     {
+ *        struct TN_MultiWaitItem items[2] = {
+ *           { .type = TN_MULTI_WAIT_OBJ_DQUEUE, .obj = &uart_rx_queue },
+ *           { .type = TN_MULTI_WAIT_OBJ_DQUEUE, .obj = &radio_rx_queue },
+ *        };
+ *        int idx;
+ *
+ *        for (;;){
+ *           if (tn_multi_wait(
+ *                    items, 2, &idx, TN_WAIT_INFINITE
+ *                    ) == TN_RC_OK)
+ *           {
+ *              //-- items[idx].p_data is the message received
+ *              //   from the queue items[idx].obj
+ *           }
+ *        }
+ *     }
+ * \endcode
+ *
+ * Multi-object wait is available if only `#TN_USE_MULTI_WAIT` is non-zero.
+ */
+
+#ifndef _TN_MULTI_WAIT_H
+#define _TN_MULTI_WAIT_H
+
+/*******************************************************************************
+ *    INCLUDED FILES
+ ******************************************************************************/
+
+#include "tn_list.h"
+#include "tn_common.h"
+#include "tn_eventgrp.h"
+
+
+
+#ifdef __cplusplus
+extern "C"  {  /*}*/
+#endif
+
+/*******************************************************************************
+ *    EXTERN TYPES
+ ******************************************************************************/
+
+struct TN_Task;
+
+
+
+/*******************************************************************************
+ *    PUBLIC TYPES
+ ******************************************************************************/
+
+/**
+ * Type of the object to wait for, see `struct #TN_MultiWaitItem`.
+ */
+enum TN_MultiWaitObjType {
+   ///
+   /// Receive data element from the data queue `struct #TN_DQueue`
+   TN_MULTI_WAIT_OBJ_DQUEUE,
+   ///
+   /// Acquire semaphore `struct #TN_Sem`
+   TN_MULTI_WAIT_OBJ_SEM,
+   ///
+   /// Get memory block from the fixed memory pool `struct #TN_FMem`
+   TN_MULTI_WAIT_OBJ_FMEM,
+   ///
+   /// Wait for event(s) in the event group `struct #TN_EventGrp`
+   TN_MULTI_WAIT_OBJ_EVENTGRP,
+};
+
+/**
+ * Single item for `tn_multi_wait()`: an object to wait for, plus the
+ * result which is filled by the kernel when the item fires.
+ */
+struct TN_MultiWaitItem {
+   ///
+   /// Type of the object `obj`, see `enum #TN_MultiWaitObjType`
+   enum TN_MultiWaitObjType type;
+   ///
+   /// Object to wait for: pointer to `struct TN_DQueue`, `struct TN_Sem`,
+   /// `struct TN_FMem` or `struct TN_EventGrp`, depending on `type`.
+   void *obj;
+   ///
+   /// For event group only: wait pattern, see `tn_eventgrp_wait()`
+   TN_UWord wait_pattern;
+   ///
+   /// For event group only: wait mode, see `tn_eventgrp_wait()`
+   enum TN_EGrpWaitMode wait_mode;
+
+   ///
+   /// Result, valid if only this item has fired: 
+   /// - for data queue: the data element received;
+   /// - for memory pool: the memory block allocated.
+   void *p_data;
+   ///
+   /// Result, valid if only this item has fired: for event group, the
+   /// events pattern that caused the item to fire (as `p_flags_pattern` of
+   /// `tn_eventgrp_wait()`).
+   TN_UWord flags_pattern;
+
+   ///
+   /// Internal: item in the `multi_wait_list` of the object `obj`
+   struct TN_ListItem obj_link;
+   ///
+   /// Internal: task which waits for this item
+   struct TN_Task *task;
+};
+
+/**
+ * Multi-wait-specific fields related to waiting task,
+ * to be included in struct TN_Task.
+ */
+struct TN_MultiWaitTaskWait {
+   ///
+   /// array of items the task waits for
+   struct TN_MultiWaitItem *items;
+   ///
+   /// number of items in the `items` array
+   int items_cnt;
+   ///
+   /// index of the item that caused task to finish waiting
+   int fired_idx;
+};
+
+
+/*******************************************************************************
+ *    PROTECTED GLOBAL DATA
+ ******************************************************************************/
+
+/*******************************************************************************
+ *    DEFINITIONS
+ ******************************************************************************/
+
+
+/*******************************************************************************
+ *    PUBLIC FUNCTION PROTOTYPES
+ ******************************************************************************/
+
+/**
+ * Wait for any of the given objects: take the first ready object, or, if none
+ * of them is ready, wait until some of them fires. When `#TN_RC_OK` is
+ * returned, the fired item is already claimed on behalf of the caller: data
+ * element is received from the queue (and stored in the `p_data` field of the
+ * item), semaphore is acquired, memory block is allocated (and stored in the
+ * `p_data` field), or event bits are checked and, if requested by
+ * `#TN_EVENTGRP_WMODE_AUTOCLR`, cleared (the pattern is stored in the 
+ * `flags_pattern` field). Other items are left untouched.
+ *
+ * For each item, the caller should set the fields `type` and `obj`, and, for
+ * the event group, `wait_pattern` and `wait_mode` as well. Other fields are
+ * managed by the kernel.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_CAN_SLEEP)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param items
+ *    Array of objects to wait for. It must stay valid until the function
+ *    returns.
+ * @param items_cnt
+ *    Number of items in the `items` array, must be positive.
+ * @param p_fired_idx
+ *    Pointer to the location at which the index of the fired item is stored
+ *    if `#TN_RC_OK` is returned. If `#TN_RC_DELETED` is returned, the index
+ *    of the item whose object was deleted is stored there.
+ * @param timeout
+ *    refer to `#TN_TickCnt`
+ *
+ * @return
+ *    * `#TN_RC_OK` if some item fired, and its index is stored at
+ *      `p_fired_idx`;
+ *    * `#TN_RC_TIMEOUT` if none of the items fired before timeout;
+ *    * `#TN_RC_DELETED` if some object was deleted while task waited;
+ *    * `#TN_RC_FORCED` if task was released from wait forcibly by
+ *      `tn_task_release_wait()`;
+ *    * `#TN_RC_WCONTEXT` if called from wrong context;
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_multi_wait(
+      struct TN_MultiWaitItem   *items,
+      int                        items_cnt,
+      int                       *p_fired_idx,
+      TN_TickCnt                 timeout
+      );
+
+/**
+ * The same as `tn_multi_wait()` with zero timeout.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ */
+enum TN_RCode tn_multi_wait_polling(
+      struct TN_MultiWaitItem   *items,
+      int                        items_cnt,
+      int                       *p_fired_idx
+      );
+
+/**
+ * The same as `tn_multi_wait()` with zero timeout, but for using in the ISR.
+ *
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ */
+enum TN_RCode tn_multi_iwait_polling(
+      struct TN_MultiWaitItem   *items,
+      int                        items_cnt,
+      int                       *p_fired_idx
+      );
+
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+
+#endif // _TN_MULTI_WAIT_H
+
+
+/*******************************************************************************
+ *    end of file
+ ******************************************************************************/
+
+
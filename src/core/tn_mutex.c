@@ -46,6 +46,7 @@
 #include "_tn_mutex.h"
 #include "_tn_tasks.h"
 #include "_tn_list.h"
+#include "_tn_trace.h"
 
 //-- header of current module
 #include "tn_mutex.h"
@@ -88,6 +89,12 @@
 // to Real-Time Synchronization, IEEE Transactions on Computers, Vol.39, No.9, 1990
 
 
+#if _TN_MUTEX_FAST_PATH
+//-- `holder` field of the mutex as a word, for the exclusive access
+#  define _holder_word(mutex)    ((volatile TN_UWord *)&((mutex)->holder))
+#endif
+
+
 
 
 /*******************************************************************************
@@ -309,6 +316,124 @@ in:
 
 }
 
+#if _TN_MUTEX_FAST_PATH
+/**
+ * Lock-free fast path of `tn_mutex_lock()`: if the mutex with priority
+ * inheritance protocol isn't held by anyone, lock it by the current task
+ * without disabling interrupts.
+ *
+ * Locking of a free mutex doesn't change priority of the task, so it's enough
+ * to just set the holder. The mutex isn't added to the task's `mutex_queue`:
+ * this is done by the first task that has to wait for it, see
+ * `_add_curr_task_to_mutex_wait_queue()`. Instead, it is remembered as the
+ * task's `mutex_fast`, so that it is unlocked if the task is terminated.
+ * The task holds at most one mutex locked by the fast path: if it already
+ * holds one, the slow path is taken.
+ *
+ * @returns `TN_TRUE` if the mutex is locked, `TN_FALSE` if the slow path
+ *          should be taken.
+ */
+_TN_STATIC_INLINE TN_BOOL _mutex_fast_lock(struct TN_Mutex *mutex)
+{
+   TN_BOOL ret = TN_FALSE;
+
+   if (     mutex->protocol == TN_MUTEX_PROT_INHERIT
+         && _tn_curr_run_task->mutex_fast == TN_NULL
+      )
+   {
+      //-- remember the mutex _before_ it is locked: if the task is terminated
+      //   right after the store below, `_tn_mutex_unlock_all_by_task()`
+      //   finds it. (if the task is terminated before the store, the mutex
+      //   isn't held by the task, and it is just ignored there)
+      _tn_curr_run_task->mutex_fast = mutex;
+
+      for (;;){
+         if (_TN_EXCL_LOAD(_holder_word(mutex)) != (TN_UWord)TN_NULL){
+            //-- mutex is already held (possibly by the current task):
+            //   leave it for the slow path
+            _TN_EXCL_CLEAR();
+            _tn_curr_run_task->mutex_fast = TN_NULL;
+            break;
+         } else if (_TN_EXCL_STORE(
+                  _holder_word(mutex), (TN_UWord)_tn_curr_run_task
+                  ))
+         {
+            //-- mutex is locked. Lock count is modified by the holder only,
+            //   so, it's safe to do that now.
+            __mutex_lock_cnt_change(mutex, 1);
+            ret = TN_TRUE;
+            break;
+         } else {
+            //-- some exception has happened after the load, so the mutex
+            //   might be locked by another task meanwhile: try again
+         }
+      }
+   }
+
+   return ret;
+}
+
+/**
+ * Lock-free fast path of `tn_mutex_unlock()`: if the mutex is held by the
+ * current task, isn't included in the task's `mutex_queue` (i.e. nobody has
+ * waited for it) and isn't locked recursively, unlock it without disabling
+ * interrupts.
+ *
+ * NOTE: lock count is modified outside of the exclusive load/store pair,
+ * since a regular store might clear the exclusive monitor on some
+ * implementations.
+ *
+ * @returns `TN_TRUE` if the mutex is unlocked, `TN_FALSE` if the slow path
+ *          should be taken.
+ */
+_TN_STATIC_INLINE TN_BOOL _mutex_fast_unlock(struct TN_Mutex *mutex)
+{
+   TN_BOOL ret = TN_FALSE;
+
+   //-- nobody but the holder can change the holder, so plain read is fine
+   //   here. But other tasks may add the mutex to the holder's
+   //   `mutex_queue` at any time, so it is checked again below.
+   if (     mutex->holder == _tn_curr_run_task
+         && _tn_list_is_empty(&(mutex->mutex_queue))
+#if TN_MUTEX_REC
+         && mutex->cnt == 1
+#endif
+      )
+   {
+      __mutex_lock_cnt_change(mutex, -1);
+
+      for (;;){
+         (void)_TN_EXCL_LOAD(_holder_word(mutex));
+
+         if (!_tn_list_is_empty(&(mutex->mutex_queue))){
+            //-- some task has started waiting for the mutex: restore lock
+            //   count and leave the mutex for the slow path
+            _TN_EXCL_CLEAR();
+            __mutex_lock_cnt_change(mutex, 1);
+            break;
+         } else if (_TN_EXCL_STORE(_holder_word(mutex), (TN_UWord)TN_NULL)){
+            //-- mutex is unlocked. It is forgotten _after_ that, so if the
+            //   task is terminated in between, `mutex_fast` is ignored by
+            //   `_tn_mutex_unlock_all_by_task()`, since the mutex isn't held
+            //   by the task anymore.
+            _tn_curr_run_task->mutex_fast = TN_NULL;
+            ret = TN_TRUE;
+            break;
+         } else {
+            //-- some exception has happened after the load, so some task
+            //   might start waiting for the mutex meanwhile: check again
+         }
+      }
+   }
+
+   return ret;
+}
+
+#else
+#  define _mutex_fast_lock(mutex)      (TN_FALSE)
+#  define _mutex_fast_unlock(mutex)    (TN_FALSE)
+#endif
+
 _TN_STATIC_INLINE void _mutex_do_lock(struct TN_Mutex *mutex, struct TN_Task *task)
 {
    mutex->holder = task;
@@ -499,6 +624,16 @@ _TN_STATIC_INLINE void _add_curr_task_to_mutex_wait_queue(
 {
    enum TN_WaitReason wait_reason;
 
+#if _TN_MUTEX_FAST_PATH
+   //-- If the mutex was locked by the lock-free fast path, it isn't included
+   //   in the holder's locked mutexes list yet: add it there now, so that
+   //   priority inheritance works, and the holder will unlock the mutex
+   //   by the slow path.
+   if (_tn_list_is_empty(&(mutex->mutex_queue))){
+      _tn_list_add_tail(&(mutex->holder->mutex_queue), &(mutex->mutex_queue));
+   }
+#endif
+
    if (mutex->protocol == TN_MUTEX_PROT_INHERIT){
       //-- Priority inheritance protocol
 
@@ -539,8 +674,19 @@ static void _mutex_do_unlock(struct TN_Mutex * mutex)
    //   if mutex is unlocked because task is being deleted.
    mutex->cnt = 0;
 
-   //-- Delete curr mutex from task's locked mutexes queue
+   //-- Delete curr mutex from task's locked mutexes queue, and reset the
+   //   item: the lock-free fast path checks whether it is empty.
+   //   (if mutex was locked by the fast path, the item is already empty,
+   //   and removing it is harmless)
    _tn_list_remove_entry(&(mutex->mutex_queue));
+   _tn_list_reset(&(mutex->mutex_queue));
+
+#if _TN_MUTEX_FAST_PATH
+   //-- if mutex was locked by the fast path, holder doesn't hold it anymore
+   if (mutex->holder->mutex_fast == mutex){
+      mutex->holder->mutex_fast = TN_NULL;
+   }
+#endif
 
    //-- update priority for current holder
    _update_task_priority(mutex->holder);
@@ -691,6 +837,7 @@ enum TN_RCode tn_mutex_create(
       mutex->id_mutex      = TN_ID_MUTEX;
    }
 
+   _TN_TRACE(TN_TRACE_EV_MUTEX_CREATE, mutex, rc);
    return rc;
 }
 
@@ -740,6 +887,7 @@ enum TN_RCode tn_mutex_delete(struct TN_Mutex *mutex)
       _tn_context_switch_pend_if_needed();
    }
 
+   _TN_TRACE(TN_TRACE_EV_MUTEX_DELETE, mutex, rc);
    return rc;
 }
 
@@ -755,6 +903,8 @@ enum TN_RCode tn_mutex_lock(struct TN_Mutex *mutex, TN_TickCnt timeout)
       //-- just return rc as it is
    } else if (!tn_is_task_context()){
       rc = TN_RC_WCONTEXT;
+   } else if (_mutex_fast_lock(mutex)){
+      //-- mutex is locked without disabling interrupts, we're done
    } else {
       TN_INTSAVE_DATA;
 
@@ -818,6 +968,7 @@ enum TN_RCode tn_mutex_lock(struct TN_Mutex *mutex, TN_TickCnt timeout)
       }
    }
 
+   _TN_TRACE(TN_TRACE_EV_MUTEX_LOCK, mutex, rc);
    return rc;
 }
 
@@ -841,6 +992,8 @@ enum TN_RCode tn_mutex_unlock(struct TN_Mutex *mutex)
       //-- just return rc as it is
    } else if (!tn_is_task_context()){
       rc = TN_RC_WCONTEXT;
+   } else if (_mutex_fast_unlock(mutex)){
+      //-- mutex is unlocked without disabling interrupts, we're done
    } else {
       TN_INTSAVE_DATA;
 
@@ -873,6 +1026,7 @@ enum TN_RCode tn_mutex_unlock(struct TN_Mutex *mutex)
       _tn_context_switch_pend_if_needed();
    }
 
+   _TN_TRACE(TN_TRACE_EV_MUTEX_UNLOCK, mutex, rc);
    return rc;
 
 }
@@ -903,6 +1057,18 @@ void _tn_mutex_unlock_all_by_task(struct TN_Task *task)
       //   inside _mutex_do_unlock().
       _mutex_do_unlock(mutex);
    }
+
+#if _TN_MUTEX_FAST_PATH
+   //-- Mutex locked by the lock-free fast path (if nobody has waited for
+   //   it) isn't included in the task's `mutex_queue`: it is remembered as
+   //   `mutex_fast`. The task might be terminated in the middle of the fast
+   //   path, so check that the mutex is actually held by the task.
+   mutex = task->mutex_fast;
+   if (mutex != TN_NULL && mutex->holder == task){
+      _mutex_do_unlock(mutex);
+   }
+   task->mutex_fast = TN_NULL;
+#endif
 }
 
 
@@ -67,7 +67,9 @@
  *    - Recursive locking is supported (if option `#TN_MUTEX_REC` is non-zero);
  *    - Deadlock detection (if option `#TN_MUTEX_DEADLOCK_DETECT` is non-zero);
  *    - Two protocols available to avoid unbounded priority inversion: priority
- *      inheritance and priority ceiling.
+ *      inheritance and priority ceiling;
+ *    - On Cortex-M3/M4/M4F, uncontended locking and unlocking of the priority
+ *      inheritance mutex doesn't disable interrupts (see below).
  *
  *
  * A discussion about the strengths and weaknesses of each protocol as
@@ -80,6 +82,15 @@
  * The priority ceiling protocol prevents deadlocks and chained blocking but it
  * is slower than the priority inheritance protocol.
  *
+ * If the architecture provides exclusive access instructions (currently,
+ * `LDREX` / `STREX` on Cortex-M3/M4/M4F), the mutex with priority inheritance
+ * protocol is locked and unlocked without disabling interrupts, as long as
+ * no other task waits for it and it isn't locked recursively. The first task
+ * which has to wait for such a mutex switches it to the usual path, which
+ * handles priority inheritance. The task holds at most one mutex locked this
+ * way at a time: while it holds one, other mutexes are locked by the usual
+ * path.
+ *
  * @see `#TN_USE_MUTEXES`
  */
 
@@ -92,6 +103,7 @@
 
 #include "tn_list.h"
 #include "tn_common.h"
+#include "../arch/tn_arch.h"
 
 
 
@@ -103,6 +115,19 @@ extern "C"  {     /*}*/
  *    PUBLIC TYPES
  ******************************************************************************/
 
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+/*
+ * Internal kernel definition: non-zero if the lock-free fast path of mutexes
+ * is available, i.e. if the architecture provides exclusive access primitives
+ * `_TN_EXCL_LOAD()` and friends.
+ */
+#if defined(_TN_EXCL_LOAD)
+#  define  _TN_MUTEX_FAST_PATH      1
+#else
+#  define  _TN_MUTEX_FAST_PATH      0
+#endif
+#endif
+
 /**
  * Mutex protocol for avoid priority inversion
  */
@@ -46,6 +46,8 @@
 //-- internal tnkernel headers
 #include "_tn_tasks.h"
 #include "_tn_list.h"
+#include "_tn_trace.h"
+#include "_tn_multi_wait.h"
 
 
 //-- header of current module
@@ -56,6 +58,23 @@
 
 
 
+/*******************************************************************************
+ *    DEFINITIONS
+ ******************************************************************************/
+
+//-- Lock-free fast path is available if only the architecture provides
+//   exclusive access primitives, see `_TN_EXCL_LOAD()` and friends, and
+//   `int` is as wide as the word they work with.
+#if defined(_TN_EXCL_LOAD) && !defined(_TN_EXCL_INT_UNSUPPORTED)
+#  define _TN_SEM_FAST_PATH      1
+//-- `count` field of the semaphore as a word, for the exclusive access
+#  define _count_word(sem)       ((volatile TN_UWord *)&((sem)->count))
+#else
+#  define _TN_SEM_FAST_PATH      0
+#endif
+
+
+
 
 /*******************************************************************************
  *    PRIVATE FUNCTIONS
@@ -84,7 +103,8 @@ _TN_STATIC_INLINE enum TN_RCode _check_param_generic(
 _TN_STATIC_INLINE enum TN_RCode _check_param_create(
       const struct TN_Sem *sem,
       int start_count,
-      int max_count
+      int max_count,
+      enum TN_WaitOrder wait_order
       )
 {
    enum TN_RCode rc = TN_RC_OK;
@@ -96,6 +116,8 @@ _TN_STATIC_INLINE enum TN_RCode _check_param_create(
          || max_count <= 0
          || start_count < 0
          || start_count > max_count
+         || (     wait_order != TN_WAIT_ORDER_FIFO
+               && wait_order != TN_WAIT_ORDER_PRIORITY)
          )
    {
       rc = TN_RC_WPARAM;
@@ -106,20 +128,114 @@ _TN_STATIC_INLINE enum TN_RCode _check_param_create(
 
 #else
 #  define _check_param_generic(sem)                            (TN_RC_OK)
-#  define _check_param_create(sem, start_count, max_count)     (TN_RC_OK)
+#  define _check_param_create(sem, start_count, max_count, wait_order)   \
+                                                               (TN_RC_OK)
 #endif
 // }}}
 
 
+#if _TN_SEM_FAST_PATH
+/**
+ * Lock-free fast path of signaling: if nobody waits for the semaphore and
+ * its count is less than `max_count`, increment the count without disabling
+ * interrupts.
+ *
+ * Tasks are added to the wait queues with interrupts disabled, and the
+ * processor clears the exclusive monitor on exception entry and exit, so if
+ * some task starts waiting after the load, the store fails, and we try
+ * again.
+ *
+ * @returns `TN_TRUE` if the count is incremented, `TN_FALSE` if the slow path
+ *          should be taken.
+ */
+_TN_STATIC_INLINE TN_BOOL _sem_fast_signal(struct TN_Sem *sem)
+{
+   TN_BOOL ret = TN_FALSE;
+
+   for (;;){
+      int count = (int)_TN_EXCL_LOAD(_count_word(sem));
+
+      if (0
+            || !_tn_list_is_empty(&(sem->wait_queue))
+#if TN_USE_MULTI_WAIT
+            || !_tn_list_is_empty(&(sem->multi_wait_list))
+#endif
+            || count >= sem->max_count
+         )
+      {
+         //-- somebody waits for the semaphore, or it overflows:
+         //   leave it for the slow path
+         _TN_EXCL_CLEAR();
+         break;
+      } else if (_TN_EXCL_STORE(_count_word(sem), (TN_UWord)(count + 1))){
+         ret = TN_TRUE;
+         break;
+      } else {
+         //-- some exception has happened after the load: try again
+      }
+   }
+
+   return ret;
+}
+
+/**
+ * Lock-free fast path of waiting: if the count is non-zero, decrement it
+ * without disabling interrupts.
+ *
+ * @returns `TN_TRUE` if the count is decremented, `TN_FALSE` if the slow path
+ *          should be taken.
+ */
+_TN_STATIC_INLINE TN_BOOL _sem_fast_wait(struct TN_Sem *sem)
+{
+   TN_BOOL ret = TN_FALSE;
+
+   for (;;){
+      int count = (int)_TN_EXCL_LOAD(_count_word(sem));
+
+      if (count <= 0){
+         //-- semaphore isn't available: leave it for the slow path
+         _TN_EXCL_CLEAR();
+         break;
+      } else if (_TN_EXCL_STORE(_count_word(sem), (TN_UWord)(count - 1))){
+         ret = TN_TRUE;
+         break;
+      } else {
+         //-- some exception has happened after the load: try again
+      }
+   }
+
+   return ret;
+}
+
+#else
+
+_TN_STATIC_INLINE TN_BOOL _sem_fast_signal(struct TN_Sem *sem)
+{
+   _TN_UNUSED(sem);
+   return TN_FALSE;
+}
+
+_TN_STATIC_INLINE TN_BOOL _sem_fast_wait(struct TN_Sem *sem)
+{
+   _TN_UNUSED(sem);
+   return TN_FALSE;
+}
+
+#endif
+
 /**
  * Generic function that performs job from task context
  *
- * @param sem        semaphore to perform job on
- * @param p_worker   pointer to actual worker function
- * @param timeout    see `#TN_TickCnt`
+ * @param sem           semaphore to perform job on
+ * @param p_fast_worker pointer to lock-free fast path function: if it
+ *                      returns `TN_TRUE`, the job is done without disabling
+ *                      interrupts
+ * @param p_worker      pointer to actual worker function
+ * @param timeout       see `#TN_TickCnt`
  */
 _TN_STATIC_INLINE enum TN_RCode _sem_job_perform(
       struct TN_Sem *sem,
+      TN_BOOL (p_fast_worker)(struct TN_Sem *sem),
       enum TN_RCode (p_worker)(struct TN_Sem *sem),
       TN_TickCnt timeout
       )
@@ -131,6 +247,8 @@ _TN_STATIC_INLINE enum TN_RCode _sem_job_perform(
       //-- just return rc as it is
    } else if (!tn_is_task_context()){
       rc = TN_RC_WCONTEXT;
+   } else if (p_fast_worker(sem)){
+      //-- job is done without disabling interrupts, rc is TN_RC_OK
    } else {
       TN_INTSAVE_DATA;
 
@@ -168,11 +286,14 @@ _TN_STATIC_INLINE enum TN_RCode _sem_job_perform(
 /**
  * Generic function that performs job from interrupt context
  *
- * @param sem        semaphore to perform job on
- * @param p_worker   pointer to actual worker function
+ * @param sem           semaphore to perform job on
+ * @param p_fast_worker pointer to lock-free fast path function, see
+ *                      `_sem_job_perform()`
+ * @param p_worker      pointer to actual worker function
  */
 _TN_STATIC_INLINE enum TN_RCode _sem_job_iperform(
       struct TN_Sem *sem,
+      TN_BOOL (p_fast_worker)(struct TN_Sem *sem),
       enum TN_RCode (p_worker)(struct TN_Sem *sem)
       )
 {
@@ -183,6 +304,8 @@ _TN_STATIC_INLINE enum TN_RCode _sem_job_iperform(
       //-- just return rc as it is
    } else if (!tn_is_isr_context()){
       rc = TN_RC_WCONTEXT;
+   } else if (p_fast_worker(sem)){
+      //-- job is done without disabling interrupts, rc is TN_RC_OK
    } else {
       TN_INTSAVE_DATA_INT;
 
@@ -198,11 +321,16 @@ _TN_STATIC_INLINE enum TN_RCode _sem_signal(struct TN_Sem *sem)
 {
    enum TN_RCode rc = TN_RC_OK;
 
-   //-- wake up first (if any) task from the semaphore wait queue
-   if (  !_tn_task_first_wait_complete(
-            &sem->wait_queue, TN_RC_OK,
+   //-- wake up first (if any) task from the semaphore wait queue;
+   //   if there are no such tasks, then give the signal to the first (if any)
+   //   task waiting for the semaphore by `tn_multi_wait()`
+   if (  !_tn_task_ordered_wait_complete(
+            &sem->wait_queue, sem->wait_order, TN_RC_OK,
             TN_NULL, TN_NULL, TN_NULL
             )
+#if TN_USE_MULTI_WAIT
+         && !_tn_multi_wait_first_complete(&sem->multi_wait_list, TN_NULL)
+#endif
       )
    {
       //-- no tasks are waiting for that semaphore,
@@ -244,26 +372,34 @@ _TN_STATIC_INLINE enum TN_RCode _sem_wait(struct TN_Sem *sem)
 /*
  * See comments in the header file (tn_sem.h)
  */
-enum TN_RCode tn_sem_create(
-      struct TN_Sem *sem,
-      int start_count,
-      int max_count
+enum TN_RCode tn_sem_create_wattr(
+      struct TN_Sem       *sem,
+      int                  start_count,
+      int                  max_count,
+      enum TN_WaitOrder    wait_order
       )
 {
    //-- perform additional params checking (if enabled by TN_CHECK_PARAM)
-   enum TN_RCode rc = _check_param_create(sem, start_count, max_count);
+   enum TN_RCode rc = _check_param_create(
+         sem, start_count, max_count, wait_order
+         );
 
    if (rc != TN_RC_OK){
       //-- just return rc as it is
    } else {
 
       _tn_list_reset(&(sem->wait_queue));
+#if TN_USE_MULTI_WAIT
+      _tn_list_reset(&(sem->multi_wait_list));
+#endif
 
-      sem->count     = start_count;
-      sem->max_count = max_count;
-      sem->id_sem    = TN_ID_SEMAPHORE;
+      sem->count        = start_count;
+      sem->max_count    = max_count;
+      sem->wait_order   = wait_order;
+      sem->id_sem       = TN_ID_SEMAPHORE;
 
    }
+   _TN_TRACE(TN_TRACE_EV_SEM_CREATE, sem, rc);
    return rc;
 }
 
@@ -286,6 +422,9 @@ enum TN_RCode tn_sem_delete(struct TN_Sem * sem)
 
       //-- Remove all tasks from wait queue, returning the TN_RC_DELETED code.
       _tn_wait_queue_notify_deleted(&(sem->wait_queue));
+#if TN_USE_MULTI_WAIT
+      _tn_multi_wait_notify_deleted(&(sem->multi_wait_list));
+#endif
 
       sem->id_sem = TN_ID_NONE;        //-- Semaphore does not exist now
       TN_INT_RESTORE();
@@ -294,6 +433,7 @@ enum TN_RCode tn_sem_delete(struct TN_Sem * sem)
       //   has woken up some high-priority task
       _tn_context_switch_pend_if_needed();
    }
+   _TN_TRACE(TN_TRACE_EV_SEM_DELETE, sem, rc);
    return rc;
 }
 
@@ -302,7 +442,10 @@ enum TN_RCode tn_sem_delete(struct TN_Sem * sem)
  */
 enum TN_RCode tn_sem_signal(struct TN_Sem *sem)
 {
-   return _sem_job_perform(sem, _sem_signal, 0);
+   enum TN_RCode rc = _sem_job_perform(sem, _sem_fast_signal, _sem_signal, 0);
+
+   _TN_TRACE(TN_TRACE_EV_SEM_SIGNAL, sem, rc);
+   return rc;
 }
 
 /*
@@ -310,7 +453,10 @@ enum TN_RCode tn_sem_signal(struct TN_Sem *sem)
  */
 enum TN_RCode tn_sem_isignal(struct TN_Sem *sem)
 {
-   return _sem_job_iperform(sem, _sem_signal);
+   enum TN_RCode rc = _sem_job_iperform(sem, _sem_fast_signal, _sem_signal);
+
+   _TN_TRACE(TN_TRACE_EV_SEM_SIGNAL, sem, rc);
+   return rc;
 }
 
 /*
@@ -318,7 +464,10 @@ enum TN_RCode tn_sem_isignal(struct TN_Sem *sem)
  */
 enum TN_RCode tn_sem_wait(struct TN_Sem *sem, TN_TickCnt timeout)
 {
-   return _sem_job_perform(sem, _sem_wait, timeout);
+   enum TN_RCode rc = _sem_job_perform(sem, _sem_fast_wait, _sem_wait, timeout);
+
+   _TN_TRACE(TN_TRACE_EV_SEM_WAIT, sem, rc);
+   return rc;
 }
 
 /*
@@ -326,7 +475,10 @@ enum TN_RCode tn_sem_wait(struct TN_Sem *sem, TN_TickCnt timeout)
  */
 enum TN_RCode tn_sem_wait_polling(struct TN_Sem *sem)
 {
-   return _sem_job_perform(sem, _sem_wait, 0);
+   enum TN_RCode rc = _sem_job_perform(sem, _sem_fast_wait, _sem_wait, 0);
+
+   _TN_TRACE(TN_TRACE_EV_SEM_WAIT, sem, rc);
+   return rc;
 }
 
 /*
@@ -334,7 +486,27 @@ enum TN_RCode tn_sem_wait_polling(struct TN_Sem *sem)
  */
 enum TN_RCode tn_sem_iwait_polling(struct TN_Sem *sem)
 {
-   return _sem_job_iperform(sem, _sem_wait);
+   enum TN_RCode rc = _sem_job_iperform(sem, _sem_fast_wait, _sem_wait);
+
+   _TN_TRACE(TN_TRACE_EV_SEM_WAIT, sem, rc);
+   return rc;
+}
+
+
+
+/*******************************************************************************
+ *    PROTECTED FUNCTIONS
+ ******************************************************************************/
+
+/**
+ * See comments in the file _tn_sem.h
+ */
+enum TN_RCode _tn_sem_wait(struct TN_Sem *sem)
+{
+   //-- interrupts should be disabled here
+   _TN_BUG_ON( !TN_IS_INT_DISABLED() );
+
+   return _sem_wait(sem);
 }
 
 
@@ -60,6 +60,12 @@
  * In addition to the article mentioned above, you may want to look at the
  * [related question on stackoverflow.com](http://goo.gl/ZBReHK).
  *
+ * If the architecture provides exclusive access instructions (currently,
+ * `LDREX` / `STREX` on Cortex-M3/M4/M4F), the semaphore count is changed
+ * without disabling interrupts when nobody waits for the semaphore: that is,
+ * when `tn_sem_signal()` / `tn_sem_isignal()` is called with empty wait
+ * queue, or when the semaphore is waited for while its count is non-zero.
+ *
  */
 
 #ifndef _TN_SEM_H
@@ -71,6 +77,7 @@
 
 #include "tn_list.h"
 #include "tn_common.h"
+#include "tn_sys.h"
 
 
 
@@ -94,12 +101,21 @@ struct TN_Sem {
    ///
    /// List of tasks that wait for the semaphore
    struct TN_ListItem wait_queue;
+#if TN_USE_MULTI_WAIT || defined(DOXYGEN_ACTIVE)
+   ///
+   /// List of items of tasks that wait for the semaphore by
+   /// `tn_multi_wait()`, available if only `#TN_USE_MULTI_WAIT` is non-zero.
+   struct TN_ListItem multi_wait_list;
+#endif
    ///
    /// Current semaphore counter value
    int count;
    ///
    /// Max value of `count`
    int max_count;
+   ///
+   /// Order in which waiting tasks are served, see `tn_sem_create_wattr()`
+   enum TN_WaitOrder wait_order;
 };
 
 
@@ -115,10 +131,33 @@ struct TN_Sem {
  *    PUBLIC FUNCTION PROTOTYPES
  ******************************************************************************/
 
+/**
+ * The same as `tn_sem_create()`, but takes additional argument:
+ * `wait_order`. If it is `#TN_WAIT_ORDER_PRIORITY`, then the task with the
+ * highest priority is served first, no matter when it has started waiting.
+ *
+ * @param sem
+ *    Pointer to already allocated `struct TN_Sem`
+ * @param start_count
+ *    Initial counter value, typically it is equal to `max_count`
+ * @param max_count
+ *    Maximum counter value.
+ * @param wait_order
+ *    Order in which waiting tasks are served, see `enum #TN_WaitOrder`
+ */
+enum TN_RCode tn_sem_create_wattr(
+      struct TN_Sem       *sem,
+      int                  start_count,
+      int                  max_count,
+      enum TN_WaitOrder    wait_order
+      );
+
 /**
  * Construct the semaphore. `id_sem` field should not contain
  * `#TN_ID_SEMAPHORE`, otherwise, `#TN_RC_WPARAM` is returned.
  *
+ * Waiting tasks are served in FIFO order, see `tn_sem_create_wattr()`.
+ *
  * $(TN_CALL_FROM_TASK)
  * $(TN_CALL_FROM_ISR)
  * $(TN_LEGEND_LINK)
@@ -135,11 +174,16 @@ struct TN_Sem {
  *    * If `#TN_CHECK_PARAM` is non-zero, additional return code
  *      is available: `#TN_RC_WPARAM`.
  */
-enum TN_RCode tn_sem_create(
+_TN_STATIC_INLINE enum TN_RCode tn_sem_create(
       struct TN_Sem *sem,
       int start_count,
       int max_count
-      );
+      )
+{
+   return tn_sem_create_wattr(
+         sem, start_count, max_count, TN_WAIT_ORDER_FIFO
+         );
+}
 
 /**
  * Destruct the semaphore.
@@ -54,6 +54,7 @@
 #include "_tn_timer.h"
 #include "_tn_tasks.h"
 #include "_tn_list.h"
+#include "_tn_trace.h"
 
 
 #include "tn_tasks.h"
@@ -69,9 +70,10 @@
 #  error TN_PRIORITIES_MAX_CNT is not defined
 #endif
 
-//-- check TN_PRIORITIES_CNT
-#if (TN_PRIORITIES_CNT > TN_PRIORITIES_MAX_CNT)
-#  error TN_PRIORITIES_CNT is too large (maximum is TN_PRIORITIES_MAX_CNT)
+//-- check TN_PRIORITIES_CNT: if it is larger than TN_PRIORITIES_MAX_CNT,
+//   two-level bitmap is used, with at most TN_INT_WIDTH groups.
+#if (TN_PRIORITIES_CNT > (TN_PRIORITIES_MAX_CNT * TN_INT_WIDTH))
+#  error TN_PRIORITIES_CNT is too large (maximum is TN_PRIORITIES_MAX_CNT * TN_INT_WIDTH)
 #endif
 
 
@@ -103,7 +105,12 @@ struct TN_Task *_tn_next_task_to_run;
 struct TN_Task *_tn_curr_run_task;
 
 // See comments in the internal/_tn_sys.h file
+#if !_TN_READY_TO_RUN_BMP_2LEVEL
 volatile unsigned int _tn_ready_to_run_bmp;
+#else
+volatile unsigned int _tn_ready_to_run_grp_bmp;
+volatile unsigned int _tn_ready_to_run_bmp[ _TN_READY_TO_RUN_GROUPS_CNT ];
+#endif
 
 // See comments in the internal/_tn_sys.h file
 struct TN_Task _tn_idle_task;
@@ -139,6 +146,64 @@ TN_CBDeadlock *_tn_cb_deadlock = TN_NULL;
 /// Time slice values for each available priority, in system ticks.
 unsigned short _tn_tslice_ticks[TN_PRIORITIES_CNT];
 
+#if TN_PROFILER
+/// User-provided callback function that returns high-resolution timestamp
+/// for the profiler (see `tn_callback_profiler_timestamp_set()`). If it is
+/// `TN_NULL`, system tick count is used.
+TN_CBProfilerTimestamp *_tn_cb_profiler_timestamp = TN_NULL;
+
+/// Last raw value of the profiler timestamp (as returned by
+/// `_tn_cb_profiler_timestamp()`, or the system tick count), needed to
+/// extend it to `_tn_profiler_timestamp`.
+unsigned long _tn_profiler_timestamp_last = 0;
+
+/// Profiler timestamp extended to 64 bits, see
+/// `_tn_sys_profiler_timestamp_get()`
+unsigned long long _tn_profiler_timestamp = 0;
+
+#if TN_DYNAMIC_TICK
+/// In dynamic tick mode, there is no periodic tick interrupt which samples
+/// the profiler timestamp, so this timer does it every
+/// `_tn_profiler_sample_period` ticks (if only the timestamp callback is set,
+/// see `tn_callback_profiler_timestamp_set()`)
+struct TN_Timer _tn_profiler_sample_timer;
+
+/// Period of `_tn_profiler_sample_timer`, in system ticks
+TN_TickCnt _tn_profiler_sample_period = 0;
+#endif
+#endif
+
+#if TN_CRIT_SECT_MEASURE
+/// User-provided callback function that returns high-resolution timestamp
+/// for measuring critical sections (see
+/// `tn_callback_crit_sect_timestamp_set()`). If it is `TN_NULL`, nothing is
+/// measured.
+TN_CBCritSectTimestamp *_tn_cb_crit_sect_timestamp = TN_NULL;
+
+/// Statistics returned by `tn_sys_crit_sect_stat_get()`
+struct TN_CritSectStat _tn_crit_sect_stat;
+
+/// Critical section which is being measured at the moment: timestamp and
+/// place where it was entered, and its nesting depth (if it is 0, nothing
+/// is measured at the moment)
+unsigned long _tn_crit_sect_start_time;
+const char *_tn_crit_sect_start_file;
+int _tn_crit_sect_start_line;
+int _tn_crit_sect_depth = 0;
+#endif
+
+#if TN_DYNAMIC_TICK
+/// Timer which fires when time slice of the task `_tn_tslice_task` is over.
+/// It is active if only there are more than one runnable task with the
+/// priority of `_tn_next_task_to_run`, and round-robin is enabled for this
+/// priority (see `_tn_sys_tslice_manage()`)
+struct TN_Timer _tn_tslice_timer;
+
+/// Task whose time slice is measured by `_tn_tslice_timer` at the moment
+/// (or `TN_NULL`, if the timer isn't active)
+struct TN_Task *_tn_tslice_task = TN_NULL;
+#endif
+
 #if TN_MUTEX_DEADLOCK_DETECT
 /// Number of deadlocks active at the moment. Normally it is equal to 0.
 int _tn_deadlocks_cnt = 0;
@@ -183,9 +248,46 @@ static void _idle_task_body(void *par)
 #if TN_DYNAMIC_TICK
 
 _TN_STATIC_INLINE void _round_robin_manage(void) {
-   /*TODO: round-robin should be powered by timers mechanism.
-    * So, when round-robin is active, the system isn't so "tickless".
-    */
+   //-- In dynamic tick mode, round-robin is powered by the timer 
+   //   `_tn_tslice_timer`, so nothing to do here.
+   //   See `_tn_sys_tslice_manage()`.
+}
+
+/**
+ * Callback of the timer `_tn_tslice_timer`: it is called when time slice of
+ * the task `_tn_tslice_task` is over.
+ */
+static void _tslice_timer_func(struct TN_Timer *timer, void *p_user_data)
+{
+   TN_INTSAVE_DATA_INT;
+
+   TN_INT_IDIS_SAVE();
+
+   //-- Manage round robin if only the task whose time slice is over is 
+   //   still the next task to run (if it isn't, then time slice timer is 
+   //   already restarted for another task, and we shouldn't get here)
+   if (_tn_tslice_task == _tn_next_task_to_run){
+      int priority = _tn_tslice_task->priority;
+      struct TN_ListItem *pri_queue = &(_tn_tasks_ready_list[priority]);
+
+      //-- If there are more than 1 task in the queue, remove task from
+      //   head and add it to the tail of ready queue for current priority
+      if (pri_queue->next->next != pri_queue){
+         _tn_list_add_tail(pri_queue, _tn_list_remove_head(pri_queue));
+
+         _tn_next_task_to_run = _tn_get_task_by_tsk_queue(pri_queue->next);
+      }
+   }
+
+   //-- timer is inactive at the moment, so, this call will start it again
+   //   for the new next task to run (if needed)
+   _tn_sys_tslice_manage();
+
+   TN_INT_IRESTORE();
+   _TN_CONTEXT_SWITCH_IPEND_IF_NEEDED();
+
+   _TN_UNUSED(timer);
+   _TN_UNUSED(p_user_data);
 }
 
 #else
@@ -232,8 +334,64 @@ _TN_STATIC_INLINE void _round_robin_manage(void)
 #endif
 
 
+#if TN_PROFILER && TN_DYNAMIC_TICK
+/**
+ * Callback of the timer `_tn_profiler_sample_timer`: sample the profiler
+ * timestamp, so that its wraparound isn't missed even if there are no
+ * context switches for a long time, and restart the timer.
+ */
+static void _profiler_sample_timer_func(
+      struct TN_Timer *timer,
+      void *p_user_data
+      )
+{
+   TN_INTSAVE_DATA_INT;
+
+   TN_INT_IDIS_SAVE();
+
+   _tn_sys_profiler_timestamp_get();
+   _tn_timer_start(timer, _tn_profiler_sample_period);
+
+   TN_INT_IRESTORE();
+
+   _TN_UNUSED(p_user_data);
+}
+
+/**
+ * Create the timer `_tn_profiler_sample_timer`, and start it if the
+ * profiler timestamp callback is set.
+ */
+static void _profiler_sample_timer_init(void)
+{
+   TN_INTSAVE_DATA;
+
+   _tn_timer_create(
+         &_tn_profiler_sample_timer, _profiler_sample_timer_func, TN_NULL
+         );
+
+   if (_tn_cb_profiler_timestamp != TN_NULL){
+      TN_INT_DIS_SAVE();
+      _tn_timer_start(&_tn_profiler_sample_timer, _tn_profiler_sample_period);
+      TN_INT_RESTORE();
+   }
+}
+#else
+#  define _profiler_sample_timer_init()   /* nothing */
+#endif
+
+
 #if _TN_ON_CONTEXT_SWITCH_HANDLER
 #if TN_PROFILER
+/**
+ * Convert profiler time to the type of `max_consecutive_...` fields of
+ * `struct #TN_TaskTiming`: if the value doesn't fit, maximum value is
+ * returned.
+ */
+_TN_STATIC_INLINE unsigned long _profiler_time_clamp(unsigned long long time)
+{
+   return (time > (unsigned long)-1) ? (unsigned long)-1 : (unsigned long)time;
+}
+
 /**
  * This function is called at every context switch, if `#TN_PROFILER` is 
  * non-zero.
@@ -251,7 +409,7 @@ _TN_STATIC_INLINE void _tn_sys_on_context_switch_profiler(
    //-- interrupts should be disabled here
    _TN_BUG_ON(!TN_IS_INT_DISABLED());
 
-   TN_TickCnt cur_tick_cnt = _tn_timer_sys_time_get();
+   unsigned long long cur_timestamp = _tn_sys_profiler_timestamp_get();
 
    //-- handle task_prev (the one that was running and going to wait) {{{
    {
@@ -264,19 +422,20 @@ _TN_STATIC_INLINE void _tn_sys_on_context_switch_profiler(
 
       //-- get difference between current time and last saved time:
       //   this is the time task was running.
-      TN_TickCnt cur_run_time
-         = (TN_TickCnt)(cur_tick_cnt - task_prev->profiler.last_tick_cnt);
+      unsigned long long cur_run_time
+         = cur_timestamp - task_prev->profiler.last_timestamp;
 
       //-- add it to total run time
       task_prev->profiler.timing.total_run_time += cur_run_time;
 
       //-- check if we should update consecutive max run time
       if (task_prev->profiler.timing.max_consecutive_run_time < cur_run_time){
-         task_prev->profiler.timing.max_consecutive_run_time = cur_run_time;
+         task_prev->profiler.timing.max_consecutive_run_time
+            = _profiler_time_clamp(cur_run_time);
       }
 
       //-- update current task state
-      task_prev->profiler.last_tick_cnt      = cur_tick_cnt;
+      task_prev->profiler.last_timestamp     = cur_timestamp;
 #if TN_PROFILER_WAIT_TIME
       task_prev->profiler.last_wait_reason   = task_prev->task_wait_reason;
 #endif
@@ -295,8 +454,8 @@ _TN_STATIC_INLINE void _tn_sys_on_context_switch_profiler(
 #if TN_PROFILER_WAIT_TIME
       //-- get difference between current time and last saved time:
       //   this is the time task was waiting.
-      TN_TickCnt cur_wait_time
-         = (TN_TickCnt)(cur_tick_cnt - task_new->profiler.last_tick_cnt);
+      unsigned long long cur_wait_time
+         = cur_timestamp - task_new->profiler.last_timestamp;
 
       //-- add it to total total_wait_time for particular wait reason
       task_new->profiler.timing.total_wait_time
@@ -310,7 +469,8 @@ _TN_STATIC_INLINE void _tn_sys_on_context_switch_profiler(
          )
       {
          task_new->profiler.timing.max_consecutive_wait_time
-            [ task_new->profiler.last_wait_reason ] = cur_wait_time;
+            [ task_new->profiler.last_wait_reason ]
+            = _profiler_time_clamp(cur_wait_time);
       }
 #endif
 
@@ -318,7 +478,7 @@ _TN_STATIC_INLINE void _tn_sys_on_context_switch_profiler(
       task_new->profiler.timing.got_running_cnt++;
 
       //-- update current task state
-      task_new->profiler.last_tick_cnt      = cur_tick_cnt;
+      task_new->profiler.last_timestamp     = cur_timestamp;
    }
    // }}}
 }
@@ -482,6 +642,34 @@ static void _build_cfg_check(void)
       _TN_FATAL_ERROR("TN_OLD_EVENT_API doesn't match");
    }
 
+   if (kernel_build_cfg.timer_wheel != app_build_cfg->timer_wheel){
+      _TN_FATAL_ERROR("TN_TIMER_WHEEL doesn't match");
+   }
+
+   if (kernel_build_cfg.timer_wheel_levels != app_build_cfg->timer_wheel_levels){
+      _TN_FATAL_ERROR("TN_TIMER_WHEEL_LEVELS doesn't match");
+   }
+
+   if (kernel_build_cfg.use_exch != app_build_cfg->use_exch){
+      _TN_FATAL_ERROR("TN_USE_EXCH doesn't match");
+   }
+
+   if (kernel_build_cfg.use_multi_wait != app_build_cfg->use_multi_wait){
+      _TN_FATAL_ERROR("TN_USE_MULTI_WAIT doesn't match");
+   }
+
+   if (kernel_build_cfg.trace != app_build_cfg->trace){
+      _TN_FATAL_ERROR("TN_TRACE doesn't match");
+   }
+
+   if (kernel_build_cfg.crit_sect_measure != app_build_cfg->crit_sect_measure){
+      _TN_FATAL_ERROR("TN_CRIT_SECT_MEASURE doesn't match");
+   }
+
+   if (kernel_build_cfg.timer_task != app_build_cfg->timer_task){
+      _TN_FATAL_ERROR("TN_TIMER_TASK doesn't match");
+   }
+
 #if defined (__TN_ARCH_PIC24_DSPIC__)
    if (kernel_build_cfg.arch.p24.p24_sys_ipl != app_build_cfg->arch.p24.p24_sys_ipl){
       _TN_FATAL_ERROR("TN_P24_SYS_IPL doesn't match");
@@ -527,6 +715,19 @@ void tn_sys_start(
 
    //-- init timers
    _tn_timers_init();
+#if TN_TIMER_TASK
+   _tn_timer_task_init();
+#endif
+
+#if TN_DYNAMIC_TICK
+   //-- create timer for round-robin
+   _tn_timer_create(&_tn_tslice_timer, _tslice_timer_func, TN_NULL);
+   _tn_tslice_task = TN_NULL;
+#endif
+
+   //-- in dynamic tick mode, start timer which samples profiler timestamp
+   //   (if needed)
+   _profiler_sample_timer_init();
 
    //-- check that build configuration for the kernel and application match
    //   (if only TN_CHECK_BUILD_CFG is non-zero)
@@ -548,7 +749,14 @@ void tn_sys_start(
    _tn_sys_state = (enum TN_StateFlag)(0);  
 
    //-- reset bitmask of priorities with runnable tasks
+#if !_TN_READY_TO_RUN_BMP_2LEVEL
    _tn_ready_to_run_bmp = 0;
+#else
+   _tn_ready_to_run_grp_bmp = 0;
+   for (i = 0; i < _TN_READY_TO_RUN_GROUPS_CNT; i++){
+      _tn_ready_to_run_bmp[i] = 0;
+   }
+#endif
 
    //-- reset pointers to currently running task and next task to run
    _tn_next_task_to_run = TN_NULL;
@@ -627,6 +835,12 @@ void tn_tick_int_processing(void)
    //-- check stack overflow
    _tn_sys_stack_overflow_check(_tn_curr_run_task);
 
+#if TN_PROFILER
+   //-- make sure the wraparound of the profiler timestamp isn't missed
+   //   even if there are no context switches for a long time
+   _tn_sys_profiler_timestamp_get();
+#endif
+
    //-- manage timers
    _tn_timers_tick_proceed(TN_INTSAVE_VAR);
 
@@ -656,6 +870,10 @@ enum TN_RCode tn_sys_tslice_set(int priority, int ticks)
 
       TN_INT_DIS_SAVE();
       _tn_tslice_ticks[priority] = ticks;
+
+      //-- in dynamic tick mode, time slice timer might need to be 
+      //   started or cancelled now
+      _tn_sys_tslice_manage();
       TN_INT_RESTORE();
    }
    return rc;
@@ -700,6 +918,87 @@ void tn_callback_stack_overflow_set(TN_CBStackOverflow *cb)
    _tn_cb_stack_overflow = cb;
 }
 
+#if TN_CRIT_SECT_MEASURE
+/*
+ * See comment in tn_sys.h file
+ */
+void tn_callback_crit_sect_timestamp_set(TN_CBCritSectTimestamp *cb)
+{
+   //-- NOTE: TN_INT_DIS_SAVE() isn't used here and below, since it is
+   //   overridden to measure critical sections, and we don't want to measure
+   //   the code which manages the measurement itself.
+   TN_UWord sr = tn_arch_sr_save_int_dis();
+
+   _tn_cb_crit_sect_timestamp = cb;
+
+   //-- if some critical section was being measured with the previous
+   //   callback, forget it
+   _tn_crit_sect_depth = 0;
+
+   tn_arch_sr_restore(sr);
+}
+
+/*
+ * See comment in tn_sys.h file
+ */
+void tn_sys_crit_sect_stat_get(struct TN_CritSectStat *p_stat)
+{
+   TN_UWord sr = tn_arch_sr_save_int_dis();
+
+   *p_stat = _tn_crit_sect_stat;
+
+   tn_arch_sr_restore(sr);
+}
+
+/*
+ * See comment in tn_sys.h file
+ */
+void tn_sys_crit_sect_stat_reset(void)
+{
+   TN_UWord sr = tn_arch_sr_save_int_dis();
+
+   memset(&_tn_crit_sect_stat, 0x00, sizeof(_tn_crit_sect_stat));
+
+   tn_arch_sr_restore(sr);
+}
+#endif
+
+#if TN_PROFILER
+/*
+ * See comment in tn_sys.h file
+ */
+void tn_callback_profiler_timestamp_set(
+      TN_CBProfilerTimestamp *cb,
+      TN_TickCnt              sample_period
+      )
+{
+   if (_tn_sys_state & TN_STATE_FLAG__SYS_RUNNING){
+      //-- timestamps which are already taken by the profiler would be
+      //   meaningless with the new callback
+      _TN_FATAL_ERROR("profiler timestamp callback should be set before "
+            "tn_sys_start()");
+   }
+
+#if TN_DYNAMIC_TICK
+   if (     cb != TN_NULL
+         && (sample_period == 0 || sample_period == TN_WAIT_INFINITE)
+      )
+   {
+      //-- without periodic sampling, wraparound of the timestamp would be
+      //   missed during long tickless idle
+      _TN_FATAL_ERROR("profiler timestamp sample period should be set in "
+            "dynamic tick mode");
+   }
+
+   _tn_profiler_sample_period = sample_period;
+#else
+   _TN_UNUSED(sample_period);
+#endif
+
+   _tn_cb_profiler_timestamp = cb;
+}
+#endif
+
 /*
  * See comment in tn_sys.h file
  */
@@ -754,6 +1053,94 @@ void tn_callback_dyn_tick_set(
  *    PROTECTED FUNCTIONS
  ******************************************************************************/
 
+#if TN_CRIT_SECT_MEASURE
+/**
+ * See comment in the _tn_sys.h file
+ */
+TN_UWord _tn_crit_sect_enter(const char *file, int line)
+{
+   TN_BOOL was_disabled = TN_IS_INT_DISABLED();
+   TN_UWord sr = tn_arch_sr_save_int_dis();
+
+   if (!was_disabled){
+      //-- interrupts were enabled, so it is the outermost critical section:
+      //   start measuring it (if the callback is set).
+      //   NOTE: if the previous one wasn't finished (it happens if some
+      //   task disabled interrupts and then context was switched to another
+      //   task, as it is done by tn_task_exit()), it is just forgotten.
+      if (_tn_cb_crit_sect_timestamp != TN_NULL){
+         _tn_crit_sect_start_file = file;
+         _tn_crit_sect_start_line = line;
+         _tn_crit_sect_depth      = 1;
+
+         //-- take timestamp as late as possible
+         _tn_crit_sect_start_time = _tn_cb_crit_sect_timestamp();
+      } else {
+         _tn_crit_sect_depth      = 0;
+      }
+   } else if (_tn_crit_sect_depth > 0){
+      //-- nested critical section
+      _tn_crit_sect_depth++;
+   }
+
+   return sr;
+}
+
+/**
+ * See comment in the _tn_sys.h file
+ */
+void _tn_crit_sect_exit(TN_UWord sr, const char *file, int line)
+{
+   if (_tn_crit_sect_depth > 0 && --_tn_crit_sect_depth == 0){
+      //-- the outermost critical section is about to be exited
+      unsigned long time
+         = _tn_cb_crit_sect_timestamp() - _tn_crit_sect_start_time;
+
+      _tn_crit_sect_stat.cnt++;
+
+      if (
+            _tn_crit_sect_stat.enter_file == TN_NULL
+            || _tn_crit_sect_stat.max_time < time
+         )
+      {
+         _tn_crit_sect_stat.max_time   = time;
+         _tn_crit_sect_stat.enter_file = _tn_crit_sect_start_file;
+         _tn_crit_sect_stat.enter_line = _tn_crit_sect_start_line;
+         _tn_crit_sect_stat.exit_file  = file;
+         _tn_crit_sect_stat.exit_line  = line;
+      }
+   }
+
+   tn_arch_sr_restore(sr);
+}
+#endif
+
+#if TN_PROFILER
+/**
+ * See comment in the _tn_sys.h file
+ */
+unsigned long long _tn_sys_profiler_timestamp_get(void)
+{
+   unsigned long cur;
+
+   //-- interrupts should be disabled here
+   _TN_BUG_ON(!TN_IS_INT_DISABLED());
+
+   if (_tn_cb_profiler_timestamp != TN_NULL){
+      cur = _tn_cb_profiler_timestamp();
+   } else {
+      cur = (unsigned long)_tn_timer_sys_time_get();
+   }
+
+   //-- raw value is allowed to wrap around: add the elapsed time (which is
+   //   correct as long as the raw value doesn't wrap twice between calls)
+   _tn_profiler_timestamp += (unsigned long)(cur - _tn_profiler_timestamp_last);
+   _tn_profiler_timestamp_last = cur;
+
+   return _tn_profiler_timestamp;
+}
+#endif
+
 /**
  * See comment in the _tn_sys.h file
  */
@@ -846,6 +1233,40 @@ void _tn_sys_on_context_switch(
 {
    _tn_sys_stack_overflow_check(task_prev);
    _tn_sys_on_context_switch_profiler(task_prev, task_new);
+
+   _TN_TRACE(TN_TRACE_EV_CONTEXT_SWITCH, task_new, 0);
+}
+#endif
+
+#if TN_DYNAMIC_TICK
+/*
+ * See comments in the file _tn_sys.h
+ */
+void _tn_sys_tslice_manage(void)
+{
+   struct TN_Task *task = _tn_next_task_to_run;
+   struct TN_ListItem *pri_queue = &(_tn_tasks_ready_list[task->priority]);
+   unsigned short tslice_ticks = _tn_tslice_ticks[task->priority];
+
+   if (     tslice_ticks != TN_NO_TIME_SLICE
+         && pri_queue->next->next != pri_queue
+      )
+   {
+      //-- round-robin is needed: if the timer is not yet started for
+      //   the next task to run, start it now
+      if (     task != _tn_tslice_task
+            || !_tn_timer_is_active(&_tn_tslice_timer)
+         )
+      {
+         _tn_tslice_task = task;
+         _tn_timer_start(&_tn_tslice_timer, tslice_ticks);
+      }
+   } else if (_tn_tslice_task != TN_NULL){
+      //-- round-robin isn't needed anymore, so, cancel the timer in order
+      //   to avoid needless ticks
+      _tn_tslice_task = TN_NULL;
+      _tn_timer_cancel(&_tn_tslice_timer);
+   }
 }
 #endif
 
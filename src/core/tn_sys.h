@@ -133,6 +133,13 @@ struct TN_Mutex;
    (_p_struct)->stack_overflow_check      = TN_STACK_OVERFLOW_CHECK;    \
    (_p_struct)->dynamic_tick              = TN_DYNAMIC_TICK;            \
    (_p_struct)->old_events_api            = TN_OLD_EVENT_API;           \
+   (_p_struct)->timer_wheel               = TN_TIMER_WHEEL;             \
+   (_p_struct)->timer_wheel_levels        = TN_TIMER_WHEEL_LEVELS;      \
+   (_p_struct)->use_exch                  = TN_USE_EXCH;                \
+   (_p_struct)->use_multi_wait            = TN_USE_MULTI_WAIT;          \
+   (_p_struct)->trace                     = TN_TRACE;                   \
+   (_p_struct)->crit_sect_measure         = TN_CRIT_SECT_MEASURE;       \
+   (_p_struct)->timer_task                = TN_TIMER_TASK;              \
                                                                         \
    _TN_BUILD_CFG_ARCH_STRUCT_FILL(_p_struct);                           \
 }
@@ -169,7 +176,7 @@ struct TN_Mutex;
 struct _TN_BuildCfg {
    ///
    /// Value of `#TN_PRIORITIES_CNT`
-   unsigned          priorities_cnt             : 7;
+   unsigned          priorities_cnt             : 11;
    ///
    /// Value of `#TN_CHECK_PARAM`
    unsigned          check_param                : 1;
@@ -209,6 +216,27 @@ struct _TN_BuildCfg {
    /// Value of `#TN_OLD_EVENT_API`
    unsigned          old_events_api             : 1;
    ///
+   /// Value of `#TN_TIMER_WHEEL`
+   unsigned          timer_wheel                : 1;
+   ///
+   /// Value of `#TN_TIMER_WHEEL_LEVELS`
+   unsigned          timer_wheel_levels         : 5;
+   ///
+   /// Value of `#TN_USE_EXCH`
+   unsigned          use_exch                   : 1;
+   ///
+   /// Value of `#TN_USE_MULTI_WAIT`
+   unsigned          use_multi_wait             : 1;
+   ///
+   /// Value of `#TN_TRACE`
+   unsigned          trace                      : 1;
+   ///
+   /// Value of `#TN_CRIT_SECT_MEASURE`
+   unsigned          crit_sect_measure          : 1;
+   ///
+   /// Value of `#TN_TIMER_TASK`
+   unsigned          timer_task                 : 1;
+   ///
    /// Architecture-dependent values
    union {
       ///
@@ -258,6 +286,38 @@ enum TN_Context {
    TN_CONTEXT_ISR,
 };
 
+#if TN_CRIT_SECT_MEASURE || defined(DOXYGEN_ACTIVE)
+/**
+ * Statistics of the kernel critical sections, see
+ * `tn_sys_crit_sect_stat_get()`.
+ *
+ * Available if only `#TN_CRIT_SECT_MEASURE` is non-zero.
+ */
+struct TN_CritSectStat {
+   ///
+   /// Duration of the longest critical section, in the units of the
+   /// timestamp returned by the callback given to
+   /// `tn_callback_crit_sect_timestamp_set()`
+   unsigned long  max_time;
+   ///
+   /// Source file where the longest critical section was entered, or
+   /// `TN_NULL` if nothing is measured yet
+   const char    *enter_file;
+   ///
+   /// Line where the longest critical section was entered
+   int            enter_line;
+   ///
+   /// Source file where the longest critical section was exited
+   const char    *exit_file;
+   ///
+   /// Line where the longest critical section was exited
+   int            exit_line;
+   ///
+   /// How many critical sections were measured
+   unsigned long  cnt;
+};
+#endif
+
 /**
  * User-provided callback function that is called directly from
  * `tn_sys_start()` as a part of system startup routine; it should merely
@@ -353,6 +413,35 @@ typedef void (TN_CBDeadlock)(
       struct TN_Task *task
       );
 
+/**
+ * User-provided callback function that returns current high-resolution
+ * timestamp for the profiler (see `tn_callback_profiler_timestamp_set()`).
+ * Typically it returns the value of some free-running hardware counter, such
+ * as DWT cycle counter `DWT->CYCCNT` on Cortex-M3/M4.
+ *
+ * The value is allowed to wrap around, as long as it wraps at the full
+ * range of `unsigned long` (so, narrower or down-counting timers should be
+ * converted by the callback), and it doesn't wrap twice between consecutive
+ * context switches or system ticks. In \ref time_ticks__dynamic_tick mode,
+ * there are no periodic system ticks, so the kernel samples the timestamp
+ * by the internal timer, see `tn_callback_profiler_timestamp_set()`.
+ * Note: this feature works if only `#TN_PROFILER` is non-zero.
+ */
+typedef unsigned long (TN_CBProfilerTimestamp)(void);
+
+/**
+ * User-provided callback function that returns current high-resolution
+ * timestamp for measuring the kernel critical sections (see
+ * `tn_callback_crit_sect_timestamp_set()`). Typically it returns the value
+ * of some free-running hardware counter, such as DWT cycle counter
+ * `DWT->CYCCNT` on Cortex-M3/M4.
+ *
+ * It is called with interrupts disabled. The value is allowed to wrap
+ * around at the full range of `unsigned long`.
+ * Note: this feature works if only `#TN_CRIT_SECT_MEASURE` is non-zero.
+ */
+typedef unsigned long (TN_CBCritSectTimestamp)(void);
+
 
 
 
@@ -495,6 +584,91 @@ void tn_callback_deadlock_set(TN_CBDeadlock *cb);
  */
 void tn_callback_stack_overflow_set(TN_CBStackOverflow *cb);
 
+#if TN_PROFILER || defined(DOXYGEN_ACTIVE)
+/**
+ * Set callback function that returns high-resolution timestamp for the
+ * profiler. By default, profiler uses system tick count, so if task runs for
+ * less than a tick, it often gets 0 of `total_run_time`. With this callback,
+ * all the times in `struct #TN_TaskTiming` are measured in the units of the
+ * timestamp (say, CPU cycles).
+ *
+ * \attention This function should be called <b>before</b> `tn_sys_start()`,
+ * otherwise, you'll run into run-time error `_TN_FATAL_ERROR()`.
+ *
+ * $(TN_CALL_FROM_MAIN)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param cb
+ *    Pointer to user-provided callback function, see
+ *    `#TN_CBProfilerTimestamp` for the prototype.
+ * @param sample_period
+ *    Used in \ref time_ticks__dynamic_tick mode only (ignored otherwise):
+ *    there is no periodic tick interrupt then, so the kernel samples the
+ *    timestamp by the internal timer every `sample_period` system ticks, in
+ *    order not to miss its wraparound during long idle. It should be less
+ *    than the wraparound period of the counter (say, for 32-bit `CYCCNT` at
+ *    168 MHz, it is about 25 seconds). If `cb` isn't `TN_NULL`, zero or
+ *    `#TN_WAIT_INFINITE` period causes run-time error `_TN_FATAL_ERROR()`
+ *    in dynamic tick mode.
+ *
+ * @see `#TN_PROFILER`
+ * @see `tn_task_profiler_timing_get()`
+ */
+void tn_callback_profiler_timestamp_set(
+      TN_CBProfilerTimestamp *cb,
+      TN_TickCnt              sample_period
+      );
+#endif
+
+#if TN_CRIT_SECT_MEASURE || defined(DOXYGEN_ACTIVE)
+/**
+ * Set callback function that returns high-resolution timestamp for
+ * measuring the kernel critical sections. Until it is set, nothing is
+ * measured; it can be set (or reset to `TN_NULL`, which stops measurement)
+ * at any time.
+ *
+ * Available if only `#TN_CRIT_SECT_MEASURE` is non-zero.
+ *
+ * $(TN_CALL_FROM_MAIN)
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param cb
+ *    Pointer to user-provided callback function, see
+ *    `#TN_CBCritSectTimestamp` for the prototype.
+ */
+void tn_callback_crit_sect_timestamp_set(TN_CBCritSectTimestamp *cb);
+
+/**
+ * Get statistics of the kernel critical sections: duration of the longest
+ * one, and where it was entered and exited. See `struct #TN_CritSectStat`.
+ *
+ * Available if only `#TN_CRIT_SECT_MEASURE` is non-zero.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param p_stat
+ *    Target structure to fill with data, should be allocated by caller
+ */
+void tn_sys_crit_sect_stat_get(struct TN_CritSectStat *p_stat);
+
+/**
+ * Reset statistics of the kernel critical sections, so that measurement
+ * starts over: say, after the system startup is done, since it usually has
+ * long critical sections which aren't interesting.
+ *
+ * Available if only `#TN_CRIT_SECT_MEASURE` is non-zero.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ */
+void tn_sys_crit_sect_stat_reset(void);
+#endif
+
 /**
  * Returns current system state flags
  *
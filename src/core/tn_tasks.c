@@ -45,8 +45,12 @@
 //-- internal tnkernel headers
 #include "_tn_tasks.h"
 #include "_tn_mutex.h"
+#include "_tn_multi_wait.h"
+#include "_tn_heap.h"
+#include "_tn_msgbuf.h"
 #include "_tn_timer.h"
 #include "_tn_list.h"
+#include "_tn_trace.h"
 
 
 //-- header of current module
@@ -60,6 +64,41 @@
 
 
 
+/*******************************************************************************
+ *    DEFINITIONS
+ ******************************************************************************/
+
+#if !defined(_TN_ARCH_STACK_DIR)
+#  error _TN_ARCH_STACK_DIR is not defined
+#endif
+
+//-- Stack usage tracking, see `tn_task_stack_usage_get()`:
+//
+//   - `_STACK_ORIGIN()`: the word at which the stack starts growing;
+//   - `_STACK_STEP`: the step from the end of the stack towards its origin;
+//   - `_STACK_IS_DEEPER()`: whether `p_a` is closer to the end of the stack
+//     than `p_b`;
+//   - `_STACK_USED_CNT()`: number of words from the origin up to `p_word`
+//     inclusive.
+#if (_TN_ARCH_STACK_DIR == _TN_ARCH_STACK_DIR__ASC)
+#  define _STACK_ORIGIN(task)             ((task)->stack_low_addr)
+#  define _STACK_STEP                     (-1)
+#  define _STACK_IS_DEEPER(p_a, p_b)      ((p_a) > (p_b))
+#  define _STACK_USED_CNT(task, p_word)                                   \
+      ((unsigned int)((p_word) - (task)->stack_low_addr) + 1)
+#elif (_TN_ARCH_STACK_DIR == _TN_ARCH_STACK_DIR__DESC)
+#  define _STACK_ORIGIN(task)             ((task)->stack_high_addr)
+#  define _STACK_STEP                     (1)
+#  define _STACK_IS_DEEPER(p_a, p_b)      ((p_a) < (p_b))
+#  define _STACK_USED_CNT(task, p_word)                                   \
+      ((unsigned int)((task)->stack_high_addr - (p_word)) + 1)
+#else
+#  error wrong _TN_ARCH_STACK_DIR
+#endif
+
+
+
+
 /*******************************************************************************
  *    EXTERNAL DATA
  ******************************************************************************/
@@ -92,6 +131,20 @@ _TN_STATIC_INLINE enum TN_RCode _check_param_generic(
 #endif
 // }}}
 
+/**
+ * Returns whether given action for `tn_task_notify()` is valid
+ */
+_TN_STATIC_INLINE TN_BOOL _notify_action_is_valid(
+      enum TN_TaskNotifyAction action
+      )
+{
+   return (0
+         || action == TN_TASK_NOTIFY_ACTION_SET_BITS
+         || action == TN_TASK_NOTIFY_ACTION_INCREMENT
+         || action == TN_TASK_NOTIFY_ACTION_OVERWRITE
+         );
+}
+
 //-- Private utilities {{{
 
 #if TN_USE_MUTEXES
@@ -99,6 +152,9 @@ _TN_STATIC_INLINE enum TN_RCode _check_param_generic(
 _TN_STATIC_INLINE void _init_mutex_queue(struct TN_Task *task)
 {
    _tn_list_reset(&(task->mutex_queue));
+#if _TN_MUTEX_FAST_PATH
+   task->mutex_fast = TN_NULL;
+#endif
 }
 
 #if TN_MUTEX_DEADLOCK_DETECT
@@ -126,7 +182,30 @@ static void _find_next_task_to_run(void)
 {
    int priority;
 
-#ifdef _TN_FFS
+#if _TN_READY_TO_RUN_BMP_2LEVEL
+   //-- two-level bitmask: first, find the highest-priority group with
+   //   runnable tasks, and then, the highest priority inside this group.
+   int group;
+
+#  ifdef _TN_FFS
+   group = _TN_FFS(_tn_ready_to_run_grp_bmp) - 1;
+   priority = group * TN_INT_WIDTH + _TN_FFS(_tn_ready_to_run_bmp[group]) - 1;
+#  else
+   unsigned int bmp;
+
+   group = 0;
+   while (_tn_ready_to_run_bmp[group] == 0){
+      group++;
+   }
+
+   bmp = _tn_ready_to_run_bmp[group];
+   priority = group * TN_INT_WIDTH;
+   while ((bmp & 1) == 0){
+      bmp >>= 1;
+      priority++;
+   }
+#  endif
+#elif defined(_TN_FFS)
    //-- architecture-dependent way to find-first-set-bit is available,
    //   so use it.
    priority = _TN_FFS(_tn_ready_to_run_bmp);
@@ -200,6 +279,118 @@ _TN_STATIC_INLINE enum TN_RCode _task_release_wait(struct TN_Task *task)
    return rc;
 }
 
+/**
+ * If notification is pending for the given task, store notification value
+ * to `p_value` (if it's not `TN_NULL`), clear given bits and pending flag,
+ * and return `#TN_RC_OK`; otherwise, return `#TN_RC_TIMEOUT`.
+ */
+_TN_STATIC_INLINE enum TN_RCode _task_notify_take(
+      struct TN_Task   *task,
+      TN_UWord          clear_bits,
+      TN_UWord         *p_value
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   if (task->notify_pending){
+      if (p_value != TN_NULL){
+         *p_value = task->notify_value;
+      }
+
+      task->notify_value &= ~clear_bits;
+      task->notify_pending = TN_FALSE;
+   } else {
+      rc = TN_RC_TIMEOUT;
+   }
+
+   return rc;
+}
+
+/**
+ * Common part of `tn_task_sleep_until()` and `tn_task_periodic_wait()`: put
+ * current task to sleep until `*p_last_wake + period`, and advance
+ * `*p_last_wake`.
+ *
+ * If that time has already passed, then the behavior depends on
+ * `p_missed_cnt`: if it is `TN_NULL`, `*p_last_wake` is advanced by one
+ * period (as `tn_task_sleep_until()` does); otherwise, it is advanced to the
+ * latest time on the grid of periods which isn't in the future, and the
+ * number of passed periods is stored to `*p_missed_cnt` (as
+ * `tn_task_periodic_wait()` does).
+ *
+ * Current time is taken in the same critical section in which the task is
+ * put to wait, so the relative timeout given to the task's timer is exact.
+ *
+ * `*p_last_wake` is advanced before the task is put to sleep, so if the
+ * sleep is cut short by `tn_task_wakeup()` or `tn_task_release_wait()`,
+ * `*p_last_wake` remains in the future. The next call then sleeps the
+ * remaining time until `*p_last_wake + period`, so the grid is kept.
+ */
+static enum TN_RCode _task_sleep_until(
+      TN_TickCnt *p_last_wake,
+      TN_TickCnt period,
+      unsigned long *p_missed_cnt
+      )
+{
+   enum TN_RCode rc = TN_RC_TIMEOUT;
+   TN_BOOL waited = TN_FALSE;
+   long elapsed_signed;
+   TN_TickCnt elapsed;
+   TN_INTSAVE_DATA;
+
+   TN_INT_DIS_SAVE();
+
+   //-- unsigned arithmetic handles system time overflow; the difference is
+   //   then treated as signed, since `*p_last_wake` may be in the future if
+   //   the previous sleep was cut short (see comment above)
+   elapsed_signed = (long)(_tn_timer_sys_time_get() - *p_last_wake);
+
+   //-- if wake-up time has already passed, the difference is non-negative,
+   //   so it may be used as unsigned in the branches below
+   elapsed = (TN_TickCnt)elapsed_signed;
+
+   if (elapsed_signed < (long)period){
+      //-- wake-up time is in the future: sleep until then
+      _tn_task_curr_to_wait_action(
+            TN_NULL, TN_WAIT_REASON_SLEEP,
+            (TN_TickCnt)((long)period - elapsed_signed)
+            );
+      *p_last_wake += period;
+      waited = TN_TRUE;
+   } else if (p_missed_cnt == TN_NULL){
+      //-- wake-up time is now or in the past: don't sleep, and advance by one
+      //   period only, so that the caller catches up with the next calls
+      if (elapsed > period){
+         rc = TN_RC_OVERFLOW;
+      }
+      *p_last_wake += period;
+   } else {
+      //-- wake-up time is now or in the past: don't sleep, and skip to the
+      //   latest time on the grid. If it is right now, then it isn't missed:
+      //   the caller is just on time.
+      TN_TickCnt periods_cnt = elapsed / period;
+
+      *p_last_wake += periods_cnt * period;
+      *p_missed_cnt = periods_cnt;
+      if (elapsed % period == 0){
+         (*p_missed_cnt)--;
+      }
+
+      if (*p_missed_cnt > 0){
+         rc = TN_RC_OVERFLOW;
+      }
+   }
+
+   TN_INT_RESTORE();
+
+   if (waited){
+      _tn_context_switch_pend_if_needed();
+      rc = _tn_curr_run_task->task_wait_rc;
+   }
+
+   return rc;
+}
+
 _TN_STATIC_INLINE enum TN_RCode _task_delete(struct TN_Task *task)
 {
    enum TN_RCode rc = TN_RC_OK;
@@ -286,7 +477,17 @@ _TN_STATIC_INLINE TN_BOOL _remove_entry_from_ready_queue(
 
    if (ret){
       //-- list is empty, so, modify bitmask _tn_ready_to_run_bmp
+#if !_TN_READY_TO_RUN_BMP_2LEVEL
       _tn_ready_to_run_bmp &= ~(1 << priority);
+#else
+      int group = priority / TN_INT_WIDTH;
+
+      _tn_ready_to_run_bmp[group] &= ~(1u << (priority % TN_INT_WIDTH));
+      if (_tn_ready_to_run_bmp[group] == 0){
+         //-- no more runnable tasks in the group
+         _tn_ready_to_run_grp_bmp &= ~(1u << group);
+      }
+#endif
    }
 
    return ret;
@@ -297,7 +498,13 @@ _TN_STATIC_INLINE void _add_entry_to_ready_queue(
       )
 {
    _tn_list_add_tail(&(_tn_tasks_ready_list[priority]), list_node);
+#if !_TN_READY_TO_RUN_BMP_2LEVEL
    _tn_ready_to_run_bmp |= (1 << priority);
+#else
+   _tn_ready_to_run_bmp[priority / TN_INT_WIDTH] |=
+      (1u << (priority % TN_INT_WIDTH));
+   _tn_ready_to_run_grp_bmp |= (1u << (priority / TN_INT_WIDTH));
+#endif
 }
 
 // }}}
@@ -339,6 +546,23 @@ static void _on_task_wait_complete(struct TN_Task *task)
       _tn_mutex_on_task_wait_complete(task);
    }
 
+   //-- for heap, let other waiting tasks get memory
+   if (task->task_wait_reason == TN_WAIT_REASON_HEAP){
+      _tn_heap_on_task_wait_complete(task);
+   }
+
+   //-- for message buffer, let other senders put their messages
+   if (task->task_wait_reason == TN_WAIT_REASON_MSGBUF_WSEND){
+      _tn_msgbuf_on_task_wait_complete(task);
+   }
+
+#if TN_USE_MULTI_WAIT
+   //-- for multi-object wait, remove task's items from all the objects
+   if (task->task_wait_reason == TN_WAIT_REASON_MULTI){
+      _tn_multi_wait_on_task_wait_complete(task);
+   }
+#endif
+
 }
 
 /**
@@ -357,6 +581,8 @@ static void _task_terminate(struct TN_Task *task)
    }
 #endif
 
+   _TN_TRACE(TN_TRACE_EV_TASK_TERMINATE, task, 0);
+
    //-- Unlock all mutexes locked by the task
    _tn_mutex_unlock_all_by_task(task);
 
@@ -397,6 +623,73 @@ static void _task_wait_timeout(struct TN_Timer *timer, void *p_user_data)
    _TN_UNUSED(timer);
 }
 
+/**
+ * Find the deepest stack word of the task which was ever touched: scan the
+ * stack from its end towards the origin, while words still contain
+ * `#TN_FILL_STACK_VAL`.
+ *
+ * The words between `task->stack_watermark` and the origin are known to be
+ * touched already, so the scan stops at `task->stack_watermark`: that is,
+ * only the untouched part of the stack is scanned.
+ *
+ * Interrupts may be enabled: the scan merely reads the stack. The caller
+ * is responsible for storing the result to `task->stack_watermark`, see
+ * `_stack_watermark_update()`.
+ */
+static TN_UWord *_stack_watermark_find(const struct TN_Task *task)
+{
+   TN_UWord *p_watermark = task->stack_watermark;
+   TN_UWord *p_word = _tn_task_stack_end_get((struct TN_Task *)task);
+
+   while (p_word != p_watermark && *p_word == TN_FILL_STACK_VAL){
+      p_word += _STACK_STEP;
+   }
+
+   return p_word;
+}
+
+/**
+ * Store the new watermark found by `_stack_watermark_find()`, unless some
+ * other caller has already stored the deeper one in the meantime.
+ *
+ * Since the scan is performed with interrupts enabled, the task might be
+ * deleted and created again with another stack in the meantime, so the
+ * watermark is also checked to be inside the current stack.
+ *
+ * Interrupts should be disabled here.
+ */
+_TN_STATIC_INLINE void _stack_watermark_update(
+      struct TN_Task *task,
+      TN_UWord *p_watermark
+      )
+{
+   if (     p_watermark >= task->stack_low_addr
+         && p_watermark <= task->stack_high_addr
+         && _STACK_IS_DEEPER(p_watermark, task->stack_watermark)
+      )
+   {
+      task->stack_watermark = p_watermark;
+   }
+}
+
+/**
+ * Fill the stack usage structure of the task: its watermark should be
+ * up-to-date.
+ */
+_TN_STATIC_INLINE void _stack_usage_fill(
+      struct TN_Task *task,
+      struct TN_TaskStackUsage *p_usage
+      )
+{
+   p_usage->task     = task;
+   p_usage->size     = (unsigned int)
+      (task->stack_high_addr - task->stack_low_addr) + 1;
+   p_usage->used_max = _STACK_USED_CNT(task, task->stack_watermark);
+}
+
+
+
+
 /*******************************************************************************
  *    PUBLIC FUNCTIONS
  ******************************************************************************/
@@ -486,6 +779,9 @@ enum TN_RCode tn_task_create(
       {
          *ptr_stack++ = TN_FILL_STACK_VAL;
       }
+
+      //-- nothing is used yet, except the very first word
+      task->stack_watermark = _STACK_ORIGIN(task);
    }
 
    //-- reset task_queue (the queue used to include task to runqueue or 
@@ -517,6 +813,7 @@ enum TN_RCode tn_task_create(
       }
    }
 
+   _TN_TRACE(TN_TRACE_EV_TASK_CREATE, task, priority);
    return rc;
 }
 
@@ -658,6 +955,80 @@ enum TN_RCode tn_task_sleep(TN_TickCnt timeout)
    return rc;
 }
 
+/*
+ * See comments in the header file (tn_tasks.h)
+ */
+enum TN_RCode tn_task_sleep_until(TN_TickCnt *p_last_wake, TN_TickCnt period)
+{
+   enum TN_RCode rc;
+
+   if (p_last_wake == TN_NULL || period == 0){
+      rc = TN_RC_WPARAM;
+   } else if (!tn_is_task_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      rc = _task_sleep_until(p_last_wake, period, TN_NULL);
+   }
+
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_tasks.h)
+ */
+enum TN_RCode tn_task_periodic_init(
+      struct TN_TaskPeriodic *periodic,
+      TN_TickCnt              period
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   if (periodic == TN_NULL || period == 0){
+      rc = TN_RC_WPARAM;
+   } else {
+      periodic->period        = period;
+      periodic->release_time  = tn_sys_time_get();
+      periodic->overrun_cnt   = 0;
+   }
+
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_tasks.h)
+ */
+enum TN_RCode tn_task_periodic_wait(struct TN_TaskPeriodic *periodic)
+{
+   enum TN_RCode rc;
+
+   if (periodic == TN_NULL || periodic->period == 0){
+      rc = TN_RC_WPARAM;
+   } else if (!tn_is_task_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      unsigned long missed_cnt = 0;
+
+      rc = _task_sleep_until(
+            &(periodic->release_time), periodic->period, &missed_cnt
+            );
+
+      switch (rc){
+         case TN_RC_TIMEOUT:
+            //-- released on time
+            rc = TN_RC_OK;
+            break;
+         case TN_RC_OVERFLOW:
+            periodic->overrun_cnt += missed_cnt;
+            break;
+         default:
+            //-- just return rc as it is
+            break;
+      }
+   }
+
+   return rc;
+}
+
 /*
  * See comments in the header file (tn_tasks.h)
  */
@@ -706,6 +1077,118 @@ enum TN_RCode tn_task_irelease_wait(struct TN_Task *task)
    return _task_job_iperform(task, _task_release_wait);
 }
 
+/*
+ * See comments in the header file (tn_tasks.h)
+ */
+enum TN_RCode tn_task_notify(
+      struct TN_Task            *task,
+      enum TN_TaskNotifyAction   action,
+      TN_UWord                   value
+      )
+{
+   enum TN_RCode rc = _check_param_generic(task);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!_notify_action_is_valid(action)){
+      rc = TN_RC_WPARAM;
+   } else if (!tn_is_task_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_INTSAVE_DATA;
+
+      TN_INT_DIS_SAVE();
+
+      rc = _tn_task_notify(task, action, value);
+
+      TN_INT_RESTORE();
+      _tn_context_switch_pend_if_needed();
+   }
+   _TN_TRACE(TN_TRACE_EV_TASK_NOTIFY, task, rc);
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_tasks.h)
+ */
+enum TN_RCode tn_task_inotify(
+      struct TN_Task            *task,
+      enum TN_TaskNotifyAction   action,
+      TN_UWord                   value
+      )
+{
+   enum TN_RCode rc = _check_param_generic(task);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!_notify_action_is_valid(action)){
+      rc = TN_RC_WPARAM;
+   } else if (!tn_is_isr_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_INTSAVE_DATA_INT;
+
+      TN_INT_IDIS_SAVE();
+
+      rc = _tn_task_notify(task, action, value);
+
+      TN_INT_IRESTORE();
+      _TN_CONTEXT_SWITCH_IPEND_IF_NEEDED();
+   }
+   _TN_TRACE(TN_TRACE_EV_TASK_NOTIFY, task, rc);
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_tasks.h)
+ */
+enum TN_RCode tn_task_notify_wait(
+      TN_UWord      clear_bits,
+      TN_UWord     *p_value,
+      TN_TickCnt    timeout
+      )
+{
+   enum TN_RCode rc;
+
+   if (!tn_is_task_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_INTSAVE_DATA;
+      TN_BOOL waited_for_notify = TN_FALSE;
+
+      TN_INT_DIS_SAVE();
+
+      rc = _task_notify_take(_tn_curr_run_task, clear_bits, p_value);
+
+      if (rc == TN_RC_TIMEOUT && timeout != 0){
+         //-- no pending notification: put task to wait with reason NOTIFY
+         //   and without wait queue.
+         _tn_task_curr_to_wait_action(TN_NULL, TN_WAIT_REASON_NOTIFY, timeout);
+         waited_for_notify = TN_TRUE;
+      }
+
+      TN_INT_RESTORE();
+      _tn_context_switch_pend_if_needed();
+
+      if (waited_for_notify){
+         rc = _tn_curr_run_task->task_wait_rc;
+
+         if (rc == TN_RC_OK){
+            //-- we've been woken up by notification, so, it is pending now.
+            //   Take it.
+            TN_INT_DIS_SAVE();
+            rc = _task_notify_take(_tn_curr_run_task, clear_bits, p_value);
+            TN_INT_RESTORE();
+
+            _TN_BUG_ON(rc != TN_RC_OK);
+         }
+      }
+   }
+
+   _TN_TRACE(TN_TRACE_EV_TASK_NOTIFY_WAIT, _tn_curr_run_task, rc);
+   return rc;
+}
+
 /*
  * See comments in the header file (tn_tasks.h)
  */
@@ -776,11 +1259,13 @@ enum TN_RCode tn_task_terminate(struct TN_Task *task)
          } else if (_tn_task_is_waiting(task)){
             //-- if task is waiting, we must clear waiting state
             //   before terminating the task.
-            //   No matter what waiting result code we specify:
-            //   nobody is going to read it.
+            //   The task itself is not going to read waiting result code,
+            //   but wait-complete handlers (say, of message buffer) check
+            //   whether the task got what it waited for, so it shouldn't
+            //   be TN_RC_OK.
             _tn_task_clear_waiting(
                   task,
-                  TN_RC_OK    //-- doesn't matter: nobody will read it
+                  TN_RC_FORCED
                   );
          }
 
@@ -820,6 +1305,7 @@ enum TN_RCode tn_task_delete(struct TN_Task *task)
       TN_INT_RESTORE();
 
    }
+   _TN_TRACE(TN_TRACE_EV_TASK_DELETE, task, rc);
    return rc;
 }
 
@@ -846,6 +1332,87 @@ enum TN_RCode tn_task_state_get(
    return rc;
 }
 
+/*
+ * See comments in the header file (tn_tasks.h)
+ */
+enum TN_RCode tn_task_stack_usage_get(
+      struct TN_Task *task,
+      struct TN_TaskStackUsage *p_usage
+      )
+{
+   enum TN_RCode rc = _check_param_generic(task);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (p_usage == TN_NULL){
+      rc = TN_RC_WPARAM;
+   } else if (!tn_is_task_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      //-- scan the untouched part of the stack with interrupts enabled,
+      //   since it may take a while
+      TN_UWord *p_watermark = _stack_watermark_find(task);
+
+      TN_INTSAVE_DATA;
+
+      TN_INT_DIS_SAVE();
+      _stack_watermark_update(task, p_watermark);
+      _stack_usage_fill(task, p_usage);
+      TN_INT_RESTORE();
+   }
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_tasks.h)
+ */
+int tn_task_stack_usage_report(
+      struct TN_TaskStackUsage *p_usage_arr,
+      int items_cnt
+      )
+{
+   int cnt = 0;
+
+   if (p_usage_arr != TN_NULL && tn_is_task_context()){
+      struct TN_ListItem *item;
+      int i;
+      TN_INTSAVE_DATA;
+
+      //-- take the snapshot of the created tasks list in one pass, so that
+      //   each task is reported exactly once, even if tasks are created or
+      //   deleted while the stacks are being scanned
+      TN_INT_DIS_SAVE();
+
+      _tn_list_for_each(item, &_tn_tasks_created_list){
+         if (cnt >= items_cnt){
+            break;
+         }
+
+         p_usage_arr[cnt++].task = _tn_list_entry(
+               item, struct TN_Task, create_queue
+               );
+      }
+
+      TN_INT_RESTORE();
+
+      for (i = 0; i < cnt; i++){
+         struct TN_Task *task = p_usage_arr[i].task;
+
+         //-- just like in `tn_task_stack_usage_get()`, scan the untouched
+         //   part of the stack with interrupts enabled, and only store the
+         //   result with interrupts disabled
+         TN_UWord *p_watermark = _stack_watermark_find(task);
+
+         TN_INT_DIS_SAVE();
+         _stack_watermark_update(task, p_watermark);
+         _stack_usage_fill(task, &p_usage_arr[i]);
+         TN_INT_RESTORE();
+      }
+   }
+
+   return cnt;
+}
+
 /*
  * See comments in the header file (tn_tasks.h)
  */
@@ -893,14 +1460,15 @@ enum TN_RCode tn_task_profiler_timing_get(
    if (rc != TN_RC_OK){
       //-- just return rc as it is
    } else {
-      int sr_saved;
-      sr_saved = tn_arch_sr_save_int_dis();
+      TN_INTSAVE_DATA;
+
+      TN_INT_DIS_SAVE();
 
       //-- just copy timing data from task structure
       //   to the user-provided location
       memcpy(tgt, &task->profiler.timing, sizeof(*tgt));
 
-      tn_arch_sr_restore(sr_saved);
+      TN_INT_RESTORE();
    }
    return rc;
 }
@@ -937,6 +1505,9 @@ void _tn_task_set_runnable(struct TN_Task * task)
    if (priority < _tn_next_task_to_run->priority){
       _tn_next_task_to_run = task;
    }
+
+   //-- manage time slice timer (in dynamic tick mode only)
+   _tn_sys_tslice_manage();
 }
 
 /**
@@ -990,6 +1561,8 @@ void _tn_task_clear_runnable(struct TN_Task *task)
    //-- and reset task's queue
    _tn_list_reset(&(task->task_queue));
 
+   //-- manage time slice timer (in dynamic tick mode only)
+   _tn_sys_tslice_manage();
 }
 
 void _tn_task_set_waiting(
@@ -1011,6 +1584,8 @@ void _tn_task_set_waiting(
 
 #endif
 
+   _TN_TRACE(TN_TRACE_EV_TASK_WAIT, task, wait_reason);
+
    task->task_state       |= TN_TASK_STATE_WAIT;
    task->task_wait_reason = wait_reason;
 
@@ -1052,6 +1627,8 @@ void _tn_task_clear_waiting(struct TN_Task *task, enum TN_RCode wait_rc)
 
 #endif
 
+   _TN_TRACE(TN_TRACE_EV_TASK_WAIT_COMPLETE, task, wait_rc);
+
    //-- NOTE: we should remove task from wait_queue before calling
    //   _on_task_wait_complete(), because _find_max_blocked_priority()
    //   in tn_mutex.c checks for all tasks in mutex's wait_queue to
@@ -1064,12 +1641,15 @@ void _tn_task_clear_waiting(struct TN_Task *task, enum TN_RCode wait_rc)
    //-- and reset task's queue
    _tn_list_reset(&(task->task_queue));
 
+   //-- set wait result before calling _on_task_wait_complete(), so that
+   //   handlers know whether the task got what it waited for
+   task->task_wait_rc = wait_rc;
+
    //-- handle current wait_reason: say, for MUTEX_I, we should
    //   handle priorities of other involved tasks.
    _on_task_wait_complete(task);
 
    task->pwait_queue  = TN_NULL;
-   task->task_wait_rc = wait_rc;
 
    //-- if timer is active (i.e. task waits for timeout),
    //   cancel that timer
@@ -1092,6 +1672,8 @@ void _tn_task_set_suspended(struct TN_Task *task)
 #endif
 
    task->task_state |= TN_TASK_STATE_SUSPEND;
+
+   _TN_TRACE(TN_TRACE_EV_TASK_SUSPEND, task, 0);
 }
 
 void _tn_task_clear_suspended(struct TN_Task *task)
@@ -1109,6 +1691,8 @@ void _tn_task_clear_suspended(struct TN_Task *task)
 #endif
 
    task->task_state &= ~TN_TASK_STATE_SUSPEND;
+
+   _TN_TRACE(TN_TRACE_EV_TASK_RESUME, task, 0);
 }
 
 void _tn_task_set_dormant(struct TN_Task* task)
@@ -1134,6 +1718,10 @@ void _tn_task_set_dormant(struct TN_Task* task)
    task->task_state  |= TN_TASK_STATE_DORMANT;   //-- Task state
 
    task->tslice_count  = 0;
+
+   //-- reset notification state
+   task->notify_value   = 0;
+   task->notify_pending = TN_FALSE;
 }
 
 void _tn_task_clear_dormant(struct TN_Task *task)
@@ -1156,14 +1744,57 @@ void _tn_task_clear_dormant(struct TN_Task *task)
 
    task->task_state &= ~TN_TASK_STATE_DORMANT;
 
+   _TN_TRACE(TN_TRACE_EV_TASK_ACTIVATE, task, 0);
+
 
 #if TN_PROFILER
-   //-- If profiler is present, set last tick count
-   //   to current tick count value
-   task->profiler.last_tick_cnt = _tn_timer_sys_time_get();
+   //-- If profiler is present, set last timestamp
+   //   to current timestamp value
+   task->profiler.last_timestamp = _tn_sys_profiler_timestamp_get();
 #endif
 }
 
+/**
+ * See comment in the _tn_tasks.h file
+ */
+enum TN_RCode _tn_task_notify(
+      struct TN_Task            *task,
+      enum TN_TaskNotifyAction   action,
+      TN_UWord                   value
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   if (_tn_task_is_dormant(task)){
+      rc = TN_RC_WSTATE;
+   } else {
+      switch (action){
+         case TN_TASK_NOTIFY_ACTION_SET_BITS:
+            task->notify_value |= value;
+            break;
+         case TN_TASK_NOTIFY_ACTION_INCREMENT:
+            task->notify_value++;
+            break;
+         case TN_TASK_NOTIFY_ACTION_OVERWRITE:
+            task->notify_value = value;
+            break;
+      }
+
+      task->notify_pending = TN_TRUE;
+
+      if (     (_tn_task_is_waiting(task))
+            && (task->task_wait_reason == TN_WAIT_REASON_NOTIFY))
+      {
+         //-- Task waits for notification, so, let's wake it up.
+         //   Note that there's no wait queue here, so no list manipulations
+         //   are needed, except for making the task runnable.
+         _tn_task_wait_complete(task, TN_RC_OK);
+      }
+   }
+
+   return rc;
+}
+
 /**
  * See comment in the _tn_tasks.h file
  */
@@ -1191,6 +1822,24 @@ TN_BOOL _tn_task_first_wait_complete(
       void                         *user_data_1,
       void                         *user_data_2
       )
+{
+   return _tn_task_ordered_wait_complete(
+         wait_queue, TN_WAIT_ORDER_FIFO,
+         wait_rc, callback, user_data_1, user_data_2
+         );
+}
+
+/**
+ * See comment in the _tn_tasks.h file
+ */
+TN_BOOL _tn_task_ordered_wait_complete(
+      struct TN_ListItem           *wait_queue,
+      enum TN_WaitOrder             wait_order,
+      enum TN_RCode                 wait_rc,
+      _TN_CBBeforeTaskWaitComplete *callback,
+      void                         *user_data_1,
+      void                         *user_data_2
+      )
 {
    TN_BOOL ret = TN_FALSE;
 
@@ -1201,6 +1850,22 @@ TN_BOOL _tn_task_first_wait_complete(
       //-- get first task from the wait_queue
       task = _tn_list_first_entry(wait_queue, struct TN_Task, task_queue);
 
+      if (wait_order == TN_WAIT_ORDER_PRIORITY){
+         struct TN_Task *cur;
+
+         //-- find the task with the highest priority (i.e. the lowest
+         //   value); strict comparison keeps FIFO order among the tasks
+         //   with equal priority
+         _tn_list_for_each_entry(
+               cur, struct TN_Task, wait_queue, task_queue
+               )
+         {
+            if (cur->priority < task->priority){
+               task = cur;
+            }
+         }
+      }
+
       //-- call provided callback (if any)
       if (callback != TN_NULL){
          callback(task, user_data_1, user_data_2);
@@ -1247,6 +1912,9 @@ void _tn_change_running_task_priority(struct TN_Task *task, int new_priority)
    _add_entry_to_ready_queue(&(task->task_queue), new_priority);
 
    _find_next_task_to_run();
+
+   //-- manage time slice timer (in dynamic tick mode only)
+   _tn_sys_tslice_manage();
 }
 
 #if 0
@@ -123,6 +123,11 @@
 #include "tn_eventgrp.h"
 #include "tn_dqueue.h"
 #include "tn_fmem.h"
+#include "tn_fmem_multi.h"
+#include "tn_heap.h"
+#include "tn_mutex.h"
+#include "tn_msgbuf.h"
+#include "tn_multi_wait.h"
 #include "tn_timer.h"
 
 
@@ -208,6 +213,34 @@ enum TN_WaitReason {
    /// memory blocks
    /// @see tn_fmem.h
    TN_WAIT_REASON_WFIXMEM,
+   ///
+   /// Task waits for notification
+   /// @see `tn_task_notify_wait()`
+   TN_WAIT_REASON_NOTIFY,
+   ///
+   /// Task wants to send a message to the message buffer, and there's not
+   /// enough space in the buffer.
+   /// @see tn_msgbuf.h
+   TN_WAIT_REASON_MSGBUF_WSEND,
+   ///
+   /// Task wants to receive a message from the message buffer, and there are
+   /// no messages in the buffer
+   /// @see tn_msgbuf.h
+   TN_WAIT_REASON_MSGBUF_WRECEIVE,
+   ///
+   /// Task wants to get memory block from multi-size-class memory pool, and
+   /// there's no free memory blocks of suitable size
+   /// @see tn_fmem_multi.h
+   TN_WAIT_REASON_WFIXMEM_MULTI,
+   ///
+   /// Task wants to allocate memory from the heap, and there's no free
+   /// memory block large enough
+   /// @see tn_heap.h
+   TN_WAIT_REASON_HEAP,
+   ///
+   /// Task waits for any of multiple objects by `tn_multi_wait()`
+   /// @see tn_multi_wait.h
+   TN_WAIT_REASON_MULTI,
 
 
    ///
@@ -242,12 +275,57 @@ enum TN_TaskExitOpt {
    TN_TASK_EXIT_OPT_DELETE = (1 << 0),
 };
 
+/**
+ * Action that is performed on the notification value of the task by
+ * `tn_task_notify()` and `tn_task_inotify()`
+ */
+enum TN_TaskNotifyAction {
+   ///
+   /// Given value is OR-ed with the notification value, so that
+   /// notification value can be used as a set of event flags
+   TN_TASK_NOTIFY_ACTION_SET_BITS,
+   ///
+   /// Notification value is incremented (given value is ignored), so that
+   /// notification value can be used as a counting semaphore
+   TN_TASK_NOTIFY_ACTION_INCREMENT,
+   ///
+   /// Notification value is overwritten with given value, even if previous
+   /// value was not yet received by the task, so that notification value can
+   /// be used as a mailbox of depth 1
+   TN_TASK_NOTIFY_ACTION_OVERWRITE,
+};
+
+/**
+ * Stack usage of the task, see `tn_task_stack_usage_get()` and
+ * `tn_task_stack_usage_report()`. Sizes are in `#TN_UWord`s, just like the
+ * stack size given to `tn_task_create()`.
+ */
+struct TN_TaskStackUsage {
+   ///
+   /// Task whose stack usage is described
+   struct TN_Task      *task;
+   ///
+   /// Total size of the stack
+   unsigned int         size;
+   ///
+   /// High-water mark: the largest amount of the stack ever used by the task
+   /// (since it was created). If it is equal to `size`, the stack has
+   /// probably overflowed.
+   unsigned int         used_max;
+};
+
 #if TN_PROFILER || DOXYGEN_ACTIVE
 /**
  * Timing structure that is managed by profiler and can be read by
  * `#tn_task_profiler_timing_get()` function. This structure is contained in
  * each `struct #TN_Task` structure. 
  *
+ * All the times are measured in system ticks by default, or in the units of
+ * the high-resolution timestamp given by
+ * `tn_callback_profiler_timestamp_set()` (say, CPU cycles). Total times are
+ * 64-bit, so they don't overflow even with the cycle counter; maximum
+ * consecutive times saturate at the maximum value of `unsigned long`.
+ *
  * Available if only `#TN_PROFILER` option is non-zero, also depends on
  * `#TN_PROFILER_WAIT_TIME`.
  */
@@ -301,8 +379,9 @@ struct TN_TaskTiming {
  */
 struct _TN_TaskProfiler {
    ///
-   /// Tick count of when the task got running or non-running last time.
-   TN_TickCnt        last_tick_cnt;
+   /// Profiler timestamp (see `_tn_sys_profiler_timestamp_get()`) of when
+   /// the task got running or non-running last time.
+   unsigned long long   last_timestamp;
 #if TN_PROFILER_WAIT_TIME || DOXYGEN_ACTIVE
    ///
    /// Available if only `#TN_PROFILER_WAIT_TIME` option is non-zero.
@@ -358,6 +437,13 @@ struct TN_Task {
    ///
    /// list of all mutexes that are locked by task
    struct TN_ListItem mutex_queue;
+#if _TN_MUTEX_FAST_PATH
+   ///
+   /// mutex locked by the lock-free fast path (or `TN_NULL`): it isn't
+   /// included in `mutex_queue` until some other task waits for it, so it's
+   /// remembered here to be unlocked if the task is terminated.
+   struct TN_Mutex *mutex_fast;
+#endif
 #if TN_MUTEX_DEADLOCK_DETECT
    ///
    /// list of other tasks involved in deadlock. This list is non-empty
@@ -378,6 +464,10 @@ struct TN_Task {
    ///   or end of stack, depending on the architecture)
    TN_UWord *stack_high_addr;
    ///
+   /// The deepest word of the stack which is known to be ever used;
+   /// maintained by `tn_task_stack_usage_get()`
+   TN_UWord *stack_watermark;
+   ///
    /// pointer to task's body function given to `tn_task_create()`
    TN_TaskBody *task_func_addr;
    ///
@@ -426,8 +516,23 @@ struct TN_Task {
       ///
       /// fields specific to tn_fmem.h
       struct TN_FMemTaskWait fmem;
+      ///
+      /// fields specific to tn_fmem_multi.h
+      struct TN_FMemMultiTaskWait fmem_multi;
+      ///
+      /// fields specific to tn_heap.h
+      struct TN_HeapTaskWait heap;
+      ///
+      /// fields specific to tn_msgbuf.h
+      struct TN_MsgBufTaskWait msgbuf;
+      ///
+      /// fields specific to tn_multi_wait.h
+      struct TN_MultiWaitTaskWait multi;
    } subsys_wait;
    ///
+   /// Notification value, see `tn_task_notify()`
+   TN_UWord notify_value;
+   ///
    /// Task name for debug purposes, user may want to set it by hand
    const char *name;          
 #if TN_PROFILER || DOXYGEN_ACTIVE
@@ -446,11 +551,37 @@ struct TN_Task {
    /// if the caller is interested in the relevant value of this flag.
    unsigned          waited : 1;
 
+   /// Flag indicates that task has notification which is not yet received
+   /// by `tn_task_notify_wait()`
+   unsigned          notify_pending : 1;
+
 
 // Other implementation specific fields may be added below
 
 };
 
+/**
+ * State of the periodic task loop, see `tn_task_periodic_wait()`.
+ *
+ * Application allocates it and initializes by `tn_task_periodic_init()`;
+ * after that, it may read the fields, but shouldn't modify them.
+ */
+struct TN_TaskPeriodic {
+   ///
+   /// Period, in system ticks
+   TN_TickCnt        period;
+   ///
+   /// System time (see `tn_sys_time_get()`) of the latest release: the
+   /// moment the task is supposed to start the current cycle at. The
+   /// releases are always `period` ticks apart, no matter how long the task
+   /// works.
+   TN_TickCnt        release_time;
+   ///
+   /// Count of releases missed because the task's cycle took longer than
+   /// the period (see `tn_task_periodic_wait()`)
+   unsigned long     overrun_cnt;
+};
+
 
 
 /*******************************************************************************
@@ -647,6 +778,122 @@ enum TN_RCode tn_task_resume(struct TN_Task *task);
  */
 enum TN_RCode tn_task_sleep(TN_TickCnt timeout);
 
+/**
+ * Put current task to sleep until the absolute system time `*p_last_wake +
+ * period` (see `tn_sys_time_get()`), and advance `*p_last_wake` by
+ * `period`. Unlike `tn_task_sleep()`, the time the task has spent working
+ * since the previous wake-up doesn't shift the next one, so the loop like
+ * this runs exactly once per `MY_PERIOD` ticks, without drift:
+ *
+ * \code{.c}
+ *    TN_TickCnt last_wake = tn_sys_time_get();
+ *
+ *    for (;;){
+ *       tn_task_sleep_until(&last_wake, MY_PERIOD);
+ *       do_work();
+ *    }
+ * \endcode
+ *
+ * If the wake-up time has already passed (the work took longer than the
+ * period), the task doesn't sleep, and `#TN_RC_OVERFLOW` is returned;
+ * `*p_last_wake` is still advanced by `period`, so the subsequent calls
+ * return immediately until the task catches up. If you'd rather skip
+ * the missed periods, use `tn_task_periodic_wait()`.
+ *
+ * Just like `tn_task_sleep()`, the task can be woken up earlier by
+ * `tn_task_wakeup()`. In this case, `*p_last_wake` is advanced anyway, so
+ * the next call sleeps until the next time on the grid of periods.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_CAN_SLEEP)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param p_last_wake
+ *    Pointer to the system time of the previous wake-up; initialize it with
+ *    `tn_sys_time_get()` before the first call
+ * @param period
+ *    Period in system ticks, should be non-zero
+ *
+ * @returns
+ *    * `#TN_RC_TIMEOUT` if task has slept until the given time, or if the
+ *       time is right now;
+ *    * `#TN_RC_OVERFLOW` if the given time has already passed, so the task
+ *       didn't sleep;
+ *    * `#TN_RC_OK` if task was woken up from other task by `tn_task_wakeup()`
+ *    * `#TN_RC_FORCED` if task was released from wait forcibly by 
+ *       `tn_task_release_wait()`
+ *    * `#TN_RC_WCONTEXT` if called from wrong context
+ *    * `#TN_RC_WPARAM` if `p_last_wake` is `TN_NULL` or `period` is 0.
+ */
+enum TN_RCode tn_task_sleep_until(TN_TickCnt *p_last_wake, TN_TickCnt period);
+
+/**
+ * Initialize the periodic task loop state: the current system time becomes
+ * the first release time, and overrun counter is cleared. Typically it's
+ * called once, at the beginning of the task body, and then
+ * `tn_task_periodic_wait()` is called on each cycle:
+ *
+ * \code{.c}
+ *    struct TN_TaskPeriodic periodic;
+ *
+ *    tn_task_periodic_init(&periodic, MY_PERIOD);
+ *
+ *    for (;;){
+ *       tn_task_periodic_wait(&periodic);
+ *       do_work();
+ *    }
+ * \endcode
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param periodic
+ *    Periodic loop state to initialize
+ * @param period
+ *    Period in system ticks, should be non-zero
+ *
+ * @returns
+ *    * `#TN_RC_OK` on success;
+ *    * `#TN_RC_WPARAM` if `periodic` is `TN_NULL` or `period` is 0.
+ */
+enum TN_RCode tn_task_periodic_init(
+      struct TN_TaskPeriodic *periodic,
+      TN_TickCnt              period
+      );
+
+/**
+ * Sleep until the next release time of the periodic loop (the previous one
+ * plus period), see `tn_task_periodic_init()`.
+ *
+ * If the cycle took longer than the period, so that one or more release
+ * times have already passed, the task doesn't sleep: the latest passed
+ * release time becomes the current one, the older ones are skipped, and all
+ * of them are added to `overrun_cnt`. This way, the releases always stay on
+ * the grid of `period` ticks, and the task doesn't run a burst of cycles to
+ * catch up (compare to `tn_task_sleep_until()`).
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_CAN_SLEEP)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param periodic
+ *    Periodic loop state
+ *
+ * @returns
+ *    * `#TN_RC_OK` if task was released on time (or woken up earlier by
+ *       `tn_task_wakeup()`);
+ *    * `#TN_RC_OVERFLOW` if one or more release times have been missed, so
+ *       the task didn't sleep;
+ *    * `#TN_RC_FORCED` if task was released from wait forcibly by 
+ *       `tn_task_release_wait()`
+ *    * `#TN_RC_WCONTEXT` if called from wrong context
+ *    * `#TN_RC_WPARAM` if `periodic` is `TN_NULL`.
+ */
+enum TN_RCode tn_task_periodic_wait(struct TN_TaskPeriodic *periodic);
+
 /**
  * Wake up task from sleep.
  *
@@ -887,6 +1134,73 @@ enum TN_RCode tn_task_profiler_timing_get(
       );
 #endif
 
+/**
+ * Get stack usage of the task: its size and the high-water mark, i.e. the
+ * largest amount of the stack ever used by the task. This is helpful to
+ * tune stack sizes: run the application through its heaviest scenarios,
+ * check the high-water marks, and cut the stacks down, leaving some margin.
+ *
+ * The stack of each task is filled with `#TN_FILL_STACK_VAL` when the task
+ * is created, so the kernel scans the stack from its end towards the origin,
+ * until it finds the word which doesn't contain that value anymore. The
+ * position of that word is remembered in the task (`stack_watermark`), so
+ * the next calls only scan the part of the stack which is still untouched,
+ * and never go through the used part again.
+ *
+ * The scan is performed with interrupts enabled.
+ *
+ * Note that the high-water mark is reliable only if the task doesn't store
+ * `#TN_FILL_STACK_VAL` itself to its deepest used stack words.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param task
+ *    Task to get stack usage of
+ * @param p_usage
+ *    Target structure to fill with data, should be allocated by caller
+ *
+ * @return
+ *    * `#TN_RC_OK` on success;
+ *    * `#TN_RC_WPARAM` if `p_usage` is `TN_NULL`;
+ *    * `#TN_RC_WCONTEXT` if called from wrong context;
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_task_stack_usage_get(
+      struct TN_Task *task,
+      struct TN_TaskStackUsage *p_usage
+      );
+
+/**
+ * Get stack usage of all the created tasks (including the idle task), in
+ * order of their creation: the same as calling `tn_task_stack_usage_get()`
+ * for each of them.
+ *
+ * The list of tasks is taken at once, with interrupts disabled for as long
+ * as it takes to walk `items_cnt` tasks; then the stacks are scanned with
+ * interrupts enabled, one by one. So, each task is reported exactly once;
+ * tasks created while the stacks are being scanned aren't reported, and
+ * tasks deleted meanwhile are reported with their last known usage.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param p_usage_arr
+ *    Array to store stack usage of the tasks to
+ * @param items_cnt
+ *    Number of items in `p_usage_arr`
+ *
+ * @return
+ *    Number of tasks stored to `p_usage_arr`. If it is equal to `items_cnt`,
+ *    there might be more tasks. If called from wrong context or
+ *    `p_usage_arr` is `TN_NULL`, 0 is returned.
+ */
+int tn_task_stack_usage_report(
+      struct TN_TaskStackUsage *p_usage_arr,
+      int items_cnt
+      );
+
 
 /**
  * Set new priority for task.
@@ -899,6 +1213,97 @@ enum TN_RCode tn_task_profiler_timing_get(
  */
 enum TN_RCode tn_task_change_priority(struct TN_Task *task, int new_priority);
 
+/**
+ * Send notification to the task: modify its notification value in accordance
+ * with given `action`, and mark the notification as pending. If the task
+ * waits for notification in `tn_task_notify_wait()`, it is woken up.
+ *
+ * Notifications are a lightweight alternative to semaphores and event groups
+ * for the case when there is just one task that should be signalled: there is
+ * no need to create a separate object, and the task is woken up directly,
+ * without any wait queue manipulations.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param task
+ *    Task to notify
+ * @param action
+ *    What to do with the notification value, see `enum #TN_TaskNotifyAction`
+ * @param value
+ *    Value to use (for `#TN_TASK_NOTIFY_ACTION_INCREMENT`, it is ignored)
+ *
+ * @return
+ *    * `#TN_RC_OK` if successful
+ *    * `#TN_RC_WSTATE` if task is dormant
+ *    * `#TN_RC_WCONTEXT` if called from wrong context;
+ *    * `#TN_RC_WPARAM` if wrong `action` is given;
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_task_notify(
+      struct TN_Task            *task,
+      enum TN_TaskNotifyAction   action,
+      TN_UWord                   value
+      );
+
+/**
+ * The same as `tn_task_notify()` but for using in the ISR.
+ *
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ */
+enum TN_RCode tn_task_inotify(
+      struct TN_Task            *task,
+      enum TN_TaskNotifyAction   action,
+      TN_UWord                   value
+      );
+
+/**
+ * Wait for notification (see `tn_task_notify()`) to the current task. If
+ * the notification is already pending, the function returns immediately;
+ * otherwise, current task waits for it, for at most `timeout` ticks.
+ *
+ * When notification is received, the notification value is stored to
+ * `p_value` (if it is not `TN_NULL`), and then `clear_bits` are cleared in
+ * the notification value. So, for example:
+ *
+ * - if notification value is used as event flags, give `~0` as `clear_bits`,
+ *   so that all received flags are cleared;
+ * - if notification value is used as a counting semaphore, give `~0` as
+ *   well: you'll get the number of notifications received since the last
+ *   call, and the counter is reset;
+ * - if you want to keep some bits of the value, don't include them into
+ *   `clear_bits`.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_CAN_SLEEP)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param clear_bits
+ *    Bits to clear in the notification value after it is received
+ * @param p_value
+ *    Pointer to the location where notification value should be stored
+ *    (may be `TN_NULL`)
+ * @param timeout
+ *    Refer to `#TN_TickCnt`
+ *
+ * @return
+ *    * `#TN_RC_OK` if notification was received;
+ *    * `#TN_RC_TIMEOUT` if there was no notification during given timeout;
+ *    * `#TN_RC_FORCED` if task was released from wait forcibly by 
+ *       `tn_task_release_wait()`;
+ *    * `#TN_RC_WCONTEXT` if called from wrong context.
+ */
+enum TN_RCode tn_task_notify_wait(
+      TN_UWord      clear_bits,
+      TN_UWord     *p_value,
+      TN_TickCnt    timeout
+      );
+
 #ifdef __cplusplus
 }  /* extern "C" */
 #endif
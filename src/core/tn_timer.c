@@ -46,6 +46,12 @@
 //-- internal tnkernel headers
 #include "_tn_timer.h"
 #include "_tn_list.h"
+#include "_tn_trace.h"
+
+#if TN_TIMER_TASK
+#  include "_tn_workq.h"
+#  include "tn_workq.h"
+#endif
 
 
 
@@ -56,6 +62,39 @@
 
 
 
+/*******************************************************************************
+ *    PRIVATE DATA
+ ******************************************************************************/
+
+#if TN_TIMER_TASK
+///
+/// Work queue whose worker task is the timer task, see
+/// `tn_timer_task_create()`
+static struct TN_WorkQueue _timer_workq;
+
+///
+/// The only work item of `_timer_workq`: `_timer_fired_work()` is posted
+/// once for the whole queue of expired timers
+static struct TN_WorkItem _timer_work_item;
+
+///
+/// Whether the timer task is created: until then, callbacks are called
+/// right from the ISR
+static TN_BOOL _timer_task_created = TN_FALSE;
+
+///
+/// Whether `_timer_fired_work()` is posted to `_timer_workq` and hasn't
+/// yet found `_timer_fired_list` empty
+static TN_BOOL _timer_work_posted = TN_FALSE;
+
+///
+/// Queue of expired timers whose callbacks are yet to be called by the
+/// timer task
+static struct TN_ListItem _timer_fired_list;
+#endif
+
+
+
 /*******************************************************************************
  *    DEFINITIONS
  ******************************************************************************/
@@ -108,6 +147,56 @@ _TN_STATIC_INLINE enum TN_RCode _check_param_create(
 #endif
 // }}}
 
+#if TN_TIMER_TASK
+/**
+ * Work function posted to the work queue of the timer task when a timer is
+ * added to the queue of expired ones: calls the callbacks of the expired
+ * timers one by one (each timer is taken from the queue in its own short
+ * critical section, and the callback is called with interrupts enabled),
+ * until the queue is empty.
+ *
+ * The work is posted again by the next expired timer only after this
+ * function has found the queue empty, so no timer is missed.
+ */
+static void _timer_fired_work(void *p_arg)
+{
+   TN_BOOL drained = TN_FALSE;
+
+   _TN_UNUSED(p_arg);
+
+   while (!drained){
+      struct TN_Timer *timer = TN_NULL;
+      TN_TimerFunc *func = TN_NULL;
+      void *p_user_data = TN_NULL;
+      TN_INTSAVE_DATA;
+
+      TN_INT_DIS_SAVE();
+
+      if (_tn_list_is_empty(&_timer_fired_list)){
+         _timer_work_posted = TN_FALSE;
+         drained = TN_TRUE;
+      } else {
+         timer = _tn_list_first_entry(
+               &_timer_fired_list, struct TN_Timer, fired_queue
+               );
+         _tn_list_remove_entry(&(timer->fired_queue));
+         _tn_list_reset(&(timer->fired_queue));
+
+         //-- remember callback while interrupts are disabled, since the
+         //   timer might be changed as soon as they are enabled
+         func        = timer->func;
+         p_user_data = timer->p_user_data;
+      }
+
+      TN_INT_RESTORE();
+
+      if (timer != TN_NULL){
+         func(timer, p_user_data);
+      }
+   }
+}
+#endif
+
 
 
 /*******************************************************************************
@@ -129,8 +218,17 @@ enum TN_RCode tn_timer_create(
       //-- just return rc as it is
    } else {
       rc = _tn_timer_create(timer, func, p_user_data);
+
+#if TN_TIMER_TASK
+      if (rc == TN_RC_OK){
+         //-- unlike kernel-internal timers, application timers get their
+         //   callbacks called from the timer task (when it's running)
+         timer->deferred = TN_TRUE;
+      }
+#endif
    }
 
+   _TN_TRACE(TN_TRACE_EV_TIMER_CREATE, timer, rc);
    return rc;
 }
 
@@ -139,19 +237,23 @@ enum TN_RCode tn_timer_create(
  */
 enum TN_RCode tn_timer_delete(struct TN_Timer *timer)
 {
-   int sr_saved;
+   TN_INTSAVE_DATA;
    enum TN_RCode rc = _check_param_generic(timer);
 
    if (rc == TN_RC_OK){
-      sr_saved = tn_arch_sr_save_int_dis();
+      TN_INT_DIS_SAVE();
       //-- if timer is active, cancel it first
       rc = _tn_timer_cancel(timer);
+#if TN_TIMER_TASK
+      _tn_timer_task_dequeue(timer);
+#endif
 
       //-- now, delete timer
       timer->id_timer = TN_ID_NONE;
-      tn_arch_sr_restore(sr_saved);
+      TN_INT_RESTORE();
    }
 
+   _TN_TRACE(TN_TRACE_EV_TIMER_DELETE, timer, rc);
    return rc;
 }
 
@@ -160,15 +262,44 @@ enum TN_RCode tn_timer_delete(struct TN_Timer *timer)
  */
 enum TN_RCode tn_timer_start(struct TN_Timer *timer, TN_TickCnt timeout)
 {
-   int sr_saved;
+   TN_INTSAVE_DATA;
+   enum TN_RCode rc = _check_param_generic(timer);
+
+   if (rc == TN_RC_OK){
+      TN_INT_DIS_SAVE();
+      rc = _tn_timer_start(timer, timeout);
+      TN_INT_RESTORE();
+   }
+
+   _TN_TRACE(TN_TRACE_EV_TIMER_START, timer, rc);
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_timer.h)
+ */
+enum TN_RCode tn_timer_start_slack(
+      struct TN_Timer  *timer,
+      TN_TickCnt        timeout,
+      TN_TickCnt        slack
+      )
+{
+   TN_INTSAVE_DATA;
    enum TN_RCode rc = _check_param_generic(timer);
 
    if (rc == TN_RC_OK){
-      sr_saved = tn_arch_sr_save_int_dis();
+      TN_INT_DIS_SAVE();
+#if TN_DYNAMIC_TICK
+      rc = _tn_timer_start_slack(timer, timeout, slack);
+#else
+      //-- with static tick, there's nothing to gain from slack
+      _TN_UNUSED(slack);
       rc = _tn_timer_start(timer, timeout);
-      tn_arch_sr_restore(sr_saved);
+#endif
+      TN_INT_RESTORE();
    }
 
+   _TN_TRACE(TN_TRACE_EV_TIMER_START, timer, rc);
    return rc;
 }
 
@@ -177,15 +308,19 @@ enum TN_RCode tn_timer_start(struct TN_Timer *timer, TN_TickCnt timeout)
  */
 enum TN_RCode tn_timer_cancel(struct TN_Timer *timer)
 {
-   int sr_saved;
+   TN_INTSAVE_DATA;
    enum TN_RCode rc = _check_param_generic(timer);
 
    if (rc == TN_RC_OK){
-      sr_saved = tn_arch_sr_save_int_dis();
+      TN_INT_DIS_SAVE();
       rc = _tn_timer_cancel(timer);
-      tn_arch_sr_restore(sr_saved);
+#if TN_TIMER_TASK
+      _tn_timer_task_dequeue(timer);
+#endif
+      TN_INT_RESTORE();
    }
 
+   _TN_TRACE(TN_TRACE_EV_TIMER_CANCEL, timer, rc);
    return rc;
 }
 
@@ -198,13 +333,13 @@ enum TN_RCode tn_timer_set_func(
       void             *p_user_data
       )
 {
-   int sr_saved;
+   TN_INTSAVE_DATA;
    enum TN_RCode rc = _check_param_generic(timer);
 
    if (rc == TN_RC_OK){
-      sr_saved = tn_arch_sr_save_int_dis();
+      TN_INT_DIS_SAVE();
       rc = _tn_timer_set_func(timer, func, p_user_data);
-      tn_arch_sr_restore(sr_saved);
+      TN_INT_RESTORE();
    }
 
    return rc;
@@ -215,13 +350,13 @@ enum TN_RCode tn_timer_set_func(
  */
 enum TN_RCode tn_timer_is_active(struct TN_Timer *timer, TN_BOOL *p_is_active)
 {
-   int sr_saved;
+   TN_INTSAVE_DATA;
    enum TN_RCode rc = _check_param_generic(timer);
 
    if (rc == TN_RC_OK){
-      sr_saved = tn_arch_sr_save_int_dis();
+      TN_INT_DIS_SAVE();
       *p_is_active = _tn_timer_is_active(timer);
-      tn_arch_sr_restore(sr_saved);
+      TN_INT_RESTORE();
    }
 
    return rc;
@@ -235,18 +370,67 @@ enum TN_RCode tn_timer_time_left(
       TN_TickCnt *p_time_left
       )
 {
-   int sr_saved;
+   TN_INTSAVE_DATA;
    enum TN_RCode rc = _check_param_generic(timer);
 
    if (rc == TN_RC_OK){
-      sr_saved = tn_arch_sr_save_int_dis();
+      TN_INT_DIS_SAVE();
       *p_time_left = _tn_timer_time_left(timer);
-      tn_arch_sr_restore(sr_saved);
+      TN_INT_RESTORE();
    }
 
    return rc;
 }
 
+#if TN_TIMER_TASK
+/*
+ * See comments in the header file (tn_timer.h)
+ */
+enum TN_RCode tn_timer_task_create(
+      int                     priority,
+      TN_UWord               *task_stack_low_addr,
+      int                     task_stack_size
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+   enum TN_Context context = tn_sys_context_get();
+
+   //-- Note: just like `tn_task_create()`, it is allowed to be called from
+   //   the callback given to `tn_sys_start()`, when context is
+   //   `#TN_CONTEXT_NONE`.
+   if (context != TN_CONTEXT_TASK && context != TN_CONTEXT_NONE){
+      rc = TN_RC_WCONTEXT;
+   } else if (_timer_task_created){
+      rc = TN_RC_WSTATE;
+   } else {
+      //-- the timer task is just the worker task of the work queue with
+      //   a single item: `_timer_fired_work()` is never posted twice
+      rc = tn_workq_create(
+            &_timer_workq,
+            &_timer_work_item,
+            1,
+            priority,
+            task_stack_low_addr,
+            task_stack_size
+            );
+
+      if (rc == TN_RC_OK){
+         TN_INTSAVE_DATA;
+
+         //-- the work queue names its worker task "tn_workq": rename it,
+         //   so that the timer task can be told apart in the debugger
+         _timer_workq.task.name = "tn_timer";
+
+         TN_INT_DIS_SAVE();
+         _timer_task_created = TN_TRUE;
+         TN_INT_RESTORE();
+      }
+   }
+
+   return rc;
+}
+#endif
+
 
 
 
@@ -273,9 +457,19 @@ enum TN_RCode _tn_timer_create(
 
       _tn_list_reset(&(timer->timer_queue));
 
+#if TN_TIMER_TASK
+      _tn_list_reset(&(timer->fired_queue));
+      timer->deferred = TN_FALSE;
+#endif
+
 #if TN_DYNAMIC_TICK
       timer->timeout = 0;
       timer->start_tick_cnt = 0;
+      timer->heap_prev = TN_NULL;
+      timer->heap_next = TN_NULL;
+      timer->heap_child = TN_NULL;
+#elif TN_TIMER_WHEEL
+      timer->expire_tick_cnt = 0;
 #else
       timer->timeout_cur   = 0;
 #endif
@@ -317,4 +511,65 @@ TN_BOOL _tn_timer_is_active(struct TN_Timer *timer)
    return (!_tn_list_is_empty(&(timer->timer_queue)));
 }
 
+#if TN_TIMER_TASK
+/**
+ * See comments in the _tn_timer.h file.
+ */
+void _tn_timer_task_init(void)
+{
+   _tn_list_reset(&_timer_fired_list);
+   _timer_task_created = TN_FALSE;
+   _timer_work_posted  = TN_FALSE;
+}
+
+/**
+ * See comments in the _tn_timer.h file.
+ */
+TN_BOOL _tn_timer_task_queue(struct TN_Timer *timer)
+{
+   TN_BOOL queued = TN_FALSE;
+
+   //-- interrupts should be disabled here
+   _TN_BUG_ON( !TN_IS_INT_DISABLED() );
+
+   if (timer->deferred && _timer_task_created){
+      //-- the timer might be in the queue already, if it was restarted
+      //   and fired again before the timer task got to it: then, its
+      //   callback is called just once.
+      if (_tn_list_is_empty(&(timer->fired_queue))){
+
+         _tn_list_add_tail(&_timer_fired_list, &(timer->fired_queue));
+
+         //-- `_timer_fired_work()` drains the whole queue, so it is posted
+         //   only if it isn't posted already. It is taken from the ring
+         //   before it runs, so the ring of one item never overflows.
+         if (!_timer_work_posted){
+            _timer_work_posted = (
+                  _tn_work_post(&_timer_workq, _timer_fired_work, TN_NULL)
+                  == TN_RC_OK
+                  );
+         }
+      }
+
+      queued = TN_TRUE;
+   }
+
+   return queued;
+}
+
+/**
+ * See comments in the _tn_timer.h file.
+ */
+void _tn_timer_task_dequeue(struct TN_Timer *timer)
+{
+   //-- interrupts should be disabled here
+   _TN_BUG_ON( !TN_IS_INT_DISABLED() );
+
+   if (!_tn_list_is_empty(&(timer->fired_queue))){
+      _tn_list_remove_entry(&(timer->fired_queue));
+      _tn_list_reset(&(timer->fired_queue));
+   }
+}
+#endif
+
 
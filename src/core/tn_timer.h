@@ -71,9 +71,34 @@
  *   function;
  * - The function should be as fast as possible;
  *
+ * Unless the timer task is used, see \ref timers_task below.
+ *
  * See `#TN_TimerFunc` for the prototype of the function that could be
  * scheduled.
  *
+ * \section timers_task Timer task
+ *
+ * If many timers expire at the same tick, their callbacks are called one
+ * after another from the $(TN_SYS_TIMER_LINK) ISR, which makes the ISR long.
+ * To bound it, set `#TN_TIMER_TASK` to 1, and create the timer task by
+ * `tn_timer_task_create()`. Then, timers are still expired in the ISR, but
+ * their callbacks are just queued there; the timer task calls them in a
+ * batch, one by one, with interrupts enabled. Be aware of the following:
+ *
+ * - Function is called from the task context, so it should use task
+ *   services (say, `tn_sem_signal()` instead of `tn_sem_isignal()`), and it
+ *   runs on the stack of the timer task;
+ * - Function is called later than the timer actually expires: how much
+ *   later depends on the priority of the timer task and on the other
+ *   callbacks queued;
+ * - If the timer is cancelled or deleted while its callback is queued, the
+ *   callback isn't called. If the timer is restarted and expires again
+ *   before the callback is called, it's called just once.
+ *
+ * It affects timers created by `tn_timer_create()` only: kernel-internal
+ * timers (such as timeouts of waiting tasks) are always handled right in
+ * the ISR.
+ *
  * TNeo offers two implementations of timers: static and dynamic. Refer
  * to the page \ref time_ticks for details.
  *
@@ -150,6 +175,59 @@
  *
  * The `N` in the TNeo is configured by the compile-time option
  * `#TN_TICK_LISTS_CNT`.
+ *
+ * \section timers_wheel_implementation Hierarchical timing wheel
+ *
+ * The drawback of the implementation above is the "generic" list: each `N`-th
+ * system tick, *all* the long-range timers are walked through. If the
+ * application has many timers with long timeouts, this walk may take
+ * significant time, and interrupts are disabled during it.
+ *
+ * If the option `#TN_TIMER_WHEEL` is set, the "generic" list is replaced with
+ * a hierarchical timing wheel (again, the idea is taken from the Linux
+ * kernel). There are `L` levels (configured by `#TN_TIMER_WHEEL_LEVELS`),
+ * each of them consists of `N` lists. The level `0` is just the "tick" lists
+ * described above, each list of the level `1` covers `N` ticks, each list of
+ * the level `2` covers `N ^ 2` ticks, and so on.
+ *
+ * Each timer remembers the absolute tick count at which it expires. When the
+ * timer is started, it is added to the lowest level which covers its timeout,
+ * to the list which is selected by the appropriate bits of the expiration
+ * tick count. Timers which expire farther than `N ^ L` ticks are added to the
+ * farthest list of the top level. So, starting and cancelling the timer
+ * takes constant time.
+ *
+ * Each time the index of some level wraps around to `0`, the current list of
+ * the next level is "cascaded": all its timers are moved to the lower levels
+ * (or to the current list of the level `0`, which is fired right after that).
+ * This way, each timer is moved at most `(L - 1)` times during its lifetime
+ * (plus once per `N ^ L` ticks for very long timeouts), and the system tick
+ * never has to walk through timers which are far from expiration.
+ *
+ * Similarly to the "tick" lists, timers are never added to the list which is
+ * being cascaded at the moment, so interrupts are enabled for a short while
+ * after each moved timer, and cascading of a large list doesn't affect
+ * interrupt latency much.
+ *
+ * \section timers_dynamic_implementation Implementation of dynamic timers
+ *
+ * When `#TN_DYNAMIC_TICK` is set, the kernel needs to know the timer that
+ * expires first, in order to schedule the next tick (see \ref
+ * time_ticks__dynamic_tick). Active timers are kept in the pairing heap: each
+ * timer contains pointers to its leftmost child and to its siblings, so the
+ * heap doesn't need any additional memory. The root of the heap is the timer
+ * with minimum time left.
+ *
+ * Since all the timers are "moving" towards expiration with the same speed,
+ * the relative order of them never changes, and the heap stays valid even
+ * though the keys (time left) are computed from the current tick count.
+ *
+ * Consequently:
+ *
+ * - Starting the timer takes constant time;
+ * - Cancelling the timer (and also removing expired timer when it fires)
+ *   takes amortized `O(log n)` time;
+ * - Finding out when the next tick is needed takes constant time.
  */
 
 
@@ -190,6 +268,9 @@ struct TN_Timer;
  *   - It's legal to call interrupt services from this function;
  *   - The function should be as fast as possible.
  *
+ * If the timer task is used, the function is called from it instead, see
+ * \ref timers_task.
+ *
  * @param timer
  *    Timer that caused function to be called
  * @param p_user_data
@@ -228,15 +309,59 @@ struct TN_Timer {
    /// Timeout value (it is set just once, and stays unchanged until timer is
    /// expired, cancelled or restarted)
    TN_TickCnt timeout;
+   ///
+   /// $(TN_IF_ONLY_DYNAMIC_TICK_SET)
+   ///
+   /// Parent (if the timer is the leftmost child) or previous sibling
+   /// in the heap of active timers, see \ref timers_dynamic_implementation
+   struct TN_Timer *heap_prev;
+   ///
+   /// $(TN_IF_ONLY_DYNAMIC_TICK_SET)
+   ///
+   /// Next sibling in the heap of active timers
+   struct TN_Timer *heap_next;
+   ///
+   /// $(TN_IF_ONLY_DYNAMIC_TICK_SET)
+   ///
+   /// Leftmost child in the heap of active timers
+   struct TN_Timer *heap_child;
 #endif
 
-#if !TN_DYNAMIC_TICK || defined(DOXYGEN_ACTIVE)
+#if (!TN_DYNAMIC_TICK && !TN_TIMER_WHEEL) || defined(DOXYGEN_ACTIVE)
    ///
    /// $(TN_IF_ONLY_DYNAMIC_TICK_NOT_SET)
    ///
+   /// <i>Used if only `#TN_TIMER_WHEEL` is <B>not set</B></i>.
+   ///
    /// Current (left) timeout value
    TN_TickCnt timeout_cur;
 #endif
+
+#if (!TN_DYNAMIC_TICK && TN_TIMER_WHEEL) || defined(DOXYGEN_ACTIVE)
+   ///
+   /// $(TN_IF_ONLY_DYNAMIC_TICK_NOT_SET)
+   ///
+   /// <i>Used if only `#TN_TIMER_WHEEL` is <B>set</B></i>.
+   ///
+   /// System tick count value at which timer expires
+   TN_TickCnt expire_tick_cnt;
+#endif
+
+#if TN_TIMER_TASK || defined(DOXYGEN_ACTIVE)
+   ///
+   /// <i>Used if only `#TN_TIMER_TASK` is <B>set</B></i>.
+   ///
+   /// A list item to be included in the queue of expired timers whose
+   /// callbacks are yet to be called by the timer task
+   struct TN_ListItem fired_queue;
+   ///
+   /// <i>Used if only `#TN_TIMER_TASK` is <B>set</B></i>.
+   ///
+   /// Whether the callback should be called from the timer task (when it's
+   /// running): it is set for timers created by `tn_timer_create()`, and
+   /// cleared for kernel-internal ones.
+   TN_BOOL deferred;
+#endif
 };
 
 
@@ -366,6 +491,46 @@ enum TN_RCode tn_timer_delete(struct TN_Timer *timer);
  */
 enum TN_RCode tn_timer_start(struct TN_Timer *timer, TN_TickCnt timeout);
 
+/**
+ * The same as `tn_timer_start()`, but the timer is allowed to fire up to
+ * `slack` ticks later than `timeout`. It is useful for soft timeouts (such
+ * as housekeeping or retries) in the dynamic tick mode: the kernel picks
+ * the expiration time within the allowed window so that timers with
+ * overlapping windows are likely to expire at the same tick, and the
+ * system is woken up once for all of them instead of many times.
+ *
+ * The expiration time is chosen when the timer is started: it's the time
+ * within the window `[timeout, timeout + slack]` (counting from now) which
+ * is divisible by the largest power of two. Since all timers pick their
+ * times from the same grid, the more slack they have, the more likely they
+ * are coalesced. Timers started with zero slack (as well as by
+ * `tn_timer_start()`) keep exact deadlines.
+ *
+ * In the static tick mode, the system is woken up at each tick anyway, so
+ * `slack` is ignored, and the timer expires exactly after `timeout` ticks.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param timer
+ *    Timer to start
+ * @param timeout
+ *    Minimum number of system ticks after which timer should fire. The same
+ *    restrictions as for `tn_timer_start()` apply.
+ * @param slack
+ *    Maximum number of system ticks the timer is allowed to fire after
+ *    `timeout`; `timeout + slack` is limited by `#TN_WAIT_INFINITE - 1`.
+ *
+ * @return 
+ *    The same as for `tn_timer_start()`.
+ */
+enum TN_RCode tn_timer_start_slack(
+      struct TN_Timer  *timer,
+      TN_TickCnt        timeout,
+      TN_TickCnt        slack
+      );
+
 /**
  * If timer is active, cancel it. If timer is already inactive, nothing is
  * changed.
@@ -451,6 +616,48 @@ enum TN_RCode tn_timer_time_left(
       TN_TickCnt *p_time_left
       );
 
+#if TN_TIMER_TASK || defined(DOXYGEN_ACTIVE)
+/**
+ * Create and start the timer task: after that, callbacks of the timers
+ * created by `tn_timer_create()` are called from this task instead of the
+ * $(TN_SYS_TIMER_LINK) ISR, see \ref timers_task.
+ *
+ * Typically it is called from the callback `#TN_CBUserTaskCreate` given to
+ * `tn_sys_start()`, before any application timers fire.
+ *
+ * The timer task is the worker task of the internal work queue (see
+ * tn_workq.h): when timers expire, the only work item is posted there, and
+ * it calls the callbacks of all the expired timers.
+ *
+ * Available if only `#TN_TIMER_TASK` is non-zero.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_MAIN)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param priority
+ *    Priority of the timer task; typically it is the highest priority in
+ *    the system, so that callbacks are called soon after the timers expire
+ * @param task_stack_low_addr
+ *    Pointer to the stack for the timer task, see `tn_task_create()`
+ * @param task_stack_size
+ *    Size of the stack for the timer task, see `tn_task_create()`. Timer
+ *    callbacks run on this stack.
+ *
+ * @return
+ *    * `#TN_RC_OK` if the timer task was successfully created;
+ *    * `#TN_RC_WSTATE` if the timer task is already created;
+ *    * `#TN_RC_WCONTEXT` if called from wrong context;
+ *    * `#TN_RC_WPARAM` if wrong params were given (they are checked by
+ *      `tn_workq_create()`).
+ */
+enum TN_RCode tn_timer_task_create(
+      int                     priority,
+      TN_UWord               *task_stack_low_addr,
+      int                     task_stack_size
+      );
+#endif
+
 #ifdef __cplusplus
 }  /* extern "C" */
 #endif
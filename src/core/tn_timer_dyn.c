@@ -77,8 +77,15 @@ TN_CBTickCntGet        *_tn_cb_tick_cnt_get  = TN_NULL;
  ******************************************************************************/
 
 ///
-/// List of active non-expired timers. Timers are sorted in ascending order
-/// by the timeout value.
+/// Root of the heap of active non-expired timers: the timer with minimum
+/// time left (or `TN_NULL` if there are no active timers). For details, refer
+/// to \ref timers_dynamic_implementation
+static struct TN_Timer       *_timer_heap;
+
+///
+/// List of active non-expired timers (in no particular order); it
+/// contains the same timers as `_timer_heap`, and is needed in order to 
+/// make `_tn_timer_is_active()` work for timers in the heap.
 static struct TN_ListItem     _timer_list__gen;
 
 
@@ -93,14 +100,6 @@ static struct TN_ListItem     _timer_list__fire;
  *    DEFINITIONS
  ******************************************************************************/
 
-/**
- * Get pointer to `struct #TN_Task` by pointer to the `task_queue` member
- * of the `struct #TN_Task`.
- */
-#define _tn_get_timer_by_timer_queue(que)                               \
-   (que ? container_of(que, struct TN_Timer, timer_queue) : 0)
-
-
 
 
 
@@ -132,6 +131,150 @@ static TN_TickCnt _time_left_get(
    return time_left;
 }
 
+/**
+ * Returns whether the timer is in the heap `_timer_heap`.
+ */
+static TN_BOOL _heap_contains(struct TN_Timer *timer)
+{
+   return (timer == _timer_heap || timer->heap_prev != TN_NULL);
+}
+
+/**
+ * Meld two heaps: the root with larger time left becomes the leftmost child
+ * of the other one.
+ *
+ * @param a, b
+ *    Roots of the heaps to meld, any of them can be `TN_NULL`. Their
+ *    `heap_prev` and `heap_next` should be `TN_NULL`.
+ *
+ * @return
+ *    Root of the resulting heap.
+ */
+static struct TN_Timer *_heap_meld(
+      struct TN_Timer *a,
+      struct TN_Timer *b,
+      TN_TickCnt cur_sys_tick_cnt
+      )
+{
+   struct TN_Timer *root = a;
+
+   if (a == TN_NULL){
+      root = b;
+   } else if (b != TN_NULL){
+      struct TN_Timer *child = b;
+
+      if (     _time_left_get(b, cur_sys_tick_cnt)
+            <  _time_left_get(a, cur_sys_tick_cnt)
+         )
+      {
+         root = b;
+         child = a;
+      }
+
+      //-- put the child to the beginning of root's children list
+      child->heap_prev = root;
+      child->heap_next = root->heap_child;
+      if (root->heap_child != TN_NULL){
+         root->heap_child->heap_prev = child;
+      }
+      root->heap_child = child;
+   }
+
+   return root;
+}
+
+/**
+ * Merge the list of sibling heaps into a single heap, by the usual two-pass
+ * pairing: first, meld siblings by pairs from left to right, and then meld
+ * resulting heaps from right to left.
+ *
+ * @param first
+ *    The first heap in the list of siblings (can be `TN_NULL`)
+ *
+ * @return
+ *    Root of the resulting heap.
+ */
+static struct TN_Timer *_heap_merge_pairs(
+      struct TN_Timer *first,
+      TN_TickCnt cur_sys_tick_cnt
+      )
+{
+   struct TN_Timer *root = TN_NULL;
+
+   //-- stack of already paired heaps, linked through `heap_next`
+   struct TN_Timer *paired = TN_NULL;
+
+   //-- first pass: meld siblings by pairs, from left to right
+   while (first != TN_NULL){
+      struct TN_Timer *a = first;
+      struct TN_Timer *b = a->heap_next;
+
+      first = (b != TN_NULL) ? b->heap_next : TN_NULL;
+
+      a->heap_prev = a->heap_next = TN_NULL;
+      if (b != TN_NULL){
+         b->heap_prev = b->heap_next = TN_NULL;
+      }
+
+      a = _heap_meld(a, b, cur_sys_tick_cnt);
+      a->heap_next = paired;
+      paired = a;
+   }
+
+   //-- second pass: meld paired heaps, from right to left
+   while (paired != TN_NULL){
+      struct TN_Timer *a = paired;
+
+      paired = a->heap_next;
+      a->heap_next = TN_NULL;
+
+      root = _heap_meld(root, a, cur_sys_tick_cnt);
+   }
+
+   return root;
+}
+
+/**
+ * Add timer to the heap `_timer_heap`. Timer should not be in the heap yet.
+ */
+static void _heap_add(struct TN_Timer *timer, TN_TickCnt cur_sys_tick_cnt)
+{
+   timer->heap_prev = timer->heap_next = timer->heap_child = TN_NULL;
+
+   _timer_heap = _heap_meld(_timer_heap, timer, cur_sys_tick_cnt);
+}
+
+/**
+ * Remove timer from the heap `_timer_heap`. Timer should be in the heap.
+ */
+static void _heap_remove(struct TN_Timer *timer, TN_TickCnt cur_sys_tick_cnt)
+{
+   //-- merge the children of the timer being removed
+   struct TN_Timer *children = _heap_merge_pairs(
+         timer->heap_child, cur_sys_tick_cnt
+         );
+
+   if (timer == _timer_heap){
+      _timer_heap = children;
+   } else {
+      //-- detach timer from its siblings: `heap_prev` is either a parent
+      //   (if timer is the leftmost child) or the previous sibling.
+      if (timer->heap_prev->heap_child == timer){
+         timer->heap_prev->heap_child = timer->heap_next;
+      } else {
+         timer->heap_prev->heap_next = timer->heap_next;
+      }
+
+      if (timer->heap_next != TN_NULL){
+         timer->heap_next->heap_prev = timer->heap_prev;
+      }
+
+      _timer_heap = _heap_meld(_timer_heap, children, cur_sys_tick_cnt);
+   }
+
+   timer->heap_prev = timer->heap_next = timer->heap_child = TN_NULL;
+}
+
 /**
  * Find out when the kernel needs `tn_tick_int_processing()` to be called next
  * time, and eventually call application callback `_tn_cb_tick_schedule()` with
@@ -141,15 +284,9 @@ static void _next_tick_schedule(TN_TickCnt cur_sys_tick_cnt)
 {
    TN_TickCnt next_timeout;
 
-   if (!_tn_list_is_empty(&_timer_list__gen)){
-      //-- need to get first timer from the list and get its timeout
-      //   (this list is sorted, so, the first timer is the one with 
-      //   minimum timeout value)
-      struct TN_Timer *timer_next = _tn_get_timer_by_timer_queue(
-            _timer_list__gen.next
-            );
-
-      next_timeout = _time_left_get(timer_next, cur_sys_tick_cnt);
+   if (_timer_heap != TN_NULL){
+      //-- the root of the heap is the timer with minimum timeout value
+      next_timeout = _time_left_get(_timer_heap, cur_sys_tick_cnt);
    } else {
       //-- no timers are active, so, no ticks needed at all
       next_timeout = TN_WAIT_INFINITE;
@@ -161,11 +298,58 @@ static void _next_tick_schedule(TN_TickCnt cur_sys_tick_cnt)
 
 
 /**
- * Cancel the timer: the main thing is that timer is removed from the linked
- * list.
+ * Pick the timeout within the window `[timeout, timeout + slack]` so that
+ * the expiration time (`cur_sys_tick_cnt` plus timeout) is divisible by the
+ * largest power of two: since all timers pick their expiration times from
+ * the same grid, timers with overlapping windows are likely to get the same
+ * one, and they all are fired by the single call to
+ * `tn_tick_int_processing()`.
+ *
+ * The expiration time is found as follows: take the latest allowed time,
+ * find the highest bit in which it differs from the earliest one, and clear
+ * all the bits below it. The result is still within the window, and no
+ * other time in the window has more trailing zeros.
  */
-static void _timer_cancel(struct TN_Timer *timer)
+static TN_TickCnt _slack_apply(
+      TN_TickCnt timeout,
+      TN_TickCnt slack,
+      TN_TickCnt cur_sys_tick_cnt
+      )
 {
+   TN_TickCnt expire = cur_sys_tick_cnt + timeout;
+   TN_TickCnt expire_limit;
+   TN_TickCnt diff;
+   TN_TickCnt mask = 0;
+
+   //-- make sure the timeout doesn't reach TN_WAIT_INFINITE
+   if (slack > (TN_WAIT_INFINITE - 1) - timeout){
+      slack = (TN_WAIT_INFINITE - 1) - timeout;
+   }
+
+   expire_limit = expire + slack;
+   diff = expire ^ expire_limit;
+
+   //-- get the mask of bits below the highest differing one
+   while (diff > 1){
+      diff >>= 1;
+      mask = (mask << 1) | 1;
+   }
+
+   expire_limit &= ~mask;
+
+   return expire_limit - cur_sys_tick_cnt;
+}
+
+/**
+ * Cancel the timer: the main thing is that timer is removed from the heap
+ * (if it is there) and from the linked list.
+ */
+static void _timer_cancel(struct TN_Timer *timer, TN_TickCnt cur_sys_tick_cnt)
+{
+   if (_heap_contains(timer)){
+      _heap_remove(timer, cur_sys_tick_cnt);
+   }
+
    //-- reset timeout and start_tick_cnt to zero (but this is actually not
    //   necessary)
    timer->timeout = 0;
@@ -215,6 +399,9 @@ void _tn_timers_init(void)
       _TN_FATAL_ERROR("");
    }
 
+   //-- reset timers heap
+   _timer_heap = TN_NULL;
+
    //-- reset "generic" timers list
    _tn_list_reset(&_timer_list__gen);
 
@@ -239,30 +426,24 @@ void _tn_timers_tick_proceed(TN_UWord TN_INTSAVE_VAR)
    //-- First of all, get current time
    TN_TickCnt cur_sys_tick_cnt = _tn_timer_sys_time_get();
 
-   //-- Now, walk through timers list from start until we get non-expired timer
-   //   (timers list is sorted)
+   //-- Now, take timers from the root of the heap until we get non-expired
+   //   timer (the root is always the timer with minimum time left)
    {
       struct TN_Timer *timer;
-      struct TN_Timer *tmp_timer;
 
-      _tn_list_for_each_entry_safe(
-            timer, struct TN_Timer, tmp_timer,
-            &_timer_list__gen, timer_queue
+      while (
+            (timer = _timer_heap) != TN_NULL
+            && _time_left_get(timer, cur_sys_tick_cnt) == 0
             )
       {
          //-- timeout value should never be TN_WAIT_INFINITE.
          _TN_BUG_ON(timer->timeout == TN_WAIT_INFINITE);
 
-         if (_time_left_get(timer, cur_sys_tick_cnt) == 0){
-            //-- it's time to fire the timer, so, move it to the "fire" list
-            //   `_timer_list__fire`
-            _tn_list_remove_entry(&(timer->timer_queue));
-            _tn_list_add_tail(&_timer_list__fire, &(timer->timer_queue));
-         } else {
-            //-- We've got non-expired timer, therefore there are no more
-            //   expired timers.
-            break;
-         }
+         //-- it's time to fire the timer, so, move it to the "fire" list
+         //   `_timer_list__fire`
+         _heap_remove(timer, cur_sys_tick_cnt);
+         _tn_list_remove_entry(&(timer->timer_queue));
+         _tn_list_add_tail(&_timer_list__fire, &(timer->timer_queue));
       }
    }
 
@@ -278,7 +459,7 @@ void _tn_timers_tick_proceed(TN_UWord TN_INTSAVE_VAR)
 
          //-- first of all, cancel timer *before* calling callback function, so
          //   that function could start it again if it wants to.
-         _timer_cancel(timer);
+         _timer_cancel(timer, cur_sys_tick_cnt);
 
          //-- call user callback function
          _tn_timer_callback_call(timer, TN_INTSAVE_VAR);
@@ -294,6 +475,18 @@ void _tn_timers_tick_proceed(TN_UWord TN_INTSAVE_VAR)
  * See comments in the _tn_timer.h file.
  */
 enum TN_RCode _tn_timer_start(struct TN_Timer *timer, TN_TickCnt timeout)
+{
+   return _tn_timer_start_slack(timer, timeout, 0);
+}
+
+/*
+ * See comments in the _tn_timer.h file.
+ */
+enum TN_RCode _tn_timer_start_slack(
+      struct TN_Timer  *timer,
+      TN_TickCnt        timeout,
+      TN_TickCnt        slack
+      )
 {
    enum TN_RCode rc = TN_RC_OK;
 
@@ -303,51 +496,27 @@ enum TN_RCode _tn_timer_start(struct TN_Timer *timer, TN_TickCnt timeout)
    if (timeout == TN_WAIT_INFINITE || timeout == 0){
       rc = TN_RC_WPARAM;
    } else {
-      //-- cancel the timer
-      _timer_cancel(timer);
-
-      //-- walk through active timers list and get the position at which
-      //   new timer should be placed.
-
       //-- First of all, get current time
       TN_TickCnt cur_sys_tick_cnt = _tn_timer_sys_time_get();
 
-      //-- Since timers list is sorted, we need to find the correct place
-      //   to put new timer at.
-      //
-      //   Initially, we set it to the head of the list, and then walk
-      //   through timers until we found needed place (or until list is over)
-      struct TN_ListItem *list_item = &_timer_list__gen;
-      {
-         struct TN_Timer *timer;
-         struct TN_Timer *tmp_timer;
-
-         _tn_list_for_each_entry_safe(
-               timer, struct TN_Timer, tmp_timer,
-               &_timer_list__gen, timer_queue
-               )
-         {
-            //-- timeout value should never be TN_WAIT_INFINITE.
-            _TN_BUG_ON(timer->timeout == TN_WAIT_INFINITE);
-
-            if (_time_left_get(timer, cur_sys_tick_cnt) < timeout){
-               //-- Probably this is the place for new timer..
-               list_item = &timer->timer_queue;
-            } else {
-               //-- Found timer with larger timeout than that of new timer.
-               //   So, list_item now contains the correct place for new timer.
-               break;
-            }
-         }
-      }
+      //-- cancel the timer
+      _timer_cancel(timer, cur_sys_tick_cnt);
 
-      //-- put timer object at the right position.
-      _tn_list_add_head(list_item, &(timer->timer_queue));
+      //-- if the timer may fire later, pick the time which other timers
+      //   are likely to fire at as well
+      if (slack != 0){
+         timeout = _slack_apply(timeout, slack, cur_sys_tick_cnt);
+      }
 
       //-- initialize timer with given timeout
       timer->timeout = timeout;
       timer->start_tick_cnt = cur_sys_tick_cnt;
 
+      //-- put timer to the heap (it should be done after timeout is set,
+      //   since it is used to find the place for the timer in the heap)
+      _heap_add(timer, cur_sys_tick_cnt);
+      _tn_list_add_tail(&_timer_list__gen, &(timer->timer_queue));
+
       //-- find out when `tn_tick_int_processing()` should be called next time,
       //   and tell that to application
       _next_tick_schedule(cur_sys_tick_cnt);
@@ -367,13 +536,15 @@ enum TN_RCode _tn_timer_cancel(struct TN_Timer *timer)
    _TN_BUG_ON( !TN_IS_INT_DISABLED() );
 
    if (_tn_timer_is_active(timer)){
+      //-- get current time
+      TN_TickCnt cur_sys_tick_cnt = _tn_timer_sys_time_get();
 
       //-- cancel the timer
-      _timer_cancel(timer);
+      _timer_cancel(timer, cur_sys_tick_cnt);
 
       //-- find out when `tn_tick_int_processing()` should be called next time,
       //   and tell that to application
-      _next_tick_schedule( _tn_timer_sys_time_get() );
+      _next_tick_schedule(cur_sys_tick_cnt);
    }
 
    return rc;
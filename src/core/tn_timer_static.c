@@ -54,7 +54,7 @@
 #include "tn_tasks.h"
 
 
-#if !TN_DYNAMIC_TICK
+#if !TN_DYNAMIC_TICK && !TN_TIMER_WHEEL
 
 
 
@@ -335,6 +335,6 @@ TN_TickCnt _tn_timer_time_left(struct TN_Timer *timer)
 }
 
 
-#endif // !TN_DYNAMIC_TICK
+#endif // !TN_DYNAMIC_TICK && !TN_TIMER_WHEEL
 
 
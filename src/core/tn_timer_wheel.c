@@ -0,0 +1,389 @@
+/*******************************************************************************
+ *
+ * TNeo: real-time kernel initially based on TNKernel
+ *
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
+ *
+ *    TNeo was born as a thorough review and re-implementation of
+ *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
+ *    as well as new features being added, and it is tested carefully with
+ *    unit-tests.
+ *
+ *    API is changed somewhat, so it's not 100% compatible with TNKernel,
+ *    hence the new name: TNeo.
+ *
+ *    Permission to use, copy, modify, and distribute this software in source
+ *    and binary forms and its documentation for any purpose and without fee
+ *    is hereby granted, provided that the above copyright notice appear
+ *    in all copies and that both that copyright notice and this permission
+ *    notice appear in supporting documentation.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE DMITRY FRANK AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DMITRY FRANK OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *    THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+/*******************************************************************************
+ *    INCLUDED FILES
+ ******************************************************************************/
+
+//-- common tnkernel headers
+#include "tn_common.h"
+#include "tn_sys.h"
+
+//-- internal tnkernel headers
+#include "_tn_timer.h"
+#include "_tn_list.h"
+
+
+//-- header of current module
+#include "tn_timer.h"
+
+//-- header of other needed modules
+#include "tn_tasks.h"
+
+
+#if !TN_DYNAMIC_TICK && TN_TIMER_WHEEL
+
+
+
+/*******************************************************************************
+ *    PROTECTED DATA
+ ******************************************************************************/
+
+//-- see comments in the file _tn_timer_static.h
+struct TN_ListItem _tn_timer_wheel[ TN_TIMER_WHEEL_LEVELS ][ TN_TICK_LISTS_CNT ];
+
+//-- see comments in the file _tn_timer_static.h
+volatile TN_TickCnt _tn_sys_time_count;
+
+
+
+
+/*******************************************************************************
+ *    DEFINITIONS
+ ******************************************************************************/
+
+#define TN_TICK_LISTS_MASK    (TN_TICK_LISTS_CNT - 1)
+
+//-- configuration check
+#if ((TN_TICK_LISTS_MASK & TN_TICK_LISTS_CNT) != 0)
+#  error TN_TICK_LISTS_CNT must be a power of two
+#endif
+
+#if (TN_TICK_LISTS_CNT < 2)
+#  error TN_TICK_LISTS_CNT must be >= 2
+#endif
+
+//-- See comments in tn_timer_static.c
+#if (TN_TICK_LISTS_CNT > 256)
+#  error TN_TICK_LISTS_CNT must be <= 256
+#endif
+
+#if (TN_TIMER_WHEEL_LEVELS < 2)
+#  error TN_TIMER_WHEEL_LEVELS must be >= 2
+#endif
+
+/**
+ * Number of bits of tick count that are covered by a single level of the
+ * wheel, i.e. `log2(TN_TICK_LISTS_CNT)`
+ */
+#if   (TN_TICK_LISTS_CNT == 2)
+#  define _WHEEL_LEVEL_BITS     1
+#elif (TN_TICK_LISTS_CNT == 4)
+#  define _WHEEL_LEVEL_BITS     2
+#elif (TN_TICK_LISTS_CNT == 8)
+#  define _WHEEL_LEVEL_BITS     3
+#elif (TN_TICK_LISTS_CNT == 16)
+#  define _WHEEL_LEVEL_BITS     4
+#elif (TN_TICK_LISTS_CNT == 32)
+#  define _WHEEL_LEVEL_BITS     5
+#elif (TN_TICK_LISTS_CNT == 64)
+#  define _WHEEL_LEVEL_BITS     6
+#elif (TN_TICK_LISTS_CNT == 128)
+#  define _WHEEL_LEVEL_BITS     7
+#elif (TN_TICK_LISTS_CNT == 256)
+#  define _WHEEL_LEVEL_BITS     8
+#endif
+
+//-- the whole range of the wheel should fit in 32-bit tick count,
+//   and we need one more bit for unambiguous arithmetic.
+//   (also, struct _TN_BuildCfg has just 5-bit field for the number of levels)
+#if ((_WHEEL_LEVEL_BITS * TN_TIMER_WHEEL_LEVELS) >= 32)
+#  error log2(TN_TICK_LISTS_CNT) * TN_TIMER_WHEEL_LEVELS must be < 32
+#endif
+
+/**
+ * Number of ticks covered by the levels from 0 to `level` inclusive
+ */
+#define _WHEEL_LEVEL_SPAN(level)                                              \
+   ((TN_TickCnt)1 << (_WHEEL_LEVEL_BITS * ((level) + 1)))
+
+/**
+ * Total number of ticks covered by the wheel
+ */
+#define _WHEEL_SPAN                                                           \
+   _WHEEL_LEVEL_SPAN(TN_TIMER_WHEEL_LEVELS - 1)
+
+/**
+ * Return index of the list in the given level of the wheel, based on
+ * given tick count.
+ */
+#define _WHEEL_LIST_INDEX(level, tick_cnt)                                    \
+   (((TN_TickCnt)(tick_cnt) >> (_WHEEL_LEVEL_BITS * (level)))                 \
+    & TN_TICK_LISTS_MASK)
+
+
+
+
+/*******************************************************************************
+ *    PRIVATE FUNCTIONS
+ ******************************************************************************/
+
+/**
+ * Add timer to the appropriate list of the wheel, depending on its
+ * `expire_tick_cnt` and current system tick count.
+ *
+ * Note that `expire_tick_cnt` may be equal to current system tick count: it
+ * happens when timer is moved from the upper level by `_wheel_cascade()`, and
+ * then timer goes to the current list of level 0, which is going to be fired
+ * right after cascading is done.
+ */
+static void _wheel_add(struct TN_Timer *timer)
+{
+   TN_TickCnt cur_tick_cnt = _tn_sys_time_count;
+   TN_TickCnt expire_tick_cnt = timer->expire_tick_cnt;
+   TN_TickCnt timeout = expire_tick_cnt - cur_tick_cnt;
+   int level;
+
+   if (timeout >= _WHEEL_SPAN){
+      //-- the timer is too far in the future: put it to the farthest list
+      //   of the top level. When this list is cascaded, the timer will be
+      //   re-added by its real expiration tick count.
+      level = TN_TIMER_WHEEL_LEVELS - 1;
+      expire_tick_cnt = cur_tick_cnt + _WHEEL_SPAN - 1;
+   } else {
+      //-- find the lowest level that covers the timeout
+      for (level = 0; timeout >= _WHEEL_LEVEL_SPAN(level); level++){
+         //-- nothing to do here
+      }
+   }
+
+   _tn_list_add_tail(
+         &_tn_timer_wheel[ level ][ _WHEEL_LIST_INDEX(level, expire_tick_cnt) ],
+         &(timer->timer_queue)
+         );
+}
+
+/**
+ * Move all the timers from the current list of the given level to the lower
+ * levels.
+ *
+ * Interrupts are enabled for a short while after each moved timer, so that
+ * interrupts aren't disabled for too long if the list is large. It is safe,
+ * because timers can't be added to the list which is being cascaded (see
+ * details in the tn_timer.h file), although they can be removed from it.
+ *
+ * @param level
+ *    Level of the wheel, should be >= 1
+ * @param TN_INTSAVE_VAR
+ *    Status of interrupts, used by `TN_INT_IDIS_SAVE()` and friends.
+ */
+static void _wheel_cascade(int level, TN_UWord TN_INTSAVE_VAR)
+{
+   struct TN_Timer *timer;
+
+   struct TN_ListItem *p_list =
+      &_tn_timer_wheel[ level ][ _WHEEL_LIST_INDEX(level, _tn_sys_time_count) ];
+
+   while (!_tn_list_is_empty(p_list)){
+      timer = _tn_list_first_entry(p_list, struct TN_Timer, timer_queue);
+
+      _tn_list_remove_entry(&(timer->timer_queue));
+      _wheel_add(timer);
+
+      //-- let pending interrupts to be served
+      TN_INT_IRESTORE();
+      TN_INT_IDIS_SAVE();
+   }
+}
+
+
+
+
+/*******************************************************************************
+ *    PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+
+
+/*******************************************************************************
+ *    PROTECTED FUNCTIONS
+ ******************************************************************************/
+
+/**
+ * See comments in the _tn_timer.h file.
+ */
+void _tn_timers_init(void)
+{
+   int level;
+   int i;
+
+   //-- reset system time
+   _tn_sys_time_count = 0;
+
+   //-- reset all the lists of the wheel
+   for (level = 0; level < TN_TIMER_WHEEL_LEVELS; level++){
+      for (i = 0; i < TN_TICK_LISTS_CNT; i++){
+         _tn_list_reset(&_tn_timer_wheel[ level ][ i ]);
+      }
+   }
+}
+
+/**
+ * See comments in the _tn_timer.h file.
+ */
+void _tn_timers_tick_proceed(TN_UWord TN_INTSAVE_VAR)
+{
+   int level;
+
+   //-- first of all, increment system timer
+   _tn_sys_time_count++;
+
+   //-- interrupts should be disabled here
+   _TN_BUG_ON( !TN_IS_INT_DISABLED() );
+
+   //-- each time the index of some level wraps around to 0, the current
+   //   list of the next level should be cascaded to the lower levels.
+   //   So, level 1 is cascaded each TN_TICK_LISTS_CNT-th system tick,
+   //   level 2 is cascaded each (TN_TICK_LISTS_CNT ^ 2)-th system tick, etc.
+   for (
+         level = 1;
+         (
+          level < TN_TIMER_WHEEL_LEVELS
+          && _WHEEL_LIST_INDEX(level - 1, _tn_sys_time_count) == 0
+         );
+         level++
+       )
+   {
+      _wheel_cascade(level, TN_INTSAVE_VAR);
+   }
+
+   //-- it happens every system tick:
+   //   we should walk through all the timers in the current list of level 0,
+   //   and fire them all, unconditionally.
+
+   //-- handle current list of level 0 {{{
+   {
+      struct TN_Timer *timer;
+
+      struct TN_ListItem *p_cur_timer_list =
+         &_tn_timer_wheel[ 0 ][ _WHEEL_LIST_INDEX(0, _tn_sys_time_count) ];
+
+      //-- NOTE that we shouldn't use iterators like
+      //   `_tn_list_for_each_entry_safe()` here, because timers can be
+      //   removed from the list while we are iterating through it:
+      //   this may happen if user-provided function cancels timer which
+      //   is in the same list.
+      //
+      //   Although timers could be removed from the list, note that
+      //   new timer can't be added to it (because timeout 0 is disallowed),
+      //   see implementation details in the tn_timer.h file
+      while (!_tn_list_is_empty(p_cur_timer_list)){
+         timer = _tn_list_first_entry(
+               p_cur_timer_list, struct TN_Timer, timer_queue
+               );
+
+         //-- first of all, cancel timer, so that
+         //   callback function could start it again if it wants to.
+         _tn_timer_cancel(timer);
+
+         //-- call user callback function
+         _tn_timer_callback_call(timer, TN_INTSAVE_VAR);
+      }
+
+      _TN_BUG_ON( !_tn_list_is_empty(p_cur_timer_list) );
+   }
+   // }}}
+}
+
+/**
+ * See comments in the _tn_timer.h file.
+ */
+enum TN_RCode _tn_timer_start(struct TN_Timer *timer, TN_TickCnt timeout)
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   //-- interrupts should be disabled here
+   _TN_BUG_ON( !TN_IS_INT_DISABLED() );
+
+   if (timeout == TN_WAIT_INFINITE || timeout == 0){
+      rc = TN_RC_WPARAM;
+   } else {
+
+      //-- if timer is active, cancel it first
+      if ((rc = _tn_timer_cancel(timer)) == TN_RC_OK){
+         timer->expire_tick_cnt = _tn_sys_time_count + timeout;
+         _wheel_add(timer);
+      }
+   }
+
+   return rc;
+}
+
+/**
+ * See comments in the _tn_timer.h file.
+ */
+enum TN_RCode _tn_timer_cancel(struct TN_Timer *timer)
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   //-- interrupts should be disabled here
+   _TN_BUG_ON( !TN_IS_INT_DISABLED() );
+
+   if (_tn_timer_is_active(timer)){
+      //-- remove entry from timer queue
+      _tn_list_remove_entry(&(timer->timer_queue));
+
+      //-- reset the list
+      _tn_list_reset(&(timer->timer_queue));
+   }
+
+   return rc;
+}
+
+/**
+ * See comments in the _tn_timer.h file.
+ */
+TN_TickCnt _tn_timer_time_left(struct TN_Timer *timer)
+{
+   TN_TickCnt time_left = TN_WAIT_INFINITE;
+
+   //-- interrupts should be disabled here
+   _TN_BUG_ON( !TN_IS_INT_DISABLED() );
+
+   if (_tn_timer_is_active(timer)){
+      //-- NOTE: it may be 0 if the timer is going to be fired right now
+      //   (i.e. from the timer callback of another timer which is in the
+      //   same list)
+      time_left = timer->expire_tick_cnt - _tn_sys_time_count;
+   }
+
+   return time_left;
+}
+
+
+#endif // !TN_DYNAMIC_TICK && TN_TIMER_WHEEL
+
+
@@ -0,0 +1,287 @@
+/*******************************************************************************
+ *
+ * TNeo: real-time kernel initially based on TNKernel
+ *
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
+ *
+ *    TNeo was born as a thorough review and re-implementation of
+ *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
+ *    as well as new features being added, and it is tested carefully with
+ *    unit-tests.
+ *
+ *    API is changed somewhat, so it's not 100% compatible with TNKernel,
+ *    hence the new name: TNeo.
+ *
+ *    Permission to use, copy, modify, and distribute this software in source
+ *    and binary forms and its documentation for any purpose and without fee
+ *    is hereby granted, provided that the above copyright notice appear
+ *    in all copies and that both that copyright notice and this permission
+ *    notice appear in supporting documentation.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE DMITRY FRANK AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DMITRY FRANK OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *    THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+/*******************************************************************************
+ *    INCLUDED FILES
+ ******************************************************************************/
+
+//-- common tnkernel headers
+#include "tn_common.h"
+#include "tn_sys.h"
+
+//-- internal tnkernel headers
+#include "_tn_timer.h"
+
+
+//-- header of current module
+#include "_tn_trace.h"
+
+
+
+#if TN_TRACE
+
+/*******************************************************************************
+ *    PRIVATE DATA
+ ******************************************************************************/
+
+//-- ring buffer given to tn_trace_start(), or TN_NULL if recording
+//   was never started
+static struct TN_TraceRec    *_recs         = TN_NULL;
+static unsigned int           _recs_cnt     = 0;
+
+//-- timestamp callback given to tn_trace_start()
+static TN_CBTraceTimestamp   *_cb_timestamp = TN_NULL;
+
+//-- total number of records written / read since tn_trace_start().
+//   Index of the record in the ring is `(cnt % _recs_cnt)`.
+static unsigned long          _write_cnt    = 0;
+static unsigned long          _read_cnt     = 0;
+
+//-- whether recording is active
+static TN_BOOL                _active       = TN_FALSE;
+
+
+
+/*******************************************************************************
+ *    PRIVATE FUNCTIONS
+ ******************************************************************************/
+
+//-- Additional param checking {{{
+#if TN_CHECK_PARAM
+_TN_STATIC_INLINE enum TN_RCode _check_param_start(
+      const struct TN_TraceRec  *recs,
+      unsigned int               recs_cnt
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   if (recs == TN_NULL || recs_cnt == 0){
+      rc = TN_RC_WPARAM;
+   }
+
+   return rc;
+}
+
+#else
+#  define _check_param_start(recs, recs_cnt)    (TN_RC_OK)
+#endif
+// }}}
+
+/**
+ * Returns current timestamp.
+ *
+ * \attention Caller must disable interrupts.
+ */
+_TN_STATIC_INLINE TN_UWord _timestamp_get(void)
+{
+   TN_UWord ret;
+
+   if (_cb_timestamp != TN_NULL){
+      ret = _cb_timestamp();
+   } else {
+      ret = (TN_UWord)_tn_timer_sys_time_get();
+   }
+
+   return ret;
+}
+
+
+
+
+/*******************************************************************************
+ *    PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+/*
+ * See comments in the header file (tn_trace.h)
+ */
+enum TN_RCode tn_trace_start(
+      struct TN_TraceRec     *recs,
+      unsigned int            recs_cnt,
+      TN_CBTraceTimestamp    *cb_timestamp
+      )
+{
+   enum TN_RCode rc = _check_param_start(recs, recs_cnt);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else {
+      unsigned int i;
+      TN_INTSAVE_DATA;
+
+      //-- stop recording (if it is active) while we're preparing the buffer
+      TN_INT_DIS_SAVE();
+      _active = TN_FALSE;
+      TN_INT_RESTORE();
+
+      //-- mark all the records as never written, so that the dump of the
+      //   buffer can be decoded even without knowing the write count
+      for (i = 0; i < recs_cnt; i++){
+         recs[i].event = TN_TRACE_EV_NONE;
+      }
+
+      TN_INT_DIS_SAVE();
+
+      _recs          = recs;
+      _recs_cnt      = recs_cnt;
+      _cb_timestamp  = cb_timestamp;
+      _write_cnt     = 0;
+      _read_cnt      = 0;
+      _active        = TN_TRUE;
+
+      TN_INT_RESTORE();
+   }
+
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_trace.h)
+ */
+void tn_trace_stop(void)
+{
+   TN_INTSAVE_DATA;
+
+   TN_INT_DIS_SAVE();
+   _active = TN_FALSE;
+   TN_INT_RESTORE();
+}
+
+/*
+ * See comments in the header file (tn_trace.h)
+ */
+unsigned int tn_trace_read(
+      struct TN_TraceRec     *dst,
+      unsigned int            max_cnt,
+      unsigned long          *p_lost_cnt
+      )
+{
+   unsigned int cnt = 0;
+   unsigned long lost_cnt = 0;
+   TN_INTSAVE_DATA;
+
+   if (dst != TN_NULL){
+      //-- copy records one by one, so that interrupts are disabled
+      //   for a short time only
+      while (cnt < max_cnt){
+         TN_BOOL copied = TN_FALSE;
+
+         TN_INT_DIS_SAVE();
+
+         if (_recs != TN_NULL){
+            //-- if the writer has overtaken the reader, skip records
+            //   that were overwritten
+            if ((_write_cnt - _read_cnt) > _recs_cnt){
+               lost_cnt += (_write_cnt - _read_cnt) - _recs_cnt;
+               _read_cnt = _write_cnt - _recs_cnt;
+            }
+
+            if (_read_cnt != _write_cnt){
+               dst[cnt] = _recs[_read_cnt % _recs_cnt];
+               _read_cnt++;
+               copied = TN_TRUE;
+            }
+         }
+
+         TN_INT_RESTORE();
+
+         if (!copied){
+            //-- no more records
+            break;
+         }
+
+         cnt++;
+      }
+   }
+
+   if (p_lost_cnt != TN_NULL){
+      *p_lost_cnt = lost_cnt;
+   }
+
+   return cnt;
+}
+
+/*
+ * See comments in the header file (tn_trace.h)
+ */
+unsigned long tn_trace_write_cnt_get(void)
+{
+   unsigned long ret;
+   TN_INTSAVE_DATA;
+
+   TN_INT_DIS_SAVE();
+   ret = _write_cnt;
+   TN_INT_RESTORE();
+
+   return ret;
+}
+
+
+
+
+/*******************************************************************************
+ *    PROTECTED FUNCTIONS
+ ******************************************************************************/
+
+/**
+ * See comments in the file _tn_trace.h
+ */
+void _tn_trace_rec(enum TN_TraceEvent event, const void *p_obj, int arg)
+{
+   TN_INTSAVE_DATA;
+
+   TN_INT_DIS_SAVE();
+
+   if (_active){
+      struct TN_TraceRec *rec = &_recs[_write_cnt % _recs_cnt];
+
+      rec->timestamp = _timestamp_get();
+      rec->obj       = (TN_UIntPtr)p_obj;
+      rec->event     = (unsigned char)event;
+      rec->arg       = (short)arg;
+
+      if (tn_is_isr_context()){
+         rec->event |= TN_TRACE_EV_FLAG_ISR;
+      }
+
+      _write_cnt++;
+   }
+
+   TN_INT_RESTORE();
+}
+
+#endif //-- TN_TRACE
+
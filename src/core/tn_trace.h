@@ -0,0 +1,470 @@
+/*******************************************************************************
+ *
+ * TNeo: real-time kernel initially based on TNKernel
+ *
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
+ *
+ *    TNeo was born as a thorough review and re-implementation of
+ *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
+ *    as well as new features being added, and it is tested carefully with
+ *    unit-tests.
+ *
+ *    API is changed somewhat, so it's not 100% compatible with TNKernel,
+ *    hence the new name: TNeo.
+ *
+ *    Permission to use, copy, modify, and distribute this software in source
+ *    and binary forms and its documentation for any purpose and without fee
+ *    is hereby granted, provided that the above copyright notice appear
+ *    in all copies and that both that copyright notice and this permission
+ *    notice appear in supporting documentation.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE DMITRY FRANK AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DMITRY FRANK OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *    THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+/**
+ * \file
+ *
+ * Kernel event trace recorder.
+ *
+ * When `#TN_TRACE` is non-zero, the kernel records what happens in the
+ * system: context switches, task state transitions (start and end of
+ * waiting, suspending, activation, termination) and operations on the kernel
+ * objects (creating, deleting, signaling, waiting, sending, receiving, etc).
+ * Each event is stored as the compact binary record `struct #TN_TraceRec`
+ * in the RAM ring buffer provided by the application via `tn_trace_start()`.
+ * When the buffer is full, the oldest records are overwritten.
+ *
+ * Recording never blocks and never waits for anything: it just stores a few
+ * words with interrupts disabled (most of the hooks are called from the
+ * kernel critical sections anyway). Each record is timestamped by the
+ * application-provided callback (typically, it reads some free-running
+ * hardware timer), or, if it isn't given, by the system tick count.
+ *
+ * Records can be fetched in two ways:
+ *
+ * - Streaming: some low-priority task calls `tn_trace_read()` periodically,
+ *   and sends the records to the host (say, via UART), as they are in
+ *   memory;
+ * - Post-mortem: the whole buffer is dumped by the debugger, along with the
+ *   value returned by `tn_trace_write_cnt_get()` (it is needed to find the
+ *   oldest record in the ring).
+ *
+ * The host-side decoder `stuff/tntrace/tntrace_decode.py` parses these
+ * records, and prints the events along with per-task timelines: when each
+ * task ran, what it waited for, for how long, and who woke it up.
+ *
+ * \code{.c}
+ *     static struct TN_TraceRec trace_recs[256];
+ *
+ *     static TN_UWord trace_timestamp(void)
+ *     {
+ *        return MY_FREE_RUNNING_TIMER;
+ *     }
+ *
+ *     //-- somewhere at the application startup
+ *     tn_trace_start(trace_recs, 256, trace_timestamp);
+ * \endcode
+ *
+ * Trace recorder is available if only `#TN_TRACE` is non-zero.
+ */
+
+#ifndef _TN_TRACE_H
+#define _TN_TRACE_H
+
+/*******************************************************************************
+ *    INCLUDED FILES
+ ******************************************************************************/
+
+#include "tn_common.h"
+#include "../arch/tn_arch.h"
+
+
+
+#ifdef __cplusplus
+extern "C"  {  /*}*/
+#endif
+
+/*******************************************************************************
+ *    PUBLIC TYPES
+ ******************************************************************************/
+
+/**
+ * Trace event code, stored in the `event` field of `struct #TN_TraceRec`.
+ *
+ * Values are part of the binary format (the host decoder depends on them),
+ * so they are given explicitly and should never be changed.
+ *
+ * Unless stated otherwise, `obj` of the record is the address of the object,
+ * and `arg` is the return code (`enum #TN_RCode`) of the operation. Events
+ * of the object operations are recorded when the operation returns, so, if
+ * the task had to wait, there are `#TN_TRACE_EV_TASK_WAIT` and
+ * `#TN_TRACE_EV_TASK_WAIT_COMPLETE` events before it.
+ */
+enum TN_TraceEvent {
+   ///
+   /// Never recorded: buffer slot that wasn't written yet
+   TN_TRACE_EV_NONE              = 0x00,
+
+   ///
+   /// Context switch; `obj`: task which is going to run
+   TN_TRACE_EV_CONTEXT_SWITCH    = 0x01,
+   ///
+   /// Task is created; `obj`: task, `arg`: base priority
+   TN_TRACE_EV_TASK_CREATE       = 0x02,
+   ///
+   /// Task is deleted; `obj`: task
+   TN_TRACE_EV_TASK_DELETE       = 0x03,
+   ///
+   /// Task is activated (it was dormant); `obj`: task
+   TN_TRACE_EV_TASK_ACTIVATE     = 0x04,
+   ///
+   /// Task is terminated (it becomes dormant); `obj`: task
+   TN_TRACE_EV_TASK_TERMINATE    = 0x05,
+   ///
+   /// Task starts waiting; `obj`: task,
+   /// `arg`: wait reason (`enum #TN_WaitReason`)
+   TN_TRACE_EV_TASK_WAIT         = 0x06,
+   ///
+   /// Task stops waiting; `obj`: task, `arg`: wait result (`enum #TN_RCode`)
+   TN_TRACE_EV_TASK_WAIT_COMPLETE = 0x07,
+   ///
+   /// Task is suspended; `obj`: task
+   TN_TRACE_EV_TASK_SUSPEND      = 0x08,
+   ///
+   /// Task is resumed; `obj`: task
+   TN_TRACE_EV_TASK_RESUME       = 0x09,
+   ///
+   /// Task notification is sent (`tn_task_notify()`, `tn_task_inotify()`);
+   /// `obj`: task which is notified
+   TN_TRACE_EV_TASK_NOTIFY       = 0x0a,
+   ///
+   /// Task notification is waited for (`tn_task_notify_wait()`); `obj`: task
+   /// which waits
+   TN_TRACE_EV_TASK_NOTIFY_WAIT  = 0x0b,
+
+   ///
+   /// Semaphore: `tn_sem_create()`
+   TN_TRACE_EV_SEM_CREATE        = 0x10,
+   ///
+   /// Semaphore: `tn_sem_delete()`
+   TN_TRACE_EV_SEM_DELETE        = 0x11,
+   ///
+   /// Semaphore: `tn_sem_signal()`, `tn_sem_isignal()`
+   TN_TRACE_EV_SEM_SIGNAL        = 0x12,
+   ///
+   /// Semaphore: `tn_sem_wait()` and friends
+   TN_TRACE_EV_SEM_WAIT          = 0x13,
+
+   ///
+   /// Mutex: `tn_mutex_create()`
+   TN_TRACE_EV_MUTEX_CREATE      = 0x14,
+   ///
+   /// Mutex: `tn_mutex_delete()`
+   TN_TRACE_EV_MUTEX_DELETE      = 0x15,
+   ///
+   /// Mutex: `tn_mutex_lock()`, `tn_mutex_lock_polling()`
+   TN_TRACE_EV_MUTEX_LOCK        = 0x16,
+   ///
+   /// Mutex: `tn_mutex_unlock()`
+   TN_TRACE_EV_MUTEX_UNLOCK      = 0x17,
+
+   ///
+   /// Data queue: `tn_queue_create()`
+   TN_TRACE_EV_QUEUE_CREATE      = 0x18,
+   ///
+   /// Data queue: `tn_queue_delete()`
+   TN_TRACE_EV_QUEUE_DELETE      = 0x19,
+   ///
+   /// Data queue: `tn_queue_send()` and friends
+   TN_TRACE_EV_QUEUE_SEND        = 0x1a,
+   ///
+   /// Data queue: `tn_queue_receive()` and friends
+   TN_TRACE_EV_QUEUE_RECEIVE     = 0x1b,
+
+   ///
+   /// Fixed memory pool: `tn_fmem_create()`
+   TN_TRACE_EV_FMEM_CREATE       = 0x1c,
+   ///
+   /// Fixed memory pool: `tn_fmem_delete()`
+   TN_TRACE_EV_FMEM_DELETE       = 0x1d,
+   ///
+   /// Fixed memory pool: `tn_fmem_get()` and friends
+   TN_TRACE_EV_FMEM_GET          = 0x1e,
+   ///
+   /// Fixed memory pool: `tn_fmem_release()`, `tn_fmem_irelease()`
+   TN_TRACE_EV_FMEM_RELEASE      = 0x1f,
+
+   ///
+   /// Event group: `tn_eventgrp_create()`, `tn_eventgrp_create_wattr()`
+   TN_TRACE_EV_EVENTGRP_CREATE   = 0x20,
+   ///
+   /// Event group: `tn_eventgrp_delete()`
+   TN_TRACE_EV_EVENTGRP_DELETE   = 0x21,
+   ///
+   /// Event group: `tn_eventgrp_modify()`, `tn_eventgrp_imodify()`
+   TN_TRACE_EV_EVENTGRP_MODIFY   = 0x22,
+   ///
+   /// Event group: `tn_eventgrp_wait()` and friends
+   TN_TRACE_EV_EVENTGRP_WAIT     = 0x23,
+
+   ///
+   /// Message buffer: `tn_msgbuf_create()`
+   TN_TRACE_EV_MSGBUF_CREATE     = 0x24,
+   ///
+   /// Message buffer: `tn_msgbuf_delete()`
+   TN_TRACE_EV_MSGBUF_DELETE     = 0x25,
+   ///
+   /// Message buffer: `tn_msgbuf_send()` and friends
+   TN_TRACE_EV_MSGBUF_SEND       = 0x26,
+   ///
+   /// Message buffer: `tn_msgbuf_receive()` and friends
+   TN_TRACE_EV_MSGBUF_RECEIVE    = 0x27,
+
+   ///
+   /// Exchange object: `tn_exch_create()`
+   TN_TRACE_EV_EXCH_CREATE       = 0x28,
+   ///
+   /// Exchange object: `tn_exch_delete()`
+   TN_TRACE_EV_EXCH_DELETE       = 0x29,
+   ///
+   /// Exchange object: `tn_exch_write()`
+   TN_TRACE_EV_EXCH_WRITE        = 0x2a,
+   ///
+   /// Exchange object: `tn_exch_read()`
+   TN_TRACE_EV_EXCH_READ         = 0x2b,
+
+   ///
+   /// Timer: `tn_timer_create()`
+   TN_TRACE_EV_TIMER_CREATE      = 0x2c,
+   ///
+   /// Timer: `tn_timer_delete()`
+   TN_TRACE_EV_TIMER_DELETE      = 0x2d,
+   ///
+   /// Timer: `tn_timer_start()`
+   TN_TRACE_EV_TIMER_START       = 0x2e,
+   ///
+   /// Timer: `tn_timer_cancel()`
+   TN_TRACE_EV_TIMER_CANCEL      = 0x2f,
+   ///
+   /// Timer fired: its callback is going to be called; `obj`: timer.
+   /// NOTE: it is recorded for the internal timers of tasks as well (they
+   /// are used for wait timeouts)
+   TN_TRACE_EV_TIMER_FIRE        = 0x30,
+
+   ///
+   /// Multi-object wait: `tn_multi_wait()` and friends; `obj`: array of
+   /// items
+   TN_TRACE_EV_MULTI_WAIT        = 0x31,
+
+   ///
+   /// Work queue: `tn_workq_create()`
+   TN_TRACE_EV_WORKQ_CREATE      = 0x32,
+   ///
+   /// Work queue: `tn_workq_delete()`
+   TN_TRACE_EV_WORKQ_DELETE      = 0x33,
+   ///
+   /// Work queue: `tn_work_post()`, `tn_work_ipost()`
+   TN_TRACE_EV_WORK_POST         = 0x34,
+
+   ///
+   /// Multi-size-class memory pool: `tn_fmem_multi_create()`
+   TN_TRACE_EV_FMEM_MULTI_CREATE = 0x35,
+   ///
+   /// Multi-size-class memory pool: `tn_fmem_multi_delete()`
+   TN_TRACE_EV_FMEM_MULTI_DELETE = 0x36,
+   ///
+   /// Multi-size-class memory pool: `tn_fmem_multi_get()` and friends
+   TN_TRACE_EV_FMEM_MULTI_GET    = 0x37,
+   ///
+   /// Multi-size-class memory pool: `tn_fmem_multi_release()`,
+   /// `tn_fmem_multi_irelease()`
+   TN_TRACE_EV_FMEM_MULTI_RELEASE = 0x38,
+
+   ///
+   /// Heap: `tn_heap_create()`
+   TN_TRACE_EV_HEAP_CREATE       = 0x39,
+   ///
+   /// Heap: `tn_heap_delete()`
+   TN_TRACE_EV_HEAP_DELETE       = 0x3a,
+   ///
+   /// Heap: `tn_heap_alloc()` and friends
+   TN_TRACE_EV_HEAP_ALLOC        = 0x3b,
+   ///
+   /// Heap: `tn_heap_free()`, `tn_heap_ifree()`
+   TN_TRACE_EV_HEAP_FREE         = 0x3c,
+
+   ///
+   /// Buffer: `tn_buf_alloc()`, `tn_buf_ialloc()`
+   TN_TRACE_EV_BUF_ALLOC         = 0x3d,
+   ///
+   /// Buffer: `tn_buf_ref()`
+   TN_TRACE_EV_BUF_REF           = 0x3e,
+   ///
+   /// Buffer: `tn_buf_unref()`, `tn_buf_iunref()`
+   TN_TRACE_EV_BUF_UNREF         = 0x3f,
+};
+
+/**
+ * Flag which is ORed with the event code if the event was recorded from
+ * the ISR context. Otherwise, the event was recorded by the task which was
+ * running at the moment (see `#TN_TRACE_EV_CONTEXT_SWITCH`).
+ */
+#define  TN_TRACE_EV_FLAG_ISR       0x80
+
+/**
+ * Single trace record.
+ *
+ * The layout is the part of the binary format which is parsed by the host
+ * decoder: two words of `#TN_UWord` width (`timestamp` and `obj`), then
+ * one byte of `event`, one padding byte and two bytes of `arg`; the record
+ * is padded up to the word size, everything is in the target byte order.
+ */
+struct TN_TraceRec {
+   ///
+   /// Timestamp, as returned by the callback given to `tn_trace_start()`,
+   /// or the system tick count if no callback is given
+   TN_UWord timestamp;
+   ///
+   /// Address of the object involved (task, semaphore, etc)
+   TN_UIntPtr obj;
+   ///
+   /// Event code, see `enum #TN_TraceEvent` and `#TN_TRACE_EV_FLAG_ISR`
+   unsigned char event;
+   ///
+   /// Event-specific argument, see `enum #TN_TraceEvent`. It is a signed
+   /// 16-bit value, so that any return code, wait reason and priority fits
+   short arg;
+};
+
+/**
+ * Prototype for the timestamp callback, see `tn_trace_start()`.
+ *
+ * It is called with interrupts disabled, so it should just read some
+ * free-running counter.
+ */
+typedef TN_UWord (TN_CBTraceTimestamp)(void);
+
+
+
+
+/*******************************************************************************
+ *    PROTECTED GLOBAL DATA
+ ******************************************************************************/
+
+/*******************************************************************************
+ *    DEFINITIONS
+ ******************************************************************************/
+
+
+/*******************************************************************************
+ *    PUBLIC FUNCTION PROTOTYPES
+ ******************************************************************************/
+
+/**
+ * Start recording kernel events into the given ring buffer. If the recording
+ * is already active, it is restarted with the new buffer: all the previously
+ * recorded records are discarded.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_CALL_FROM_MAIN)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param recs
+ *    Array of records to be used as a ring buffer
+ * @param recs_cnt
+ *    Number of records in the `recs` array
+ * @param cb_timestamp
+ *    Callback which returns the timestamp for each record. If `TN_NULL`,
+ *    the system tick count is used.
+ *
+ * @return 
+ *    * `#TN_RC_OK` if recording is started;
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return code
+ *      is available: `#TN_RC_WPARAM`.
+ */
+enum TN_RCode tn_trace_start(
+      struct TN_TraceRec     *recs,
+      unsigned int            recs_cnt,
+      TN_CBTraceTimestamp    *cb_timestamp
+      );
+
+/**
+ * Stop recording kernel events. Records which are already in the buffer are
+ * kept intact, and can still be read by `tn_trace_read()`.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ */
+void tn_trace_stop(void);
+
+/**
+ * Copy the oldest records which weren't read yet to the `dst` array. It is
+ * intended to be called periodically by some low-priority task which
+ * sends the records to the host.
+ *
+ * If the writer has overtaken the reader (i.e. the buffer was overflowed
+ * since the previous call), the records that were overwritten are skipped,
+ * and their number is stored at `p_lost_cnt`.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param dst
+ *    Destination array
+ * @param max_cnt
+ *    Max number of records to copy
+ * @param p_lost_cnt
+ *    Pointer to the location at which the number of skipped records is
+ *    stored. May be `TN_NULL`.
+ *
+ * @return 
+ *    Number of records copied to `dst`.
+ */
+unsigned int tn_trace_read(
+      struct TN_TraceRec     *dst,
+      unsigned int            max_cnt,
+      unsigned long          *p_lost_cnt
+      );
+
+/**
+ * Returns the total number of records written since `tn_trace_start()`.
+ * Needed for decoding the post-mortem dump of the ring buffer: the record
+ * with the index `(write_cnt % recs_cnt)` is the oldest one, if only
+ * `write_cnt` is larger than `recs_cnt`.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_LEGEND_LINK)
+ */
+unsigned long tn_trace_write_cnt_get(void);
+
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+
+#endif // _TN_TRACE_H
+
+
+/*******************************************************************************
+ *    end of file
+ ******************************************************************************/
+
+
@@ -0,0 +1,401 @@
+/*******************************************************************************
+ *
+ * TNeo: real-time kernel initially based on TNKernel
+ *
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
+ *
+ *    TNeo was born as a thorough review and re-implementation of
+ *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
+ *    as well as new features being added, and it is tested carefully with
+ *    unit-tests.
+ *
+ *    API is changed somewhat, so it's not 100% compatible with TNKernel,
+ *    hence the new name: TNeo.
+ *
+ *    Permission to use, copy, modify, and distribute this software in source
+ *    and binary forms and its documentation for any purpose and without fee
+ *    is hereby granted, provided that the above copyright notice appear
+ *    in all copies and that both that copyright notice and this permission
+ *    notice appear in supporting documentation.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE DMITRY FRANK AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DMITRY FRANK OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *    THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+/*******************************************************************************
+ *    INCLUDED FILES
+ ******************************************************************************/
+
+#include "tn_common.h"
+#include "tn_sys.h"
+
+//-- internal tnkernel headers
+#include "_tn_sys.h"
+#include "_tn_tasks.h"
+#include "_tn_trace.h"
+
+
+#include "tn_workq.h"
+#include "_tn_workq.h"
+
+#include "tn_tasks.h"
+
+
+
+
+/*******************************************************************************
+ *    PRIVATE FUNCTIONS
+ ******************************************************************************/
+
+//-- Additional param checking {{{
+#if TN_CHECK_PARAM
+_TN_STATIC_INLINE enum TN_RCode _check_param_generic(
+      const struct TN_WorkQueue *workq
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   if (workq == TN_NULL){
+      rc = TN_RC_WPARAM;
+   } else if (!_tn_workq_is_valid(workq)){
+      rc = TN_RC_INVALID_OBJ;
+   }
+
+   return rc;
+}
+
+_TN_STATIC_INLINE enum TN_RCode _check_param_post(
+      const struct TN_WorkQueue *workq,
+      TN_WorkFunc *func
+      )
+{
+   enum TN_RCode rc = _check_param_generic(workq);
+
+   if (rc == TN_RC_OK && func == TN_NULL){
+      rc = TN_RC_WPARAM;
+   }
+
+   return rc;
+}
+
+#else
+#  define _check_param_generic(workq)           (TN_RC_OK)
+#  define _check_param_post(workq, func)        (TN_RC_OK)
+#endif
+// }}}
+
+/**
+ * Checks params for `tn_workq_create()`. Done regardless of `#TN_CHECK_PARAM`
+ * (just like `tn_task_create()` does), since creation isn't a hot path.
+ */
+static enum TN_RCode _check_param_create(
+      const struct TN_WorkQueue *workq,
+      const struct TN_WorkItem *items,
+      unsigned int items_cnt
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   if (workq == TN_NULL || items == TN_NULL || items_cnt == 0){
+      rc = TN_RC_WPARAM;
+   } else if (_tn_workq_is_valid(workq)){
+      rc = TN_RC_WPARAM;
+   }
+
+   return rc;
+}
+
+/**
+ * Put new item to the ring.
+ *
+ * \attention Caller must disable interrupts.
+ *
+ * @param p_was_empty
+ *    Location where to store whether the ring was empty before the item is
+ *    put (i.e. whether worker task should be woken up)
+ *
+ * @return
+ *    * `#TN_RC_OK` if item was put;
+ *    * `#TN_RC_OVERFLOW` if the ring is full.
+ */
+static enum TN_RCode _item_put(
+      struct TN_WorkQueue *workq,
+      TN_WorkFunc *func,
+      void *p_arg,
+      TN_BOOL *p_was_empty
+      )
+{
+   enum TN_RCode rc = TN_RC_OK;
+
+   if (workq->filled_items_cnt >= workq->items_cnt){
+      rc = TN_RC_OVERFLOW;
+   } else {
+      unsigned int head_idx = workq->tail_idx + workq->filled_items_cnt;
+
+      if (head_idx >= workq->items_cnt){
+         head_idx -= workq->items_cnt;
+      }
+
+      workq->items[head_idx].func  = func;
+      workq->items[head_idx].p_arg = p_arg;
+
+      *p_was_empty = (workq->filled_items_cnt == 0);
+      workq->filled_items_cnt++;
+   }
+
+   return rc;
+}
+
+/**
+ * Take the oldest item from the ring.
+ *
+ * \attention Caller must disable interrupts.
+ *
+ * @return
+ *    `TN_TRUE` if item was taken, `TN_FALSE` if the ring is empty.
+ */
+static TN_BOOL _item_take(
+      struct TN_WorkQueue *workq,
+      struct TN_WorkItem *p_item
+      )
+{
+   TN_BOOL taken = TN_FALSE;
+
+   if (workq->filled_items_cnt > 0){
+      *p_item = workq->items[workq->tail_idx];
+
+      workq->tail_idx++;
+      if (workq->tail_idx >= workq->items_cnt){
+         workq->tail_idx = 0;
+      }
+
+      workq->filled_items_cnt--;
+      taken = TN_TRUE;
+   }
+
+   return taken;
+}
+
+/**
+ * Body of the worker task: drains the ring (each item is taken in its own
+ * short critical section, and work function is called with interrupts
+ * enabled), and then waits for the notification which is sent when an
+ * item is posted to the empty ring.
+ *
+ * If an item is posted after the ring is found empty but before the task
+ * starts waiting, the notification is just left pending, so
+ * `tn_task_notify_wait()` returns immediately and nothing is missed.
+ */
+static void _worker_task_body(void *param)
+{
+   struct TN_WorkQueue *workq = (struct TN_WorkQueue *)param;
+   struct TN_WorkItem item;
+   TN_BOOL taken;
+
+   for (;;){
+      TN_INTSAVE_DATA;
+
+      TN_INT_DIS_SAVE();
+      taken = _item_take(workq, &item);
+      TN_INT_RESTORE();
+
+      if (taken){
+         item.func(item.p_arg);
+      } else {
+         tn_task_notify_wait((TN_UWord)~0, TN_NULL, TN_WAIT_INFINITE);
+      }
+   }
+}
+
+
+
+
+/*******************************************************************************
+ *    PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+/*
+ * See comments in the header file (tn_workq.h)
+ */
+enum TN_RCode tn_workq_create(
+      struct TN_WorkQueue    *workq,
+      struct TN_WorkItem     *items,
+      unsigned int            items_cnt,
+      int                     task_priority,
+      TN_UWord               *task_stack_low_addr,
+      int                     task_stack_size
+      )
+{
+   enum TN_RCode rc = _check_param_create(workq, items, items_cnt);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else {
+      workq->items            = items;
+      workq->items_cnt        = items_cnt;
+      workq->filled_items_cnt = 0;
+      workq->tail_idx         = 0;
+
+      //-- the worker task is started right away: it finds the ring empty
+      //   and waits for the notification
+      rc = tn_task_create_wname(
+            &(workq->task),
+            _worker_task_body,
+            task_priority,
+            task_stack_low_addr,
+            task_stack_size,
+            workq,
+            TN_TASK_CREATE_OPT_START,
+            "tn_workq"
+            );
+
+      if (rc == TN_RC_OK){
+         workq->id_workq = TN_ID_WORKQ;
+      }
+   }
+
+   _TN_TRACE(TN_TRACE_EV_WORKQ_CREATE, workq, rc);
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_workq.h)
+ */
+enum TN_RCode tn_workq_delete(struct TN_WorkQueue *workq)
+{
+   enum TN_RCode rc = _check_param_generic(workq);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_task_context()){
+      rc = TN_RC_WCONTEXT;
+   } else if ((rc = tn_task_terminate(&(workq->task))) != TN_RC_OK){
+      //-- worker task can't be terminated: most likely, we're called from
+      //   the work function (tn_task_terminate() returns TN_RC_WCONTEXT
+      //   then). Just return rc as it is.
+   } else {
+      rc = tn_task_delete(&(workq->task));
+
+      workq->id_workq = TN_ID_NONE; //-- work queue does not exist now
+   }
+
+   _TN_TRACE(TN_TRACE_EV_WORKQ_DELETE, workq, rc);
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_workq.h)
+ */
+enum TN_RCode tn_work_post(
+      struct TN_WorkQueue    *workq,
+      TN_WorkFunc            *func,
+      void                   *p_arg
+      )
+{
+   enum TN_RCode rc = _check_param_post(workq, func);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_task_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_BOOL was_empty = TN_FALSE;
+      TN_INTSAVE_DATA;
+
+      TN_INT_DIS_SAVE();
+      rc = _item_put(workq, func, p_arg, &was_empty);
+      TN_INT_RESTORE();
+
+      //-- worker task is awake (or the notification is pending already)
+      //   while the ring isn't empty, so wake it up on the first item only
+      if (rc == TN_RC_OK && was_empty){
+         rc = tn_task_notify(
+               &(workq->task), TN_TASK_NOTIFY_ACTION_SET_BITS, 1
+               );
+      }
+   }
+
+   _TN_TRACE(TN_TRACE_EV_WORK_POST, workq, rc);
+   return rc;
+}
+
+/*
+ * See comments in the header file (tn_workq.h)
+ */
+enum TN_RCode tn_work_ipost(
+      struct TN_WorkQueue    *workq,
+      TN_WorkFunc            *func,
+      void                   *p_arg
+      )
+{
+   enum TN_RCode rc = _check_param_post(workq, func);
+
+   if (rc != TN_RC_OK){
+      //-- just return rc as it is
+   } else if (!tn_is_isr_context()){
+      rc = TN_RC_WCONTEXT;
+   } else {
+      TN_BOOL was_empty = TN_FALSE;
+      TN_INTSAVE_DATA_INT;
+
+      TN_INT_IDIS_SAVE();
+      rc = _item_put(workq, func, p_arg, &was_empty);
+      TN_INT_IRESTORE();
+
+      //-- see comment in tn_work_post()
+      if (rc == TN_RC_OK && was_empty){
+         rc = tn_task_inotify(
+               &(workq->task), TN_TASK_NOTIFY_ACTION_SET_BITS, 1
+               );
+      }
+   }
+
+   _TN_TRACE(TN_TRACE_EV_WORK_POST, workq, rc);
+   return rc;
+}
+
+
+
+
+/*******************************************************************************
+ *    PROTECTED FUNCTIONS
+ ******************************************************************************/
+
+/*
+ * See comments in the header file (_tn_workq.h)
+ */
+enum TN_RCode _tn_work_post(
+      struct TN_WorkQueue    *workq,
+      TN_WorkFunc            *func,
+      void                   *p_arg
+      )
+{
+   TN_BOOL was_empty = TN_FALSE;
+   enum TN_RCode rc = _item_put(workq, func, p_arg, &was_empty);
+
+   //-- interrupts should be disabled here
+   _TN_BUG_ON( !TN_IS_INT_DISABLED() );
+
+   //-- see comment in tn_work_post()
+   if (rc == TN_RC_OK && was_empty){
+      rc = _tn_task_notify(
+            &(workq->task), TN_TASK_NOTIFY_ACTION_SET_BITS, 1
+            );
+   }
+
+   return rc;
+}
+
+
@@ -0,0 +1,296 @@
+/*******************************************************************************
+ *
+ * TNeo: real-time kernel initially based on TNKernel
+ *
+ *    TNKernel:                  copyright 2004, 2013 Yuri Tiomkin.
+ *    PIC32-specific routines:   copyright 2013, 2014 Anders Montonen.
+ *    TNeo:                      copyright 2014       Dmitry Frank.
+ *
+ *    TNeo was born as a thorough review and re-implementation of
+ *    TNKernel. The new kernel has well-formed code, inherited bugs are fixed
+ *    as well as new features being added, and it is tested carefully with
+ *    unit-tests.
+ *
+ *    API is changed somewhat, so it's not 100% compatible with TNKernel,
+ *    hence the new name: TNeo.
+ *
+ *    Permission to use, copy, modify, and distribute this software in source
+ *    and binary forms and its documentation for any purpose and without fee
+ *    is hereby granted, provided that the above copyright notice appear
+ *    in all copies and that both that copyright notice and this permission
+ *    notice appear in supporting documentation.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE DMITRY FRANK AND CONTRIBUTORS "AS IS"
+ *    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *    PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL DMITRY FRANK OR CONTRIBUTORS BE
+ *    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ *    THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************/
+
+/**
+ * \file
+ *
+ * Work queue: deferred execution of short jobs (work items) by the dedicated
+ * kernel task, typically used to move the bulk of interrupt handling out of
+ * the ISR.
+ *
+ * A work item is just a function and an argument for it. ISR posts it to
+ * the work queue by `tn_work_ipost()` (tasks may use `tn_work_post()`): the
+ * item is copied to the ring of items provided by the application, and
+ * that's all, so ISR body stays short. The worker task, which is created
+ * by the kernel when the work queue is created (with the priority and the
+ * stack given by the application), takes items from the ring one by one and
+ * calls their functions with interrupts enabled.
+ *
+ * Worker task is woken up only when the item is posted to the empty queue;
+ * when it's awake, it drains all the posted items in a batch, so that one
+ * context switch is paid for many items. Compared to the usual "ISR sends
+ * message to the data queue, task receives it" approach, there's no need
+ * for a separate task and queue for each driver.
+ *
+ * Posting never blocks: if the ring is full, `#TN_RC_OVERFLOW` is returned,
+ * and the item isn't posted. Size the ring for the worst burst of interrupts
+ * which may happen while the worker task is busy or preempted.
+ *
+ * Work functions are called from the worker task, so they may call any
+ * services allowed for tasks, but they should keep in mind that the next
+ * items are delayed until the current one returns; and they shouldn't wait
+ * for something for long, for the same reason.
+ *
+ * Typical usage:
+ *
+ * \code{.c}
+ *     #define MY_WORKQ_ITEMS_CNT    16
+ *     #define MY_WORKQ_STACK_SIZE   (TN_MIN_STACK_SIZE + 64)
+ *
+ *     static struct TN_WorkItem my_workq_items[ MY_WORKQ_ITEMS_CNT ];
+ *     TN_STACK_ARR_DEF(my_workq_stack, MY_WORKQ_STACK_SIZE);
+ *     static struct TN_WorkQueue my_workq;
+ *
+ *     static void uart_rx_work(void *p_arg)
+ *     {
+ *        //-- handle received byte (TN_UWord)p_arg with interrupts enabled
+ *     }
+ *
+ *     void uart_rx_isr(void)
+ *     {
+ *        tn_work_ipost(&my_workq, uart_rx_work, (void *)(TN_UWord)UART_RX);
+ *     }
+ *
+ *     //-- somewhere from the callback given to tn_sys_start()
+ *     void init_task_create(void)
+ *     {
+ *        tn_workq_create(
+ *              &my_workq, my_workq_items, MY_WORKQ_ITEMS_CNT,
+ *              1, my_workq_stack, MY_WORKQ_STACK_SIZE
+ *              );
+ *     }
+ * \endcode
+ */
+
+#ifndef _TN_WORKQ_H
+#define _TN_WORKQ_H
+
+/*******************************************************************************
+ *    INCLUDED FILES
+ ******************************************************************************/
+
+#include "tn_common.h"
+#include "tn_tasks.h"
+
+
+
+#ifdef __cplusplus
+extern "C"  {  /*}*/
+#endif
+
+/*******************************************************************************
+ *    PUBLIC TYPES
+ ******************************************************************************/
+
+/**
+ * Prototype for the work function, see `struct #TN_WorkItem`.
+ *
+ * @param p_arg
+ *    Argument given to `tn_work_post()` or `tn_work_ipost()`
+ */
+typedef void (TN_WorkFunc)(void *p_arg);
+
+/**
+ * Work item: the job posted to the work queue. Application provides the
+ * array of them to `tn_workq_create()`; it shouldn't touch its contents.
+ */
+struct TN_WorkItem {
+   ///
+   /// Function to call from the worker task
+   TN_WorkFunc   *func;
+   ///
+   /// Argument to give to `func`
+   void          *p_arg;
+};
+
+/**
+ * Work queue
+ */
+struct TN_WorkQueue {
+   ///
+   /// id for object validity verification.
+   /// This field is in the beginning of the structure to make it easier
+   /// to detect memory corruption.
+   enum TN_ObjId        id_workq;
+   ///
+   /// Ring of posted work items
+   struct TN_WorkItem  *items;
+   ///
+   /// Capacity of `items`
+   unsigned int         items_cnt;
+   ///
+   /// Count of posted items which aren't taken by the worker task yet
+   unsigned int         filled_items_cnt;
+   ///
+   /// Index of the item which will be taken next time
+   unsigned int         tail_idx;
+   ///
+   /// Worker task which calls work functions
+   struct TN_Task       task;
+};
+
+
+
+
+/*******************************************************************************
+ *    GLOBAL VARIABLES
+ ******************************************************************************/
+
+/*******************************************************************************
+ *    DEFINITIONS
+ ******************************************************************************/
+
+
+
+
+/*******************************************************************************
+ *    PUBLIC FUNCTION PROTOTYPES
+ ******************************************************************************/
+
+/**
+ * Construct work queue and start its worker task. `id_workq` member should
+ * not contain `#TN_ID_WORKQ`, otherwise, `#TN_RC_WPARAM` is returned.
+ *
+ * Like `tn_task_create()`, it can be called from the callback
+ * `#TN_CBUserTaskCreate` given to `tn_sys_start()`.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param workq
+ *    Pointer to already allocated `struct #TN_WorkQueue`
+ * @param items
+ *    Pointer to already allocated array of items
+ * @param items_cnt
+ *    Capacity of `items`: how many items may be posted and not yet taken
+ *    by the worker task
+ * @param task_priority
+ *    Priority of the worker task; typically it is one of the highest
+ *    priorities, so that work is done soon after the ISR
+ * @param task_stack_low_addr
+ *    Pointer to the stack for the worker task, see `tn_task_create()`
+ * @param task_stack_size
+ *    Size of the stack for the worker task, see `tn_task_create()`.
+ *    Work functions run on this stack.
+ *
+ * @return
+ *    * `#TN_RC_OK` if work queue was successfully created;
+ *    * `#TN_RC_WCONTEXT` if called from wrong context;
+ *    * `#TN_RC_WPARAM` if wrong params were given (the ones for the
+ *      worker task are checked by `tn_task_create()`)
+ */
+enum TN_RCode tn_workq_create(
+      struct TN_WorkQueue    *workq,
+      struct TN_WorkItem     *items,
+      unsigned int            items_cnt,
+      int                     task_priority,
+      TN_UWord               *task_stack_low_addr,
+      int                     task_stack_size
+      );
+
+/**
+ * Destruct work queue: stop and delete its worker task. Items which are
+ * posted but not yet taken by the worker task are discarded.
+ *
+ * It can't be called from the work function of the same work queue.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param workq      work queue to destruct
+ *
+ * @return
+ *    * `#TN_RC_OK` if work queue was successfully deleted;
+ *    * `#TN_RC_WCONTEXT` if called from wrong context (including the
+ *      worker task of the same work queue);
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_workq_delete(struct TN_WorkQueue *workq);
+
+/**
+ * Post work item to the work queue: `func(p_arg)` will be called from the
+ * worker task. Never waits.
+ *
+ * $(TN_CALL_FROM_TASK)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ *
+ * @param workq
+ *    Work queue to post item to
+ * @param func
+ *    Work function
+ * @param p_arg
+ *    Argument to give to `func`
+ *
+ * @return
+ *    * `#TN_RC_OK` if item was posted;
+ *    * `#TN_RC_OVERFLOW` if there's no free space in the ring of items;
+ *    * `#TN_RC_WCONTEXT` if called from wrong context;
+ *    * If `#TN_CHECK_PARAM` is non-zero, additional return codes
+ *      are available: `#TN_RC_WPARAM` and `#TN_RC_INVALID_OBJ`.
+ */
+enum TN_RCode tn_work_post(
+      struct TN_WorkQueue    *workq,
+      TN_WorkFunc            *func,
+      void                   *p_arg
+      );
+
+/**
+ * The same as `tn_work_post()`, but for using in the ISR.
+ *
+ * $(TN_CALL_FROM_ISR)
+ * $(TN_CAN_SWITCH_CONTEXT)
+ * $(TN_LEGEND_LINK)
+ */
+enum TN_RCode tn_work_ipost(
+      struct TN_WorkQueue    *workq,
+      TN_WorkFunc            *func,
+      void                   *p_arg
+      );
+
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif // _TN_WORKQ_H
+
+/*******************************************************************************
+ *    end of file
+ ******************************************************************************/
+
+
@@ -53,10 +53,20 @@
 #include "core/tn_dqueue.h"
 #include "core/tn_eventgrp.h"
 #include "core/tn_fmem.h"
+#include "core/tn_fmem_multi.h"
+#include "core/tn_heap.h"
+#include "core/tn_buf.h"
+#include "core/tn_msgbuf.h"
+#include "core/tn_multi_wait.h"
 #include "core/tn_mutex.h"
 #include "core/tn_sem.h"
 #include "core/tn_tasks.h"
 #include "core/tn_timer.h"
+#include "core/tn_trace.h"
+#include "core/tn_workq.h"
+#include "core/tn_exch.h"
+#include "core/tn_exch_link_queue.h"
+#include "core/tn_exch_link_eventgrp.h"
 
 
 //-- include old symbols for compatibility with old projects
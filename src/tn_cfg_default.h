@@ -110,14 +110,22 @@
 
 /**
  * Number of priorities that can be used by application, plus one for idle task
- * (which has the lowest priority). This value can't be higher than
- * architecture-dependent value `#TN_PRIORITIES_MAX_CNT`, which typically
+ * (which has the lowest priority). Typically, this value shouldn't be higher
+ * than architecture-dependent value `#TN_PRIORITIES_MAX_CNT`, which
  * equals to width of `int` type. So, for 32-bit systems, max number of
- * priorities is 32.
+ * priorities which fit in a single word is 32.
  *
  * But usually, application needs much less: I can imagine **at most** 4-5
  * different priorities, plus one for the idle task.
  *
+ * If your application really needs more priorities (say, you use
+ * rate-monotonic priority assignment for many tasks), the value can be up to
+ * `(#TN_PRIORITIES_MAX_CNT * #TN_INT_WIDTH)`: in this case, the kernel uses
+ * two-level bitmap of runnable priorities (groups of `#TN_INT_WIDTH`
+ * priorities, and priorities inside the group), so that finding the next task
+ * to run still takes constant time. It costs one more bit test per change
+ * of runnable tasks, and one word for each group.
+ *
  * Do note also that each possible priority level takes RAM: two pointers for
  * linked list and one `short` for time slice value, so on 32-bit system it
  * takes 10 bytes. So, with default value of 32 priorities available, it takes
@@ -192,6 +200,23 @@
 #  define TN_MUTEX_DEADLOCK_DETECT  1
 #endif
 
+/**
+ * Whether exchange objects API should be available, see \ref tn_exch.h.
+ */
+#ifndef TN_USE_EXCH
+#  define TN_USE_EXCH            1
+#endif
+
+/**
+ * Whether `tn_multi_wait()` should be available, see \ref tn_multi_wait.h.
+ * Each data queue, semaphore, fixed memory pool and event group gets one more
+ * list head (two pointers) then, and signalling / releasing these objects
+ * also checks tasks waiting by `tn_multi_wait()`. So, it's off by default.
+ */
+#ifndef TN_USE_MULTI_WAIT
+#  define TN_USE_MULTI_WAIT      0
+#endif
+
 /**
  *
  * <i>Takes effect if only `#TN_DYNAMIC_TICK` is <B>not set</B></i>.
@@ -213,6 +238,68 @@
 #  define TN_TICK_LISTS_CNT    8
 #endif
 
+/**
+ *
+ * <i>Takes effect if only `#TN_DYNAMIC_TICK` is <B>not set</B></i>.
+ *
+ * Whether the kernel should use hierarchical timing wheel instead of the
+ * "generic" list of timers. Refer to the \ref timers_wheel_implementation
+ * for details.
+ *
+ * With this option set, starting and cancelling the timer is O(1) no
+ * matter how many timers are active, and the system tick never has to walk
+ * through all the long-range timers: each timer is moved to the lower level
+ * at most `#TN_TIMER_WHEEL_LEVELS - 1` times during its lifetime.
+ *
+ * The cost is RAM: the wheel takes `#TN_TIMER_WHEEL_LEVELS` arrays of
+ * `#TN_TICK_LISTS_CNT` elements of `struct TN_ListItem`, and each timer
+ * keeps its absolute expiration tick count.
+ *
+ * If your application has a lot of timers with long timeouts, consider
+ * setting this option; otherwise, default value should work for you.
+ */
+#ifndef TN_TIMER_WHEEL
+#  define TN_TIMER_WHEEL       0
+#endif
+
+/**
+ *
+ * <i>Takes effect if only `#TN_DYNAMIC_TICK` is <B>not set</B> and
+ * `#TN_TIMER_WHEEL` is <B>set</B></i>.
+ *
+ * Number of levels of the timing wheel, minimum value: `2`. Each level
+ * consists of `#TN_TICK_LISTS_CNT` lists, so the wheel covers timeouts up to
+ * `TN_TICK_LISTS_CNT ^ TN_TIMER_WHEEL_LEVELS` system ticks directly; timers
+ * with larger timeouts are parked at the top level and re-inserted when
+ * reached.
+ *
+ * The total number of bits, i.e. `log2(TN_TICK_LISTS_CNT) *
+ * TN_TIMER_WHEEL_LEVELS`, must be less than 32.
+ */
+#ifndef TN_TIMER_WHEEL_LEVELS
+#  define TN_TIMER_WHEEL_LEVELS   4
+#endif
+
+/**
+ * Whether timer callbacks may be called from the timer task instead of the
+ * $(TN_SYS_TIMER_LINK) ISR. If it is non-zero, and the application has
+ * started the timer task by `tn_timer_task_create()`, then the timers
+ * created by `tn_timer_create()` are still expired in the ISR, but their
+ * callbacks are just queued there, and the timer task calls them later, in
+ * a batch. This way, a burst of expirations doesn't make the tick ISR
+ * longer; the price is the extra context switch and the stack of the timer
+ * task.
+ *
+ * Kernel-internal timers (such as timeouts of waiting tasks) are always
+ * handled right in the ISR.
+ *
+ * Enabling this option makes `struct #TN_Timer` bigger by a list item
+ * (two pointers) and a flag.
+ */
+#ifndef TN_TIMER_TASK
+#  define TN_TIMER_TASK        0
+#endif
+
 
 /**
  * API option for `MAKE_ALIG()` macro.
@@ -249,7 +336,11 @@
 /**
  * Whether profiler functionality should be enabled.
  * Enabling this option adds overhead to context switching and increases
- * the size of `#TN_Task` structure by about 20 bytes.
+ * the size of `#TN_Task` structure by about 30 bytes.
+ *
+ * By default, times are measured in system ticks; for finer resolution,
+ * provide high-resolution timestamp with
+ * `tn_callback_profiler_timestamp_set()`.
  *
  * @see `#TN_PROFILER_WAIT_TIME`
  * @see `#tn_task_profiler_timing_get()`
@@ -270,6 +361,40 @@
 #  define TN_PROFILER_WAIT_TIME  0
 #endif
 
+/**
+ * Whether kernel event trace recorder should be enabled. If it is non-zero,
+ * the kernel records context switches, task state transitions and object
+ * operations into the ring buffer given to `tn_trace_start()`, see
+ * \ref tn_trace.h.
+ *
+ * Enabling this option adds overhead to context switching and to every
+ * kernel service: each record is written with interrupts disabled for a
+ * short time, including the operations done by the lock-free fast paths of
+ * mutexes and semaphores.
+ */
+#ifndef TN_TRACE
+#  define TN_TRACE               0
+#endif
+
+/**
+ * Whether the kernel should measure how long it keeps interrupts disabled.
+ * If it is non-zero, each critical section of the kernel (the code between
+ * `TN_INT_DIS_SAVE()` and `TN_INT_RESTORE()`, and their ISR versions) is
+ * timestamped on entry and exit, and the longest one is remembered along
+ * with the place in the source code where it was entered and exited. Since
+ * interrupt latency is bounded by the longest critical section, it helps to
+ * find kernel paths which hurt ISR jitter. See
+ * `tn_callback_crit_sect_timestamp_set()` and `tn_sys_crit_sect_stat_get()`.
+ *
+ * Only the kernel critical sections are measured: the application code
+ * which uses `TN_INT_DIS_SAVE()` isn't affected. Measurement itself makes
+ * each critical section a bit longer, so this option is intended for
+ * debug builds.
+ */
+#ifndef TN_CRIT_SECT_MEASURE
+#  define TN_CRIT_SECT_MEASURE   0
+#endif
+
 /**
  * Whether interrupt stack space should be initialized with
  * `#TN_FILL_STACK_VAL` on system start. It is useful to disable this option if
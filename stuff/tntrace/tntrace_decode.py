@@ -0,0 +1,664 @@
+#!/usr/bin/env python3
+
+"""
+Decoder of the TNeo kernel event trace (see src/core/tn_trace.h).
+
+Reads binary records `struct TN_TraceRec`, as they are laid out in the
+target's memory, and prints:
+
+  - the list of events, with the context (task or ISR) each one was
+    recorded in;
+  - per-task timelines: when each task ran, what it waited for and for how
+    long, who woke it up, and how long it then waited for the CPU;
+  - the per-task summary.
+
+Input is either a stream of records, as fetched by `tn_trace_read()`
+(default), or the post-mortem dump of the whole ring buffer given to
+`tn_trace_start()` (`--snapshot`). For the latter, it's better to give the
+value of `tn_trace_write_cnt_get()` as well (`--write-cnt`), so that the
+oldest record is found reliably; without it, the oldest record is guessed
+by the timestamps.
+
+Example:
+
+    tntrace_decode.py --word 4 --ts-bits 16 \\
+          --name 0x20000100=task_a --name 0x20000180=sem_rx trace.bin
+"""
+
+import argparse
+import struct
+import sys
+
+
+#-- Event codes: should match `enum TN_TraceEvent` in src/core/tn_trace.h
+EV_NONE                 = 0x00
+EV_CONTEXT_SWITCH       = 0x01
+EV_TASK_CREATE          = 0x02
+EV_TASK_DELETE          = 0x03
+EV_TASK_ACTIVATE        = 0x04
+EV_TASK_TERMINATE       = 0x05
+EV_TASK_WAIT            = 0x06
+EV_TASK_WAIT_COMPLETE   = 0x07
+EV_TASK_SUSPEND         = 0x08
+EV_TASK_RESUME          = 0x09
+EV_TASK_NOTIFY          = 0x0a
+EV_TASK_NOTIFY_WAIT     = 0x0b
+EV_TIMER_FIRE           = 0x30
+
+EV_FLAG_ISR             = 0x80
+
+EVENT_NAMES = {
+    0x01: "CONTEXT_SWITCH",
+    0x02: "TASK_CREATE",
+    0x03: "TASK_DELETE",
+    0x04: "TASK_ACTIVATE",
+    0x05: "TASK_TERMINATE",
+    0x06: "TASK_WAIT",
+    0x07: "TASK_WAIT_COMPLETE",
+    0x08: "TASK_SUSPEND",
+    0x09: "TASK_RESUME",
+    0x0a: "TASK_NOTIFY",
+    0x0b: "TASK_NOTIFY_WAIT",
+
+    0x10: "SEM_CREATE",
+    0x11: "SEM_DELETE",
+    0x12: "SEM_SIGNAL",
+    0x13: "SEM_WAIT",
+
+    0x14: "MUTEX_CREATE",
+    0x15: "MUTEX_DELETE",
+    0x16: "MUTEX_LOCK",
+    0x17: "MUTEX_UNLOCK",
+
+    0x18: "QUEUE_CREATE",
+    0x19: "QUEUE_DELETE",
+    0x1a: "QUEUE_SEND",
+    0x1b: "QUEUE_RECEIVE",
+
+    0x1c: "FMEM_CREATE",
+    0x1d: "FMEM_DELETE",
+    0x1e: "FMEM_GET",
+    0x1f: "FMEM_RELEASE",
+
+    0x20: "EVENTGRP_CREATE",
+    0x21: "EVENTGRP_DELETE",
+    0x22: "EVENTGRP_MODIFY",
+    0x23: "EVENTGRP_WAIT",
+
+    0x24: "MSGBUF_CREATE",
+    0x25: "MSGBUF_DELETE",
+    0x26: "MSGBUF_SEND",
+    0x27: "MSGBUF_RECEIVE",
+
+    0x28: "EXCH_CREATE",
+    0x29: "EXCH_DELETE",
+    0x2a: "EXCH_WRITE",
+    0x2b: "EXCH_READ",
+
+    0x2c: "TIMER_CREATE",
+    0x2d: "TIMER_DELETE",
+    0x2e: "TIMER_START",
+    0x2f: "TIMER_CANCEL",
+    0x30: "TIMER_FIRE",
+
+    0x31: "MULTI_WAIT",
+
+    0x32: "WORKQ_CREATE",
+    0x33: "WORKQ_DELETE",
+    0x34: "WORK_POST",
+
+    0x35: "FMEM_MULTI_CREATE",
+    0x36: "FMEM_MULTI_DELETE",
+    0x37: "FMEM_MULTI_GET",
+    0x38: "FMEM_MULTI_RELEASE",
+
+    0x39: "HEAP_CREATE",
+    0x3a: "HEAP_DELETE",
+    0x3b: "HEAP_ALLOC",
+    0x3c: "HEAP_FREE",
+
+    0x3d: "BUF_ALLOC",
+    0x3e: "BUF_REF",
+    0x3f: "BUF_UNREF",
+}
+
+#-- Task state events: `arg` of them isn't a return code
+TASK_STATE_EVENTS = (
+    EV_CONTEXT_SWITCH,
+    EV_TASK_ACTIVATE,
+    EV_TASK_TERMINATE,
+    EV_TASK_WAIT,
+    EV_TASK_WAIT_COMPLETE,
+    EV_TASK_SUSPEND,
+    EV_TASK_RESUME,
+    EV_TIMER_FIRE,
+)
+
+#-- Should match `enum TN_WaitReason` in src/core/tn_tasks.h
+WAIT_REASONS = [
+    "NONE",
+    "SLEEP",
+    "SEM",
+    "EVENT",
+    "DQUE_WSEND",
+    "DQUE_WRECEIVE",
+    "MUTEX_C",
+    "MUTEX_I",
+    "WFIXMEM",
+    "NOTIFY",
+    "MSGBUF_WSEND",
+    "MSGBUF_WRECEIVE",
+    "WFIXMEM_MULTI",
+    "HEAP",
+    "MULTI",
+]
+WAIT_REASON_SLEEP = 1
+
+#-- Should match `enum TN_RCode` in src/core/tn_common.h
+RC_TIMEOUT = -1
+RCODES = {
+    0: "OK",
+    -1: "TIMEOUT",
+    -2: "OVERFLOW",
+    -3: "WCONTEXT",
+    -4: "WSTATE",
+    -5: "WPARAM",
+    -6: "ILLEGAL_USE",
+    -7: "INVALID_OBJ",
+    -8: "DELETED",
+    -9: "FORCED",
+    -10: "INTERNAL",
+}
+
+
+class Record:
+    """
+    Single decoded `struct TN_TraceRec`
+    """
+
+    def __init__(self, ts, obj, event, arg):
+        #-- unwrapped timestamp
+        self.ts = ts
+        self.obj = obj
+        self.event = event & ~EV_FLAG_ISR
+        self.isr = bool(event & EV_FLAG_ISR)
+        self.arg = arg
+
+
+class DataCodecTN:
+    """
+    Converts raw bytes to the list of `Record`s
+    """
+
+    def __init__(self, word_size, big_endian, ts_bits):
+        code = {2: "H", 4: "I", 8: "Q"}[word_size]
+        #-- struct TN_TraceRec: two words, unsigned char `event`, padding
+        #   byte, signed short `arg`; padded up to the word alignment
+        self.fmt = struct.Struct(
+            ("<" if not big_endian else ">") + code + code + "Bxh"
+        )
+        self.rec_size = (
+            (self.fmt.size + word_size - 1) // word_size * word_size
+        )
+        self.ts_mask = (1 << ts_bits) - 1
+
+    def split(self, data):
+        """
+        Returns list of raw tuples (timestamp, obj, event, arg)
+        """
+        cnt = len(data) // self.rec_size
+        if len(data) % self.rec_size:
+            sys.stderr.write(
+                "warning: trailing {} bytes ignored\n".format(
+                    len(data) % self.rec_size
+                )
+            )
+        return [
+            self.fmt.unpack_from(data, i * self.rec_size) for i in range(cnt)
+        ]
+
+    def delta(self, ts_from, ts_to):
+        return (ts_to - ts_from) & self.ts_mask
+
+    def decode(self, raw):
+        """
+        Takes raw tuples in chronological order, returns list of `Record`s
+        with unwrapped timestamps (the first one is 0)
+        """
+        ret = []
+        ts = 0
+        prev = None
+        for (rts, obj, event, arg) in raw:
+            rts &= self.ts_mask
+            if prev is not None:
+                ts += self.delta(prev, rts)
+            prev = rts
+            ret.append(Record(ts, obj, event, arg))
+        return ret
+
+
+class DataSrcStream:
+    """
+    Records fetched by `tn_trace_read()`: already in chronological order
+    """
+
+    def __init__(self, codec, data):
+        self.raw = codec.split(data)
+
+    def get(self):
+        return [r for r in self.raw if r[2] != EV_NONE]
+
+
+class DataSrcSnapshot:
+    """
+    Dump of the whole ring buffer given to `tn_trace_start()`
+    """
+
+    def __init__(self, codec, data, write_cnt):
+        self.codec = codec
+        self.raw = codec.split(data)
+        self.write_cnt = write_cnt
+
+    def _oldest_guess(self):
+        #-- The newest record is followed by the oldest one, so the
+        #   (wrapped) timestamp difference between them is the largest one
+        #   in the ring. This works if only the whole buffer spans less
+        #   than the timestamp range.
+        cnt = len(self.raw)
+        best_idx = 0
+        best_delta = -1
+        for i in range(cnt):
+            d = self.codec.delta(self.raw[i - 1][0], self.raw[i][0])
+            if d > best_delta:
+                best_idx = i
+                best_delta = d
+        return best_idx
+
+    def get(self):
+        cnt = len(self.raw)
+        if cnt == 0:
+            return []
+
+        if self.write_cnt is not None:
+            if self.write_cnt <= cnt:
+                ordered = self.raw[:self.write_cnt]
+            else:
+                oldest = self.write_cnt % cnt
+                ordered = self.raw[oldest:] + self.raw[:oldest]
+        elif any(r[2] == EV_NONE for r in self.raw):
+            #-- buffer wasn't filled up yet: records start from the beginning
+            ordered = self.raw
+        else:
+            oldest = self._oldest_guess()
+            ordered = self.raw[oldest:] + self.raw[:oldest]
+
+        return [r for r in ordered if r[2] != EV_NONE]
+
+
+class Names:
+    """
+    Human-readable names of the objects
+    """
+
+    def __init__(self, word_size, names):
+        self.width = word_size * 2
+        self.names = names
+
+    def get(self, addr):
+        if addr in self.names:
+            return self.names[addr]
+        return "0x{:0{}x}".format(addr, self.width)
+
+
+class Wait:
+    def __init__(self, start, reason):
+        self.start = start
+        self.end = None
+        self.reason = reason
+        self.rc = None
+        #-- object operation the task waited in (recorded by the task itself
+        #   when the wait is over)
+        self.op = None
+        #-- who completed the wait, and the operation it was doing
+        self.waker = None
+        self.waker_op = None
+        #-- time since the wait is completed until the task runs
+        self.latency = None
+
+
+class TaskInfo:
+    def __init__(self, addr):
+        self.addr = addr
+        #-- list of (start, end) run intervals
+        self.runs = []
+        self.run_start = None
+        self.waits = []
+        #-- wait which is in progress, or which is completed but the task
+        #   hasn't yet fetched its result
+        self.wait = None
+        self.ready_since = None
+        self.max_latency = 0
+        self.ops = {}
+
+    def run_time(self):
+        return sum(end - start for (start, end) in self.runs)
+
+
+class TNTracerCore:
+    """
+    Walks through the records and reconstructs what each task did
+    """
+
+    def __init__(self, records, names):
+        self.records = records
+        self.names = names
+        self.tasks = {}
+        #-- currently running task, or None if unknown yet
+        self.curr = None
+        #-- waits completed by some context, whose operation (recorded
+        #   when it finishes) isn't seen yet: context -> list of `Wait`s
+        self.pending_wakers = {}
+
+    def _task(self, addr):
+        if addr not in self.tasks:
+            self.tasks[addr] = TaskInfo(addr)
+        return self.tasks[addr]
+
+    def ctx_name(self, rec):
+        if rec.isr:
+            return "ISR"
+        if self.curr is None:
+            return "?"
+        return self.names.get(self.curr)
+
+    def _ctx_key(self, rec):
+        return "ISR" if rec.isr else self.curr
+
+    def _on_context_switch(self, rec):
+        if self.curr is not None:
+            prev = self._task(self.curr)
+            if prev.run_start is not None:
+                prev.runs.append((prev.run_start, rec.ts))
+                prev.run_start = None
+
+        self.curr = rec.obj
+        task = self._task(rec.obj)
+        task.run_start = rec.ts
+        if task.ready_since is not None:
+            latency = rec.ts - task.ready_since
+            task.max_latency = max(task.max_latency, latency)
+            if task.wait is not None:
+                task.wait.latency = latency
+            task.ready_since = None
+
+    def _on_wait(self, rec):
+        task = self._task(rec.obj)
+        task.wait = Wait(rec.ts, rec.arg)
+        task.waits.append(task.wait)
+
+    def _on_wait_complete(self, rec):
+        task = self._task(rec.obj)
+        wait = task.wait
+        if wait is None:
+            #-- the wait started before the trace did
+            wait = Wait(None, None)
+            task.wait = wait
+            task.waits.append(wait)
+        wait.end = rec.ts
+        wait.rc = rec.arg
+        task.ready_since = rec.ts
+        if rec.arg == RC_TIMEOUT:
+            #-- completed by the system timer, there's no operation to
+            #   look for
+            wait.waker = "timeout"
+        else:
+            wait.waker = self.ctx_name(rec)
+            self.pending_wakers.setdefault(
+                self._ctx_key(rec), []
+            ).append(wait)
+
+    def _on_op(self, rec):
+        key = self._ctx_key(rec)
+
+        #-- the first operation in the waker context after it has
+        #   completed some waits is the one which did it
+        for wait in self.pending_wakers.pop(key, []):
+            wait.waker_op = rec
+
+        #-- if the current task has waited, this is the operation it waited
+        #   in
+        if not rec.isr and self.curr is not None:
+            task = self._task(self.curr)
+            if task.wait is not None and task.wait.end is not None:
+                if task.wait.reason != WAIT_REASON_SLEEP:
+                    task.wait.op = rec
+                task.wait = None
+            task.ops[rec.event] = task.ops.get(rec.event, 0) + 1
+
+    def run(self):
+        for rec in self.records:
+            if rec.event == EV_CONTEXT_SWITCH:
+                self._on_context_switch(rec)
+            elif rec.event == EV_TASK_WAIT:
+                self._on_wait(rec)
+            elif rec.event == EV_TASK_WAIT_COMPLETE:
+                self._on_wait_complete(rec)
+            elif rec.event in (EV_TASK_CREATE, EV_TASK_ACTIVATE):
+                self._task(rec.obj)
+                if rec.event == EV_TASK_CREATE:
+                    self._on_op(rec)
+            elif rec.event not in TASK_STATE_EVENTS:
+                self._on_op(rec)
+
+            yield rec
+
+        #-- close the last run interval
+        if self.records and self.curr is not None:
+            task = self._task(self.curr)
+            if task.run_start is not None:
+                task.runs.append((task.run_start, self.records[-1].ts))
+                task.run_start = None
+
+
+def event_name(code):
+    return EVENT_NAMES.get(code, "UNKNOWN_0x{:02x}".format(code))
+
+
+def rc_name(rc):
+    return RCODES.get(rc, str(rc))
+
+
+def reason_name(reason):
+    if reason is None:
+        return "?"
+    if 0 <= reason < len(WAIT_REASONS):
+        return WAIT_REASONS[reason]
+    return str(reason)
+
+
+def arg_str(rec):
+    if rec.event == EV_TASK_WAIT:
+        return reason_name(rec.arg)
+    elif rec.event == EV_TASK_CREATE:
+        return "prio {}".format(rec.arg)
+    elif rec.event in TASK_STATE_EVENTS and rec.event != EV_TASK_WAIT_COMPLETE:
+        return ""
+    return rc_name(rec.arg)
+
+
+def print_events(core, names, out):
+    out.write("{:>12}  {:<20} {:<20} {:<20} {}\n".format(
+        "time", "context", "event", "object", "arg"
+    ))
+    for rec in core.run():
+        #-- context of the context switch is the task which is switched to,
+        #   so take the name after the switch is processed
+        out.write("{:>12}  {:<20} {:<20} {:<20} {}\n".format(
+            rec.ts,
+            core.ctx_name(rec),
+            event_name(rec.event),
+            names.get(rec.obj),
+            arg_str(rec),
+        ))
+
+
+def print_timelines(core, names, out):
+    for task in core.tasks.values():
+        out.write("\ntask {}:\n".format(names.get(task.addr)))
+
+        items = [(start, "run", (start, end)) for (start, end) in task.runs]
+        items += [
+            (w.start if w.start is not None else w.end, "wait", w)
+            for w in task.waits
+        ]
+        items.sort(key=lambda x: (x[0] if x[0] is not None else -1))
+
+        for (_, kind, item) in items:
+            if kind == "run":
+                (start, end) = item
+                out.write("   [{:>10} .. {:>10}] run   {:>10}\n".format(
+                    start, end, end - start
+                ))
+            else:
+                w = item
+                start = "?" if w.start is None else w.start
+                end = "..." if w.end is None else w.end
+                dur = (
+                    "" if (w.start is None or w.end is None)
+                    else w.end - w.start
+                )
+                line = "   [{:>10} .. {:>10}] wait  {:>10} {}".format(
+                    start, end, dur, reason_name(w.reason)
+                )
+                if w.op is not None:
+                    line += " in {}({})".format(
+                        event_name(w.op.event), names.get(w.op.obj)
+                    )
+                if w.rc is not None:
+                    line += " -> {}".format(rc_name(w.rc))
+                    if w.waker == "timeout":
+                        line += ", timed out"
+                    else:
+                        line += ", woken by {}".format(w.waker)
+                    if w.waker_op is not None:
+                        line += " via {}({})".format(
+                            event_name(w.waker_op.event),
+                            names.get(w.waker_op.obj)
+                        )
+                if w.latency is not None:
+                    line += ", ran after {}".format(w.latency)
+                out.write(line + "\n")
+
+
+def print_summary(core, names, records, out):
+    total = (records[-1].ts - records[0].ts) if records else 0
+    out.write("\ntotal: {} records, time span {}\n".format(
+        len(records), total
+    ))
+    out.write("{:<20} {:>8} {:>12} {:>7} {:>8} {:>12} {:>12}\n".format(
+        "task", "runs", "run time", "cpu %", "waits", "wait time",
+        "max latency"
+    ))
+    for task in core.tasks.values():
+        run_time = task.run_time()
+        wait_time = sum(
+            w.end - w.start for w in task.waits
+            if w.start is not None and w.end is not None
+        )
+        out.write(
+            "{:<20} {:>8} {:>12} {:>7.2f} {:>8} {:>12} {:>12}\n".format(
+                names.get(task.addr),
+                len(task.runs),
+                run_time,
+                (100.0 * run_time / total) if total else 0.0,
+                len(task.waits),
+                wait_time,
+                task.max_latency,
+            )
+        )
+
+
+def parse_name(s):
+    try:
+        (addr, name) = s.split("=", 1)
+        return (int(addr, 0), name)
+    except ValueError:
+        raise argparse.ArgumentTypeError(
+            "expected ADDR=NAME, got '{}'".format(s)
+        )
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Decode TNeo kernel event trace",
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog=__doc__,
+    )
+    parser.add_argument("file", help="binary file with trace records")
+    parser.add_argument(
+        "-w", "--word", type=int, choices=(2, 4, 8), default=4,
+        help="size of TN_UWord and pointers on the target (default: 4)"
+    )
+    parser.add_argument(
+        "--big-endian", action="store_true",
+        help="target is big-endian (default: little-endian)"
+    )
+    parser.add_argument(
+        "--ts-bits", type=int, default=None,
+        help="number of significant bits of the timestamp, if the timer "
+             "is narrower than TN_UWord (default: word size)"
+    )
+    parser.add_argument(
+        "-s", "--snapshot", action="store_true",
+        help="file is the dump of the whole ring buffer, not the stream "
+             "of records fetched by tn_trace_read()"
+    )
+    parser.add_argument(
+        "--write-cnt", type=lambda s: int(s, 0), default=None,
+        help="value returned by tn_trace_write_cnt_get() when the snapshot "
+             "was taken"
+    )
+    parser.add_argument(
+        "-n", "--name", type=parse_name, action="append", default=[],
+        metavar="ADDR=NAME", help="name of the object (task, semaphore, "
+                                  "etc) at the given address"
+    )
+    parser.add_argument(
+        "--no-events", action="store_true", help="don't print event list"
+    )
+    parser.add_argument(
+        "--no-timelines", action="store_true",
+        help="don't print per-task timelines"
+    )
+    args = parser.parse_args()
+
+    ts_bits = args.ts_bits if args.ts_bits else args.word * 8
+    codec = DataCodecTN(args.word, args.big_endian, ts_bits)
+    names = Names(args.word, dict(args.name))
+
+    with open(args.file, "rb") as f:
+        data = f.read()
+
+    if args.snapshot:
+        src = DataSrcSnapshot(codec, data, args.write_cnt)
+    else:
+        src = DataSrcStream(codec, data)
+
+    records = codec.decode(src.get())
+    core = TNTracerCore(records, names)
+    out = sys.stdout
+
+    if args.no_events:
+        for _ in core.run():
+            pass
+    else:
+        print_events(core, names, out)
+
+    if not args.no_timelines:
+        print_timelines(core, names, out)
+
+    print_summary(core, names, records, out)
+
+
+if __name__ == "__main__":
+    main()